@@ -43,6 +43,11 @@
 /* default RDCU destkey, see RDCU-FRS-FN-0260 */
 #define RDCU_DEST_KEY	0x0
 
+/* the GPIO line of the first GPIO port the RDCU interrupt signal is connected
+ * to; adjust to the board wiring
+ */
+#define RDCU_IRQ_GPIO_LINE	0
+
 
 /* set header size maximum so we can fit the largest possible rmap commands
  * given the hardware limit (HEADERLEN is 8 bits wide, see GR712RC UM, p. 112)
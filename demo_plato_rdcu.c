@@ -29,11 +29,13 @@
 
 #include <irq.h>
 #include <irq_dispatch.h>
+#include <leon_reg.h>
 
 #include <list.h>
 #include <io.h>
 #include <grspw2.h>
 #include <rmap.h>
+#include <dlog.h>
 #include <asm/leon.h>
 #include <errors.h>
 #include <event_report.h>
@@ -43,12 +45,17 @@
 #include <rdcu_ctrl.h>
 #include <rdcu_rmap.h>
 
+#include <rdcu_scrub.h>
+#include <rdcu_hk.h>
+
 #include <cmp_support.h>
 #include <cmp_rdcu.h>
+#include <cmp_icu.h>
 
 #include <cfg.h>
 #include <demo.h>
 
+#include <leon3_grtimer.h>
 #include <leon3_grtimer_longcount.h>
 
 
@@ -65,6 +72,17 @@ struct grtimer_unit *rtu = (struct grtimer_unit *) LEON3_BASE_ADDRESS_GRTIMER;
 
 #define MAX_PAYLOAD_SIZE	4096
 
+/* SRAM scrubbing: bytes per step and transfer bytes granted per second */
+#define SCRUB_STEP_SIZE		MAX_PAYLOAD_SIZE
+#define SCRUB_BUDGET		(64 * 1024)
+
+/* seconds per housekeeping snapshot */
+#define HK_PERIOD		1
+
+/* a full transfer window at the slowest link rate takes well below this */
+#define RMAP_TIMEOUT_USEC	500000
+#define RMAP_RETRIES		3
+
 /* XXX include extra for RMAP headers, 128 bytes is plenty */
 #undef GRSPW2_DEFAULT_MTU
 #define GRSPW2_DEFAULT_MTU (MAX_PAYLOAD_SIZE + 128)
@@ -93,6 +111,9 @@ void event_report(enum error_class c, enum error_severity s, uint32_t err)
 	case GRSPW2:
 		printf("%s ", "GRSPW2");
 		break;
+	case RMAP:
+		printf("%s ", "RMAP");
+		break;
 	default:
 		printf("%d ", c);
 		break;
@@ -157,6 +178,32 @@ static int32_t rmap_tx(const void *hdr,  uint32_t hdr_size,
 }
 
 
+/**
+ * zero-copy tx function for rdcu_ctrl
+ *
+ * @note the data payload is referenced by the tx descriptor instead of being
+ *	 copied, see rdcu_rmap_set_tx_zero_copy()
+ */
+
+static int32_t rmap_tx_zero_copy(const void *hdr,  uint32_t hdr_size,
+				 const uint8_t non_crc_bytes,
+				 const void *data, uint32_t data_size)
+{
+	return grspw2_add_pkt_zero_copy(&spw_cfg.spw, hdr, hdr_size,
+					non_crc_bytes, data, data_size);
+}
+
+
+/**
+ * tx buffer query function for rdcu_ctrl
+ */
+
+static uint32_t rmap_tx_avail(void)
+{
+	return grspw2_get_num_free_tx_desc_avail(&spw_cfg.spw);
+}
+
+
 /**
  * rx function for rdcu_ctrl
  *
@@ -171,6 +218,42 @@ static uint32_t rmap_rx(uint8_t *pkt)
 }
 
 
+/**
+ * zero-copy rx functions for rdcu_ctrl
+ *
+ * @note these reference the packet in the descriptor buffer instead of
+ *	 copying it out, see rdcu_rmap_set_rx_zero_copy()
+ */
+
+static uint32_t rmap_rx_peek(uint8_t **pkt)
+{
+	return grspw2_peek_pkt(&spw_cfg.spw, pkt);
+}
+
+static uint32_t rmap_rx_release(void)
+{
+	return grspw2_drop_pkt(&spw_cfg.spw);
+}
+
+
+/**
+ * burst rx functions for rdcu_ctrl
+ *
+ * @note these reference a batch of packets in the descriptor buffers and
+ *	 release them in one go, see rdcu_rmap_set_rx_burst()
+ */
+
+static uint32_t rmap_rx_burst(uint8_t **pkts, uint32_t *sizes, uint32_t n)
+{
+	return grspw2_get_pkts(&spw_cfg.spw, pkts, sizes, n);
+}
+
+static uint32_t rmap_rx_burst_release(uint32_t n)
+{
+	return grspw2_release_pkts(&spw_cfg.spw, n);
+}
+
+
 /**
  * @brief allocate and align a descriptor table as well as data memory for a
  *	  spw core configuration
@@ -218,6 +301,140 @@ static void spw_alloc(struct spw_cfg *cfg)
 }
 
 
+/**
+ * @brief determine the RMAP transfer window supported by the spw core
+ */
+
+static int spw_get_max_window(void)
+{
+	int n = rdcu_rmap_get_max_window();
+
+	if (n > GRSPW2_TX_DESCRIPTORS)
+		n = GRSPW2_TX_DESCRIPTORS;
+
+	if (n > GRSPW2_RX_DESCRIPTORS)
+		n = GRSPW2_RX_DESCRIPTORS;
+
+	return n;
+}
+
+
+/**
+ * @brief time source for the RMAP latency statistics
+ *
+ * @returns the uptime in microseconds (wraps after about 71 minutes, which
+ *	    is fine for the differences we're interested in)
+ */
+
+static uint32_t rmap_uptime_usec(void)
+{
+	struct grtimer_uptime up;
+
+
+	grtimer_longcount_get_uptime(rtu, &up);
+
+	return up.coarse * 1000000UL + up.fine / (CPU_CPS / 1000000UL);
+}
+
+
+/**
+ * @brief configure the GPIO line connected to the RDCU interrupt signal and
+ *	  collect the results of finished compressions on its interrupt
+ *
+ * @note the callback is deferred to irq_queue_execute(), as it issues RMAP
+ *	 transactions; the library only uses it after rdcu_cmp_irq_enable()
+ */
+
+static void rdcu_cmp_irq_init(void)
+{
+	uint32_t line = 1UL << RDCU_IRQ_GPIO_LINE;
+
+	struct leon3_grgpio_registermap *gpio =
+		(struct leon3_grgpio_registermap *) LEON3_BASE_ADDRESS_GRGPIO_1;
+
+
+	/* input, interrupt on the rising edge */
+	iowrite32be(ioread32be(&gpio->ioport_direction) & ~line,
+		    &gpio->ioport_direction);
+	iowrite32be(ioread32be(&gpio->irq_polarity) | line, &gpio->irq_polarity);
+	iowrite32be(ioread32be(&gpio->irq_edge) | line, &gpio->irq_edge);
+	iowrite32be(ioread32be(&gpio->irq_mask) | line, &gpio->irq_mask);
+
+	irl1_register_callback(GR712_IRL1_GRGPIO_0, PRIORITY_LATER,
+			       rdcu_cmp_done_irq, NULL);
+}
+
+
+/* the background tasks only run with the demonstrator */
+#if !(BENCHMARK) && !(CONFORMANCE)
+
+/**
+ * @brief acknowledge the once-per-second underflow of the fine timer
+ */
+
+static int32_t grtimer_tick_irq(__attribute__((unused)) void *userdata)
+{
+	grtimer_clear_interrupt_pending_status(rtu, 0);
+
+	return 0;
+}
+
+
+/**
+ * @brief enable a once-per-second timer interrupt for the background tasks
+ *
+ * @note both GRTIMER timers are in use by the longcount, but the fine timer
+ *	 underflows once per second, so its interrupt serves as the tick
+ */
+
+static void grtimer_tick_init(void)
+{
+	irl1_register_callback(GR712_IRL1_GRTIMER, PRIORITY_NOW,
+			       grtimer_tick_irq, NULL);
+
+	grtimer_set_interrupt_enabled(rtu, 0);
+}
+
+
+/**
+ * @brief scrub the RDCU SRAM in the background
+ *
+ * @note the step is deferred to irq_queue_execute(), as it issues RMAP
+ *	 transactions
+ */
+
+static void rdcu_scrub_irq_init(void)
+{
+	if (rdcu_scrub_init(SCRUB_STEP_SIZE, SCRUB_BUDGET)) {
+		printf("failed to set up the SRAM scrubber\n");
+		return;
+	}
+
+	irl1_register_callback(GR712_IRL1_GRTIMER, PRIORITY_LATER,
+			       rdcu_scrub_irq, NULL);
+}
+
+
+/**
+ * @brief take housekeeping snapshots of the RDCU in the background
+ *
+ * @note the request is deferred to irq_queue_execute(), as it issues an RMAP
+ *	 transaction
+ */
+
+static void rdcu_hk_irq_init(void)
+{
+	if (rdcu_hk_start(HK_PERIOD)) {
+		printf("failed to set up the housekeeping snapshots\n");
+		return;
+	}
+
+	irl1_register_callback(GR712_IRL1_GRTIMER, PRIORITY_LATER,
+			       rdcu_hk_irq, NULL);
+}
+#endif /* !BENCHMARK && !CONFORMANCE */
+
+
 /**
  * @brief perform basic initialisation of the spw core
  */
@@ -367,6 +584,8 @@ static void sync(void)
 	int cnt = 0;
 	printf("syncing...");
 	while (rdcu_rmap_sync_status()) {
+		/* serve deferred reply processing */
+		irq_queue_execute();
 		printf("pending: %d\n", rdcu_rmap_sync_status());
 
 		if (cnt++ > 10) {
@@ -376,6 +595,47 @@ static void sync(void)
 
 	}
 	printf("synced\n");
+
+	/* print what the library recorded meanwhile */
+	dlog_drain(0);
+}
+
+
+/**
+ * @brief print the last housekeeping snapshot of the RDCU
+ */
+
+static void rdcu_show_hk(void)
+{
+	struct rdcu_hk hk;
+	struct rdcu_hk_stats st;
+
+
+	rdcu_hk_get_stats(&st);
+
+	printf("housekeeping: %lu snapshots, %lu failed, %lu skipped\n",
+	       (unsigned long) st.done, (unsigned long) st.failed,
+	       (unsigned long) st.skipped);
+
+	if (rdcu_hk_get(&hk))
+		return;
+
+	printf("snapshot %lu taken at %lu us (requested at %lu us):\n",
+	       (unsigned long) hk.seq, (unsigned long) hk.t_done,
+	       (unsigned long) hk.t_req);
+	printf("\tRDCU status:          0x%08lx\n",
+	       (unsigned long) hk.rdcu_status);
+	printf("\tSpW link status:      0x%08lx\n",
+	       (unsigned long) hk.spw_link_status);
+	printf("\tSpW error counters:   0x%08lx\n",
+	       (unsigned long) hk.spw_err_cntrs);
+	printf("\tRMAP last error:      0x%08lx\n",
+	       (unsigned long) hk.rmap_last_err);
+	printf("\tADC values:           0x%08lx 0x%08lx 0x%08lx 0x%08lx\n",
+	       (unsigned long) hk.adc_values_1, (unsigned long) hk.adc_values_2,
+	       (unsigned long) hk.adc_values_3, (unsigned long) hk.adc_values_4);
+	printf("\tADC status:           0x%08lx\n",
+	       (unsigned long) hk.adc_status);
 }
 
 
@@ -569,15 +829,12 @@ static void rdcu_compression_demo(void)
 
 
 	printf("Configuring compression start bit and starting compression\n");
-	rdcu_set_data_compr_start();
-	rdcu_sync_compr_ctrl();
-	sync();
-
-	/* clear local bit immediately, this is a write-only register.
+	/* this also clears the local bit, this is a write-only register.
 	 * we would not want to restart compression by accidentially calling
 	 * rdcu_sync_compr_ctrl() again
 	 */
-	rdcu_clear_data_compr_start();
+	rdcu_start_data_compr();
+	sync();
 
 
 	/* start polling the compression status */
@@ -598,10 +855,8 @@ static void rdcu_compression_demo(void)
 		printf("Not waiting for compressor to become ready, will "
 		       "check status and abort\n");
 
-		rdcu_set_data_compr_interrupt();
-		rdcu_sync_compr_ctrl();
+		rdcu_interrupt_data_compr(); /* also clears locally */
 		sync();
-		rdcu_clear_data_compr_interrupt(); /* always clear locally */
 
 		/* now we may read the error code */
 		rdcu_sync_compr_error();
@@ -788,10 +1043,598 @@ static void rdcu_compression_cmp_lib_demo(void)
 	/* read updated model to some buffer and print */
 }
 
+#if (BENCHMARK) || (CONFORMANCE)
+
+#define RDCU_CMP_TIMEOUT	1000000UL	/* usec */
+
+
+/**
+ * @brief run a compression on the RDCU and read back the bitstream
+ *
+ * @param cfg	the compression configuration
+ * @param info	the compression information of the RDCU
+ * @param buf	the buffer for the bitstream
+ *
+ * @note the bitstream is only read if the RDCU reports no compression error
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static int rdcu_run_compression(const struct cmp_cfg *cfg,
+				struct cmp_info *info, void *buf)
+{
+	uint32_t t0;
+	struct cmp_status status;
+
+
+	if (rdcu_compress_data(cfg))
+		return -1;
+
+	t0 = rmap_uptime_usec();
+	do {
+		if (rdcu_read_cmp_status(&status))
+			return -1;
+
+		if (rmap_uptime_usec() - t0 > RDCU_CMP_TIMEOUT) {
+			rdcu_interrupt_compression();
+			return -1;
+		}
+	} while (!status.cmp_ready);
+
+	if (rdcu_read_cmp_info(info))
+		return -1;
+
+	if (info->cmp_err)
+		return 0;
+
+	if (rdcu_read_cmp_bitstream(info, buf) < 0)
+		return -1;
+
+	return 0;
+}
+#endif /* BENCHMARK || CONFORMANCE */
+
+
+#if (BENCHMARK)
+
+/**
+ * The benchmark results are printed as comma separated lines prefixed with
+ * "BENCH", so they can be filtered from the console log and compared between
+ * library versions:
+ *
+ *	BENCH,<test>,<mtu>,<size or mode>,<iterations>,<usec>
+ *
+ * where usec is the total time of all iterations; a failed test reports zero
+ * iterations.
+ */
+
+#define BENCH_REG_ITER		100
+#define BENCH_SYNC_TIMEOUT	20000000UL	/* usec */
+
+
+/**
+ * @brief wait for all pending transactions to complete (quietly)
+ *
+ * @returns 0 on success, -1 on timeout
+ */
+
+static int bench_sync(void)
+{
+	uint32_t t0 = rmap_uptime_usec();
+
+
+	while (rdcu_rmap_sync_status()) {
+		irq_queue_execute();
+
+		if (rmap_uptime_usec() - t0 > BENCH_SYNC_TIMEOUT)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief print a benchmark result line
+ */
+
+static void bench_print(const char *test, uint32_t mtu, uint32_t param,
+			uint32_t iter, uint32_t usec)
+{
+	printf("BENCH,%s,%lu,%lu,%lu,%lu\n", test, (unsigned long) mtu,
+	       (unsigned long) param, (unsigned long) iter,
+	       (unsigned long) usec);
+}
+
+
+/**
+ * @brief time SRAM transfers in both directions over MTUs and sizes
+ */
+
+static void bench_sram_transfers(void)
+{
+	size_t i, j;
+	uint32_t t0;
+	uint32_t usec;
+
+	static const uint32_t mtu[]  = {64, 256, 1024, MAX_PAYLOAD_SIZE};
+	static const uint32_t size[] = {0x1000, 0x10000, 0x100000,
+					RDCU_SRAM_SIZE};
+
+
+	for (i = 0; i < sizeof(mtu) / sizeof(mtu[0]); i++) {
+		for (j = 0; j < sizeof(size) / sizeof(size[0]); j++) {
+
+			t0 = rmap_uptime_usec();
+			if (rdcu_sync_mirror_to_sram(DATASTART, size[j], mtu[i]) ||
+			    bench_sync()) {
+				bench_print("sram_write", mtu[i], size[j], 0, 0);
+			} else {
+				usec = rmap_uptime_usec() - t0;
+				bench_print("sram_write", mtu[i], size[j], 1, usec);
+			}
+
+			t0 = rmap_uptime_usec();
+			if (rdcu_sync_sram_to_mirror(DATASTART, size[j], mtu[i]) ||
+			    bench_sync()) {
+				bench_print("sram_read", mtu[i], size[j], 0, 0);
+			} else {
+				usec = rmap_uptime_usec() - t0;
+				bench_print("sram_read", mtu[i], size[j], 1, usec);
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief time the round trip of single register syncs
+ */
+
+static void bench_register_sync(void)
+{
+	int i;
+	uint32_t t0;
+	uint32_t usec;
+
+
+	t0 = rmap_uptime_usec();
+	for (i = 0; i < BENCH_REG_ITER; i++) {
+		if (rdcu_sync_fpga_version() || bench_sync()) {
+			bench_print("reg_read", 0, 4, 0, 0);
+			break;
+		}
+	}
+	usec = rmap_uptime_usec() - t0;
+	if (i == BENCH_REG_ITER)
+		bench_print("reg_read", 0, 4, BENCH_REG_ITER, usec);
+
+	/* writing back the current target logical address changes nothing */
+	t0 = rmap_uptime_usec();
+	for (i = 0; i < BENCH_REG_ITER; i++) {
+		if (rdcu_sync_core_ctrl() || bench_sync()) {
+			bench_print("reg_write", 0, 4, 0, 0);
+			break;
+		}
+	}
+	usec = rmap_uptime_usec() - t0;
+	if (i == BENCH_REG_ITER)
+		bench_print("reg_write", 0, 4, BENCH_REG_ITER, usec);
+}
+
+
+/**
+ * @brief run a compression and read back the bitstream
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static int bench_compress(const struct cmp_cfg *cfg, uint8_t *buf)
+{
+	struct cmp_info info;
+
+
+	if (rdcu_run_compression(cfg, &info, buf))
+		return -1;
+
+	if (info.cmp_err)
+		return -1;
+
+	return 0;
+}
+
+
+/**
+ * @brief time end-to-end compressions for all RDCU compression modes
+ */
+
+static void bench_compression(void)
+{
+	uint32_t mode;
+	uint32_t t0;
+	uint32_t usec;
+	struct cmp_cfg cfg;
+
+	static uint8_t buf[COMPRDATALEN * sizeof(uint16_t)];
+
+
+	for (mode = MODE_RAW; mode <= MODE_DIFF_MULTI; mode++) {
+
+		if (model_mode_is_used(mode))
+			cfg = DEFAULT_CFG_MODEL;
+		else
+			cfg = DEFAULT_CFG_DIFF;
+
+		cfg.cmp_mode      = mode;
+		cfg.input_buf     = data;
+		cfg.model_buf     = model;
+		cfg.samples       = NUMSAMPLES;
+		cfg.buffer_length = COMPRDATALEN;
+
+		t0 = rmap_uptime_usec();
+		if (bench_compress(&cfg, buf)) {
+			bench_print("compress", rdcu_get_data_mtu(), mode, 0, 0);
+			continue;
+		}
+		usec = rmap_uptime_usec() - t0;
+
+		bench_print("compress", rdcu_get_data_mtu(), mode, 1, usec);
+	}
+}
+
+
+/**
+ * @brief run the benchmark suite
+ */
+
+static void rdcu_benchmark(void)
+{
+	printf("BENCH,test,mtu,param,iterations,usec\n");
+
+	bench_register_sync();
+	bench_sram_transfers();
+	bench_compression();
+
+	printf("BENCH,done,0,0,0,0\n");
+}
+#endif /* BENCHMARK */
+
+
+#if (CONFORMANCE)
+
+/**
+ * The conformance harness compresses the same inputs on the RDCU and with the
+ * software compressor (icu_compress_data()) for a sweep of compression
+ * parameters and compares the compression information, the bitstream (bit
+ * for bit) and the updated model. The results are printed as comma separated
+ * lines prefixed with "CONF", one per input and compression mode:
+ *
+ *	CONF,<input>,<mode>,<runs>,<failures>,<bytes>,<hw usec>,<sw usec>
+ *
+ * where bytes is the size of the input data of all runs, hw usec the total
+ * time of upload, compression and read-back of bitstream and model and sw usec
+ * the total time of the software compression, both measured with the GRTIMER
+ * long count. Every mismatch is reported with its parameters as
+ *
+ *	CONF_FAIL,<input>,<mode>,<golomb_par>,<spill>,<model_value>,<round>,<what>
+ *
+ * and the last line is CONF,done with the total number of failures.
+ */
+
+#define CONF_SAMPLES	NUMSAMPLES
+#define CONF_BUF_LEN	(2 * CONF_SAMPLES)	/* samples, holds any input */
+
+enum conf_input {CONF_DEMO, CONF_CONST, CONF_RAMP, CONF_NEAR, CONF_NOISE,
+		 CONF_INPUTS};
+
+static const char *conf_input_name[CONF_INPUTS] = {
+	"demo", "const", "ramp", "near", "noise"
+};
+
+static const uint32_t conf_golomb_par[] = {1, 2, 3, 4, 7, 8, 16, 31, 63};
+static const uint32_t conf_model_value[] = {0, 8, MAX_MODEL_VALUE};
+
+static uint16_t conf_data[CONF_SAMPLES];
+static uint16_t conf_model[CONF_SAMPLES];
+static uint16_t conf_hw_model[CONF_SAMPLES];
+static uint16_t conf_sw_model[CONF_SAMPLES];
+static uint32_t conf_hw_buf[CONF_BUF_LEN / 2];
+static uint32_t conf_sw_buf[CONF_BUF_LEN / 2];
+
+
+/**
+ * @brief generate the data and model of an input
+ *
+ * @note the synthetic inputs use a fixed seed, so they are the same in every
+ *	 run and library version
+ */
+
+static void conf_gen_input(enum conf_input in)
+{
+	uint32_t i;
+	uint32_t lcg = 0x2545F491UL;
+
+
+	/* the demo arrays are byte images, copy them for alignment */
+	memcpy(conf_data, data, sizeof(conf_data));
+	memcpy(conf_model, model, sizeof(conf_model));
+
+	for (i = 0; i < CONF_SAMPLES; i++) {
+
+		lcg = lcg * 1103515245UL + 12345UL;
+
+		switch (in) {
+		case CONF_CONST:
+			conf_data[i]  = 0x1234;
+			conf_model[i] = 0x1234;
+			break;
+		case CONF_RAMP:
+			conf_data[i]  = (uint16_t) (i * 7);
+			conf_model[i] = (uint16_t) (i * 7 - 3);
+			break;
+		case CONF_NEAR:
+			conf_data[i] = (uint16_t) (conf_model[i] +
+						   (lcg >> 16) % 64 - 32);
+			break;
+		case CONF_NOISE:
+			conf_data[i] = (uint16_t) (lcg >> 16);
+			break;
+		case CONF_DEMO:
+		default:
+			break;
+		}
+	}
+}
+
+
+/**
+ * @brief report a mismatch
+ */
+
+static void conf_fail(enum conf_input in, const struct cmp_cfg *cfg,
+		      const char *what)
+{
+	printf("CONF_FAIL,%s,%lu,%lu,%lu,%lu,%lu,%s\n", conf_input_name[in],
+	       (unsigned long) cfg->cmp_mode, (unsigned long) cfg->golomb_par,
+	       (unsigned long) cfg->spill, (unsigned long) cfg->model_value,
+	       (unsigned long) cfg->round, what);
+}
+
+
+/**
+ * @brief compare two bitstreams
+ *
+ * @param a	a bitstream
+ * @param b	another bitstream
+ * @param bits	the number of bits to compare
+ *
+ * @returns 0 if the first bits are identical, otherwise not
+ */
+
+static int conf_bitstream_cmp(const void *a, const void *b, uint32_t bits)
+{
+	uint8_t mask;
+
+	const uint8_t *p = (const uint8_t *) a;
+	const uint8_t *q = (const uint8_t *) b;
+
+
+	/* the bitstreams are big-endian, the bits fill the bytes msb first */
+	if (memcmp(p, q, bits >> 3))
+		return 1;
+
+	if (!(bits & 7))
+		return 0;
+
+	mask = (uint8_t) (0xFF << (8 - (bits & 7)));
+
+	return (p[bits >> 3] ^ q[bits >> 3]) & mask;
+}
+
+
+/**
+ * @brief compress an input on the RDCU and in software and compare the results
+ *
+ * @param in		the input
+ * @param cfg		the compression configuration
+ * @param hw_usec	incremented by the time of the RDCU compression
+ * @param sw_usec	incremented by the time of the software compression
+ *
+ * @returns 0 if both results are identical, 1 otherwise
+ */
+
+static int conf_run(enum conf_input in, const struct cmp_cfg *cfg,
+		    uint32_t *hw_usec, uint32_t *sw_usec)
+{
+	uint32_t t0;
+	struct cmp_cfg sw_cfg;
+	struct cmp_info hw_info;
+	struct cmp_info sw_info;
+
+
+	t0 = rmap_uptime_usec();
+
+	if (rdcu_run_compression(cfg, &hw_info, conf_hw_buf)) {
+		conf_fail(in, cfg, "rdcu");
+		return 1;
+	}
+
+	if (!hw_info.cmp_err && model_mode_is_used(cfg->cmp_mode)) {
+		if (rdcu_read_model(&hw_info, conf_hw_model) < 0) {
+			conf_fail(in, cfg, "rdcu_model");
+			return 1;
+		}
+	}
+
+	(*hw_usec) += rmap_uptime_usec() - t0;
+
+	sw_cfg = (*cfg);
+	sw_cfg.icu_output_buf    = conf_sw_buf;
+	sw_cfg.icu_new_model_buf = conf_sw_model;
+
+	/* a rejected configuration sets cmp_err, which is compared below */
+	t0 = rmap_uptime_usec();
+	icu_compress_data(&sw_cfg, &sw_info);
+	(*sw_usec) += rmap_uptime_usec() - t0;
+
+	if (hw_info.cmp_err != sw_info.cmp_err) {
+		conf_fail(in, cfg, "cmp_err");
+		return 1;
+	}
+
+	/* both compressors failed the same way */
+	if (hw_info.cmp_err)
+		return 0;
+
+	if (hw_info.cmp_mode_used    != sw_info.cmp_mode_used    ||
+	    hw_info.golomb_par_used  != sw_info.golomb_par_used  ||
+	    hw_info.spill_used       != sw_info.spill_used       ||
+	    hw_info.model_value_used != sw_info.model_value_used ||
+	    hw_info.round_used       != sw_info.round_used       ||
+	    hw_info.samples_used     != sw_info.samples_used) {
+		conf_fail(in, cfg, "info");
+		return 1;
+	}
+
+	if (hw_info.cmp_size != sw_info.cmp_size) {
+		conf_fail(in, cfg, "cmp_size");
+		return 1;
+	}
+
+	if (conf_bitstream_cmp(conf_hw_buf, conf_sw_buf, hw_info.cmp_size)) {
+		conf_fail(in, cfg, "bitstream");
+		return 1;
+	}
+
+	if (model_mode_is_used(cfg->cmp_mode)) {
+		if (memcmp(conf_hw_model, conf_sw_model,
+			   size_of_model(cfg->samples, cfg->cmp_mode))) {
+			conf_fail(in, cfg, "model");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief run the parameter sweep of a compression mode on an input
+ *
+ * @returns the number of failed runs
+ */
+
+static int conf_sweep(enum conf_input in, uint32_t mode)
+{
+	int fails = 0;
+	uint32_t runs = 0;
+	uint32_t hw_usec = 0;
+	uint32_t sw_usec = 0;
+	size_t g, s, m;
+	size_t n_g, n_s, n_m;
+	uint32_t spill[3];
+	struct cmp_cfg cfg;
+
+
+	if (model_mode_is_used(mode))
+		cfg = DEFAULT_CFG_MODEL;
+	else
+		cfg = DEFAULT_CFG_DIFF;
+
+	cfg.cmp_mode      = mode;
+	cfg.input_buf     = conf_data;
+	cfg.model_buf     = conf_model;
+	cfg.samples       = CONF_SAMPLES;
+	cfg.buffer_length = CONF_BUF_LEN;
+
+	/* raw mode ignores the coder parameters, diff modes the model value */
+	n_g = sizeof(conf_golomb_par) / sizeof(conf_golomb_par[0]);
+	n_s = sizeof(spill) / sizeof(spill[0]);
+	n_m = sizeof(conf_model_value) / sizeof(conf_model_value[0]);
+
+	if (raw_mode_is_used(mode))
+		n_g = n_s = 1;
+
+	if (!model_mode_is_used(mode))
+		n_m = 1;
+
+	for (g = 0; g < n_g; g++) {
+
+		if (!raw_mode_is_used(mode))
+			cfg.golomb_par = conf_golomb_par[g];
+
+		spill[0] = MIN_RDCU_SPILL;
+		spill[2] = get_max_spill(cfg.golomb_par, mode);
+		spill[1] = (spill[0] + spill[2]) / 2;
+
+		for (s = 0; s < n_s; s++) {
+
+			if (!raw_mode_is_used(mode))
+				cfg.spill = spill[s];
+
+			/* the adaptive parameters are not compared */
+			cfg.ap1_golomb_par = cfg.golomb_par;
+			cfg.ap1_spill      = cfg.spill;
+			cfg.ap2_golomb_par = cfg.golomb_par;
+			cfg.ap2_spill      = cfg.spill;
+
+			for (m = 0; m < n_m; m++) {
+
+				if (model_mode_is_used(mode))
+					cfg.model_value = conf_model_value[m];
+
+				for (cfg.round = 0; cfg.round <= MAX_RDCU_ROUND;
+				     cfg.round++) {
+					fails += conf_run(in, &cfg, &hw_usec,
+							  &sw_usec);
+					runs++;
+				}
+			}
+		}
+	}
+
+	printf("CONF,%s,%lu,%lu,%d,%lu,%lu,%lu\n", conf_input_name[in],
+	       (unsigned long) mode, (unsigned long) runs, fails,
+	       (unsigned long) (runs * CONF_SAMPLES * sizeof(uint16_t)),
+	       (unsigned long) hw_usec, (unsigned long) sw_usec);
+
+	return fails;
+}
+
+
+/**
+ * @brief run the conformance harness
+ */
+
+static void rdcu_conformance(void)
+{
+	int in;
+	int fails = 0;
+	uint32_t mode;
+
+
+	printf("CONF,input,mode,runs,failures,bytes,hw_usec,sw_usec\n");
+
+	for (in = 0; in < CONF_INPUTS; in++) {
+
+		conf_gen_input((enum conf_input) in);
+
+		for (mode = MODE_RAW; mode <= MODE_DIFF_MULTI; mode++)
+			fails += conf_sweep((enum conf_input) in, mode);
+	}
+
+	printf("CONF,done,0,0,%d,0,0,0\n", fails);
+}
+#endif /* CONFORMANCE */
+
+
 /**
  * @brief exchange some stuff
+ *
+ * @note not used in the benchmark and conformance builds
  */
 
+__attribute__((unused))
 static void rdcu_demo(void)
 {
 	struct grtimer_uptime t0, t1;
@@ -819,10 +1662,8 @@ static void rdcu_demo(void)
 	if (rdcu_get_data_compr_active()) {
 		printf("Compressor is active, must interrupt or RMAP cannot "
 		       "access the data compressor control registers\n");
-		rdcu_set_data_compr_interrupt();
-		rdcu_sync_compr_ctrl();
+		rdcu_interrupt_data_compr(); /* also clears locally */
 		sync();
-		rdcu_clear_data_compr_interrupt(); /* always clear locally */
 		rdcu_sync_compr_status(); /* read back status */
 		sync();
 
@@ -859,6 +1700,9 @@ static void rdcu_demo(void)
 
 	/* now do some compression work using the cmp_rdcu library */
 	rdcu_compression_cmp_lib_demo();
+
+	/* and show what the housekeeping looked like meanwhile */
+	rdcu_show_hk();
 }
 
 
@@ -899,6 +1743,34 @@ int main(void)
 	/* initialise the libraries */
 	rdcu_ctrl_init();
 	rdcu_rmap_init(MAX_PAYLOAD_SIZE, rmap_tx, rmap_rx);
+	rdcu_rmap_set_tx_zero_copy(rmap_tx_zero_copy);
+	rdcu_rmap_set_rx_zero_copy(rmap_rx_peek, rmap_rx_release);
+	rdcu_rmap_set_rx_burst(rmap_rx_burst, rmap_rx_burst_release);
+	rdcu_rmap_set_time_source(rmap_uptime_usec);
+
+	/* lost or corrupted replies are retransmitted */
+	rdcu_rmap_set_timeout(RMAP_TIMEOUT_USEC, RMAP_RETRIES);
+
+	/* the transfer window is limited by whatever descriptor ring is
+	 * smaller, so the core can always buffer all replies in flight
+	 */
+	rdcu_rmap_set_tx_avail(rmap_tx_avail);
+	rdcu_rmap_set_window(spw_get_max_window());
+
+	/* process RMAP replies on packet reception; the callback is deferred
+	 * and executed in irq_queue_execute(), as the transaction log must
+	 * only be accessed from a single context
+	 */
+	irl2_register_callback(GR712_IRL2_GRSPW2_0, PRIORITY_LATER,
+			       rdcu_rmap_rx_irq, NULL);
+
+	/* and print the messages logged while doing so in the background */
+	irl2_register_callback(GR712_IRL2_GRSPW2_0, PRIORITY_LATER,
+			       dlog_drain_irq, NULL);
+	grspw2_rx_interrupt_enable(&spw_cfg.spw);
+
+	/* finished compressions may be signalled by the RDCU */
+	rdcu_cmp_irq_init();
 
 	/* set initial link configuration */
 	rdcu_set_destination_logical_address(RDCU_ADDR_START);
@@ -922,8 +1794,28 @@ int main(void)
 	rdcu_set_destination_path(NULL, 0);
 	rdcu_set_return_path(NULL, 0);
 
+	/* start with clear link error counters, so the housekeeping only
+	 * shows the errors of this run
+	 */
+	rdcu_reset_error_cntrs();
+
+#if (BENCHMARK)
+	/* or the benchmark suite instead */
+	rdcu_benchmark();
+#elif (CONFORMANCE)
+	/* or compare the RDCU with the software compressor */
+	rdcu_conformance();
+#else
+	/* scrub the SRAM and collect housekeeping while the demonstrator
+	 * runs
+	 */
+	grtimer_tick_init();
+	rdcu_scrub_irq_init();
+	rdcu_hk_irq_init();
+
 	/* now run the demonstrator */
 	rdcu_demo();
+#endif /* BENCHMARK, CONFORMANCE */
 
 	return 0;
 }
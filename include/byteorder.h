@@ -25,6 +25,10 @@
  *	cpu_to_[bl]eXXs(uintXX_t x)
  *	[bl]eXX_to_cpus(uintXX_t x)
  *
+ * the same, but for n values while copying from src to dst (big endian only):
+ *	cpu_to_beXX_copy(void *dst, const void *src, size_t n)
+ *	beXX_to_cpu_copy(void *dst, const void *src, size_t n)
+ *
  *
  * This is based on the byte order macros from the linux kernel, see:
  * include/linux/byteorder/generic.h
@@ -38,6 +42,8 @@
 #define BYTEORDER_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
 
 
 
@@ -215,6 +221,60 @@ static inline void __swab64s(uint64_t *p)
 }
 
 
+/**
+ * @brief copy an array of 16-bit values, swapping the byte order of each
+ * @param dst the destination buffer
+ * @param src the source buffer
+ * @param n the number of values
+ *
+ * @note the buffers need not be aligned but may not overlap; the loop is kept
+ *	 trivial, so the compiler may vectorise it (e.g. to byte shuffles)
+ */
+
+static inline void __swab16_copy(void *dst, const void *src, size_t n)
+{
+	size_t i;
+	uint16_t v;
+
+	uint8_t *d = (uint8_t *) dst;
+	const uint8_t *s = (const uint8_t *) src;
+
+
+	for (i = 0; i < n; i++) {
+		memcpy(&v, &s[i * sizeof(v)], sizeof(v));
+		v = __swab16(v);
+		memcpy(&d[i * sizeof(v)], &v, sizeof(v));
+	}
+}
+
+
+/**
+ * @brief copy an array of 32-bit values, swapping the byte order of each
+ * @param dst the destination buffer
+ * @param src the source buffer
+ * @param n the number of values
+ *
+ * @note the buffers need not be aligned but may not overlap; the loop is kept
+ *	 trivial, so the compiler may vectorise it (e.g. to byte shuffles)
+ */
+
+static inline void __swab32_copy(void *dst, const void *src, size_t n)
+{
+	size_t i;
+	uint32_t v;
+
+	uint8_t *d = (uint8_t *) dst;
+	const uint8_t *s = (const uint8_t *) src;
+
+
+	for (i = 0; i < n; i++) {
+		memcpy(&v, &s[i * sizeof(v)], sizeof(v));
+		v = __swab32(v);
+		memcpy(&d[i * sizeof(v)], &v, sizeof(v));
+	}
+}
+
+
 #ifdef __BIG_ENDIAN
 
 #define __cpu_to_le16(x)   ((uint16_t)__swab16((x)))
@@ -251,6 +311,12 @@ static inline void __swab64s(uint64_t *p)
 #define __be32_to_cpus(x)  { (void)(x); }
 #define __be64_to_cpus(x)  { (void)(x); }
 
+#define __cpu_to_be16_copy(d, s, n) ((void) memcpy((d), (s), (n) * 2))
+#define __cpu_to_be32_copy(d, s, n) ((void) memcpy((d), (s), (n) * 4))
+
+#define __be16_to_cpu_copy(d, s, n) ((void) memcpy((d), (s), (n) * 2))
+#define __be32_to_cpu_copy(d, s, n) ((void) memcpy((d), (s), (n) * 4))
+
 #endif /* __BIG_ENDIAN */
 
 
@@ -290,6 +356,12 @@ static inline void __swab64s(uint64_t *p)
 #define __be32_to_cpus(x) __swab32s((x))
 #define __be64_to_cpus(x) __swab64s((x))
 
+#define __cpu_to_be16_copy(d, s, n) __swab16_copy((d), (s), (n))
+#define __cpu_to_be32_copy(d, s, n) __swab32_copy((d), (s), (n))
+
+#define __be16_to_cpu_copy(d, s, n) __swab16_copy((d), (s), (n))
+#define __be32_to_cpu_copy(d, s, n) __swab32_copy((d), (s), (n))
+
 #endif /* __LITTLE_ENDIAN */
 
 
@@ -316,6 +388,10 @@ static inline void __swab64s(uint64_t *p)
 #define cpu_to_be32s __cpu_to_be32s
 #define cpu_to_be64s __cpu_to_be64s
 
+/** copy and convert an array in cpu order to big endian */
+#define cpu_to_be16_copy __cpu_to_be16_copy
+#define cpu_to_be32_copy __cpu_to_be32_copy
+
 
 /* same, but in reverse */
 
@@ -339,6 +415,10 @@ static inline void __swab64s(uint64_t *p)
 #define be32_to_cpus __be32_to_cpus
 #define be64_to_cpus __be64_to_cpus
 
+/** copy and convert a big endian array to cpu order */
+#define be16_to_cpu_copy __be16_to_cpu_copy
+#define be32_to_cpu_copy __be32_to_cpu_copy
+
 
 
 #endif /* BYTEORDER_H */
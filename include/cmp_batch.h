@@ -0,0 +1,74 @@
+/**
+ * @file   cmp_batch.h
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief multi-threaded batch (de)compression for PC builds
+ */
+
+
+#ifndef _CMP_BATCH_H_
+#define _CMP_BATCH_H_
+
+#include <stdint.h>
+#include "../include/cmp_support.h"
+
+
+/**
+ * @brief a software compression job
+ *
+ * @note if chained is set, the model of the job is the updated model of the
+ *	 previous job in the array, i.e. cfg.model_buf is ignored and the
+ *	 previous job must have an icu_new_model_buf
+ */
+
+struct cmp_job {
+	struct cmp_cfg cfg;	/* the configuration of the compression */
+	int chained;		/* continue the model chain of the previous job */
+	struct cmp_info info;	/* the result of the compression */
+	int status;		/* the return value of icu_compress_data() */
+};
+
+
+/**
+ * @brief a decompression job
+ *
+ * @note if chained is set, the model of the job is the updated model of the
+ *	 previous job in the array, i.e. model_buf is ignored and the previous
+ *	 job must have an up_model_buf
+ */
+
+struct decmp_job {
+	const struct cmp_info *info;	/* compression information */
+	const void *compressed_data;	/* the bitstream */
+	const void *model_buf;		/* the model (model modes only) */
+	void *decompressed_data;	/* the buffer for the samples */
+	void *up_model_buf;		/* the buffer for the updated model
+					 * (may be NULL)
+					 */
+	int chained;			/* continue the model chain of the
+					 * previous job
+					 */
+	int status;			/* the return value of
+					 * decompress_data()
+					 */
+};
+
+
+int icu_compress_batch(struct cmp_job *jobs, unsigned int n_jobs,
+		       unsigned int n_threads);
+
+int decompress_batch(struct decmp_job *jobs, unsigned int n_jobs,
+		     unsigned int n_threads);
+
+#endif /* _CMP_BATCH_H_ */
@@ -0,0 +1,29 @@
+/**
+ * @file   cmp_icu.h
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+
+#ifndef _CMP_ICU_H_
+#define _CMP_ICU_H_
+
+#include <stdint.h>
+#include "../include/cmp_support.h"
+
+
+int icu_compress_data(const struct cmp_cfg *cfg, struct cmp_info *info);
+int icu_estimate_cmp_cfg(const struct cmp_cfg *cfg, uint32_t step,
+			 struct cmp_cfg *rec);
+
+#endif /* _CMP_ICU_H_ */
@@ -22,6 +22,25 @@
 #include "../include/cmp_support.h"
 
 
+#define RDCU_PIPE_SLOTS_MAX	4
+
+/**
+ * @brief the RDCU SRAM buffers of one compression pipeline slot
+ *
+ * @note samples and buffer_length are the capacities of the slot, the frames
+ *	 loaded into the slot may be smaller
+ */
+
+struct rdcu_pipe_slot {
+	uint32_t rdcu_data_adr;      /* data to compress start address */
+	uint32_t rdcu_model_adr;     /* model start address */
+	uint32_t rdcu_new_model_adr; /* updated model start address */
+	uint32_t rdcu_buffer_adr;    /* compressed data start address */
+	uint32_t samples;            /* capacity of the data and model buffers in samples */
+	uint32_t buffer_length;      /* capacity of the compressed data buffer in samples */
+};
+
+
 int rdcu_compress_data(const struct cmp_cfg *cfg);
 
 int rdcu_read_cmp_status(struct cmp_status *status);
@@ -32,9 +51,39 @@ int rdcu_read_cmp_bitstream(const struct cmp_info *info, void *output_buf);
 
 int rdcu_read_model(const struct cmp_info *info, void *model_buf);
 
+int rdcu_write_n_dpu_streams(const void *data_buf, uint32_t samples,
+			     uint32_t entry_size, const uint32_t *stream_adr);
+int rdcu_read_n_dpu_streams(void *data_buf, uint32_t samples,
+			    uint32_t entry_size, const uint32_t *stream_adr);
+
 int rdcu_interrupt_compression(void);
 
+int rdcu_cmp_cfg_adapt(struct cmp_cfg *cfg, const struct cmp_info *info);
+
 void rdcu_enable_interrput_signal(void);
 void rdcu_disable_interrput_signal(void);
 
+int rdcu_pipe_init(const struct rdcu_pipe_slot *slots, unsigned int n_slots);
+int rdcu_pipe_load(const struct cmp_cfg *cfg);
+int rdcu_pipe_start(void);
+int rdcu_pipe_finish(void);
+int rdcu_pipe_read(int slot, struct cmp_info *info, void *output_buf,
+		   void *model_buf);
+int rdcu_compress_stream(const struct cmp_cfg *cfg, uint32_t frame_samples,
+			 void *output_buf, uint32_t output_size);
+
+void rdcu_cmp_irq_enable(void (*cb)(const struct cmp_info *info, int status,
+				    void *userdata),
+			 void *output_buf, void *userdata);
+void rdcu_cmp_irq_disable(void);
+int32_t rdcu_cmp_done_irq(void *userdata);
+
+/* an RDCU with its link, mirror and compressor state, see rdcu_unit_select() */
+struct rdcu_unit;
+
+struct rdcu_unit *rdcu_unit_alloc(void);
+void rdcu_unit_free(struct rdcu_unit *u);
+void rdcu_unit_select(struct rdcu_unit *u);
+struct rdcu_unit *rdcu_unit_get(void);
+
 #endif /* _CMP_RDCU_H_ */
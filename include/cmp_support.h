@@ -168,6 +168,9 @@ unsigned int round_fwd(unsigned int value, unsigned int round);
 unsigned int round_inv(unsigned int value, unsigned int round);
 unsigned int cal_up_model(unsigned int data, unsigned int model, unsigned int
 			  model_value);
+int cal_up_model_buf(void *model_buf, const void *data_buf,
+		     unsigned int samples, unsigned int cmp_mode,
+		     unsigned int model_value, unsigned int round);
 
 uint32_t get_max_spill(unsigned int golomb_par, unsigned int cmp_mode);
 
@@ -0,0 +1,29 @@
+/**
+ * @file   decmp.h
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ */
+
+
+#ifndef _DECMP_H_
+#define _DECMP_H_
+
+#include <stdint.h>
+#include "../include/cmp_support.h"
+
+
+int decompress_data(const void *compressed_data, const void *model_buf,
+		    const struct cmp_info *info, void *decompressed_data,
+		    void *up_model_buf);
+
+#endif /* _DECMP_H_ */
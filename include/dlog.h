@@ -0,0 +1,63 @@
+/**
+ * @file   dlog.h
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief deferred, ring-buffered logging
+ *
+ * A log message is recorded as a reference to its (constant) format string
+ * and up to three 32 bit arguments; formatting and output only happen when
+ * the log is drained, so logging is cheap enough for the hot paths.
+ *
+ * With DEBUGLEVEL 0, the logging macros compile to nothing.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+
+
+/**
+ * the number of records in the log, must be a power of two
+ */
+
+#ifndef DLOG_RING_SIZE
+#define DLOG_RING_SIZE		64
+#endif
+
+/* the number of messages printed per call of dlog_drain_irq() */
+#define DLOG_DRAIN_BATCH	 8
+
+
+#if (DEBUGLEVEL > 0)
+#define dlog0(fmt)		dlog_event(fmt, 0, 0, 0)
+#define dlog1(fmt, a)		dlog_event(fmt, (a), 0, 0)
+#define dlog2(fmt, a, b)	dlog_event(fmt, (a), (b), 0)
+#define dlog3(fmt, a, b, c)	dlog_event(fmt, (a), (b), (c))
+#else
+#define dlog0(fmt)		do { } while (0)
+#define dlog1(fmt, a)		do { (void) (a); } while (0)
+#define dlog2(fmt, a, b)	do { (void) (a); (void) (b); } while (0)
+#define dlog3(fmt, a, b, c)	do { (void) (a); (void) (b); (void) (c); } while (0)
+#endif
+
+
+void dlog_event(const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2);
+
+int dlog_drain(unsigned int max);
+int32_t dlog_drain_irq(void *userdata);
+
+uint32_t dlog_lost(void);
+
+#endif /* DLOG_H */
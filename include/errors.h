@@ -260,6 +260,9 @@
  *
  * @def E_SPW_TX_DESC_TABLE_ALIGN
  *	the supplied TX descriptor table is incorrectly aligned
+ *
+ * @def E_SPW_DMA_CHANNEL_INVALID
+ *	the specified DMA channel is not implemented by the core
  */
 
 /*
@@ -283,6 +286,7 @@
 #define E_SPW_TX_AHB_ERROR		ERR_SPW(12)
 #define E_SPW_RX_DESC_TABLE_ALIGN	ERR_SPW(13)
 #define E_SPW_TX_DESC_TABLE_ALIGN	ERR_SPW(14)
+#define E_SPW_DMA_CHANNEL_INVALID	ERR_SPW(15)
 
 
 /*
@@ -372,6 +376,54 @@
 #define ERR_DSU_CWP_INVALID		ERR_DSU(1)
 
 
+/**
+ * @def E_RMAP_STATUS
+ *	a reply carried the given error status code (1 to 15), see Table 5-4
+ *	of ECSS-E-ST-50-52C; codes above 15 are reported as reserved
+ *
+ * @def E_RMAP_REPLY_INVALID
+ *	a received packet could not be decoded as an RMAP reply
+ *
+ * @def E_RMAP_REPLY_UNKNOWN
+ *	a reply did not match a pending transaction, e.g. a late reply to a
+ *	transaction that was retransmitted
+ *
+ * @def E_RMAP_REPLY_DATA_LEN
+ *	the data length or the command of a reply does not match its
+ *	transaction
+ *
+ * @def E_RMAP_REPLY_DATA_CRC
+ *	the data CRC of a reply did not match, the data are invalid or the
+ *	packet was truncated
+ *
+ * @def E_RMAP_REPLY_TIMEOUT
+ *	no reply to a transaction arrived in time
+ *
+ * @def E_RMAP_TRANS_DROPPED
+ *	a transaction failed after all retransmissions
+ *
+ * @def E_RMAP_REPLY_HDR_CRC
+ *	the header CRC of a reply did not match, the reply was discarded as
+ *	none of its fields can be trusted
+ */
+
+/*
+ *	rmap errors
+ */
+
+#define ERR_RMAP_OFF	900
+#define ERR_RMAP(x)   (x+ERR_BASE+ERR_RMAP_OFF)
+
+#define E_RMAP_STATUS(s)		ERR_RMAP(s)
+#define E_RMAP_REPLY_INVALID		ERR_RMAP(16)
+#define E_RMAP_REPLY_UNKNOWN		ERR_RMAP(17)
+#define E_RMAP_REPLY_DATA_LEN		ERR_RMAP(18)
+#define E_RMAP_REPLY_DATA_CRC		ERR_RMAP(19)
+#define E_RMAP_REPLY_TIMEOUT		ERR_RMAP(20)
+#define E_RMAP_TRANS_DROPPED		ERR_RMAP(21)
+#define E_RMAP_REPLY_HDR_CRC		ERR_RMAP(22)
+
+
 
 
 #endif
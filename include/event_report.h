@@ -56,7 +56,8 @@ void CrIaEvtRaise(uint8_t subtype, uint16_t id, uint16_t *data, uint32_t size);
 #endif
 
 
-enum error_class {INIT, NOTIFY, FBF, EDAC, CORE1553BRM, GRSPW2, ERRLOG, SYNC};
+enum error_class {INIT, NOTIFY, FBF, EDAC, CORE1553BRM, GRSPW2, ERRLOG, SYNC,
+		  RMAP};
 enum error_severity {NORMAL, LOW, MEDIUM, HIGH};
 
 void event_report(enum error_class c, enum error_severity s, uint32_t err);
@@ -320,6 +320,16 @@
 #define GRSPW2_TX_DESC_WR	0x00002000
 /* packet interrupt enabled    */
 #define GRSPW2_TX_DESC_IE	0x00004000
+/* append header CRC           */
+#define GRSPW2_TX_DESC_HC	0x00010000
+/* append data CRC             */
+#define GRSPW2_TX_DESC_DC	0x00020000
+
+/* non-CRC bytes field         */
+#define GRSPW2_TX_DESC_NON_CRC_BYTES_BIT	8
+#define GRSPW2_TX_DESC_NON_CRC_BYTES_MASK	0x00000F00
+/* header size field           */
+#define GRSPW2_TX_DESC_HDR_SIZE_MASK		0x000000FF
 
 
 
@@ -424,19 +434,20 @@ compile_time_assert((sizeof(struct grspw2_tx_desc) == GRSPW2_TX_DESC_SIZE),
 
 
 /**
- * the descriptor ring elements are tracked in a doubly linked list
+ * the descriptor ring elements are used in the same order as the descriptor
+ * table, see the ring indices in struct grspw2_core_cfg
  */
 
 
 struct grspw2_rx_desc_ring_elem {
 	struct grspw2_rx_desc	*desc;
-	struct list_head	 node;
 };
 
 
 struct grspw2_tx_desc_ring_elem {
 	struct grspw2_tx_desc	*desc;
-	struct list_head	 node;
+	uint32_t		 hdr_buf;	/* private header buffer */
+	uint32_t		 data_buf;	/* private data buffer */
 };
 
 
@@ -454,6 +465,11 @@ struct grspw2_core_cfg {
 	/* points to the register map of a grspw2 core */
 	struct grspw2_regs *regs;
 
+	/* the DMA channel of the core the descriptor rings are used with,
+	 * see grspw2_dma_chan_init()
+	 */
+	uint32_t dma_chan;
+
 	/* the core's interrupt */
 	uint32_t core_irq;
 
@@ -480,17 +496,29 @@ struct grspw2_core_cfg {
 	struct grspw2_tx_desc_ring_elem	tx_desc_ring[GRSPW2_TX_DESCRIPTORS];
 
 	/**
-	 * we use two list heads for each descriptor type to manage active and
-	 * inactive descriptors
-	 * spin-lock protection is fine as long as the lists are only modified
-	 * outside of an ISR or if the ISR may schedule itself to be
-	 * re-executed at a later time when the lock has been released
+	 * each ring is tracked by a producer (head) and a consumer (tail)
+	 * index running from 0 to twice the number of descriptors in the
+	 * table, so a full ring can be told apart from an empty one without
+	 * sacrificing a descriptor; the descriptor of an index is found at
+	 * (index modulo number of descriptors)
+	 *
+	 * head is the next descriptor to be activated, tail the oldest
+	 * descriptor handed to the core; the descriptors in between are owned
+	 * by the core until it clears their enable bit
+	 *
+	 * each index is only ever written by one side and is updated with a
+	 * compiler barrier after the descriptor itself, so no locking is
+	 * needed as long as there is only one producer and one consumer per
+	 * ring, e.g. an ISR releasing descriptors while the main loop adds new
+	 * ones
 	 */
-	struct list_head		rx_desc_ring_used;
-	struct list_head		rx_desc_ring_free;
+	uint32_t			rx_desc_num;
+	uint32_t			rx_desc_head;
+	uint32_t			rx_desc_tail;
 
-	struct list_head		tx_desc_ring_used;
-	struct list_head		tx_desc_ring_free;
+	uint32_t			tx_desc_num;
+	uint32_t			tx_desc_head;
+	uint32_t			tx_desc_tail;
 
 	struct  {
 		uint32_t *rx_desc_tbl;
@@ -523,9 +551,14 @@ int32_t grspw2_rx_desc_table_init(struct grspw2_core_cfg *cfg,
 
 uint32_t grspw2_get_num_pkts_avail(struct grspw2_core_cfg *cfg);
 uint32_t grspw2_get_num_free_tx_desc_avail(struct grspw2_core_cfg *cfg);
+uint32_t grspw2_tx_pkt_pending(struct grspw2_core_cfg *cfg, const void *data);
 
 uint32_t grspw2_get_pkt(struct grspw2_core_cfg *cfg, uint8_t *pkt);
+uint32_t grspw2_peek_pkt(struct grspw2_core_cfg *cfg, uint8_t **pkt);
 uint32_t grspw2_drop_pkt(struct grspw2_core_cfg *cfg);
+uint32_t grspw2_get_pkts(struct grspw2_core_cfg *cfg,
+			 uint8_t **pkts, uint32_t *sizes, uint32_t n);
+uint32_t grspw2_release_pkts(struct grspw2_core_cfg *cfg, uint32_t n);
 uint32_t grspw2_get_next_pkt_size(struct grspw2_core_cfg *cfg);
 
 void grspw2_tick_in(struct grspw2_core_cfg *cfg);
@@ -533,6 +566,8 @@ uint32_t grspw2_get_timecnt(struct grspw2_core_cfg *cfg);
 uint32_t grspw2_get_link_status(struct grspw2_core_cfg *cfg);
 
 void grspw2_tick_out_interrupt_enable(struct grspw2_core_cfg *cfg);
+void grspw2_rx_interrupt_enable(struct grspw2_core_cfg *cfg);
+void grspw2_rx_interrupt_disable(struct grspw2_core_cfg *cfg);
 void grspw2_set_time_rx(struct grspw2_core_cfg *cfg);
 
 int32_t grspw2_add_pkt(struct grspw2_core_cfg *cfg,
@@ -540,9 +575,19 @@ int32_t grspw2_add_pkt(struct grspw2_core_cfg *cfg,
 			uint8_t non_crc_bytes,
 			const void *data, uint32_t data_size);
 
+int32_t grspw2_add_pkt_zero_copy(struct grspw2_core_cfg *cfg,
+				 const void *hdr,  uint32_t hdr_size,
+				 const uint8_t non_crc_bytes,
+				 const void *data, uint32_t data_size);
+
 
 void grspw2_core_start(struct grspw2_core_cfg *cfg);
 
+int32_t grspw2_dma_chan_init(struct grspw2_core_cfg *cfg,
+			     struct grspw2_core_cfg *core,
+			     uint32_t channel, uint8_t addr, uint32_t mtu);
+void grspw2_dma_chan_start(struct grspw2_core_cfg *cfg);
+
 
 int32_t grspw2_core_init(struct grspw2_core_cfg *cfg, uint32_t core_addr,
 			 uint8_t node_addr, uint8_t link_start,
@@ -19,6 +19,7 @@
 #ifndef N_DPU_PKT_H
 #define N_DPU_PKT_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define MODE_RAW_S_FX           100
@@ -78,6 +79,24 @@ int lossy_rounding_32(uint32_t *data_buf, unsigned int samples, unsigned int
 int de_lossy_rounding_32(uint32_t *data_buf, uint32_t samples_used, uint32_t
 			 round_used);
 
+/* the maximum number of 32 bit fields of an N-DPU entry */
+#define N_DPU_FIELDS_MAX	6
+
+/* an N-DPU entry buffer split into one stream per field (structure of arrays) */
+struct n_dpu_streams {
+	uint8_t *exposure_flags;		/* not used for F_ entry types */
+	uint32_t *field[N_DPU_FIELDS_MAX];	/* in the order of the entry */
+};
+
+int n_dpu_get_layout(size_t entry_size, unsigned int *n_fields);
+int n_dpu_split(const void *data_buf, unsigned int samples, size_t entry_size,
+		struct n_dpu_streams *s);
+int n_dpu_join(void *data_buf, unsigned int samples, size_t entry_size,
+	       const struct n_dpu_streams *s);
+int n_dpu_cal_up_model(void *model_buf, const void *data_buf,
+		       unsigned int samples, size_t entry_size,
+		       unsigned int model_value);
+
 /* @see PLATO-LESIA-PL-RP-0031 Issue: 1.9 (N-DPU->ICU data rate) */
 struct __attribute__((packed)) S_FX {
 	uint8_t EXPOSURE_FLAGS;
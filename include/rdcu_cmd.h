@@ -98,11 +98,23 @@
 int rdcu_read_cmd_register(uint16_t trans_id, uint8_t *cmd, uint32_t addr);
 int rdcu_write_cmd_register(uint16_t trans_id, uint8_t *cmd, uint32_t addr);
 
+int rdcu_read_cmd_register_block(uint16_t trans_id, uint8_t *cmd,
+				 uint32_t addr, uint32_t size);
+int rdcu_write_cmd_register_block(uint16_t trans_id, uint8_t *cmd,
+				  uint32_t addr, uint32_t size);
+
 int rdcu_write_cmd_data(uint16_t trans_id, uint8_t *cmd,
 			uint32_t addr, uint32_t size);
 int rdcu_read_cmd_data(uint16_t trans_id, uint8_t *cmd,
 		       uint32_t addr, uint32_t size);
 
+int rdcu_write_cmd_register_at(uint16_t trans_id, uint8_t *cmd,
+			       uint32_t addr, uint32_t size);
+int rdcu_write_cmd_register_noreply(uint16_t trans_id, uint8_t *cmd,
+				    uint32_t addr, uint32_t size);
+int rdcu_rmw_cmd_data(uint16_t trans_id, uint8_t *cmd,
+		      uint32_t addr, uint32_t size);
+
 
 /* RDCU read accessors */
 int rdcu_read_cmd_fpga_version(uint16_t trans_id, uint8_t *cmd);
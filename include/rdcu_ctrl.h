@@ -117,6 +117,18 @@ int rdcu_sync_compr_error(void);
 int rdcu_sync_new_model_addr_used(void);
 int rdcu_sync_samples_used(void);
 
+/* batched register syncs */
+int rdcu_sync_register_block(uint32_t addr, uint32_t n);
+int rdcu_sync_compr_cfg_regs(void);
+int rdcu_sync_compr_info_regs(void);
+
+/* masked single register updates */
+int rdcu_update_register(uint32_t addr, uint32_t val, uint32_t mask);
+int rdcu_poke_register(uint32_t addr, uint32_t val, uint32_t mask);
+int rdcu_start_data_compr(void);
+int rdcu_interrupt_data_compr(void);
+int rdcu_reset_error_cntrs(void);
+
 /* SRAM EDAC registers */
 int rdcu_sync_sram_edac_ctrl(void);
 int rdcu_sync_sram_edac_status(void);
@@ -124,6 +136,16 @@ int rdcu_sync_sram_edac_status(void);
 /* SRAM */
 int rdcu_sync_mirror_to_sram(uint32_t addr, uint32_t size, uint32_t mtu);
 int rdcu_sync_sram_to_mirror(uint32_t addr, uint32_t size, uint32_t mtu);
+int rdcu_sync_dirty_to_sram(uint32_t mtu);
+int rdcu_sync_dirty_range_to_sram(uint32_t addr, uint32_t size, uint32_t mtu);
+int rdcu_write_user_to_sram(const void *buf, uint32_t addr, uint32_t size,
+			    uint32_t width, uint32_t mtu);
+int rdcu_read_sram_to_user(void *buf, uint32_t addr, uint32_t size,
+			   uint32_t width, uint32_t mtu);
+int rdcu_sync_wait(void);
+int rdcu_sram_invalidate(uint32_t addr, uint32_t size);
+int rdcu_sram_add_window(uint32_t addr, uint32_t size, void *buf);
+int rdcu_rmw_sram_32(uint32_t addr, uint32_t val, uint32_t mask);
 
 
 
@@ -275,9 +297,22 @@ int rdcu_write_sram(void *buf, uint32_t addr, uint32_t size);
 int rdcu_write_sram_8(uint8_t *buf, uint32_t addr, uint32_t size);
 int rdcu_write_sram_16(uint16_t *buf, uint32_t addr, uint32_t size);
 int rdcu_write_sram_32(uint32_t *buf, uint32_t addr, uint32_t size);
+int rdcu_write_sram_strided(const void *buf, uint32_t stride, uint32_t width,
+			    uint32_t addr, uint32_t n);
+int rdcu_read_sram_strided(void *buf, uint32_t stride, uint32_t width,
+			   uint32_t addr, uint32_t n);
+
+
+/* an RDCU control context, see rdcu_ctrl_select_ctx() */
+struct rdcu_ctrl_ctx;
 
+struct rdcu_ctrl_ctx *rdcu_ctrl_ctx_alloc(void);
+void rdcu_ctrl_ctx_free(struct rdcu_ctrl_ctx *c);
+void rdcu_ctrl_select_ctx(struct rdcu_ctrl_ctx *c);
+struct rdcu_ctrl_ctx *rdcu_ctrl_get_ctx(void);
 
 int rdcu_ctrl_init(void);
+int rdcu_ctrl_init_sparse(void);
 
 
 #endif /* _RDCU_CTRL_H_ */
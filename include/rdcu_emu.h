@@ -0,0 +1,43 @@
+/**
+ * @file   rdcu_emu.h
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief a loopback RMAP RDCU target emulator
+ */
+
+#ifndef _RDCU_EMU_H_
+#define _RDCU_EMU_H_
+
+#include <stdint.h>
+
+
+#define RDCU_EMU_FPGA_VERSION	0x0106UL	/* reported by the emulator */
+#define RDCU_EMU_QUEUE_SIZE	64		/* max. pending replies */
+
+
+int32_t rdcu_emu_tx(const void *hdr,  uint32_t hdr_size,
+		    const uint8_t non_crc_bytes,
+		    const void *data, uint32_t data_size);
+uint32_t rdcu_emu_rx(uint8_t *pkt);
+uint32_t rdcu_emu_tx_avail(void);
+
+void rdcu_emu_set_link(uint32_t (*time)(void), uint32_t ticks_per_sec,
+		       uint32_t latency, uint32_t bytes_per_sec);
+void rdcu_emu_set_compressor(int enable);
+void rdcu_emu_flush(void);
+
+int rdcu_emu_init(uint8_t addr, uint8_t key);
+void rdcu_emu_exit(void);
+
+#endif /* _RDCU_EMU_H_ */
@@ -0,0 +1,80 @@
+/**
+ * @file   rdcu_hk.h
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief RDCU housekeeping snapshots
+ */
+
+#ifndef _RDCU_HK_H_
+#define _RDCU_HK_H_
+
+#include <stdint.h>
+#include <rdcu_cmd.h>
+
+
+/* the housekeeping registers, up to the first spare address */
+#define RDCU_HK_START	FPGA_VERSION
+#define RDCU_HK_SIZE	(ADC_STATUS - FPGA_VERSION + 4)
+
+
+/**
+ * @brief a housekeeping snapshot, the registers are in cpu order
+ */
+
+struct rdcu_hk {
+	uint32_t seq;			/* number of the snapshot */
+	uint32_t t_req;			/* time the snapshot was requested */
+	uint32_t t_done;		/* time its reply was processed */
+
+	uint32_t fpga_version;
+	uint32_t rdcu_status;
+	uint32_t lvds_core_status;
+	uint32_t spw_link_status;
+	uint32_t spw_err_cntrs;
+	uint32_t rmap_last_err;
+	uint32_t rmap_no_reply_err_cntrs;
+	uint32_t rmap_pckt_err_cntrs;
+	uint32_t adc_values_1;
+	uint32_t adc_values_2;
+	uint32_t adc_values_3;
+	uint32_t adc_values_4;
+	uint32_t adc_status;
+};
+
+
+/**
+ * @brief the bookkeeping of the snapshots
+ */
+
+struct rdcu_hk_stats {
+	uint32_t done;		/* snapshots taken */
+	uint32_t failed;	/* requests dropped by the link */
+	uint32_t skipped;	/* periodic requests not issued */
+};
+
+
+int rdcu_hk_request(void);
+int rdcu_hk_get(struct rdcu_hk *snapshot);
+void rdcu_hk_set_callback(void (*cb)(const struct rdcu_hk *hk,
+				     void *userdata),
+			  void *userdata);
+
+int rdcu_hk_start(uint32_t period);
+void rdcu_hk_stop(void);
+void rdcu_hk_tick(void);
+int32_t rdcu_hk_irq(void *userdata);
+
+void rdcu_hk_get_stats(struct rdcu_hk_stats *stats);
+
+#endif /* _RDCU_HK_H_ */
@@ -21,6 +21,8 @@
 #include <stdint.h>
 
 
+/* an RDCU link context, see rdcu_rmap_select_ctx() */
+struct rdcu_rmap_ctx;
 
 int rdcu_submit_tx(const uint8_t *cmd,  int cmd_size,
 		   const uint8_t *data, int data_size);
@@ -37,6 +39,36 @@ int rdcu_sync_data(int (*fn)(uint16_t trans_id, uint8_t *cmd,
 			     uint32_t addr, uint32_t data_len),
 		   uint32_t addr, void *data, uint32_t data_len, int read);
 
+int rdcu_sync_block(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+			      uint32_t addr, uint32_t data_len),
+		    uint32_t addr, void *data, uint32_t data_len, int read);
+
+int rdcu_sync_async(int (*fn)(uint16_t trans_id, uint8_t *cmd),
+		    void *addr, int data_len,
+		    void (*cb)(uint16_t trans_id, int status, void *userdata),
+		    void *userdata);
+
+int rdcu_sync_data_async(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+				   uint32_t addr, uint32_t data_len),
+			 uint32_t addr, void *data, uint32_t data_len, int read,
+			 void (*cb)(uint16_t trans_id, int status,
+				    void *userdata),
+			 void *userdata);
+
+int rdcu_sync_data_swab(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+				  uint32_t addr, uint32_t data_len),
+			uint32_t addr, void *data, uint32_t data_len, int read,
+			uint32_t width);
+
+int rdcu_sync_rmw(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+			    uint32_t addr, uint32_t data_len),
+		  uint32_t addr, uint32_t *local, uint32_t val, uint32_t mask,
+		  int swap);
+
+int rdcu_sync_noreply(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+				uint32_t addr, uint32_t data_len),
+		      uint32_t addr, void *data, uint32_t data_len);
+
 int rdcu_package(uint8_t *blob,
 		 const uint8_t *cmd,  int cmd_size,
 		 const uint8_t non_crc_bytes,
@@ -47,12 +79,37 @@ void rdcu_set_destination_logical_address(uint8_t addr);
 int rdcu_set_destination_path(uint8_t *path, uint8_t len);
 int rdcu_set_return_path(uint8_t *path, uint8_t len);
 void rdcu_set_source_logical_address(uint8_t addr);
+void rdcu_set_bulk_source_logical_address(uint8_t addr);
 void rdcu_set_destination_key(uint8_t key);
 size_t rdcu_get_data_mtu(void);
 
 int rdcu_rmap_sync_status(void);
+int32_t rdcu_rmap_rx_irq(void *userdata);
 
 void rdcu_rmap_reset_log(void);
+uint32_t rdcu_rmap_get_stat(const char *name);
+
+int rdcu_rmap_set_window(int depth);
+int rdcu_rmap_get_window(void);
+int rdcu_rmap_get_max_window(void);
+void rdcu_rmap_set_tx_avail(uint32_t (*fn)(void));
+
+void rdcu_rmap_set_time_source(uint32_t (*fn)(void));
+uint32_t rdcu_rmap_get_time(void);
+int rdcu_rmap_set_timeout(uint32_t timeout, uint32_t retries);
+
+void rdcu_rmap_set_tx_zero_copy(int32_t (*tx)(const void *hdr,
+					      uint32_t hdr_size,
+					      const uint8_t non_crc_bytes,
+					      const void *data,
+					      uint32_t data_size));
+
+void rdcu_rmap_set_rx_zero_copy(uint32_t (*peek)(uint8_t **pkt),
+				uint32_t (*release)(void));
+
+void rdcu_rmap_set_rx_burst(uint32_t (*get)(uint8_t **pkts, uint32_t *sizes,
+					    uint32_t n),
+			    uint32_t (*release)(uint32_t n));
 
 int rdcu_rmap_init(size_t mtu,
 		   int32_t (*tx)(const void *hdr,  uint32_t hdr_size,
@@ -60,6 +117,11 @@ int rdcu_rmap_init(size_t mtu,
 				 const void *data, uint32_t data_size),
 		   uint32_t (*rx)(uint8_t *pkt));
 
+struct rdcu_rmap_ctx *rdcu_rmap_ctx_alloc(void);
+void rdcu_rmap_ctx_free(struct rdcu_rmap_ctx *c);
+void rdcu_rmap_select_ctx(struct rdcu_rmap_ctx *c);
+struct rdcu_rmap_ctx *rdcu_rmap_get_ctx(void);
+
 
 
 #endif /* _RDCU_RMAP_H_ */
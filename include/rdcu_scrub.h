@@ -0,0 +1,58 @@
+/**
+ * @file   rdcu_scrub.h
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief background scrubbing of the RDCU SRAM
+ */
+
+#ifndef _RDCU_SCRUB_H_
+#define _RDCU_SCRUB_H_
+
+#include <stdint.h>
+#include <rdcu_cmd.h>
+
+
+/* the SRAM is split in regions for the error accounting */
+#define RDCU_SCRUB_REGIONS	16
+#define RDCU_SCRUB_REGION_SIZE	(RDCU_SRAM_SIZE / RDCU_SCRUB_REGIONS)
+
+/* the largest amount of SRAM scrubbed in one step */
+#define RDCU_SCRUB_STEP_MAX	4096
+
+
+/**
+ * @brief the progress and error counters of the scrubber
+ */
+
+struct rdcu_scrub_status {
+	uint32_t cursor;	/* the next SRAM address to scrub */
+	uint32_t passes;	/* completed passes over the SRAM */
+	uint32_t steps;		/* steps read and written back */
+	uint32_t yields;	/* steps deferred for other traffic */
+	uint32_t bypassed;	/* steps skipped as the EDAC was bypassed */
+	uint32_t read_err[RDCU_SCRUB_REGIONS];	/* steps that failed to read */
+	uint32_t mb_err[RDCU_SCRUB_REGIONS];	/* reported multi-bit errors */
+};
+
+
+int rdcu_scrub_init(uint32_t step, uint32_t budget);
+void rdcu_scrub_stop(void);
+
+void rdcu_scrub_tick(void);
+int32_t rdcu_scrub_irq(void *userdata);
+
+void rdcu_scrub_report_mb_err(uint32_t addr, uint32_t size);
+void rdcu_scrub_get_status(struct rdcu_scrub_status *status);
+
+#endif /* _RDCU_SCRUB_H_ */
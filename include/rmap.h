@@ -63,6 +63,19 @@
 #define RMAP_STATUS_RMW_DATA_LEN_ERROR		0xb
 #define RMAP_STATUS_INVALID_TARGET_LOGICAL_ADDR	0xc
 
+/**
+ * classes of RMAP reply status codes, see rmap_status_class()
+ */
+
+enum rmap_err_class {
+	RMAP_ERR_NONE,		/* command executed successfully */
+	RMAP_ERR_TRANSFER,	/* command damaged in transfer, worth a retry */
+	RMAP_ERR_CMD,		/* command malformed or of an unsupported type */
+	RMAP_ERR_AUTH,		/* key, logical address or access rejected */
+	RMAP_ERR_TARGET,	/* general, reserved or unknown target error */
+	RMAP_ERR_CLASSES
+};
+
 
 /**
  * RMAP minimum header sizes, see ECSS‐E‐ST‐50‐52C
@@ -133,6 +146,26 @@
 #define RMAP_MAX_DATA_LEN	   0xFFFFFFUL
 
 
+/**
+ * If RMAP_STATIC_ALLOC is set, packets, their paths and data buffers are taken
+ * from fixed-size pools instead of the heap. The pools may be sized at compile
+ * time; the packet pool matches the number of RDCU transaction log slots, the
+ * data buffers hold up to one maximum size transfer unit each.
+ */
+
+#ifndef RMAP_POOL_PKTS
+#define RMAP_POOL_PKTS			 64
+#endif
+
+#ifndef RMAP_POOL_DATA_BUFS
+#define RMAP_POOL_DATA_BUFS		  4
+#endif
+
+#ifndef RMAP_POOL_DATA_SIZE
+#define RMAP_POOL_DATA_SIZE		4096
+#endif
+
+
 
 __extension__
 struct rmap_instruction {
@@ -190,9 +223,13 @@ struct rmap_pkt {
 
 
 uint8_t rmap_crc8(const uint8_t *buf, const size_t len);
+uint8_t rmap_crc8_init(void);
+uint8_t rmap_crc8_update(uint8_t crc8, const uint8_t *buf, size_t len);
+uint8_t rmap_crc8_final(uint8_t crc8);
 
 struct rmap_pkt *rmap_create_packet(void);
 struct rmap_pkt *rmap_pkt_from_buffer(uint8_t *buf, uint32_t len);
+int rmap_pkt_view_from_buffer(struct rmap_pkt *pkt, uint8_t *buf, uint32_t len);
 int rmap_build_hdr(struct rmap_pkt *pkt, uint8_t *hdr);
 int rmap_set_data_len(struct rmap_pkt *pkt, uint32_t len);
 void rmap_set_data_addr(struct rmap_pkt *pkt, uint32_t addr);
@@ -211,6 +248,8 @@ int rmap_set_dest_path(struct rmap_pkt *pkt, const uint8_t *path, uint8_t len);
 void rmap_erase_packet(struct rmap_pkt *pkt);
 
 
+enum rmap_err_class rmap_status_class(uint8_t status);
+
 void rmap_parse_pkt(uint8_t *pkt);
 
 
@@ -0,0 +1,436 @@
+/**
+ * @file   cmp_batch.c
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief multi-threaded batch (de)compression for PC builds
+ *
+ * The jobs of a batch are grouped into chains: a chain starts with a job that
+ * is not chained and includes all directly following chained jobs, which use
+ * the updated model of their predecessor. The jobs of a chain are executed
+ * in order by a single thread, different chains are independent.
+ *
+ * The chains are distributed evenly over per-thread queues. A thread takes
+ * chains from the back of its own queue; when it runs dry, it steals from the
+ * front of the queues of the other threads, so the load evens out even if
+ * the chains differ in length.
+ *
+ * This is meant for ground segment and EGSE use, it needs POSIX threads
+ * (link with -pthread) and is empty in LEON builds.
+ */
+
+#if !(__sparc__) /* assume PC */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../include/cmp_support.h"
+#include "../include/cmp_icu.h"
+#include "../include/decmp.h"
+#include "../include/cmp_batch.h"
+
+
+/**
+ * @brief the chain queue of a thread
+ */
+
+struct batch_queue {
+	pthread_mutex_t lock;
+	unsigned int head;	/* next chain to steal */
+	unsigned int tail;	/* one past the next chain to take */
+};
+
+
+/**
+ * @brief a batch in progress
+ */
+
+struct batch {
+	void *jobs;
+	unsigned int *chain;	/* the first job of each chain and n_jobs */
+	unsigned int n_chains;
+
+	struct batch_queue *queue;
+	unsigned int n_queues;
+
+	/* execute jobs first...last - 1 of a chain */
+	void (*run)(void *jobs, unsigned int first, unsigned int last);
+};
+
+
+/**
+ * @brief the argument of a worker thread
+ */
+
+struct batch_worker {
+	struct batch *b;
+	unsigned int id;
+	pthread_t thread;
+};
+
+
+/**
+ * @brief take a chain from the back of the own queue
+ *
+ * @param q the queue
+ *
+ * @returns the index of the chain, -1 if the queue is empty
+ */
+
+static int batch_pop(struct batch_queue *q)
+{
+	int c = -1;
+
+
+	pthread_mutex_lock(&q->lock);
+
+	if (q->head < q->tail)
+		c = (int) --q->tail;
+
+	pthread_mutex_unlock(&q->lock);
+
+	return c;
+}
+
+
+/**
+ * @brief steal a chain from the front of another queue
+ *
+ * @param q the queue
+ *
+ * @returns the index of the chain, -1 if the queue is empty
+ */
+
+static int batch_steal(struct batch_queue *q)
+{
+	int c = -1;
+
+
+	pthread_mutex_lock(&q->lock);
+
+	if (q->head < q->tail)
+		c = (int) q->head++;
+
+	pthread_mutex_unlock(&q->lock);
+
+	return c;
+}
+
+
+/**
+ * @brief execute chains until all queues are empty
+ *
+ * @param arg the worker (struct batch_worker)
+ *
+ * @returns NULL
+ */
+
+static void *batch_work(void *arg)
+{
+	int c;
+	unsigned int i;
+
+	struct batch_worker *w = (struct batch_worker *) arg;
+	struct batch *b = w->b;
+
+
+	while (1) {
+
+		c = batch_pop(&b->queue[w->id]);
+
+		for (i = 1; c < 0 && i < b->n_queues; i++)
+			c = batch_steal(&b->queue[(w->id + i) % b->n_queues]);
+
+		/* the queues never refill, so we are done */
+		if (c < 0)
+			break;
+
+		b->run(b->jobs, b->chain[c], b->chain[c + 1]);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * @brief execute a batch of jobs
+ *
+ * @param jobs		the array of jobs
+ * @param chained	for every job, whether it continues the chain of its
+ *			predecessor
+ * @param n_jobs	the number of jobs
+ * @param n_threads	the number of threads, 0 for one per online CPU
+ * @param run		the function executing the jobs of a chain
+ *
+ * @returns 0 on success, -1 if the batch could not be set up
+ */
+
+static int batch_run(void *jobs, const int *chained, unsigned int n_jobs,
+		     unsigned int n_threads,
+		     void (*run)(void *jobs, unsigned int first,
+				 unsigned int last))
+{
+	int ret = 0;
+	long n_cpu;
+	unsigned int i;
+	unsigned int n_started = 0;
+
+	struct batch b;
+	struct batch_worker *w = NULL;
+
+
+	if (!n_jobs)
+		return 0;
+
+	if (!n_threads) {
+		n_cpu = sysconf(_SC_NPROCESSORS_ONLN);
+		n_threads = n_cpu > 0 ? (unsigned int) n_cpu : 1;
+	}
+
+	b.jobs  = jobs;
+	b.run   = run;
+	b.chain = (unsigned int *) malloc((n_jobs + 1) * sizeof(unsigned int));
+	if (!b.chain)
+		return -1;
+
+	b.n_chains = 0;
+	for (i = 0; i < n_jobs; i++) {
+		if (!i || !chained[i])
+			b.chain[b.n_chains++] = i;
+	}
+	b.chain[b.n_chains] = n_jobs;
+
+	if (n_threads > b.n_chains)
+		n_threads = b.n_chains;
+
+	b.n_queues = n_threads;
+	b.queue = (struct batch_queue *) malloc(n_threads *
+						sizeof(struct batch_queue));
+	w = (struct batch_worker *) malloc(n_threads *
+					   sizeof(struct batch_worker));
+	if (!b.queue || !w) {
+		ret = -1;
+		goto cleanup;
+	}
+
+	/* an even share of consecutive chains per thread */
+	for (i = 0; i < n_threads; i++) {
+		pthread_mutex_init(&b.queue[i].lock, NULL);
+		b.queue[i].head = (unsigned int)
+			((unsigned long) b.n_chains * i / n_threads);
+		b.queue[i].tail = (unsigned int)
+			((unsigned long) b.n_chains * (i + 1) / n_threads);
+	}
+
+	for (i = 0; i < n_threads; i++) {
+		w[i].b  = &b;
+		w[i].id = i;
+	}
+
+	/* the calling thread is the first worker */
+	for (i = 1; i < n_threads; i++) {
+		if (pthread_create(&w[i].thread, NULL, batch_work, &w[i])) {
+			printf("Error: could not start batch thread %u, "
+			       "continuing with %u.\n", i, i);
+			break;
+		}
+		n_started++;
+	}
+
+	batch_work(&w[0]);
+
+	for (i = 1; i <= n_started; i++)
+		pthread_join(w[i].thread, NULL);
+
+	for (i = 0; i < n_threads; i++)
+		pthread_mutex_destroy(&b.queue[i].lock);
+
+cleanup:
+	free(w);
+	free(b.queue);
+	free(b.chain);
+
+	return ret;
+}
+
+
+/**
+ * @brief compress the jobs of a chain
+ *
+ * @param jobs	the array of struct cmp_job
+ * @param first	the first job of the chain
+ * @param last	one past the last job of the chain
+ */
+
+static void run_cmp_chain(void *jobs, unsigned int first, unsigned int last)
+{
+	unsigned int i;
+	struct cmp_job *j = (struct cmp_job *) jobs;
+
+
+	for (i = first; i < last; i++) {
+
+		if (i != first) {
+			/* the chain is broken */
+			if (j[i - 1].status || !j[i - 1].cfg.icu_new_model_buf) {
+				j[i].status = -1;
+				continue;
+			}
+			j[i].cfg.model_buf = j[i - 1].cfg.icu_new_model_buf;
+		}
+
+		j[i].status = icu_compress_data(&j[i].cfg, &j[i].info);
+	}
+}
+
+
+/**
+ * @brief decompress the jobs of a chain
+ *
+ * @param jobs	the array of struct decmp_job
+ * @param first	the first job of the chain
+ * @param last	one past the last job of the chain
+ */
+
+static void run_decmp_chain(void *jobs, unsigned int first, unsigned int last)
+{
+	unsigned int i;
+	struct decmp_job *j = (struct decmp_job *) jobs;
+
+
+	for (i = first; i < last; i++) {
+
+		if (i != first) {
+			/* the chain is broken */
+			if (j[i - 1].status < 0 || !j[i - 1].up_model_buf) {
+				j[i].status = -1;
+				continue;
+			}
+			j[i].model_buf = j[i - 1].up_model_buf;
+		}
+
+		j[i].status = decompress_data(j[i].compressed_data,
+					      j[i].model_buf, j[i].info,
+					      j[i].decompressed_data,
+					      j[i].up_model_buf);
+	}
+}
+
+
+/**
+ * @brief compress a batch of jobs in software, using several threads
+ *
+ * @param jobs		the array of jobs
+ * @param n_jobs	the number of jobs
+ * @param n_threads	the number of threads, 0 for one per online CPU
+ *
+ * @note the jobs of a model chain are compressed in order, independent
+ *	 chains in parallel; if a job of a chain fails, the following jobs of
+ *	 the chain fail as well
+ * @note in a chained job, cfg.model_buf is set to the updated model buffer
+ *	 of the previous job
+ *
+ * @returns the number of failed jobs, -1 on error
+ */
+
+int icu_compress_batch(struct cmp_job *jobs, unsigned int n_jobs,
+		       unsigned int n_threads)
+{
+	int ret;
+	int n_fail = 0;
+	unsigned int i;
+
+	int *chained;
+
+
+	if (!jobs && n_jobs)
+		return -1;
+
+	chained = (int *) malloc((n_jobs + 1) * sizeof(int));
+	if (!chained)
+		return -1;
+
+	for (i = 0; i < n_jobs; i++)
+		chained[i] = jobs[i].chained;
+
+	ret = batch_run(jobs, chained, n_jobs, n_threads, run_cmp_chain);
+
+	free(chained);
+
+	if (ret)
+		return -1;
+
+	for (i = 0; i < n_jobs; i++) {
+		if (jobs[i].status)
+			n_fail++;
+	}
+
+	return n_fail;
+}
+
+
+/**
+ * @brief decompress a batch of jobs, using several threads
+ *
+ * @param jobs		the array of jobs
+ * @param n_jobs	the number of jobs
+ * @param n_threads	the number of threads, 0 for one per online CPU
+ *
+ * @note the jobs of a model chain are decompressed in order, independent
+ *	 chains in parallel; if a job of a chain fails, the following jobs of
+ *	 the chain fail as well
+ * @note in a chained job, model_buf is set to the updated model buffer of
+ *	 the previous job
+ *
+ * @returns the number of failed jobs, -1 on error
+ */
+
+int decompress_batch(struct decmp_job *jobs, unsigned int n_jobs,
+		     unsigned int n_threads)
+{
+	int ret;
+	int n_fail = 0;
+	unsigned int i;
+
+	int *chained;
+
+
+	if (!jobs && n_jobs)
+		return -1;
+
+	chained = (int *) malloc((n_jobs + 1) * sizeof(int));
+	if (!chained)
+		return -1;
+
+	for (i = 0; i < n_jobs; i++)
+		chained[i] = jobs[i].chained;
+
+	ret = batch_run(jobs, chained, n_jobs, n_threads, run_decmp_chain);
+
+	free(chained);
+
+	if (ret)
+		return -1;
+
+	for (i = 0; i < n_jobs; i++) {
+		if (jobs[i].status < 0)
+			n_fail++;
+	}
+
+	return n_fail;
+}
+
+#endif /* __sparc__ */
@@ -0,0 +1,897 @@
+/**
+ * @file   cmp_icu.c
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief software compressor implementing the RDCU compression algorithm
+ * @see Data Compression User Manual PLATO-UVIE-PL-UM-0001
+ *
+ * The bitstream is generated in the same format as the RDCU writes it to its
+ * SRAM: code words are packed MSB first into big-endian 32 bit words, the
+ * last word is padded with zeros.
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <byteorder.h>
+
+#include "../include/cmp_support.h"
+#include "../include/cmp_icu.h"
+
+
+/* the sample width of the RDCU compression modes */
+#define CMP_SAMPLE_BITS	16
+
+
+/**
+ * @brief a bit writer emitting whole 32 bit words
+ */
+
+struct bit_writer {
+	uint32_t *dst;		/* next word in the output buffer */
+	uint32_t *end;		/* end of the output buffer */
+	uint32_t cache;		/* pending bits, MSB aligned */
+	uint32_t n_cache;	/* number of pending bits */
+	uint32_t n_bits;	/* total number of bits written */
+	int overflow;		/* set if the output buffer was too small */
+};
+
+
+/**
+ * @brief the setup of the Golomb encoder
+ */
+
+struct encoder_setup {
+	uint32_t golomb_par;	/* Golomb parameter */
+	uint32_t len0;		/* code word length of group 0 */
+	uint32_t cutoff;	/* number of code words in group 0 */
+	uint32_t spill;		/* spillover threshold */
+	int rice;		/* Golomb parameter is a power of two */
+};
+
+
+/**
+ * @brief initialise a bit writer
+ *
+ * @param bw		the bit writer
+ * @param buf		the output buffer (may be NULL to count bits only)
+ * @param n_words	the size of the output buffer in 32 bit words
+ */
+
+static void bw_init(struct bit_writer *bw, void *buf, uint32_t n_words)
+{
+	bw->dst      = (uint32_t *) buf;
+	bw->end      = bw->dst + n_words;
+	bw->cache    = 0;
+	bw->n_cache  = 0;
+	bw->n_bits   = 0;
+	bw->overflow = 0;
+
+	if (!buf)
+		bw->end = NULL;
+}
+
+
+/**
+ * @brief write a full word to the output buffer
+ *
+ * @param bw	the bit writer
+ * @param word	the word to write
+ */
+
+static void bw_emit(struct bit_writer *bw, uint32_t word)
+{
+	if (!bw->dst)
+		return;
+
+	if (bw->dst >= bw->end) {
+		bw->overflow = 1;
+		return;
+	}
+
+	(*bw->dst++) = cpu_to_be32(word);
+}
+
+
+/**
+ * @brief append a number of bits to the bitstream
+ *
+ * @param bw	the bit writer
+ * @param value	the value to put, right aligned
+ * @param n	the number of bits to put (0...32)
+ */
+
+static void bw_put(struct bit_writer *bw, uint32_t value, uint32_t n)
+{
+	uint32_t free_bits;
+
+
+	if (!n)
+		return;
+
+	if (n < 32)
+		value &= (1UL << n) - 1;
+
+	bw->n_bits += n;
+
+	free_bits = 32 - bw->n_cache;
+
+	if (n < free_bits) {
+		bw->cache   |= value << (free_bits - n);
+		bw->n_cache += n;
+		return;
+	}
+
+	/* fill up the cache and emit it, keep the remaining bits */
+	bw->cache |= value >> (n - free_bits);
+	bw_emit(bw, bw->cache);
+
+	bw->n_cache = n - free_bits;
+
+	if (bw->n_cache)
+		bw->cache = value << (32 - bw->n_cache);
+	else
+		bw->cache = 0;
+}
+
+
+/**
+ * @brief write the pending bits to the output buffer, padded with zeros
+ *
+ * @param bw	the bit writer
+ */
+
+static void bw_flush(struct bit_writer *bw)
+{
+	if (!bw->n_cache)
+		return;
+
+	bw_emit(bw, bw->cache);
+
+	bw->cache   = 0;
+	bw->n_cache = 0;
+}
+
+
+/**
+ * @brief map a signed 16 bit difference to a positive number
+ *	  (0, -1, 1, -2, 2, ... -> 0, 1, 2, 3, 4, ...)
+ *
+ * @param value the difference, only the lower 16 bits are used
+ *
+ * @returns the mapped value
+ */
+
+static uint32_t map_to_pos(uint32_t value)
+{
+	value &= 0xFFFF;
+
+	if (value & 0x8000)
+		return ((0x10000 - value) << 1) - 1;
+
+	return value << 1;
+}
+
+
+/**
+ * @brief set up the Golomb encoder
+ *
+ * @param setup		the setup to fill
+ * @param golomb_par	the Golomb parameter (> 0)
+ * @param spill		the spillover threshold
+ */
+
+static void encoder_setup(struct encoder_setup *setup, uint32_t golomb_par,
+			  uint32_t spill)
+{
+	setup->golomb_par = golomb_par;
+	setup->len0       = (uint32_t) ilog_2(golomb_par) + 1;
+	setup->cutoff     = (1UL << setup->len0) - golomb_par;
+	setup->spill      = spill;
+	setup->rice       = is_a_pow_of_2(golomb_par);
+}
+
+
+/**
+ * @brief encode a value with a Golomb code word and append it
+ *
+ * @param bw	the bit writer
+ * @param setup	the encoder setup
+ * @param value	the value to encode
+ *
+ * @returns 0 on success, -1 if the code word would exceed 32 bits
+ */
+
+static int encode_normal(struct bit_writer *bw,
+			 const struct encoder_setup *setup, uint32_t value)
+{
+	uint32_t g;
+	uint32_t cw;
+	uint32_t len;
+
+
+	if (value < setup->cutoff) {
+		/* group 0 */
+		bw_put(bw, value, setup->len0);
+		return 0;
+	}
+
+	g   = (value - setup->cutoff) / setup->golomb_par;
+	len = setup->len0 + 1 + g;
+
+	if (len > 32)
+		return -1;
+
+	/* base code word of the group plus the offset within */
+	cw = (setup->cutoff << 1) + (value - setup->cutoff - g * setup->golomb_par);
+
+	/* prepend the unary prefix */
+	if (g)
+		cw |= ((1UL << g) - 1) << (setup->len0 + 1);
+
+	bw_put(bw, cw, len);
+
+	return 0;
+}
+
+
+/**
+ * @brief encode a value with a Rice code word and append it
+ *
+ * @param bw	the bit writer
+ * @param setup	the encoder setup, the Golomb parameter is a power of two
+ * @param value	the value to encode
+ *
+ * @note for a Golomb parameter of 2^k, the code word of encode_normal() is
+ *	 the quotient value >> k in unary, a zero and the k low bits of the
+ *	 value, so no division is needed
+ *
+ * @returns 0 on success, -1 if the code word would exceed 32 bits
+ */
+
+static int encode_rice(struct bit_writer *bw,
+		       const struct encoder_setup *setup, uint32_t value)
+{
+	uint32_t q;
+	uint32_t cw;
+	uint32_t len;
+
+
+	q   = value >> (setup->len0 - 1);
+	len = q + setup->len0;
+
+	if (len > 32)
+		return -1;
+
+	cw = value & (setup->golomb_par - 1);
+
+	/* prepend the unary prefix */
+	if (q)
+		cw |= ((1UL << q) - 1) << setup->len0;
+
+	bw_put(bw, cw, len);
+
+	return 0;
+}
+
+
+/**
+ * @brief encode a mapped value using the zero escape symbol mechanism
+ *
+ * @param bw	 the bit writer
+ * @param setup	 the encoder setup
+ * @param mapped the mapped value
+ * @param rice	 0: Golomb code, otherwise Rice code (see encode_rice())
+ *
+ * @note every value is incremented by one, so that 0 can serve as escape
+ *	 symbol; outliers are put unencoded after the escape symbol
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+static inline __attribute__((always_inline))
+int encode_value_zero(struct bit_writer *bw, const struct encoder_setup *setup,
+		      uint32_t mapped, const int rice)
+{
+	mapped++;
+
+	if (mapped < setup->spill) {
+		if (rice)
+			return encode_rice(bw, setup, mapped);
+		return encode_normal(bw, setup, mapped);
+	}
+
+	if (encode_normal(bw, setup, 0))
+		return -1;
+
+	bw_put(bw, mapped, CMP_SAMPLE_BITS);
+
+	return 0;
+}
+
+
+/**
+ * @brief encode a mapped value using the multi escape symbol mechanism
+ *
+ * @param bw	 the bit writer
+ * @param setup	 the encoder setup
+ * @param mapped the mapped value
+ * @param rice	 0: Golomb code, otherwise Rice code (see encode_rice())
+ *
+ * @note outliers are put unencoded after an escape symbol, the difference of
+ *	 the escape symbol and the spillover threshold selects the size of the
+ *	 unencoded value: spill + 0 -> 2 bits, spill + 1 -> 4 bits, ...
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+static inline __attribute__((always_inline))
+int encode_value_multi(struct bit_writer *bw, const struct encoder_setup *setup,
+		       uint32_t mapped, const int rice)
+{
+	uint32_t unencoded;
+	uint32_t offset;
+
+
+	if (mapped < setup->spill) {
+		if (rice)
+			return encode_rice(bw, setup, mapped);
+		return encode_normal(bw, setup, mapped);
+	}
+
+	unencoded = mapped - setup->spill;
+
+	if (unencoded)
+		offset = (uint32_t) ilog_2(unencoded) >> 1;
+	else
+		offset = 0;
+
+	if (encode_normal(bw, setup, setup->spill + offset))
+		return -1;
+
+	bw_put(bw, unencoded, (offset + 1) << 1);
+
+	return 0;
+}
+
+
+/**
+ * @brief calculate the updated model of a 16 bit sample
+ *
+ * @param data		the (rounded back) data
+ * @param model		the (rounded back) model
+ * @param model_value	the model weighting parameter (<= MAX_MODEL_VALUE)
+ *
+ * @returns the updated model, the same as cal_up_model()
+ *
+ * @note the products fit into 32 bits for 16 bit samples, so this avoids the
+ *	 64 bit arithmetic of cal_up_model() in the inner loop
+ */
+
+static inline uint32_t up_model_16(uint32_t data, uint32_t model,
+				   uint32_t model_value)
+{
+	return (model * model_value + data * (MAX_MODEL_VALUE - model_value)) /
+		MAX_MODEL_VALUE;
+}
+
+
+/**
+ * @brief encode the samples of a compression
+ *
+ * @param bw		the bit writer
+ * @param setup		the encoder setup
+ * @param cfg		configuration contains all parameters required for
+ *			compression
+ * @param model_mode	0: 1d-differencing, otherwise model mode
+ * @param zero		0: multi escape symbol mechanism, otherwise zero
+ *			escape symbol mechanism
+ * @param update	0: no updated model, otherwise the updated model is
+ *			written to icu_new_model_buf
+ * @param rice		0: Golomb code, otherwise Rice code; the Golomb
+ *			parameter must be a power of two
+ *
+ * @note this is always inlined and only ever called with constant flags, so
+ *	 the compiler generates a separate loop for every combination; the
+ *	 mode decisions are not made per sample
+ *
+ * @returns 0 on success, -1 if a code word would exceed 32 bits
+ */
+
+static inline __attribute__((always_inline))
+int encode_samples(struct bit_writer *bw, const struct encoder_setup *setup,
+		   const struct cmp_cfg *cfg, const int model_mode,
+		   const int zero, const int update, const int rice)
+{
+	uint32_t i;
+	uint32_t d, m;
+	uint32_t prev = 0;
+	uint32_t mapped;
+	int err;
+
+	const uint32_t round = cfg->round;
+	const uint32_t model_value = cfg->model_value;
+	const uint16_t *data  = (const uint16_t *) cfg->input_buf;
+	const uint16_t *model = (const uint16_t *) cfg->model_buf;
+	uint16_t *up_model    = (uint16_t *) cfg->icu_new_model_buf;
+
+
+	for (i = 0; i < cfg->samples; i++) {
+
+		d = (uint32_t) data[i] >> round;
+
+		if (model_mode) {
+			m = (uint32_t) model[i] >> round;
+			mapped = map_to_pos(d - m);
+
+			/* before encoding, up_model may be the model buffer */
+			if (update)
+				up_model[i] = (uint16_t) up_model_16(d << round,
+								     m << round,
+								     model_value);
+		} else {
+			mapped = map_to_pos(d - prev);
+			prev = d;
+		}
+
+		if (zero)
+			err = encode_value_zero(bw, setup, mapped, rice);
+		else
+			err = encode_value_multi(bw, setup, mapped, rice);
+
+		if (err)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief encode the samples of a compression, with the Rice code if possible
+ *
+ * @note see encode_samples()
+ *
+ * @returns 0 on success, -1 if a code word would exceed 32 bits
+ */
+
+static inline __attribute__((always_inline))
+int encode_mode(struct bit_writer *bw, const struct encoder_setup *setup,
+		const struct cmp_cfg *cfg, const int model_mode,
+		const int zero, const int update)
+{
+	if (setup->rice)
+		return encode_samples(bw, setup, cfg, model_mode, zero, update,
+				      1);
+
+	return encode_samples(bw, setup, cfg, model_mode, zero, update, 0);
+}
+
+
+/**
+ * @brief check the compression parameters like the RDCU does
+ *
+ * @param cfg	configuration contains all parameters required for compression
+ *
+ * @returns the content of the compressor error register
+ */
+
+static uint16_t icu_cmp_cfg_check(const struct cmp_cfg *cfg)
+{
+	uint16_t cmp_err = 0;
+
+
+	if (cfg->cmp_mode > MAX_RDCU_CMP_MODE)
+		cmp_err |= 1U << CMP_MODE_ERR_BIT;
+
+	if (model_mode_is_used(cfg->cmp_mode) &&
+	    cfg->model_value > MAX_MODEL_VALUE)
+		cmp_err |= 1U << MODEL_VALUE_ERR_BIT;
+
+	if (!raw_mode_is_used(cfg->cmp_mode)) {
+		if (cfg->golomb_par < MIN_RDCU_GOLOMB_PAR ||
+		    cfg->golomb_par > MAX_RDCU_GOLOMB_PAR ||
+		    cfg->spill < MIN_RDCU_SPILL ||
+		    cfg->spill > get_max_spill(cfg->golomb_par, cfg->cmp_mode))
+			cmp_err |= 1U << CMP_PAR_ERR_BIT;
+	}
+
+	return cmp_err;
+}
+
+
+/**
+ * @brief compress data on the ICU in software
+ *
+ * @param cfg	configuration contains all parameters required for compression
+ * @param info	compression information of the executed compression
+ *
+ * @note the bitstream is written to icu_output_buf, the updated model (model
+ *	 modes only) to icu_new_model_buf; icu_new_model_buf may be the same
+ *	 buffer as model_buf
+ * @note if icu_output_buf is NULL, only the size of the bitstream is
+ *	 determined
+ * @note only the RDCU compression modes are supported; the semi-adaptive
+ *	 parameters and the rdcu_*_adr fields are ignored
+ * @note in raw mode, the data is copied without rounding
+ * @note the updated model is calculated from the rounded (and rounded back)
+ *	 data and model, so that it can be reproduced by a decompressor
+ *
+ * @returns 0 on success, error otherwise; on a compression error, the
+ *	    cmp_err field of info is set like the RDCU would
+ */
+
+int icu_compress_data(const struct cmp_cfg *cfg, struct cmp_info *info)
+{
+	uint32_t i;
+	int err = 0;
+
+	const uint16_t *data;
+	const uint16_t *model;
+	uint16_t *up_model = NULL;
+
+	struct bit_writer bw;
+	struct encoder_setup setup;
+
+
+	if (!cfg)
+		return -1;
+
+	if (!info)
+		return -1;
+
+	memset(info, 0, sizeof(struct cmp_info));
+
+	info->cmp_mode_used    = cfg->cmp_mode;
+	info->model_value_used = (uint8_t) cfg->model_value;
+	info->round_used       = (uint8_t) cfg->round;
+	info->spill_used       = cfg->spill;
+	info->golomb_par_used  = cfg->golomb_par;
+	info->samples_used     = cfg->samples;
+
+	info->cmp_err = icu_cmp_cfg_check(cfg);
+	if (info->cmp_err)
+		return -1;
+
+	if (cfg->round > MAX_ICU_ROUND) {
+		printf("Error: selected round parameter: %lu is not supported. "
+		       "Largest supported value is: %lu.\n",
+		       cfg->round, MAX_ICU_ROUND);
+		return -1;
+	}
+
+	if (!cfg->input_buf && cfg->samples)
+		return -1;
+
+	data = (const uint16_t *) cfg->input_buf;
+
+	bw_init(&bw, cfg->icu_output_buf,
+		(cfg->buffer_length * SAM2BYT) / sizeof(uint32_t));
+
+	if (raw_mode_is_used(cfg->cmp_mode)) {
+
+		for (i = 0; i < cfg->samples; i++)
+			bw_put(&bw, data[i], CMP_SAMPLE_BITS);
+
+	} else {
+
+		model = (const uint16_t *) cfg->model_buf;
+
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			if (!model && cfg->samples)
+				return -1;
+			up_model = (uint16_t *) cfg->icu_new_model_buf;
+		}
+
+		encoder_setup(&setup, cfg->golomb_par, cfg->spill);
+
+		/* choose the instance of the encoder loop */
+		switch (cfg->cmp_mode) {
+		case MODE_MODEL_ZERO:
+			if (up_model)
+				err = encode_mode(&bw, &setup, cfg, 1, 1, 1);
+			else
+				err = encode_mode(&bw, &setup, cfg, 1, 1, 0);
+			break;
+		case MODE_MODEL_MULTI:
+			if (up_model)
+				err = encode_mode(&bw, &setup, cfg, 1, 0, 1);
+			else
+				err = encode_mode(&bw, &setup, cfg, 1, 0, 0);
+			break;
+		case MODE_DIFF_ZERO:
+			err = encode_mode(&bw, &setup, cfg, 0, 1, 0);
+			break;
+		case MODE_DIFF_MULTI:
+		default:
+			err = encode_mode(&bw, &setup, cfg, 0, 0, 0);
+			break;
+		}
+	}
+
+	bw_flush(&bw);
+
+	info->cmp_size = bw.n_bits;
+
+	if (err) {
+		info->cmp_err |= 1U << CMP_PAR_ERR_BIT;
+		return -1;
+	}
+
+	/* the RDCU limits the bitstream to the buffer length in samples */
+	if (cfg->icu_output_buf &&
+	    (bw.overflow || bw.n_bits > cfg->buffer_length * SAM2BYT * 8)) {
+		info->cmp_err |= 1U << SMALL_BUFFER_ERR_BIT;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief determine the length of the Golomb code word of a value
+ *
+ * @param setup	the encoder setup
+ * @param value	the value to encode
+ *
+ * @returns the code word length in bits, see encode_normal()
+ */
+
+static uint32_t cw_len(const struct encoder_setup *setup, uint32_t value)
+{
+	if (value < setup->cutoff)
+		return setup->len0;
+
+	return setup->len0 + 1 + (value - setup->cutoff) / setup->golomb_par;
+}
+
+
+/**
+ * @brief determine the encoded length of a mapped value
+ *
+ * @param setup	 the encoder setup
+ * @param mapped the mapped value
+ * @param zero	 0: multi escape symbol mechanism, otherwise zero escape
+ *		 symbol mechanism
+ *
+ * @returns the number of bits, see encode_value_zero() and
+ *	    encode_value_multi()
+ */
+
+static uint32_t value_len(const struct encoder_setup *setup, uint32_t mapped,
+			  int zero)
+{
+	uint32_t offset;
+
+
+	if (zero) {
+		if (mapped + 1 < setup->spill)
+			return cw_len(setup, mapped + 1);
+
+		return cw_len(setup, 0) + CMP_SAMPLE_BITS;
+	}
+
+	if (mapped < setup->spill)
+		return cw_len(setup, mapped);
+
+	mapped -= setup->spill;
+
+	if (mapped)
+		offset = (uint32_t) ilog_2(mapped) >> 1;
+	else
+		offset = 0;
+
+	return cw_len(setup, setup->spill + offset) + ((offset + 1) << 1);
+}
+
+
+/**
+ * @brief determine the longest encoded length of any mapped value
+ *
+ * @param setup	the encoder setup
+ * @param zero	0: multi escape symbol mechanism, otherwise zero escape
+ *		symbol mechanism
+ *
+ * @returns the number of bits
+ */
+
+static uint32_t value_len_max(const struct encoder_setup *setup, int zero)
+{
+	uint32_t n;
+	uint32_t n_max;
+
+
+	/* the longest regular code word */
+	n_max = cw_len(setup, setup->spill - 1);
+
+	/* the largest outlier, mapped values have at most 16 bits */
+	n = value_len(setup, 0xFFFF, zero);
+	if (n > n_max)
+		n_max = n;
+
+	return n_max;
+}
+
+
+/**
+ * @brief estimate the best compression mode and parameters for a data set
+ *
+ * @param cfg	configuration of the data set; input_buf, samples, round
+ *		and, for the model modes, model_buf are used, the other
+ *		fields are copied to the recommendation
+ * @param step	the distance between two samples used for the estimate;
+ *		1 uses all of them, larger values trade accuracy for speed
+ * @param rec	the recommended configuration
+ *
+ * @note the code length is computed for every Golomb parameter
+ *	 (MIN_RDCU_GOLOMB_PAR...MAX_RDCU_GOLOMB_PAR) with both escape symbol
+ *	 mechanisms and in the 1d-differencing and, if a model buffer is
+ *	 given, the model modes; the spillover threshold is set where a code
+ *	 word gets longer than an escape symbol followed by an unencoded
+ *	 sample; if no mode beats the raw mode, that is recommended
+ * @note the runner-up Golomb parameters of the recommended mode are set as
+ *	 the semi-adaptive parameters
+ * @note buffer_length is set to the size of the bitstream if every sample
+ *	 were encoded with the longest code word of the recommended mode, so
+ *	 the compression cannot fail with a small buffer error; where SRAM is
+ *	 tight, a buffer sized from the returned estimate plus a margin will
+ *	 usually do
+ *
+ * @returns the estimated size of the bitstream in bits, < 0 on error
+ */
+
+int icu_estimate_cmp_cfg(const struct cmp_cfg *cfg, uint32_t step,
+			 struct cmp_cfg *rec)
+{
+	uint32_t i, g;
+	uint32_t d, m;
+	uint32_t n = 0;
+	uint32_t n_max;
+	uint32_t mapped[2];
+	uint32_t mode, best_mode;
+	uint32_t best_g = 0;
+	uint32_t ap[2] = {0, 0};
+	uint64_t bits;
+
+	const uint16_t *data;
+	const uint16_t *model;
+
+	/* in order of preference for equal sizes */
+	static const uint32_t modes[4] = {MODE_DIFF_ZERO, MODE_MODEL_ZERO,
+					  MODE_DIFF_MULTI, MODE_MODEL_MULTI};
+
+	/* the estimated code length in bits per mode and Golomb parameter */
+	uint32_t len[4][MAX_RDCU_GOLOMB_PAR + 1];
+	struct encoder_setup setup[MAX_RDCU_GOLOMB_PAR + 1];
+
+
+	if (!cfg || !rec)
+		return -1;
+
+	if (!cfg->input_buf || !cfg->samples || !step)
+		return -1;
+
+	if (cfg->round > MAX_ICU_ROUND)
+		return -1;
+
+	data  = (const uint16_t *) cfg->input_buf;
+	model = (const uint16_t *) cfg->model_buf;
+
+	for (g = MIN_RDCU_GOLOMB_PAR; g <= MAX_RDCU_GOLOMB_PAR; g++) {
+
+		encoder_setup(&setup[g], g, 0);
+
+		/* code words beyond this are longer than an escaped sample */
+		setup[g].spill = setup[g].cutoff + CMP_SAMPLE_BITS * g;
+
+		if (setup[g].spill > get_max_spill(g, MODE_DIFF_ZERO))
+			setup[g].spill = get_max_spill(g, MODE_DIFF_ZERO);
+
+		if (setup[g].spill < MIN_RDCU_SPILL)
+			setup[g].spill = MIN_RDCU_SPILL;
+	}
+
+	memset(len, 0, sizeof(len));
+
+	for (i = 0; i < cfg->samples; i += step) {
+
+		d = round_fwd(data[i], cfg->round);
+
+		if (i)
+			mapped[0] = map_to_pos(d - round_fwd(data[i - 1],
+							     cfg->round));
+		else
+			mapped[0] = map_to_pos(d);
+
+		if (model) {
+			m = round_fwd(model[i], cfg->round);
+			mapped[1] = map_to_pos(d - m);
+		} else {
+			mapped[1] = 0;
+		}
+
+		for (g = MIN_RDCU_GOLOMB_PAR; g <= MAX_RDCU_GOLOMB_PAR; g++) {
+			len[0][g] += value_len(&setup[g], mapped[0], 1);
+			len[1][g] += value_len(&setup[g], mapped[1], 1);
+			len[2][g] += value_len(&setup[g], mapped[0], 0);
+			len[3][g] += value_len(&setup[g], mapped[1], 0);
+		}
+
+		n++;
+	}
+
+	/* the raw mode is the one to beat */
+	best_mode = 4;
+	bits = (uint64_t) n * CMP_SAMPLE_BITS;
+
+	for (mode = 0; mode < 4; mode++) {
+
+		if (model_mode_is_used(modes[mode]) && !model)
+			continue;
+
+		for (g = MIN_RDCU_GOLOMB_PAR; g <= MAX_RDCU_GOLOMB_PAR; g++) {
+			if (len[mode][g] < bits) {
+				bits      = len[mode][g];
+				best_mode = mode;
+				best_g    = g;
+			}
+		}
+	}
+
+	(*rec) = (*cfg);
+
+	/* scale to the whole data set */
+	bits = (bits * cfg->samples + n - 1) / n;
+
+	if (best_mode == 4) {
+		rec->cmp_mode = MODE_RAW;
+		rec->buffer_length = (cfg->samples + 1) & ~1U;
+		return (int) bits;
+	}
+
+	/* the two next best parameters for the semi-adaptive compression */
+	for (g = MIN_RDCU_GOLOMB_PAR; g <= MAX_RDCU_GOLOMB_PAR; g++) {
+
+		if (g == best_g)
+			continue;
+
+		if (!ap[0] || len[best_mode][g] < len[best_mode][ap[0]]) {
+			ap[1] = ap[0];
+			ap[0] = g;
+		} else if (!ap[1] ||
+			   len[best_mode][g] < len[best_mode][ap[1]]) {
+			ap[1] = g;
+		}
+	}
+
+	rec->cmp_mode       = modes[best_mode];
+	rec->golomb_par     = best_g;
+	rec->spill          = setup[best_g].spill;
+	rec->ap1_golomb_par = ap[0];
+	rec->ap1_spill      = setup[ap[0]].spill;
+	rec->ap2_golomb_par = ap[1];
+	rec->ap2_spill      = setup[ap[1]].spill;
+
+	n_max = value_len_max(&setup[best_g],
+			      zero_escape_mech_is_used(rec->cmp_mode));
+
+	/* whole 32 bit words, in samples */
+	rec->buffer_length = (uint32_t) ((((uint64_t) cfg->samples * n_max +
+					    31) / 32) * 2);
+
+	return (int) bits;
+}
@@ -19,19 +19,70 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "../include/dlog.h"
 #include "../include/rdcu_cmd.h"
 #include "../include/cmp_support.h"
+#include "../include/n_dpu_pkt.h"
 #include "../include/rdcu_ctrl.h"
 #include "../include/rdcu_rmap.h"
+#include "../include/cmp_rdcu.h"
 
 
 #define RDCU_INTR_SIG_ENA 1 /* RDCU interrupt signal enabled */
 #define RDCU_INTR_SIG_DIS 0 /* RDCU interrupt signal disable */
 #define RDCU_INTR_SIG_DEFAULT RDCU_INTR_SIG_ENA /* default start value for RDCU
 						   interrupt signal */
-/* RDCU interrupt signal status */
-static int interrupt_signal_enabled = RDCU_INTR_SIG_DEFAULT;
+enum rdcu_pipe_state {RDCU_PIPE_IDLE, RDCU_PIPE_LOADED, RDCU_PIPE_ACTIVE,
+		      RDCU_PIPE_DONE};
+
+/**
+ * The compressor control state is kept per RDCU in a unit, together with the
+ * link and control contexts of that RDCU, so several RDCUs can be operated
+ * concurrently (see rdcu_unit_select()). All functions operate on the
+ * selected unit, which is a built-in default one that uses the default link
+ * and control contexts unless another is selected.
+ */
+
+struct rdcu_unit {
+	struct rdcu_rmap_ctx *rmap;	/* the link to the RDCU */
+	struct rdcu_ctrl_ctx *ctrl;	/* the mirror of the RDCU */
+
+	/* RDCU interrupt signal status */
+	int interrupt_signal_enabled;
+
+	/* compression done notification, see rdcu_cmp_done_irq() */
+	struct {
+		void (*cb)(const struct cmp_info *info, int status,
+			   void *userdata);
+		void *userdata;
+		void *output_buf;
+		int enabled;
+		int slot;	/* pipeline slot finished by the interrupt,
+				 * -1 if none
+				 */
+	} cmp_irq;
+
+	/* the compression pipeline, see rdcu_pipe_init() */
+	struct {
+		struct rdcu_pipe_slot slot[RDCU_PIPE_SLOTS_MAX];
+		struct cmp_cfg cfg[RDCU_PIPE_SLOTS_MAX];
+		struct cmp_info info[RDCU_PIPE_SLOTS_MAX];
+		enum rdcu_pipe_state state[RDCU_PIPE_SLOTS_MAX];
+		uint32_t seq[RDCU_PIPE_SLOTS_MAX];	/* load order */
+		uint32_t next_seq;
+		unsigned int n_slots;
+	} pipe;
+};
+
+static struct rdcu_unit unit_default = {
+	.interrupt_signal_enabled = RDCU_INTR_SIG_DEFAULT,
+	.cmp_irq.slot = -1,
+};
+
+static struct rdcu_unit *unit = &unit_default;
 
 
 /**
@@ -112,6 +163,9 @@ static int buffers_overlap(uint32_t start_a, uint32_t end_a, uint32_t start_b,
  * @param cfg	configuration contains all parameters required for compression
  *
  * @returns  >= 0 on success, error otherwise
+ *
+ * @note the reasons for errors and warnings are recorded in the deferred log,
+ *	 see dlog.h
  */
 
 int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
@@ -123,149 +177,149 @@ int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
 		return -1;
 
 	if (cfg->cmp_mode > MAX_RDCU_CMP_MODE) {
-		printf("Error: selected cmp_mode: %lu is not supported. "
-		       "Largest supported mode is: %lu.\n", cfg->cmp_mode,
-		       MAX_RDCU_CMP_MODE);
+		dlog2("Error: selected cmp_mode: %lu is not supported. "
+		      "Largest supported mode is: %lu.\n", cfg->cmp_mode,
+		      MAX_RDCU_CMP_MODE);
 		cfg_invalid++;
 	}
 
 	if (cfg->model_value > MAX_MODEL_VALUE) {
-		printf("Error: selected model_value: %lu is invalid. "
-		       "Largest supported value is: %lu.\n", cfg->model_value,
-		       MAX_MODEL_VALUE);
+		dlog2("Error: selected model_value: %lu is invalid. "
+		      "Largest supported value is: %lu.\n", cfg->model_value,
+		      MAX_MODEL_VALUE);
 		cfg_invalid++;
 	}
 
 	if (cfg->golomb_par < MIN_RDCU_GOLOMB_PAR||
 	    cfg->golomb_par > MAX_RDCU_GOLOMB_PAR) {
-		printf("Error: The selected Golomb parameter: %lu is not supported. "
-		       "The Golomb parameter has to  be between [%lu, %lu].\n",
-		       cfg->golomb_par, MIN_RDCU_GOLOMB_PAR,
-		       MAX_RDCU_GOLOMB_PAR);
+		dlog3("Error: The selected Golomb parameter: %lu is not supported. "
+		      "The Golomb parameter has to  be between [%lu, %lu].\n",
+		      cfg->golomb_par, MIN_RDCU_GOLOMB_PAR,
+		      MAX_RDCU_GOLOMB_PAR);
 		cfg_invalid++;
 	}
 
 	if (cfg->ap1_golomb_par < MIN_RDCU_GOLOMB_PAR ||
 	    cfg->ap1_golomb_par > MAX_RDCU_GOLOMB_PAR) {
-		printf("Error: The selected adaptive 1 Golomb parameter: %lu is not supported. "
-		       "The Golomb parameter has to  be between [%lu, %lu].\n",
-		       cfg->ap1_golomb_par, MIN_RDCU_GOLOMB_PAR,
-		       MAX_RDCU_GOLOMB_PAR);
+		dlog3("Error: The selected adaptive 1 Golomb parameter: %lu is not supported. "
+		      "The Golomb parameter has to  be between [%lu, %lu].\n",
+		      cfg->ap1_golomb_par, MIN_RDCU_GOLOMB_PAR,
+		      MAX_RDCU_GOLOMB_PAR);
 		cfg_invalid++;
 	}
 
 	if (cfg->ap2_golomb_par < MIN_RDCU_GOLOMB_PAR ||
 	    cfg->ap2_golomb_par > MAX_RDCU_GOLOMB_PAR) {
-		printf("Error: The selected adaptive 2 Golomb parameter: %lu is not supported. "
-		       "The Golomb parameter has to be between [%lu, %lu].\n",
-		       cfg->ap2_golomb_par, MIN_RDCU_GOLOMB_PAR,
-		       MAX_RDCU_GOLOMB_PAR);
+		dlog3("Error: The selected adaptive 2 Golomb parameter: %lu is not supported. "
+		      "The Golomb parameter has to be between [%lu, %lu].\n",
+		      cfg->ap2_golomb_par, MIN_RDCU_GOLOMB_PAR,
+		      MAX_RDCU_GOLOMB_PAR);
 		cfg_invalid++;
 	}
 
 	if (cfg->spill < MIN_RDCU_SPILL) {
-		printf("Error: The selected spillover threshold value: %lu is too small. "
-		       "Smallest possible spillover value is: %lu.\n",
-		       cfg->spill, MIN_RDCU_SPILL);
+		dlog2("Error: The selected spillover threshold value: %lu is too small. "
+		      "Smallest possible spillover value is: %lu.\n",
+		      cfg->spill, MIN_RDCU_SPILL);
 		cfg_invalid++;
 	}
 
 	if (cfg->spill > get_max_spill(cfg->golomb_par, cfg->cmp_mode)) {
-		printf("Error: The selected spillover threshold value: %lu is "
-		       "too large for the selected Golomb parameter: %lu, the "
-		       "largest possible spillover value is: %lu.\n",
-		       cfg->spill, cfg->golomb_par,
-		       get_max_spill(cfg->golomb_par, cfg->cmp_mode));
+		dlog3("Error: The selected spillover threshold value: %lu is "
+		      "too large for the selected Golomb parameter: %lu, the "
+		      "largest possible spillover value is: %lu.\n",
+		      cfg->spill, cfg->golomb_par,
+		      get_max_spill(cfg->golomb_par, cfg->cmp_mode));
 		cfg_invalid++;
 	}
 
 	if (cfg->ap1_spill < MIN_RDCU_SPILL) {
-		printf("Error: The selected adaptive 1 spillover threshold "
-		       "value: %lu is too small. "
-		       "Smallest possible spillover value is: %lu.\n",
-		       cfg->ap1_spill, MIN_RDCU_SPILL);
+		dlog2("Error: The selected adaptive 1 spillover threshold "
+		      "value: %lu is too small. "
+		      "Smallest possible spillover value is: %lu.\n",
+		      cfg->ap1_spill, MIN_RDCU_SPILL);
 		cfg_invalid++;
 	}
 
 	if (cfg->ap1_spill > get_max_spill(cfg->ap1_golomb_par, cfg->cmp_mode)) {
-		printf("Error: The selected adaptive 1 spillover threshold "
-		       "value: %lu is too large for the selected adaptive 1 "
-		       "Golomb parameter: %lu, the largest possible adaptive 1 "
-		       "spillover value is: %lu.\n",
-		       cfg->ap1_spill, cfg->ap1_golomb_par,
-		       get_max_spill(cfg->ap1_golomb_par, cfg->cmp_mode));
+		dlog3("Error: The selected adaptive 1 spillover threshold "
+		      "value: %lu is too large for the selected adaptive 1 "
+		      "Golomb parameter: %lu, the largest possible adaptive 1 "
+		      "spillover value is: %lu.\n",
+		      cfg->ap1_spill, cfg->ap1_golomb_par,
+		      get_max_spill(cfg->ap1_golomb_par, cfg->cmp_mode));
 		cfg_invalid++;
 	}
 
 	if (cfg->ap2_spill < MIN_RDCU_SPILL) {
-		printf("Error: The selected adaptive 2 spillover threshold "
-		       "value: %lu is too small."
-		       "Smallest possible spillover value is: %lu.\n",
-		       cfg->ap2_spill, MIN_RDCU_SPILL);
+		dlog2("Error: The selected adaptive 2 spillover threshold "
+		      "value: %lu is too small."
+		      "Smallest possible spillover value is: %lu.\n",
+		      cfg->ap2_spill, MIN_RDCU_SPILL);
 		cfg_invalid++;
 	}
 
 	if (cfg->ap2_spill > get_max_spill(cfg->ap2_golomb_par, cfg->cmp_mode)) {
-		printf("Error: The selected adaptive 2 spillover threshold "
-		       "value: %lu is too large for the selected adaptive 2 "
-		       "Golomb parameter: %lu, the largest possible adaptive 2 "
-		       "spillover value is: %lu.\n",
-		       cfg->ap2_spill, cfg->ap2_golomb_par,
-		       get_max_spill(cfg->ap2_golomb_par, cfg->cmp_mode));
+		dlog3("Error: The selected adaptive 2 spillover threshold "
+		      "value: %lu is too large for the selected adaptive 2 "
+		      "Golomb parameter: %lu, the largest possible adaptive 2 "
+		      "spillover value is: %lu.\n",
+		      cfg->ap2_spill, cfg->ap2_golomb_par,
+		      get_max_spill(cfg->ap2_golomb_par, cfg->cmp_mode));
 		cfg_invalid++;
 	}
 
 	if (cfg->round > MAX_RDCU_ROUND) {
-		printf("Error: selected round parameter: %lu is not supported. "
-		       "Largest supported value is: %lu.\n",
-		       cfg->round, MAX_RDCU_ROUND);
+		dlog2("Error: selected round parameter: %lu is not supported. "
+		      "Largest supported value is: %lu.\n",
+		      cfg->round, MAX_RDCU_ROUND);
 		cfg_invalid++;
 	}
 
 	if (cfg->samples == 0) {
-		printf("Warning: The samples parameter is set to 0. No data will be compressed.\n");
+		dlog0("Warning: The samples parameter is set to 0. No data will be compressed.\n");
 		cfg_warning++;
 	}
 
 	if (cfg->buffer_length == 0) {
-		printf("Error: The buffer_length is set to 0. There is no place "
-		       "to store the compressed data.\n");
+		dlog0("Error: The buffer_length is set to 0. There is no place "
+		      "to store the compressed data.\n");
 		cfg_invalid++;
 	}
 
 	if (cfg->cmp_mode == MODE_RAW) {
 		if (cfg->buffer_length < cfg->samples) {
-			printf("buffer_length is smaller than samples parameter. "
-			       "There is not enough space to copy the data in "
-			       "RAW mode.\n");
+			dlog0("buffer_length is smaller than samples parameter. "
+			      "There is not enough space to copy the data in "
+			      "RAW mode.\n");
 			cfg_invalid++;
 		}
 	}
 
 	if (!cfg->input_buf) {
-		printf("Warning: The data to compress buffer is set to NULL. "
-		       "No data will be transferred to the rdcu_data_adr in  "
-		       "the RDCU-SRAM.\n");
+		dlog0("Warning: The data to compress buffer is set to NULL. "
+		      "No data will be transferred to the rdcu_data_adr in  "
+		      "the RDCU-SRAM.\n");
 		cfg_warning++;
 	}
 
 	if (cfg->rdcu_data_adr & 0x3) {
-		printf("Error: The RDCU data to compress start address is not 4-Byte aligned.\n");
+		dlog0("Error: The RDCU data to compress start address is not 4-Byte aligned.\n");
 		cfg_invalid++;
 	}
 
 	if (cfg->rdcu_buffer_adr & 0x3) {
-		printf("Error: The RDCU compressed data start address is not 4-Byte aligned.\n");
+		dlog0("Error: The RDCU compressed data start address is not 4-Byte aligned.\n");
 		cfg_invalid++;
 	}
 
 	if (!in_sram_range(cfg->rdcu_data_adr, cfg->samples * SAM2BYT)) {
-		printf("Error: The RDCU data to compress buffer is outside the RDCU SRAM address space.\n");
+		dlog0("Error: The RDCU data to compress buffer is outside the RDCU SRAM address space.\n");
 		cfg_invalid++;
 	}
 
 	if (!in_sram_range(cfg->rdcu_buffer_adr, cfg->buffer_length * SAM2BYT)) {
-		printf("Error: The RDCU compressed data buffer is outside the RDCU SRAM address space.\n");
+		dlog0("Error: The RDCU compressed data buffer is outside the RDCU SRAM address space.\n");
 		cfg_invalid++;
 	}
 
@@ -273,32 +327,32 @@ int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
 			    cfg->rdcu_data_adr + cfg->samples * SAM2BYT,
 			    cfg->rdcu_buffer_adr,
 			    cfg->rdcu_buffer_adr + cfg->buffer_length * SAM2BYT)) {
-		printf("Error: The RDCU data to compress buffer and the RDCU "
-		       "compressed data buffer are overlapping.\n");
+		dlog0("Error: The RDCU data to compress buffer and the RDCU "
+		      "compressed data buffer are overlapping.\n");
 		cfg_invalid++;
 	}
 
 	if (model_mode_is_used(cfg->cmp_mode)) {
 		if (cfg->model_buf == cfg->input_buf) {
-			printf("Error: The model buffer (model_buf) and the data "
-			       "to be compressed (input_buf) are equal.");
+			dlog0("Error: The model buffer (model_buf) and the data "
+			      "to be compressed (input_buf) are equal.");
 			cfg_invalid++;
 		}
 
 		if (!cfg->model_buf) {
-			printf("Warning: The model buffer is set to NULL. No "
-			       "model data will be transferred to the "
-			       "rdcu_model_adr in the RDCU-SRAM.\n");
+			dlog0("Warning: The model buffer is set to NULL. No "
+			      "model data will be transferred to the "
+			      "rdcu_model_adr in the RDCU-SRAM.\n");
 			cfg_warning++;
 		}
 
 		if (cfg->rdcu_model_adr & 0x3) {
-			printf("Error: The RDCU model start address is not 4-Byte aligned.\n");
+			dlog0("Error: The RDCU model start address is not 4-Byte aligned.\n");
 			cfg_invalid++;
 		}
 
 		if (!in_sram_range(cfg->rdcu_model_adr, cfg->samples * SAM2BYT)) {
-			printf("Error: The RDCU model buffer is outside the RDCU SRAM address space.\n");
+			dlog0("Error: The RDCU model buffer is outside the RDCU SRAM address space.\n");
 			cfg_invalid++;
 		}
 
@@ -307,7 +361,7 @@ int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
 			    cfg->rdcu_model_adr + cfg->samples * SAM2BYT,
 			    cfg->rdcu_data_adr,
 			    cfg->rdcu_data_adr + cfg->samples * SAM2BYT)) {
-			printf("Error: The model buffer and the data to compress buffer are overlapping.\n");
+			dlog0("Error: The model buffer and the data to compress buffer are overlapping.\n");
 			cfg_invalid++;
 		}
 
@@ -317,21 +371,21 @@ int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
 			cfg->rdcu_buffer_adr,
 			cfg->rdcu_buffer_adr + cfg->buffer_length * SAM2BYT)
 		    ){
-			printf("Error: The model buffer and the compressed data buffer are overlapping.\n");
+			dlog0("Error: The model buffer and the compressed data buffer are overlapping.\n");
 			cfg_invalid++;
 		}
 
 		if (cfg->rdcu_model_adr != cfg->rdcu_new_model_adr) {
 			if (cfg->rdcu_new_model_adr & 0x3) {
-				printf("Error: The RDCU updated model start address "
-				       "(rdcu_new_model_adr) is not 4-Byte aligned.\n");
+				dlog0("Error: The RDCU updated model start address "
+				      "(rdcu_new_model_adr) is not 4-Byte aligned.\n");
 				cfg_invalid++;
 			}
 
 			if (!in_sram_range(cfg->rdcu_new_model_adr,
 					   cfg->samples * SAM2BYT)) {
-				printf("Error: The RDCU updated model buffer is "
-				       "outside the RDCU SRAM address space.\n");
+				dlog0("Error: The RDCU updated model buffer is "
+				      "outside the RDCU SRAM address space.\n");
 				cfg_invalid++;
 			}
 
@@ -341,8 +395,8 @@ int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
 				cfg->rdcu_data_adr,
 				cfg->rdcu_data_adr + cfg->samples * SAM2BYT)
 			    ){
-				printf("Error: The updated model buffer and the data to "
-				       "compress buffer are overlapping.\n");
+				dlog0("Error: The updated model buffer and the data to "
+				      "compress buffer are overlapping.\n");
 				cfg_invalid++;
 			}
 
@@ -352,8 +406,8 @@ int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
 				cfg->rdcu_buffer_adr,
 				cfg->rdcu_buffer_adr + cfg->buffer_length * SAM2BYT)
 			    ){
-				printf("Error: The updated model buffer and the compressed "
-				       "data buffer are overlapping.\n");
+				dlog0("Error: The updated model buffer and the compressed "
+				      "data buffer are overlapping.\n");
 				cfg_invalid++;
 			}
 			if (buffers_overlap(
@@ -362,22 +416,22 @@ int rdcu_cmp_cfg_valid(const struct cmp_cfg *cfg)
 				cfg->rdcu_model_adr,
 				cfg->rdcu_model_adr + cfg->samples * SAM2BYT)
 			    ){
-				printf("Error: The updated model buffer and the "
-				       "model buffer are overlapping.\n");
+				dlog0("Error: The updated model buffer and the "
+				      "model buffer are overlapping.\n");
 				cfg_invalid++;
 			}
 		}
 	}
 
 	if (cfg->icu_new_model_buf) {
-		printf("Warning: ICU updated model buffer is set. This "
-		       "buffer is not used for an RDCU compression.\n");
+		dlog0("Warning: ICU updated model buffer is set. This "
+		      "buffer is not used for an RDCU compression.\n");
 		cfg_warning++;
 	}
 
 	if (cfg->icu_output_buf) {
-		printf("Warning: ICU compressed data buffer is set. This "
-		       "buffer is not used for an RDCU compression.\n");
+		dlog0("Warning: ICU compressed data buffer is set. This "
+		      "buffer is not used for an RDCU compression.\n");
 		cfg_warning++;
 	}
 
@@ -437,26 +491,8 @@ int rdcu_set_compression_register(const struct cmp_cfg *cfg)
 	if (rdcu_set_compr_data_buf_len(cfg->buffer_length))
 		return -1;
 
-	/* now sync the configuration registers to the RDCU... */
-	if (rdcu_sync_compressor_param1())
-		return -1;
-	if (rdcu_sync_compressor_param2())
-		return -1;
-	if (rdcu_sync_adaptive_param1())
-		return -1;
-	if (rdcu_sync_adaptive_param2())
-		return -1;
-	if (rdcu_sync_data_start_addr())
-		return -1;
-	if (rdcu_sync_model_start_addr())
-		return -1;
-	if (rdcu_sync_num_samples())
-		return -1;
-	if (rdcu_sync_new_model_start_addr())
-		return -1;
-	if (rdcu_sync_compr_data_buf_start_addr())
-		return -1;
-	if (rdcu_sync_compr_data_buf_len())
+	/* now sync the configuration registers to the RDCU in one go... */
+	if (rdcu_sync_compr_cfg_regs())
 		return -1;
 
 	return 0;
@@ -473,7 +509,7 @@ int rdcu_set_compression_register(const struct cmp_cfg *cfg)
 
 int rdcu_start_compression(void)
 {
-	if (interrupt_signal_enabled) {
+	if (unit->interrupt_signal_enabled) {
 		/* enable the interrupt signal to the ICU */
 		rdcu_set_rdcu_interrupt();
 	} else {
@@ -481,18 +517,11 @@ int rdcu_start_compression(void)
 		rdcu_clear_rdcu_interrupt();
 	}
 
-	/* start the compression */
-	rdcu_set_data_compr_start();
-	if (rdcu_sync_compr_ctrl())
+	/* start the compression, the interrupt signal goes in the same write */
+	if (rdcu_start_data_compr())
 		return -1;
 	sync();
 
-	/* clear local bit immediately, this is a write-only register.
-	 * we would not want to restart compression by accidentally calling
-	 * rdcu_sync_compr_ctrl() again
-	 */
-	rdcu_clear_data_compr_start();
-
 	return 0;
 }
 
@@ -508,6 +537,16 @@ int rdcu_start_compression(void)
  * @note the overlapping of the different rdcu buffers is not checked
  * @note the validity of the cfg structure is checked before the compression is
  *	 started
+ * @note the data are sent directly from the input buffer; only the parts of
+ *	 the model that differ from what is known to be in the RDCU SRAM are
+ *	 transferred, see rdcu_sync_dirty_range_to_sram()
+ * @note all transfers have completed or were dropped when this returns, so
+ *	 the input buffer may be reused right away
+ * @note without an input buffer, the modified parts of the data already in
+ *	 the local SRAM mirror are transferred
+ * @note only the data and model buffers are written to, so they may share
+ *	 SRAM pages with buffers of a previous compression that were not yet
+ *	 read back
  *
  * @returns 0 on success, error otherwise
  */
@@ -521,41 +560,56 @@ int rdcu_compress_data(const struct cmp_cfg *cfg)
 		return -1;
 
 	if (cfg->input_buf != NULL) {
-		/* round up needed size must be a multiple of 4 bytes */
-		uint32_t size = (cfg->samples * 2 + 3) & ~3U;
-		/* now set the data in the local mirror... */
-		if (rdcu_write_sram_16(cfg->input_buf, cfg->rdcu_data_adr,
-				       cfg->samples * 2) < 0)
+		/* now send the data, they are new every time... */
+		if (rdcu_write_user_to_sram(cfg->input_buf, cfg->rdcu_data_adr,
+					    cfg->samples * 2, sizeof(uint16_t),
+					    rdcu_get_data_mtu()))
 			return -1;
-		if (rdcu_sync_mirror_to_sram(cfg->rdcu_data_adr, size,
-					     rdcu_get_data_mtu()))
+	} else {
+		/* ...or whatever changed of them in the local mirror... */
+		if (rdcu_sync_dirty_range_to_sram(cfg->rdcu_data_adr,
+						  cfg->samples * 2,
+						  rdcu_get_data_mtu()))
 			return -1;
 	}
 	/*...and the model when needed */
-	if (cfg->model_buf != NULL) {
-		/* set model only when model mode is used */
-		if (model_mode_is_used(cfg->cmp_mode)) {
-			/* round up needed size must be a multiple of 4 bytes */
-			uint32_t size = (cfg->samples * 2 + 3) & ~3U;
-			/* set the model in the local mirror... */
+	if (model_mode_is_used(cfg->cmp_mode)) {
+		/* set the model in the local mirror... */
+		if (cfg->model_buf != NULL) {
 			if (rdcu_write_sram_16(cfg->model_buf,
 					       cfg->rdcu_model_adr,
 					       cfg->samples * 2) < 0)
-				return -1;
-			if (rdcu_sync_mirror_to_sram(cfg->rdcu_model_adr, size,
-						     rdcu_get_data_mtu()))
-				return -1;
+				goto error;
 		}
+
+		/* ...and transfer whatever changed to the RDCU... */
+		if (rdcu_sync_dirty_range_to_sram(cfg->rdcu_model_adr,
+						  cfg->samples * 2,
+						  rdcu_get_data_mtu()))
+			goto error;
 	}
 
 	/* ...and wait for completion */
-	sync();
+	if (rdcu_sync_wait())
+		return -1;
 
 	/* start the compression */
 	if (rdcu_start_compression())
 		return -1;
 
+	/* the RDCU now writes to these, so our mirror is no longer up to date */
+	if (model_mode_is_used(cfg->cmp_mode))
+		rdcu_sram_invalidate(cfg->rdcu_new_model_adr, cfg->samples * 2);
+
+	rdcu_sram_invalidate(cfg->rdcu_buffer_adr, cfg->buffer_length * 2);
+
 	return 0;
+
+error:
+	/* the input buffer is referenced until the transfers completed */
+	rdcu_sync_wait();
+
+	return -1;
 }
 
 
@@ -600,24 +654,8 @@ int rdcu_read_cmp_status(struct cmp_status *status)
 
 int rdcu_read_cmp_info(struct cmp_info *info)
 {
-	/* read out the compressor information register*/
-	if (rdcu_sync_used_param1())
-		return -1;
-	if (rdcu_sync_used_param2())
-		return -1;
-	if (rdcu_sync_compr_data_start_addr())
-		return -1;
-	if (rdcu_sync_compr_data_size())
-		return -1;
-	if (rdcu_sync_compr_data_adaptive_1_size())
-		return -1;
-	if (rdcu_sync_compr_data_adaptive_2_size())
-		return -1;
-	if (rdcu_sync_compr_error())
-		return -1;
-	if (rdcu_sync_new_model_addr_used())
-		return -1;
-	if (rdcu_sync_samples_used())
+	/* read out the compressor information registers in one go */
+	if (rdcu_sync_compr_info_regs())
 		return -1;
 
 	sync();
@@ -649,6 +687,8 @@ int rdcu_read_cmp_info(struct cmp_info *info)
  * @param output_buf  the buffer to store the bitstream (if NULL, the required
  *		      size is returned)
  *
+ * @note the transfer has completed or was dropped when this returns
+ *
  * @returns the number of bytes read, < 0 on error
  */
 
@@ -665,14 +705,16 @@ int rdcu_read_cmp_bitstream(const struct cmp_info *info, void *output_buf)
 	if (output_buf == NULL)
 		return (int)s;
 
-	if (rdcu_sync_sram_to_mirror(info->rdcu_cmp_adr_used, s,
-				     rdcu_get_data_mtu()))
+	/* the bitstream is a byte image, read it straight into the buffer */
+	if (rdcu_read_sram_to_user(output_buf, info->rdcu_cmp_adr_used, s, 1,
+				   rdcu_get_data_mtu()))
 		return -1;
 
 	/* wait for it */
-	sync();
+	if (rdcu_sync_wait())
+		return -1;
 
-	return rdcu_read_sram(output_buf, info->rdcu_cmp_adr_used, s);
+	return (int)s;
 }
 
 
@@ -684,6 +726,12 @@ int rdcu_read_cmp_bitstream(const struct cmp_info *info, void *output_buf)
  * @param model_buf  the buffer to store the model (if NULL, the required size
  *		     is returned)
  *
+ * @note a local copy of the model can be kept up to date with
+ *	 cal_up_model_buf() instead, so the model needs to be read back only
+ *	 to verify it once in a while
+ * @note the model is stored as 16 bit values in cpu order
+ * @note the transfer has completed or was dropped when this returns
+ *
  * @returns the number of bytes read, < 0 on error
  */
 
@@ -700,17 +748,198 @@ int rdcu_read_model(const struct cmp_info *info, void *model_buf)
 	if (model_buf == NULL)
 		return (int)s;
 
-	if (rdcu_sync_sram_to_mirror(info->rdcu_new_model_adr_used, (s+3) & ~3U,
-				     rdcu_get_data_mtu()))
+	if (rdcu_read_sram_to_user(model_buf, info->rdcu_new_model_adr_used,
+				   s & ~3U, sizeof(uint16_t),
+				   rdcu_get_data_mtu()))
 		return -1;
 
+	/* a trailing partial word goes through the mirror */
+	if (s & 3U) {
+		if (rdcu_sync_sram_to_mirror(info->rdcu_new_model_adr_used +
+					     (s & ~3U), 4, rdcu_get_data_mtu())) {
+			rdcu_sync_wait();
+			return -1;
+		}
+	}
+
 	/* wait for it */
-	sync();
+	if (rdcu_sync_wait())
+		return -1;
+
+	if (s & 3U)
+		rdcu_read_sram_strided((uint8_t *) model_buf + (s & ~3U),
+				       sizeof(uint16_t), sizeof(uint16_t),
+				       info->rdcu_new_model_adr_used + (s & ~3U),
+				       (s & 3U) / sizeof(uint16_t));
+
+	return (int)s;
+}
+
+/**
+ * @brief check the SRAM stream addresses for a buffer of N-DPU entries
+ *
+ * @param samples	the number of entries
+ * @param entry_size	the size of one entry, e.g. sizeof(struct S_FX_NCOB)
+ * @param stream_adr	the SRAM addresses of the streams
+ * @param n_streams	set to the number of streams of the entry type
+ *
+ * @returns 1 if the entry has an exposure flags stream, 0 if not, -1 on error
+ */
+
+static int n_dpu_streams_valid(uint32_t samples, uint32_t entry_size,
+			       const uint32_t *stream_adr,
+			       unsigned int *n_streams)
+{
+	int flags;
+	unsigned int i;
+	unsigned int n_fields;
+	uint32_t size;
+
+
+	if (!stream_adr)
+		return -1;
+
+	flags = n_dpu_get_layout(entry_size, &n_fields);
+	if (flags < 0) {
+		dlog1("Error: %lu is not the size of an N-DPU entry.\n",
+		      entry_size);
+		return -1;
+	}
+
+	*n_streams = n_fields + (unsigned int)flags;
+
+	for (i = 0; i < *n_streams; i++) {
 
-	return rdcu_read_sram(model_buf, info->rdcu_new_model_adr_used, s);
+		if (flags && i == 0)
+			size = samples;
+		else
+			size = samples * sizeof(uint32_t);
+
+		if (stream_adr[i] & 0x3) {
+			dlog1("Error: The SRAM address of stream %lu is not 4 byte aligned.\n", i);
+			return -1;
+		}
+
+		if (!in_sram_range(stream_adr[i], size)) {
+			dlog1("Error: The stream %lu is not in the SRAM range.\n", i);
+			return -1;
+		}
+	}
+
+	return flags;
+}
+
+
+/**
+ * @brief split a buffer of N-DPU entries into one stream per field in the
+ *	  local SRAM mirror
+ *
+ * @param data_buf	a buffer of N-DPU entries of any S_ or F_ type
+ * @param samples	the number of entries in the buffer
+ * @param entry_size	the size of one entry, e.g. sizeof(struct S_FX_NCOB)
+ * @param stream_adr	4 byte aligned SRAM addresses of the streams: first the
+ *			exposure flags (S_ types only, samples bytes), then one
+ *			per field in entry order (samples 32 bit words each)
+ *
+ * @note every field stream can then be compressed with its own configuration,
+ *	 as 2 * samples 16 bit samples; the modified pages are uploaded by
+ *	 rdcu_compress_data() when called without an input buffer
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int rdcu_write_n_dpu_streams(const void *data_buf, uint32_t samples,
+			     uint32_t entry_size, const uint32_t *stream_adr)
+{
+	int flags;
+	unsigned int i;
+	unsigned int n_streams;
+
+	const uint8_t *p = (const uint8_t *) data_buf;
+
+
+	if (!data_buf)
+		return -1;
+
+	flags = n_dpu_streams_valid(samples, entry_size, stream_adr, &n_streams);
+	if (flags < 0)
+		return -1;
+
+	for (i = 0; i < n_streams; i++) {
+
+		if (flags && i == 0) {
+			if (rdcu_write_sram_strided(p, entry_size, 1,
+						    stream_adr[i], samples) < 0)
+				return -1;
+			p++;
+			continue;
+		}
+
+		if (rdcu_write_sram_strided(p, entry_size, sizeof(uint32_t),
+					    stream_adr[i], samples) < 0)
+			return -1;
+
+		p += sizeof(uint32_t);
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief join the field streams in the local SRAM mirror into a buffer of N-DPU
+ *	  entries; this is the inverse of rdcu_write_n_dpu_streams()
+ *
+ * @param data_buf	a buffer of N-DPU entries of any S_ or F_ type
+ * @param samples	the number of entries in the buffer
+ * @param entry_size	the size of one entry, e.g. sizeof(struct S_FX_NCOB)
+ * @param stream_adr	the SRAM addresses of the streams
+ *
+ * @note the streams must have been synced to the mirror in advance, e.g. with
+ *	 rdcu_sync_sram_to_mirror()
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int rdcu_read_n_dpu_streams(void *data_buf, uint32_t samples,
+			    uint32_t entry_size, const uint32_t *stream_adr)
+{
+	int flags;
+	unsigned int i;
+	unsigned int n_streams;
+
+	uint8_t *p = (uint8_t *) data_buf;
+
+
+	if (!data_buf)
+		return -1;
+
+	flags = n_dpu_streams_valid(samples, entry_size, stream_adr, &n_streams);
+	if (flags < 0)
+		return -1;
+
+	for (i = 0; i < n_streams; i++) {
+
+		if (flags && i == 0) {
+			if (rdcu_read_sram_strided(p, entry_size, 1,
+						   stream_adr[i], samples) < 0)
+				return -1;
+			p++;
+			continue;
+		}
+
+		if (rdcu_read_sram_strided(p, entry_size, sizeof(uint32_t),
+					   stream_adr[i], samples) < 0)
+			return -1;
+
+		p += sizeof(uint32_t);
+	}
+
+	return 0;
 }
 
 
+
 /**
  * @brief interrupt a data compression
  *
@@ -720,17 +949,10 @@ int rdcu_read_model(const struct cmp_info *info, void *model_buf)
 int rdcu_interrupt_compression(void)
 {
 	/* interrupt a compression */
-	rdcu_set_data_compr_interrupt();
-	if (rdcu_sync_compr_ctrl())
+	if (rdcu_interrupt_data_compr())
 		return -1;
 	sync();
 
-	/* clear local bit immediately, this is a write-only register.
-	 * we would not want to restart compression by accidentially calling
-	 * rdcu_sync_compr_ctrl() again
-	 */
-	rdcu_clear_data_compr_interrupt();
-
 	return 0;
 }
 
@@ -741,7 +963,7 @@ int rdcu_interrupt_compression(void)
 
 void rdcu_enable_interrput_signal(void)
 {
-	interrupt_signal_enabled = RDCU_INTR_SIG_ENA;
+	unit->interrupt_signal_enabled = RDCU_INTR_SIG_ENA;
 }
 
 
@@ -751,6 +973,979 @@ void rdcu_enable_interrput_signal(void)
 
 void rdcu_disable_interrput_signal(void)
 {
-	interrupt_signal_enabled = RDCU_INTR_SIG_DIS;
+	unit->interrupt_signal_enabled = RDCU_INTR_SIG_DIS;
+}
+
+
+
+/**
+ * @brief get a spillover threshold for a Golomb parameter, scaled from a
+ *	  reference pair relative to the largest valid spillover thresholds
+ *
+ * @param golomb_par	the Golomb parameter to get the spill for
+ * @param ref_par	the reference Golomb parameter
+ * @param ref_spill	the spillover threshold of the reference
+ * @param cmp_mode	compression mode
+ *
+ * @returns the spillover threshold
+ */
+
+static uint32_t scale_spill(uint32_t golomb_par, uint32_t ref_par,
+			    uint32_t ref_spill, uint32_t cmp_mode)
+{
+	uint32_t spill;
+	uint32_t max_spill = get_max_spill(golomb_par, cmp_mode);
+	uint32_t ref_max_spill = get_max_spill(ref_par, cmp_mode);
+
+
+	if (!ref_max_spill)
+		return max_spill;
+
+	spill = (ref_spill * max_spill + ref_max_spill / 2) / ref_max_spill;
+
+	if (spill > max_spill)
+		spill = max_spill;
+
+	if (spill < MIN_RDCU_SPILL)
+		spill = MIN_RDCU_SPILL;
+
+	return spill;
+}
+
+
+/**
+ * @brief clamp a Golomb parameter to the range supported by the RDCU
+ *
+ * @param golomb_par	the Golomb parameter
+ *
+ * @returns the clamped Golomb parameter
+ */
+
+static int32_t clamp_golomb_par(int32_t golomb_par)
+{
+	if (golomb_par < (int32_t) MIN_RDCU_GOLOMB_PAR)
+		return (int32_t) MIN_RDCU_GOLOMB_PAR;
+
+	if (golomb_par > (int32_t) MAX_RDCU_GOLOMB_PAR)
+		return (int32_t) MAX_RDCU_GOLOMB_PAR;
+
+	return golomb_par;
+}
+
+
+/**
+ * @brief adapt the compression parameters based on the results of the
+ *	  semi-adaptive compression of the previous frame
+ *
+ * @param cfg	the configuration used for the previous frame; updated for the
+ *		next frame
+ * @param info	the compression information of the previous frame
+ *
+ * The RDCU compresses every frame with the main and the two adaptive
+ * parameter sets, but returns only the bitstream of the main set. This
+ * selects the parameter set which yielded the smallest size as the new main
+ * set and places the new adaptive candidates below and above it. The
+ * distance of the candidates grows while the optimum moves and shrinks when
+ * it stays, so the search homes in on the best parameter and then tracks it.
+ *
+ * The spillover thresholds of the new candidates are chosen such that they
+ * have the same ratio to their largest valid value (see get_max_spill()) as
+ * the spillover threshold of the best set.
+ *
+ * @note the main set is kept if it is at least as good as the others
+ * @note has no effect in raw mode
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int rdcu_cmp_cfg_adapt(struct cmp_cfg *cfg, const struct cmp_info *info)
+{
+	int32_t best_par;
+	int32_t step;
+	int32_t ap1_par, ap2_par;
+
+	uint32_t best_size;
+	uint32_t best_spill;
+
+
+	if (!cfg)
+		return -1;
+
+	if (!info)
+		return -1;
+
+	if (raw_mode_is_used(cfg->cmp_mode))
+		return 0;
+
+	/* the sizes are not meaningful if the compression failed */
+	if (info->cmp_err & ~(1U << SMALL_BUFFER_ERR_BIT))
+		return -1;
+
+	best_par   = (int32_t) cfg->golomb_par;
+	best_spill = cfg->spill;
+	best_size  = info->cmp_size;
+
+	/* the current candidate distance */
+	step = (int32_t) cfg->ap2_golomb_par - (int32_t) cfg->ap1_golomb_par;
+	step = step / 2;
+	if (step < 0)
+		step = -step;
+
+	if (info->ap1_cmp_size < best_size) {
+		best_par   = (int32_t) cfg->ap1_golomb_par;
+		best_spill = cfg->ap1_spill;
+		best_size  = info->ap1_cmp_size;
+	}
+
+	if (info->ap2_cmp_size < best_size) {
+		best_par   = (int32_t) cfg->ap2_golomb_par;
+		best_spill = cfg->ap2_spill;
+		best_size  = info->ap2_cmp_size;
+	}
+
+	if (best_par == (int32_t) cfg->golomb_par)
+		step = step / 2;	/* stationary, search closer */
+	else
+		step = step * 2;	/* moving, search further */
+
+	/* a distance of one gets easily trapped in the shallow local minima
+	 * caused by the spillover thresholds, so never search closer than two
+	 */
+	if (step < 2)
+		step = 2;
+
+	if (step > (int32_t) (MAX_RDCU_GOLOMB_PAR / 4))
+		step = (int32_t) (MAX_RDCU_GOLOMB_PAR / 4);
+
+	ap1_par = clamp_golomb_par(best_par - step);
+	ap2_par = clamp_golomb_par(best_par + step);
+
+	/* at the edges of the range, keep two distinct candidates */
+	if (ap1_par == best_par)
+		ap1_par = clamp_golomb_par(best_par + 2 * step);
+	if (ap2_par == best_par)
+		ap2_par = clamp_golomb_par(best_par - 2 * step);
+
+	cfg->golomb_par = (uint32_t) best_par;
+	cfg->spill      = scale_spill(cfg->golomb_par, cfg->golomb_par,
+				      best_spill, cfg->cmp_mode);
+
+	cfg->ap1_golomb_par = (uint32_t) ap1_par;
+	cfg->ap1_spill      = scale_spill(cfg->ap1_golomb_par, cfg->golomb_par,
+					  best_spill, cfg->cmp_mode);
+
+	cfg->ap2_golomb_par = (uint32_t) ap2_par;
+	cfg->ap2_spill      = scale_spill(cfg->ap2_golomb_par, cfg->golomb_par,
+					  best_spill, cfg->cmp_mode);
+
+	return 0;
+}
+
+
+
+/**
+ * the compression pipeline
+ *
+ * The RDCU SRAM is partitioned into a number of slots, each holding the data,
+ * model, updated model and compressed data buffers of one frame. While the
+ * Data Compressor works on the frame in one slot, the next frame can be
+ * uploaded to an idle slot and the results of the previous frame can be read
+ * from its slot, so that the SpW link and the compressor are busy at the same
+ * time.
+ *
+ * A slot runs through the states idle -> loaded -> active -> done -> idle,
+ * driven by the calls:
+ *
+ *	rdcu_pipe_load()	upload a frame into an idle slot
+ *	rdcu_pipe_start()	start the compression of the oldest loaded slot
+ *	rdcu_pipe_finish()	collect the compression information of the
+ *				active slot once the compressor is ready
+ *	rdcu_pipe_read()	read the bitstream (and model) of a done slot
+ *
+ * a typical frame loop with two slots would be:
+ *
+ *	rdcu_pipe_load(frame 0); rdcu_pipe_start();
+ *	rdcu_pipe_load(frame 1);
+ *	loop:
+ *		while (rdcu_pipe_finish() > 0);		(frame N done)
+ *		rdcu_pipe_start();			(frame N+1 compressing)
+ *		rdcu_pipe_read(slot of frame N, ...);
+ *		rdcu_pipe_load(frame N+2);		(into the freed slot)
+ *
+ * rdcu_compress_stream() runs this loop over a sequence of frames of arbitrary
+ * length, passing the updated model of one frame on to the next in place.
+ */
+
+
+
+
+/**
+ * @brief check if any of the buffers of two pipeline slots are overlapping
+ *
+ * @param a	the 1st slot
+ * @param b	the 2nd slot
+ *
+ * @returns 0 if the slots are not overlapping, otherwise the slots are
+ *	overlapping
+ */
+
+static int pipe_slots_overlap(const struct rdcu_pipe_slot *a,
+			      const struct rdcu_pipe_slot *b)
+{
+	int i, j;
+
+	uint32_t start_a[4], end_a[4];
+	uint32_t start_b[4], end_b[4];
+
+
+	start_a[0] = a->rdcu_data_adr;
+	start_a[1] = a->rdcu_model_adr;
+	start_a[2] = a->rdcu_new_model_adr;
+	start_a[3] = a->rdcu_buffer_adr;
+
+	start_b[0] = b->rdcu_data_adr;
+	start_b[1] = b->rdcu_model_adr;
+	start_b[2] = b->rdcu_new_model_adr;
+	start_b[3] = b->rdcu_buffer_adr;
+
+	for (i = 0; i < 3; i++) {
+		end_a[i] = start_a[i] + a->samples * SAM2BYT;
+		end_b[i] = start_b[i] + b->samples * SAM2BYT;
+	}
+
+	end_a[3] = start_a[3] + a->buffer_length * SAM2BYT;
+	end_b[3] = start_b[3] + b->buffer_length * SAM2BYT;
+
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 4; j++) {
+			if (buffers_overlap(start_a[i], end_a[i],
+					    start_b[j], end_b[j]))
+				return 1;
+		}
+	}
+
+	return 0;
 }
 
+
+/**
+ * @brief set up the compression pipeline
+ *
+ * @param slots		an array of SRAM slot definitions
+ * @param n_slots	the number of slots (2...RDCU_PIPE_SLOTS_MAX)
+ *
+ * @note the buffers of a slot may overlap among themselves as far as
+ *	 permitted by rdcu_cmp_cfg_valid(), which is checked for each frame
+ *	 in rdcu_pipe_load(); the buffers of different slots must not overlap,
+ *	 but they may share SRAM pages, as only the byte ranges of the data
+ *	 and model of a frame are uploaded
+ * @note any frames still in the pipeline are dropped
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int rdcu_pipe_init(const struct rdcu_pipe_slot *slots, unsigned int n_slots)
+{
+	unsigned int i, j;
+
+
+	if (!slots)
+		return -1;
+
+	if (n_slots < 2 || n_slots > RDCU_PIPE_SLOTS_MAX) {
+		dlog1("Error: the number of pipeline slots must be between "
+		      "[2, %lu].\n", RDCU_PIPE_SLOTS_MAX);
+		return -1;
+	}
+
+	for (i = 0; i < n_slots; i++) {
+		if (!in_sram_range(slots[i].rdcu_data_adr,
+				   slots[i].samples * SAM2BYT) ||
+		    !in_sram_range(slots[i].rdcu_model_adr,
+				   slots[i].samples * SAM2BYT) ||
+		    !in_sram_range(slots[i].rdcu_new_model_adr,
+				   slots[i].samples * SAM2BYT) ||
+		    !in_sram_range(slots[i].rdcu_buffer_adr,
+				   slots[i].buffer_length * SAM2BYT)) {
+			dlog1("Error: pipeline slot %lu is outside the RDCU "
+			      "SRAM address space.\n", i);
+			return -1;
+		}
+
+		for (j = 0; j < i; j++) {
+			if (pipe_slots_overlap(&slots[i], &slots[j])) {
+				dlog2("Error: pipeline slots %lu and %lu are "
+				      "overlapping.\n", j, i);
+				return -1;
+			}
+		}
+	}
+
+	memset(&unit->pipe, 0, sizeof(unit->pipe));
+
+	for (i = 0; i < n_slots; i++) {
+		unit->pipe.slot[i] = slots[i];
+		unit->pipe.state[i] = RDCU_PIPE_IDLE;
+	}
+
+	unit->pipe.n_slots = n_slots;
+
+	return 0;
+}
+
+
+/**
+ * @brief find a pipeline slot in a given state
+ *
+ * @param state	the state to look for
+ *
+ * @returns the index of the first slot in the state, -1 if there is none
+ */
+
+static int pipe_find_slot(enum rdcu_pipe_state state)
+{
+	int i;
+
+
+	for (i = 0; i < (int) unit->pipe.n_slots; i++) {
+		if (unit->pipe.state[i] == state)
+			return i;
+	}
+
+	return -1;
+}
+
+
+/**
+ * @brief upload a frame into an idle pipeline slot
+ *
+ * @param cfg		configuration of the frame; the RDCU SRAM addresses
+ *			are ignored and replaced by those of the slot
+ * @param model_slot	the slot the updated model of which is the model of
+ *			this frame, or -1 to upload the model from the
+ *			model buffer
+ *
+ * @returns the slot index on success, -1 on error, 1 if no slot is idle
+ */
+
+static int pipe_load(const struct cmp_cfg *cfg, int model_slot)
+{
+	int i;
+	int slot = -1;
+
+	struct cmp_cfg *c;
+
+
+	if (!cfg)
+		return -1;
+
+	for (i = 0; i < (int) unit->pipe.n_slots; i++) {
+		if (unit->pipe.state[i] == RDCU_PIPE_IDLE) {
+			slot = i;
+			break;
+		}
+	}
+
+	if (slot < 0) {
+		if (!unit->pipe.n_slots)
+			return -1;
+		return 1;
+	}
+
+	if (cfg->samples > unit->pipe.slot[slot].samples ||
+	    cfg->buffer_length > unit->pipe.slot[slot].buffer_length) {
+		dlog1("Error: the frame does not fit into pipeline slot %lu.\n",
+		      slot);
+		return -1;
+	}
+
+	c = &unit->pipe.cfg[slot];
+
+	(*c) = (*cfg);
+	c->rdcu_data_adr      = unit->pipe.slot[slot].rdcu_data_adr;
+	c->rdcu_model_adr     = unit->pipe.slot[slot].rdcu_model_adr;
+	c->rdcu_new_model_adr = unit->pipe.slot[slot].rdcu_new_model_adr;
+	c->rdcu_buffer_adr    = unit->pipe.slot[slot].rdcu_buffer_adr;
+
+	/* the model is already in place, no need to upload it */
+	if (model_slot >= 0)
+		c->rdcu_model_adr = unit->pipe.slot[model_slot].rdcu_new_model_adr;
+
+	/* the ICU buffers are supplied in rdcu_pipe_read() */
+	c->icu_new_model_buf  = NULL;
+	c->icu_output_buf     = NULL;
+
+	if (rdcu_cmp_cfg_valid(c) < 0)
+		return -1;
+
+	if (c->input_buf != NULL) {
+		if (rdcu_write_sram_16(c->input_buf, c->rdcu_data_adr,
+				       c->samples * 2) < 0)
+			return -1;
+	}
+
+	if (c->model_buf != NULL && model_mode_is_used(c->cmp_mode) &&
+	    model_slot < 0) {
+		if (rdcu_write_sram_16(c->model_buf, c->rdcu_model_adr,
+				       c->samples * 2) < 0)
+			return -1;
+	}
+
+	/* submit, but do not wait; the other slots may share the border
+	 * pages, so nothing but the frame buffers must be written
+	 */
+	if (rdcu_sync_dirty_range_to_sram(c->rdcu_data_adr, c->samples * 2,
+					  rdcu_get_data_mtu()))
+		return -1;
+
+	if (model_mode_is_used(c->cmp_mode) && model_slot < 0) {
+		if (rdcu_sync_dirty_range_to_sram(c->rdcu_model_adr,
+						  c->samples * 2,
+						  rdcu_get_data_mtu()))
+			return -1;
+	}
+
+	unit->pipe.seq[slot]   = unit->pipe.next_seq++;
+	unit->pipe.state[slot] = RDCU_PIPE_LOADED;
+
+	return slot;
+}
+
+
+/**
+ * @brief upload a frame into an idle pipeline slot
+ *
+ * @param cfg	configuration of the frame; the RDCU SRAM addresses are
+ *		ignored and replaced by those of the slot
+ *
+ * @note the upload is only submitted, it is completed latest in
+ *	 rdcu_pipe_start()
+ *
+ * @returns the slot index on success, -1 on error, 1 if no slot is idle
+ */
+
+int rdcu_pipe_load(const struct cmp_cfg *cfg)
+{
+	return pipe_load(cfg, -1);
+}
+
+
+/**
+ * @brief start the compression of the oldest loaded pipeline slot
+ *
+ * @note waits for all outstanding transfers to complete
+ *
+ * @returns the slot index on success, -1 on error, 1 if no slot is loaded or
+ *	    a compression is still active
+ */
+
+int rdcu_pipe_start(void)
+{
+	int i;
+	int slot = -1;
+
+	struct cmp_cfg *c;
+
+
+	for (i = 0; i < (int) unit->pipe.n_slots; i++) {
+
+		if (unit->pipe.state[i] == RDCU_PIPE_ACTIVE)
+			return 1;
+
+		if (unit->pipe.state[i] != RDCU_PIPE_LOADED)
+			continue;
+
+		/* wrap-safe comparison of the load order */
+		if (slot < 0 ||
+		    (int32_t) (unit->pipe.seq[i] - unit->pipe.seq[slot]) < 0)
+			slot = i;
+	}
+
+	if (slot < 0) {
+		if (!unit->pipe.n_slots)
+			return -1;
+		return 1;
+	}
+
+	c = &unit->pipe.cfg[slot];
+
+	/* the frame must be in place before we start */
+	sync();
+
+	if (rdcu_set_compression_register(c))
+		return -1;
+
+	if (rdcu_start_compression())
+		return -1;
+
+	if (model_mode_is_used(c->cmp_mode))
+		rdcu_sram_invalidate(c->rdcu_new_model_adr, c->samples * 2);
+
+	rdcu_sram_invalidate(c->rdcu_buffer_adr, c->buffer_length * 2);
+
+	unit->pipe.state[slot] = RDCU_PIPE_ACTIVE;
+
+	return slot;
+}
+
+
+/**
+ * @brief collect the results of the active pipeline slot
+ *
+ * @note this reads the compression information registers, which must happen
+ *	 before the next compression is started
+ * @note if rdcu_cmp_irq_enable() is used, the results are collected by
+ *	 rdcu_cmp_done_irq() and this only reports the finished slot, i.e. no
+ *	 RMAP transactions are issued
+ *
+ * @returns the slot index on success, -1 on error, 1 if the compression is
+ *	    still ongoing
+ */
+
+int rdcu_pipe_finish(void)
+{
+	int i;
+	int slot = -1;
+
+	struct cmp_status status;
+
+
+	for (i = 0; i < (int) unit->pipe.n_slots; i++) {
+		if (unit->pipe.state[i] == RDCU_PIPE_ACTIVE) {
+			slot = i;
+			break;
+		}
+	}
+
+	if (unit->cmp_irq.enabled) {
+		if (unit->cmp_irq.slot < 0)
+			return slot < 0 ? -1 : 1;
+
+		slot = unit->cmp_irq.slot;
+		unit->cmp_irq.slot = -1;
+
+		return slot;
+	}
+
+	if (slot < 0)
+		return -1;
+
+	if (rdcu_read_cmp_status(&status))
+		return -1;
+
+	if (!status.cmp_ready)
+		return 1;
+
+	if (rdcu_read_cmp_info(&unit->pipe.info[slot]))
+		return -1;
+
+	unit->pipe.state[slot] = RDCU_PIPE_DONE;
+
+	return slot;
+}
+
+
+/**
+ * @brief read the results of a finished pipeline slot and release the slot
+ *
+ * @param slot		the slot index as returned by rdcu_pipe_finish()
+ * @param info		compression information of the frame (may be NULL)
+ * @param output_buf	the buffer to store the bitstream (may be NULL)
+ * @param model_buf	the buffer to store the updated model (may be NULL;
+ *			ignored if no model mode was used)
+ *
+ * @note this may be called while the compression of another slot is active
+ *
+ * @returns the number of bitstream bytes read, < 0 on error
+ */
+
+int rdcu_pipe_read(int slot, struct cmp_info *info, void *output_buf,
+		   void *model_buf)
+{
+	int n = 0;
+
+	struct cmp_info *inf;
+
+
+	if (slot < 0 || slot >= (int) unit->pipe.n_slots)
+		return -1;
+
+	if (unit->pipe.state[slot] != RDCU_PIPE_DONE)
+		return -1;
+
+	inf = &unit->pipe.info[slot];
+
+	if (output_buf) {
+		n = rdcu_read_cmp_bitstream(inf, output_buf);
+		if (n < 0)
+			return -1;
+	}
+
+	if (model_buf && model_mode_is_used(inf->cmp_mode_used)) {
+		if (rdcu_read_model(inf, model_buf) < 0)
+			return -1;
+	}
+
+	if (info)
+		(*info) = (*inf);
+
+	unit->pipe.state[slot] = RDCU_PIPE_IDLE;
+
+	return n;
+}
+
+
+/**
+ * @brief compress a sequence of frames of arbitrary total length in the
+ *	  compression pipeline
+ *
+ * @param cfg		configuration of the stream; input_buf holds samples
+ *			samples, which are split into frames of frame_samples
+ *			samples (the last one may be shorter); model_buf is
+ *			the model of the first frame, buffer_length is the
+ *			compressed data buffer length of a frame; the RDCU
+ *			SRAM addresses are ignored
+ * @param frame_samples	the number of samples per frame; must fit into the
+ *			slots set up with rdcu_pipe_init()
+ * @param output_buf	the buffer to store the framed output in
+ * @param output_size	the size of the output buffer in bytes
+ *
+ * @note in model mode, the model of a frame is the updated model of the
+ *	 previous frame, which is used right where the RDCU put it, so only
+ *	 the first model is uploaded; the updated model of the last frame is
+ *	 read to icu_new_model_buf, if it is set
+ * @note the output is a sequence of a struct cmp_info (in cpu order)
+ *	 followed by the bitstream of the frame (see rdcu_read_cmp_bitstream())
+ *	 for every frame; the upload of the next frames, the compression and
+ *	 the download of the previous frame overlap
+ * @note on error, frames may be left in the pipeline; set it up again with
+ *	 rdcu_pipe_init()
+ *
+ * @returns the number of bytes written to the output buffer, < 0 on error
+ */
+
+int rdcu_compress_stream(const struct cmp_cfg *cfg, uint32_t frame_samples,
+			 void *output_buf, uint32_t output_size)
+{
+	int slot;
+	int model_slot = -1;
+
+	uint32_t n_frames;
+	uint32_t loaded = 0;
+	uint32_t done = 0;
+	uint32_t pos = 0;
+	uint32_t s;
+
+	void *model_buf;
+	struct cmp_cfg c;
+	struct cmp_info info;
+	uint8_t *out = (uint8_t *) output_buf;
+
+
+	if (!cfg || !output_buf)
+		return -1;
+
+	if (!cfg->input_buf || !cfg->samples || !frame_samples)
+		return -1;
+
+	if (!unit->pipe.n_slots) {
+		dlog0("Error: the compression pipeline is not set up.\n");
+		return -1;
+	}
+
+	for (slot = 0; slot < (int) unit->pipe.n_slots; slot++) {
+		if (unit->pipe.state[slot] != RDCU_PIPE_IDLE) {
+			dlog0("Error: the compression pipeline is busy.\n");
+			return -1;
+		}
+	}
+
+	n_frames = (cfg->samples + frame_samples - 1) / frame_samples;
+
+	while (done < n_frames) {
+
+		/* upload the next frames into the idle slots... */
+		while (loaded < n_frames && pipe_find_slot(RDCU_PIPE_IDLE) >= 0) {
+
+			c = (*cfg);
+			c.input_buf = (uint16_t *) cfg->input_buf +
+				      loaded * frame_samples;
+			c.samples = cfg->samples - loaded * frame_samples;
+			if (c.samples > frame_samples)
+				c.samples = frame_samples;
+
+			if (!model_mode_is_used(c.cmp_mode))
+				model_slot = -1;
+
+			/* ...chaining the model from the previous frame */
+			model_slot = pipe_load(&c, model_slot);
+			if (model_slot < 0)
+				return -1;
+
+			loaded++;
+		}
+
+		/* ...keep the compressor busy... */
+		if (pipe_find_slot(RDCU_PIPE_ACTIVE) < 0 &&
+		    pipe_find_slot(RDCU_PIPE_LOADED) >= 0) {
+			if (rdcu_pipe_start() < 0)
+				return -1;
+		}
+
+		/* ...and download the frame that finished */
+		slot = pipe_find_slot(RDCU_PIPE_DONE);
+		if (slot < 0) {
+			if (rdcu_pipe_finish() < 0)
+				return -1;
+			continue;
+		}
+
+		info = unit->pipe.info[slot];
+
+		if (info.cmp_err) {
+			dlog2("Error: compression of frame %lu failed with "
+			      "error 0x%04lX.\n", done, info.cmp_err);
+			return -1;
+		}
+
+		s = size_of_bitstream(info.cmp_size);
+
+		if (output_size - pos < sizeof(struct cmp_info) + s) {
+			dlog0("Error: the output buffer is too small.\n");
+			return -1;
+		}
+
+		model_buf = NULL;
+		if (done == n_frames - 1)
+			model_buf = cfg->icu_new_model_buf;
+
+		if (rdcu_pipe_read(slot, NULL, out + pos + sizeof(struct cmp_info),
+				   model_buf) < 0)
+			return -1;
+
+		memcpy(out + pos, &info, sizeof(struct cmp_info));
+
+		pos += sizeof(struct cmp_info) + s;
+		done++;
+	}
+
+	return (int) pos;
+}
+
+
+/**
+ * @brief use the RDCU interrupt signal to detect finished compressions
+ *
+ * @param cb		a function to call when a compression finished (may be
+ *			NULL); status is 0 if the results were read, -1 on error
+ * @param output_buf	the buffer to download the bitstream to (may be NULL)
+ * @param userdata	a pointer to arbitrary user data; passed to cb
+ *
+ * @note this enables the RDCU interrupt signal; rdcu_cmp_done_irq() must be
+ *	 registered on the interrupt the signal is connected to
+ * @note in this mode, rdcu_pipe_finish() does not poll the compressor status
+ * @note the bitstream is only downloaded for compressions started with
+ *	 rdcu_compress_data(), pipeline slots are read with rdcu_pipe_read()
+ */
+
+void rdcu_cmp_irq_enable(void (*cb)(const struct cmp_info *info, int status,
+				    void *userdata),
+			 void *output_buf, void *userdata)
+{
+	unit->cmp_irq.cb         = cb;
+	unit->cmp_irq.output_buf = output_buf;
+	unit->cmp_irq.userdata   = userdata;
+	unit->cmp_irq.slot       = -1;
+	unit->cmp_irq.enabled    = 1;
+
+	rdcu_enable_interrput_signal();
+}
+
+
+/**
+ * @brief go back to detecting finished compressions by polling
+ *
+ * @note the RDCU interrupt signal is left enabled
+ */
+
+void rdcu_cmp_irq_disable(void)
+{
+	unit->cmp_irq.enabled = 0;
+	unit->cmp_irq.cb      = NULL;
+	unit->cmp_irq.slot    = -1;
+}
+
+
+/**
+ * @brief collect the results of a finished compression from an interrupt
+ *	  callback
+ *
+ * @param userdata the unit of the RDCU (see rdcu_unit_alloc()) or NULL for
+ *		  the selected one
+ *
+ * @returns always 0
+ *
+ * @note this is meant to be registered with irl1_register_callback() on the
+ *	 interrupt the RDCU interrupt signal is connected to; as this issues
+ *	 RMAP transactions, use PRIORITY_LATER and call irq_queue_execute() from
+ *	 the same context the other RDCU functions are used in
+ */
+
+int32_t rdcu_cmp_done_irq(void *userdata)
+{
+	int i;
+	int status = 0;
+	int slot = -1;
+
+	struct cmp_info info;
+	struct rdcu_unit *prev = unit;
+
+
+	/* serve the RDCU the interrupt was registered for */
+	if (userdata)
+		rdcu_unit_select((struct rdcu_unit *) userdata);
+
+	if (!unit->cmp_irq.enabled) {
+		rdcu_unit_select(prev);
+		return 0;
+	}
+
+	memset(&info, 0, sizeof(struct cmp_info));
+
+	if (rdcu_read_cmp_info(&info))
+		status = -1;
+
+	for (i = 0; i < (int) unit->pipe.n_slots; i++) {
+		if (unit->pipe.state[i] == RDCU_PIPE_ACTIVE) {
+			slot = i;
+			break;
+		}
+	}
+
+	if (slot >= 0) {
+		if (!status) {
+			unit->pipe.info[slot]  = info;
+			unit->pipe.state[slot] = RDCU_PIPE_DONE;
+			unit->cmp_irq.slot     = slot;
+		}
+	} else if (!status && unit->cmp_irq.output_buf) {
+		if (rdcu_read_cmp_bitstream(&info,
+					    unit->cmp_irq.output_buf) < 0)
+			status = -1;
+	}
+
+	if (unit->cmp_irq.cb)
+		unit->cmp_irq.cb(&info, status, unit->cmp_irq.userdata);
+
+	rdcu_unit_select(prev);
+
+	return 0;
+}
+
+
+/**
+ * @brief allocate a new RDCU unit
+ *
+ * @returns a pointer to the unit or NULL on error
+ *
+ * @note a unit comes with its own link and control contexts; select it with
+ *	 rdcu_unit_select(), then initialise it with rdcu_ctrl_init() and
+ *	 rdcu_rmap_init() and configure the addresses, paths and key of the RDCU
+ *	 just like the default one
+ * @note while the unit is selected, rdcu_rmap_get_ctx() returns the link
+ *	 context to register with rdcu_rmap_rx_irq(); the unit itself is the
+ *	 userdata to register with rdcu_cmp_done_irq()
+ */
+
+struct rdcu_unit *rdcu_unit_alloc(void)
+{
+	struct rdcu_unit *u;
+
+
+	u = (struct rdcu_unit *) calloc(1, sizeof(struct rdcu_unit));
+	if (!u) {
+		printf("Error allocating memory for the RDCU unit\n");
+		return NULL;
+	}
+
+	u->rmap = rdcu_rmap_ctx_alloc();
+	u->ctrl = rdcu_ctrl_ctx_alloc();
+
+	if (!u->rmap || !u->ctrl) {
+		rdcu_unit_free(u);
+		return NULL;
+	}
+
+	u->interrupt_signal_enabled = RDCU_INTR_SIG_DEFAULT;
+	u->cmp_irq.slot = -1;
+
+	return u;
+}
+
+
+/**
+ * @brief free an RDCU unit and its contexts
+ *
+ * @param u the unit to free
+ *
+ * @note if the unit is currently selected, the default unit is selected
+ *	 instead; the default unit itself is never freed
+ */
+
+void rdcu_unit_free(struct rdcu_unit *u)
+{
+	if (!u)
+		return;
+
+	if (u == &unit_default)
+		return;
+
+	if (unit == u)
+		rdcu_unit_select(NULL);
+
+	rdcu_rmap_ctx_free(u->rmap);
+	rdcu_ctrl_ctx_free(u->ctrl);
+
+	free(u);
+}
+
+
+/**
+ * @brief select the RDCU unit all subsequent calls operate on
+ *
+ * @param u the unit to select; NULL selects the default unit
+ *
+ * @note this also selects the link and control contexts of the unit, i.e.
+ *	 all of the rdcu_rmap, rdcu_ctrl and cmp_rdcu functions will address
+ *	 the RDCU of the unit; as all transfers are asynchronous, several RDCUs
+ *	 are driven concurrently by selecting them in turn, e.g.
+ *
+ *	for each unit:	select, rdcu_pipe_load(), rdcu_pipe_start()
+ *	for each unit:	select, rdcu_pipe_finish(), rdcu_pipe_read(), ...
+ *
+ * @note never select a unit from interrupt context, see
+ *	 rdcu_rmap_select_ctx(); rdcu_cmp_done_irq() is deferred for this reason
+ */
+
+void rdcu_unit_select(struct rdcu_unit *u)
+{
+	if (!u)
+		u = &unit_default;
+
+	unit = u;
+
+	rdcu_rmap_select_ctx(u->rmap);
+	rdcu_ctrl_select_ctx(u->ctrl);
+}
+
+
+/**
+ * @brief get the currently selected RDCU unit
+ *
+ * @returns the selected unit
+ */
+
+struct rdcu_unit *rdcu_unit_get(void)
+{
+	return unit;
+}
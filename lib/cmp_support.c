@@ -378,6 +378,86 @@ unsigned int cal_up_model(unsigned int data, unsigned int model, unsigned int
 	return (unsigned int)((weighted_model + weighted_data) / MAX_MODEL_VALUE);
 }
 
+/**
+ * @brief update a whole model buffer in-place, the same way the compressor
+ *	  does it, so a local copy of the model can be kept in step with the
+ *	  updated model of a compression
+ *
+ * @param model_buf	the model buffer to update
+ * @param data_buf	the data buffer used in the compression
+ * @param samples	the number of samples in the buffers
+ * @param cmp_mode	the used compression mode (one of the MODE_MODEL_* modes)
+ * @param model_value	the used model weighting parameter
+ * @param round		the used number of lossy rounding bits; only applies to
+ *			the 16 and 32 bit modes, N-DPU entries are rounded with
+ *			the lossy_rounding_* functions in advance
+ *
+ * @note the result is bit-identical to the updated model produced by the RDCU
+ *	 (for the RDCU supported modes) or the ICU compressor
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int cal_up_model_buf(void *model_buf, const void *data_buf,
+		     unsigned int samples, unsigned int cmp_mode,
+		     unsigned int model_value, unsigned int round)
+{
+	unsigned int i;
+	uint32_t mask;
+	uint32_t wd;
+
+
+	if (!samples)
+		return 0;
+
+	if (!model_buf || !data_buf)
+		return -1;
+
+	if (!model_mode_is_used(cmp_mode))
+		return -1;
+
+	if (model_value > MAX_MODEL_VALUE)
+		return -1;
+
+	if (round >= 16)
+		return -1;
+
+	wd = MAX_MODEL_VALUE - model_value;
+	mask = ~0U << round;	/* same as round_inv(round_fwd()) */
+
+	switch (cmp_mode) {
+	case MODE_MODEL_ZERO:
+	case MODE_MODEL_MULTI:
+	{
+		uint16_t *model = (uint16_t *) model_buf;
+		const uint16_t *data = (const uint16_t *) data_buf;
+
+		/* a 16 bit weighted sum can not overflow 32 bits */
+		for (i = 0; i < samples; i++)
+			model[i] = (uint16_t) (((model[i] & mask) * model_value +
+						(data[i] & mask) * wd) /
+					       MAX_MODEL_VALUE);
+		return 0;
+	}
+	case MODE_MODEL_ZERO_32:
+	case MODE_MODEL_MULTI_32:
+	{
+		uint32_t *model = (uint32_t *) model_buf;
+		const uint32_t *data = (const uint32_t *) data_buf;
+
+		for (i = 0; i < samples; i++)
+			model[i] = cal_up_model(data[i] & mask, model[i] & mask,
+						model_value);
+		return 0;
+	}
+	default:
+		return n_dpu_cal_up_model(model_buf, data_buf, samples,
+					  size_of_a_sample(cmp_mode),
+					  model_value);
+	}
+}
+
+
 
 /**
  * @brief get the maximum valid spill threshold value for a given golomb_par
@@ -447,6 +527,12 @@ size_t size_of_a_sample(unsigned int cmp_mode)
 	case MODE_MODEL_MULTI_S_FX_EFX:
 	case MODE_DIFF_ZERO_S_FX_EFX:
 	case MODE_DIFF_MULTI_S_FX_EFX:
+		sample_len = sizeof(struct S_FX_EFX);
+		break;
+	case MODE_MODEL_ZERO_S_FX_NCOB:
+	case MODE_MODEL_MULTI_S_FX_NCOB:
+	case MODE_DIFF_ZERO_S_FX_NCOB:
+	case MODE_DIFF_MULTI_S_FX_NCOB:
 		sample_len = sizeof(struct S_FX_NCOB);
 		break;
 	case MODE_MODEL_ZERO_S_FX_EFX_NCOB_ECOB:
@@ -507,7 +593,8 @@ size_t size_of_a_sample(unsigned int cmp_mode)
 
 unsigned int size_of_bitstream(unsigned int cmp_size)
 {
-	return (((cmp_size >> 3) + 3) & ~0x3U);
+	/* the bitstream is written in 32 bit words, round up to a full one */
+	return ((cmp_size + 31) >> 5) << 2;
 }
 
 
@@ -0,0 +1,702 @@
+/**
+ * @file   decmp.c
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief decompressor for bitstreams of the RDCU compression modes
+ * @see Data Compression User Manual PLATO-UVIE-PL-UM-0001
+ *
+ * The bitstream is expected in the format the RDCU writes to its SRAM (and
+ * rdcu_read_cmp_bitstream() returns), i.e. code words packed MSB first into
+ * big-endian 32 bit words.
+ *
+ * Golomb code words are decoded with a lookup table indexed by the next
+ * DECMP_LUT_BITS bits of the bitstream. An entry holds all (up to
+ * DECMP_LUT_MAX_SYM) complete, non-escape code words starting at that
+ * position, so short code words are decoded several at a time. Anything else
+ * (escape symbols, long code words) takes the bitwise path.
+ *
+ * @note the lookup table is kept in static memory and rebuilt only when the
+ *	 Golomb parameter, spillover threshold or escape mechanism changes;
+ *	 decompress_data() is hence not reentrant; on PC builds, the table is
+ *	 thread-local, so threads may decompress concurrently
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <byteorder.h>
+
+#include "../include/cmp_support.h"
+#include "../include/decmp.h"
+
+
+/* the sample width of the RDCU compression modes */
+#define DECMP_SAMPLE_BITS	16
+
+#define DECMP_LUT_BITS		10
+#define DECMP_LUT_MAX_SYM	4
+
+#if (__sparc__)
+#define DECMP_TLS
+#else /* assume PC */
+#define DECMP_TLS	__thread
+#endif
+
+
+/**
+ * @brief a bit reader using a 64 bit cache
+ */
+
+struct bit_reader {
+	const uint8_t *src;	/* next byte of the bitstream */
+	const uint8_t *end;	/* end of the bitstream */
+	uint64_t cache;		/* pending bits, MSB aligned */
+	uint32_t n_cache;	/* number of pending bits */
+	uint32_t n_bits;	/* total number of bits consumed */
+};
+
+
+/**
+ * @brief the setup of the Golomb decoder
+ */
+
+struct decoder_setup {
+	uint32_t golomb_par;	/* Golomb parameter */
+	uint32_t k;		/* ceil(log2(golomb_par)) */
+	uint32_t u;		/* number of short remainder code words */
+	uint32_t spill;		/* spillover threshold */
+	int zero_escape;	/* zero escape symbol mechanism used */
+	int rice;		/* Golomb parameter is a power of two */
+};
+
+
+/**
+ * @brief a lookup table entry
+ */
+
+struct lut_entry {
+	uint8_t  n;				/* number of symbols */
+	uint8_t  len[DECMP_LUT_MAX_SYM];	/* bits after each symbol */
+	uint16_t sym[DECMP_LUT_MAX_SYM];	/* the mapped values */
+};
+
+
+static DECMP_TLS struct lut_entry lut[1UL << DECMP_LUT_BITS];
+
+/* the parameters the lookup table was built for */
+static DECMP_TLS struct decoder_setup lut_setup;
+static DECMP_TLS int lut_valid;
+
+
+/**
+ * @brief initialise a bit reader
+ *
+ * @param br	the bit reader
+ * @param buf	the bitstream
+ * @param size	the size of the bitstream in bytes
+ */
+
+static void br_init(struct bit_reader *br, const void *buf, uint32_t size)
+{
+	br->src     = (const uint8_t *) buf;
+	br->end     = br->src + size;
+	br->cache   = 0;
+	br->n_cache = 0;
+	br->n_bits  = 0;
+}
+
+
+/**
+ * @brief fill the bit cache; beyond the end of the bitstream, zeros are read
+ *
+ * @param br	the bit reader
+ *
+ * @note at least 57 bits are in the cache afterwards
+ */
+
+static void br_refill(struct bit_reader *br)
+{
+	uint64_t byte;
+
+
+	/* take a whole word if we can */
+	if (br->n_cache <= 32 && (br->end - br->src) >= 4 &&
+	    !((uintptr_t) br->src & 0x3)) {
+		br->cache |= (uint64_t) be32_to_cpu(*(const uint32_t *) br->src)
+			     << (32 - br->n_cache);
+		br->src     += 4;
+		br->n_cache += 32;
+	}
+
+	while (br->n_cache <= 56) {
+		byte = 0;
+		if (br->src < br->end)
+			byte = *br->src++;
+
+		br->cache   |= byte << (56 - br->n_cache);
+		br->n_cache += 8;
+	}
+}
+
+
+/**
+ * @brief get the next bits of the bitstream without consuming them
+ *
+ * @param br	the bit reader
+ * @param n	the number of bits (0...32)
+ *
+ * @returns the bits, right aligned
+ */
+
+static uint32_t br_peek(const struct bit_reader *br, uint32_t n)
+{
+	if (!n)
+		return 0;
+
+	return (uint32_t) (br->cache >> (64 - n));
+}
+
+
+/**
+ * @brief consume bits of the bitstream
+ *
+ * @param br	the bit reader
+ * @param n	the number of bits (must not exceed the cached bits)
+ */
+
+static void br_consume(struct bit_reader *br, uint32_t n)
+{
+	br->cache   <<= n;
+	br->n_cache  -= n;
+	br->n_bits   += n;
+}
+
+
+/**
+ * @brief decode a Golomb code word from a window of bits
+ *
+ * @param w	the bits, MSB aligned
+ * @param avail	the number of valid bits in w (<= 32)
+ * @param s	the decoder setup
+ * @param value	the decoded value
+ *
+ * @returns the length of the code word, 0 if it is not completely contained
+ *	    in the window
+ */
+
+static uint32_t golomb_decode_window(uint32_t w, uint32_t avail,
+				     const struct decoder_setup *s,
+				     uint32_t *value)
+{
+	uint32_t q;
+	uint32_t r;
+	uint32_t x;
+	uint32_t len;
+
+
+	/* unary coded quotient */
+	if (~w == 0)
+		return 0;
+
+	q = (uint32_t) __builtin_clz(~w);
+
+	len = q + 1;
+	if (len > avail)
+		return 0;
+
+	/* truncated binary coded remainder */
+	if (s->k) {
+		if (len + s->k - 1 > avail)
+			return 0;
+
+		x = 0;
+		if (s->k > 1)
+			x = (w << len) >> (32 - (s->k - 1));
+
+		if (x < s->u) {
+			r = x;
+			len += s->k - 1;
+		} else {
+			if (len + s->k > avail)
+				return 0;
+
+			r = ((w << len) >> (32 - s->k)) - s->u;
+			len += s->k;
+		}
+	} else {
+		r = 0;
+	}
+
+	(*value) = q * s->golomb_par + r;
+
+	return len;
+}
+
+
+/**
+ * @brief decode a Rice code word from a window of bits
+ *
+ * @param w	the bits, MSB aligned
+ * @param avail	the number of valid bits in w (<= 32)
+ * @param s	the decoder setup, the Golomb parameter is a power of two
+ * @param value	the decoded value
+ *
+ * @note for a Golomb parameter of 2^k, all remainders have k bits, so the
+ *	 value is just the unary quotient shifted up by k with the remainder
+ *	 in the low bits, see golomb_decode_window()
+ *
+ * @returns the length of the code word, 0 if it is not completely contained
+ *	    in the window
+ */
+
+static uint32_t rice_decode_window(uint32_t w, uint32_t avail,
+				   const struct decoder_setup *s,
+				   uint32_t *value)
+{
+	uint32_t q;
+	uint32_t len;
+
+
+	/* unary coded quotient */
+	if (~w == 0)
+		return 0;
+
+	q = (uint32_t) __builtin_clz(~w);
+
+	len = q + 1 + s->k;
+	if (len > avail)
+		return 0;
+
+	(*value) = q << s->k;
+
+	/* the remainder, q + 1 < 32 if there is one */
+	if (s->k)
+		(*value) |= (w << (q + 1)) >> (32 - s->k);
+
+	return len;
+}
+
+
+/**
+ * @brief set up the Golomb decoder
+ *
+ * @param s		the setup to fill
+ * @param info		compression information of the bitstream
+ */
+
+static void decoder_setup(struct decoder_setup *s, const struct cmp_info *info)
+{
+	s->golomb_par  = info->golomb_par_used;
+	s->spill       = info->spill_used;
+	s->zero_escape = zero_escape_mech_is_used(info->cmp_mode_used);
+
+	if (s->golomb_par > 1)
+		s->k = (uint32_t) ilog_2(s->golomb_par - 1) + 1;
+	else
+		s->k = 0;
+
+	s->u = (1UL << s->k) - s->golomb_par;
+
+	s->rice = is_a_pow_of_2(s->golomb_par);
+}
+
+
+/**
+ * @brief (re)build the lookup table for a decoder setup if needed
+ *
+ * @param s	the decoder setup
+ */
+
+static void lut_build(const struct decoder_setup *s)
+{
+	uint32_t i;
+	uint32_t w;
+	uint32_t v;
+	uint32_t len;
+	uint32_t pos;
+
+	struct lut_entry *e;
+
+
+	if (lut_valid &&
+	    lut_setup.golomb_par  == s->golomb_par &&
+	    lut_setup.spill       == s->spill &&
+	    lut_setup.zero_escape == s->zero_escape)
+		return;
+
+	for (i = 0; i < (1UL << DECMP_LUT_BITS); i++) {
+
+		e   = &lut[i];
+		w   = i << (32 - DECMP_LUT_BITS);
+		pos = 0;
+
+		e->n = 0;
+
+		while (e->n < DECMP_LUT_MAX_SYM) {
+
+			len = golomb_decode_window(w << pos,
+						   DECMP_LUT_BITS - pos, s, &v);
+			if (!len)
+				break;
+
+			/* escape symbols are handled bitwise */
+			if (s->zero_escape) {
+				if (!v || v >= s->spill)
+					break;
+				v--;
+			} else {
+				if (v >= s->spill)
+					break;
+			}
+
+			pos += len;
+
+			e->len[e->n] = (uint8_t)  pos;
+			e->sym[e->n] = (uint16_t) v;
+			e->n++;
+
+			if (pos >= DECMP_LUT_BITS)
+				break;
+		}
+	}
+
+	lut_setup = (*s);
+	lut_valid = 1;
+}
+
+
+/**
+ * @brief decode a single mapped value bitwise, including escape sequences
+ *
+ * @param br	 the bit reader
+ * @param s	 the decoder setup
+ * @param mapped the decoded mapped value
+ * @param zero	 0: multi escape symbol mechanism, otherwise zero escape
+ *		 symbol mechanism
+ * @param rice	 0: Golomb code, otherwise Rice code
+ *
+ * @returns 0 on success, -1 on a corrupt bitstream
+ */
+
+static inline __attribute__((always_inline))
+int decode_value(struct bit_reader *br, const struct decoder_setup *s,
+		 uint32_t *mapped, const int zero, const int rice)
+{
+	uint32_t v;
+	uint32_t n;
+	uint32_t len;
+
+
+	br_refill(br);
+
+	if (rice)
+		len = rice_decode_window(br_peek(br, 32), 32, s, &v);
+	else
+		len = golomb_decode_window(br_peek(br, 32), 32, s, &v);
+	if (!len)
+		return -1;
+
+	br_consume(br, len);
+
+	if (zero) {
+		if (v >= s->spill)
+			return -1;
+
+		if (v) {
+			(*mapped) = v - 1;
+			return 0;
+		}
+
+		/* escape symbol, the value follows unencoded */
+		br_refill(br);
+		v = br_peek(br, DECMP_SAMPLE_BITS);
+		br_consume(br, DECMP_SAMPLE_BITS);
+
+		(*mapped) = (v - 1) & 0xFFFF;
+
+		return 0;
+	}
+
+	if (v < s->spill) {
+		(*mapped) = v;
+		return 0;
+	}
+
+	/* escape symbol, its offset selects the size of the unencoded value */
+	n = ((v - s->spill) + 1) << 1;
+	if (n > 32)
+		return -1;
+
+	br_refill(br);
+	v = br_peek(br, n);
+	br_consume(br, n);
+
+	v += s->spill;
+	if (v > 0xFFFF)
+		return -1;
+
+	(*mapped) = v;
+
+	return 0;
+}
+
+
+/**
+ * @brief decode the mapped values of a bitstream
+ *
+ * @param br	  the bit reader
+ * @param s	  the decoder setup
+ * @param data	  the buffer for the mapped values
+ * @param samples the number of values to decode
+ * @param zero	  0: multi escape symbol mechanism, otherwise zero escape
+ *		  symbol mechanism
+ * @param rice	  0: Golomb code, otherwise Rice code
+ *
+ * @note this is always inlined and only ever called with constant flags, so
+ *	 each escape mechanism and code gets its own loop
+ *
+ * @returns 0 on success, -1 on a corrupt bitstream
+ */
+
+static inline __attribute__((always_inline))
+int decode_mapped(struct bit_reader *br, const struct decoder_setup *s,
+		  uint16_t *data, uint32_t samples, const int zero,
+		  const int rice)
+{
+	uint32_t i, j, n;
+	uint32_t mapped;
+
+	const struct lut_entry *e;
+
+
+	for (i = 0; i < samples;) {
+
+		br_refill(br);
+
+		e = &lut[br_peek(br, DECMP_LUT_BITS)];
+
+		if (e->n) {
+			n = e->n;
+			if (n > samples - i)
+				n = samples - i;
+
+			for (j = 0; j < n; j++)
+				data[i + j] = e->sym[j];
+
+			br_consume(br, e->len[n - 1]);
+			i += n;
+			continue;
+		}
+
+		if (decode_value(br, s, &mapped, zero, rice)) {
+			printf("Error: corrupt bitstream at sample %lu.\n",
+			       (unsigned long) i);
+			return -1;
+		}
+
+		data[i++] = (uint16_t) mapped;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief map a positive number back to a signed 16 bit difference
+ *
+ * @param mapped the mapped value
+ *
+ * @returns the difference (modulo 2^16)
+ */
+
+static uint32_t map_to_signed(uint32_t mapped)
+{
+	if (mapped & 0x1)
+		return (0x10000 - ((mapped + 1) >> 1)) & 0xFFFF;
+
+	return mapped >> 1;
+}
+
+
+/**
+ * @brief undo the mapping, model prediction and rounding of decoded values
+ *
+ * @param data	   the mapped values, replaced by the samples
+ * @param model	   the model used for the compression
+ * @param up_model the buffer for the updated model; may be the same as model
+ * @param info	   compression information of the bitstream
+ * @param update   0: no updated model, otherwise it is written to up_model
+ *
+ * @note this is always inlined and only ever called with a constant update
+ *	 flag, so each variant gets its own loop
+ */
+
+static inline __attribute__((always_inline))
+void reconstruct_model(uint16_t *data, const uint16_t *model,
+		       uint16_t *up_model, const struct cmp_info *info,
+		       const int update)
+{
+	uint32_t i;
+	uint32_t x, m, d;
+
+
+	for (i = 0; i < info->samples_used; i++) {
+		x = map_to_signed(data[i]);
+		m = round_fwd(model[i], info->round_used);
+		d = (x + m) & 0xFFFF;
+
+		data[i] = (uint16_t) round_inv(d, info->round_used);
+
+		if (update)
+			up_model[i] = (uint16_t) cal_up_model(
+				data[i], round_inv(m, info->round_used),
+				info->model_value_used);
+	}
+}
+
+
+/**
+ * @brief decompress a bitstream of an RDCU or ICU compression
+ *
+ * @param compressed_data	the bitstream
+ * @param model_buf		the model used for the compression (model
+ *				modes only)
+ * @param info			compression information of the bitstream
+ * @param decompressed_data	the buffer for the decompressed samples (if
+ *				NULL, the required size is returned)
+ * @param up_model_buf		the buffer for the updated model (may be NULL,
+ *				model modes only); may be the same as model_buf
+ *
+ * @note only the RDCU compression modes are supported
+ * @note the updated model is calculated from the rounded back data and model
+ *
+ * @returns the size of the decompressed data in bytes, < 0 on error
+ */
+
+int decompress_data(const void *compressed_data, const void *model_buf,
+		    const struct cmp_info *info, void *decompressed_data,
+		    void *up_model_buf)
+{
+	int ret;
+
+	uint32_t i;
+	uint32_t x, d;
+	uint32_t prev;
+
+	uint16_t *data;
+	const uint16_t *model;
+	uint16_t *up_model;
+
+	struct bit_reader br;
+	struct decoder_setup s;
+
+
+	if (!info)
+		return -1;
+
+	if (!decompressed_data)
+		return (int) (info->samples_used * SAM2BYT);
+
+	if (!info->samples_used)
+		return 0;
+
+	if (!compressed_data)
+		return -1;
+
+	if (info->cmp_mode_used > MAX_RDCU_CMP_MODE) {
+		printf("Error: selected cmp_mode: %lu is not supported.\n",
+		       info->cmp_mode_used);
+		return -1;
+	}
+
+	if (info->round_used > MAX_ICU_ROUND)
+		return -1;
+
+	data = (uint16_t *) decompressed_data;
+
+	br_init(&br, compressed_data, (info->cmp_size + 7) >> 3);
+
+	if (raw_mode_is_used(info->cmp_mode_used)) {
+
+		for (i = 0; i < info->samples_used; i++) {
+			br_refill(&br);
+			data[i] = (uint16_t) br_peek(&br, DECMP_SAMPLE_BITS);
+			br_consume(&br, DECMP_SAMPLE_BITS);
+		}
+
+		if (br.n_bits > info->cmp_size)
+			return -1;
+
+		return (int) (info->samples_used * SAM2BYT);
+	}
+
+	if (info->golomb_par_used < MIN_RDCU_GOLOMB_PAR ||
+	    info->golomb_par_used > MAX_RDCU_GOLOMB_PAR)
+		return -1;
+
+	if (model_mode_is_used(info->cmp_mode_used)) {
+		if (!model_buf)
+			return -1;
+		if (info->model_value_used > MAX_MODEL_VALUE)
+			return -1;
+	}
+
+	decoder_setup(&s, info);
+	lut_build(&s);
+
+	/* first pass: decode the mapped values into the output buffer */
+	if (s.zero_escape && s.rice)
+		ret = decode_mapped(&br, &s, data, info->samples_used, 1, 1);
+	else if (s.zero_escape)
+		ret = decode_mapped(&br, &s, data, info->samples_used, 1, 0);
+	else if (s.rice)
+		ret = decode_mapped(&br, &s, data, info->samples_used, 0, 1);
+	else
+		ret = decode_mapped(&br, &s, data, info->samples_used, 0, 0);
+
+	if (ret)
+		return -1;
+
+	if (br.n_bits > info->cmp_size) {
+		printf("Error: the bitstream is shorter than expected.\n");
+		return -1;
+	}
+
+	/* second pass: undo mapping, prediction and rounding */
+	if (model_mode_is_used(info->cmp_mode_used)) {
+
+		model    = (const uint16_t *) model_buf;
+		up_model = (uint16_t *) up_model_buf;
+
+		if (up_model)
+			reconstruct_model(data, model, up_model, info, 1);
+		else
+			reconstruct_model(data, model, NULL, info, 0);
+	} else {
+
+		prev = 0;
+
+		for (i = 0; i < info->samples_used; i++) {
+			x = map_to_signed(data[i]);
+			d = (x + prev) & 0xFFFF;
+			prev = d;
+
+			data[i] = (uint16_t) round_inv(d, info->round_used);
+		}
+	}
+
+	return (int) (info->samples_used * SAM2BYT);
+}
@@ -0,0 +1,263 @@
+/**
+ * @file   dlog.c
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief deferred, ring-buffered logging
+ *
+ * Writers reserve a record by advancing the head index, fill it in and
+ * then stamp it with its index + 1 to mark it complete. The (single) reader
+ * prints records in order until it finds one that is not stamped yet, so a
+ * writer that was interrupted while filling in its record never exposes a
+ * partial message. If the log is full, new messages are dropped and counted,
+ * the oldest ones are usually the interesting ones.
+ *
+ * On the LEON, the reservation masks interrupts for a few instructions, as
+ * there is no atomic add or compare-and-swap in SPARC V8, everything else
+ * is done without locking. On the PC, a compare-and-swap is used, so
+ * several threads may log at the same time.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <compiler.h>
+#include <spinlock.h>
+#include <dlog.h>
+
+
+compile_time_assert(!(DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)),
+		    DLOG_RING_SIZE_NOT_A_POWER_OF_TWO);
+
+
+struct dlog_rec {
+	volatile uint32_t stamp;	/* index + 1 once complete */
+	const char *fmt;
+	uint32_t arg[3];
+};
+
+static struct dlog_rec dlog_ring[DLOG_RING_SIZE];
+
+static volatile uint32_t dlog_head;	/* next record to reserve */
+static volatile uint32_t dlog_tail;	/* next record to print */
+
+static volatile uint32_t dlog_lost_cnt;
+static uint32_t dlog_lost_reported;
+
+
+/**
+ * @brief load an index or stamp shared between writers and reader
+ *
+ * @note the accesses to a record cannot be moved before the load
+ */
+
+static uint32_t dlog_load(volatile uint32_t *p)
+{
+#if (__sparc__)
+	uint32_t v = *p;
+
+	barrier();
+
+	return v;
+#else /* assume PC */
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+
+/**
+ * @brief store an index or stamp shared between writers and reader
+ *
+ * @note the accesses to a record cannot be moved past the store
+ */
+
+static void dlog_store(volatile uint32_t *p, uint32_t v)
+{
+#if (__sparc__)
+	barrier();
+
+	*p = v;
+#else /* assume PC */
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#endif
+}
+
+
+/**
+ * @brief reserve the next record of the log
+ *
+ * @param idx the index of the record
+ *
+ * @returns 0 on success, -1 if the log is full
+ */
+
+static int dlog_reserve(uint32_t *idx)
+{
+#if (__sparc__)
+	int ret = -1;
+	uint32_t psr;
+
+
+	psr = spin_lock_save_irq();
+
+	if (dlog_head - dlog_tail < DLOG_RING_SIZE) {
+		*idx = dlog_head++;
+		ret = 0;
+	} else {
+		dlog_lost_cnt++;
+	}
+
+	spin_lock_restore_irq(psr);
+
+	return ret;
+#else /* assume PC */
+	uint32_t head;
+
+
+	do {
+		head = dlog_load(&dlog_head);
+
+		if (head - dlog_load(&dlog_tail) >= DLOG_RING_SIZE) {
+			__sync_fetch_and_add(&dlog_lost_cnt, 1);
+			return -1;
+		}
+
+	} while (!__sync_bool_compare_and_swap(&dlog_head, head, head + 1));
+
+	*idx = head;
+
+	return 0;
+#endif
+}
+
+
+/**
+ * @brief record a log message
+ *
+ * @param fmt	the printf format string of the message; it is referenced
+ *		until the message was printed and thus must be constant,
+ *		arguments are passed as unsigned long (i.e. use %lu, %lx...)
+ * @param a0	the first argument
+ * @param a1	the second argument
+ * @param a2	the third argument
+ *
+ * @note may be called from any context, use the dlog* macros instead so
+ *	 that messages can be compiled out
+ */
+
+void dlog_event(const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+	uint32_t idx;
+	struct dlog_rec *r;
+
+
+	if (dlog_reserve(&idx))
+		return;
+
+	r = &dlog_ring[idx & (DLOG_RING_SIZE - 1)];
+
+	r->fmt    = fmt;
+	r->arg[0] = a0;
+	r->arg[1] = a1;
+	r->arg[2] = a2;
+
+	dlog_store(&r->stamp, idx + 1);
+}
+
+
+/**
+ * @brief print the pending log messages
+ *
+ * @param max the maximum number of messages to print, 0 for all
+ *
+ * @returns the number of messages printed
+ *
+ * @note the log must only be drained from a single context
+ */
+
+int dlog_drain(unsigned int max)
+{
+	int n = 0;
+	uint32_t tail;
+	uint32_t lost;
+
+	struct dlog_rec r;
+	struct dlog_rec *p;
+
+
+	while (!max || (unsigned int) n < max) {
+
+		tail = dlog_tail;
+		if (tail == dlog_load(&dlog_head))
+			break;
+
+		p = &dlog_ring[tail & (DLOG_RING_SIZE - 1)];
+
+		/* reserved, but not yet complete */
+		if (dlog_load(&p->stamp) != tail + 1)
+			break;
+
+		r.fmt    = p->fmt;
+		r.arg[0] = p->arg[0];
+		r.arg[1] = p->arg[1];
+		r.arg[2] = p->arg[2];
+
+		/* the record may be reused now */
+		dlog_store(&dlog_tail, tail + 1);
+
+		printf(r.fmt, (unsigned long) r.arg[0],
+		       (unsigned long) r.arg[1], (unsigned long) r.arg[2]);
+		n++;
+	}
+
+	lost = dlog_lost();
+	if (lost != dlog_lost_reported) {
+		printf("dlog: %lu messages lost\n",
+		       (unsigned long) (lost - dlog_lost_reported));
+		dlog_lost_reported = lost;
+	}
+
+	return n;
+}
+
+
+/**
+ * @brief drain the log from a deferred interrupt callback
+ *
+ * @param userdata unused
+ *
+ * @returns 1 if messages are left, 0 otherwise
+ *
+ * @note register with PRIORITY_LATER; the callback prints DLOG_DRAIN_BATCH
+ *	 messages at a time and is queued again by irq_queue_execute() until
+ *	 the log is empty, so other deferred callbacks are served in between
+ */
+
+int32_t dlog_drain_irq(__attribute__((unused)) void *userdata)
+{
+	dlog_drain(DLOG_DRAIN_BATCH);
+
+	return dlog_tail != dlog_load(&dlog_head);
+}
+
+
+/**
+ * @brief get the number of messages lost because the log was full
+ *
+ * @returns the number of lost messages
+ */
+
+uint32_t dlog_lost(void)
+{
+	return dlog_load(&dlog_lost_cnt);
+}
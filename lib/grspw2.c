@@ -253,7 +253,7 @@ static int32_t grspw2_dma_error(void *userdata)
 
 	cfg = (struct grspw2_core_cfg *) userdata;
 
-	dmactrl = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	dmactrl = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 
 	if (dmactrl & GRSPW2_DMACONTROL_RA) {
 		errno = E_SPW_RX_AHB_ERROR;
@@ -267,7 +267,7 @@ static int32_t grspw2_dma_error(void *userdata)
 		dmactrl &= GRSPW2_DMACONTROL_TA;
 	}
 
-	iowrite32be(dmactrl, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(dmactrl, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 
 	return 0;
 }
@@ -382,9 +382,9 @@ static void grspw2_set_ahb_irq(struct grspw2_core_cfg *cfg)
 {
 	uint32_t dmactrl;
 
-	dmactrl  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	dmactrl  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	dmactrl |= GRSPW2_DMACONTROL_AI;
-	iowrite32be(dmactrl, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(dmactrl, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 
 #if (__unused__)
@@ -395,7 +395,7 @@ static void grspw2_unset_ahb_irq(struct grspw2_core_cfg *cfg)
 {
 	uint32_t dmactrl;
 
-	dmactrl  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	dmactrl  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	dmactrl &= ~GRSPW2_DMACONTROL_AI;
 }
 #endif
@@ -704,31 +704,33 @@ static void grspw2_clear_status(struct grspw2_core_cfg *cfg)
 
 /**
  * @brief set Receive Interrupt enable bit in the DMA register
+ *
+ * @note the interrupt is signalled on the core's interrupt line, see
+ *	 grspw2_core_init()
  */
-__attribute__((unused))
-static void grspw2_rx_interrupt_enable(struct grspw2_core_cfg *cfg)
+
+void grspw2_rx_interrupt_enable(struct grspw2_core_cfg *cfg)
 {
 	uint32_t flags;
 
-	flags  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	flags  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	flags |= GRSPW2_DMACONTROL_RI;
 
-	iowrite32be(flags, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 
 /**
  * @brief clear Receive Interrupt enable bit in the DMA register
  */
 
-__attribute__((unused))
-static void grspw2_rx_interrupt_disable(struct grspw2_core_cfg *cfg)
+void grspw2_rx_interrupt_disable(struct grspw2_core_cfg *cfg)
 {
 	uint32_t flags;
 
-	flags  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	flags  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	flags &= ~GRSPW2_DMACONTROL_RI;
 
-	iowrite32be(flags, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 
 
@@ -741,10 +743,10 @@ static void grspw2_tx_interrupt_enable(struct grspw2_core_cfg *cfg)
 {
 	uint32_t flags;
 
-	flags  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	flags  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	flags |= GRSPW2_DMACONTROL_TI;
 
-	iowrite32be(flags, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 #endif
 
@@ -758,10 +760,10 @@ static void grspw2_tx_interrupt_disable(struct grspw2_core_cfg *cfg)
 {
 	uint32_t flags;
 
-	flags  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	flags  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	flags &= ~GRSPW2_DMACONTROL_TI;
 
-	iowrite32be(flags, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 #endif
 
@@ -830,7 +832,8 @@ static int32_t grspw2_set_rx_desc_table_addr(struct grspw2_core_cfg *cfg,
 		return -1;
 	}
 
-	iowrite32be(((uint32_t) mem), &cfg->regs->dma[0].rx_desc_table_addr);
+	iowrite32be(((uint32_t) mem),
+		    &cfg->regs->dma[cfg->dma_chan].rx_desc_table_addr);
 
 	return 0;
 }
@@ -854,14 +857,15 @@ static int32_t grspw2_set_tx_desc_table_addr(struct grspw2_core_cfg *cfg,
 		return -1;
 	}
 
-	iowrite32be(((uint32_t) mem), &cfg->regs->dma[0].tx_desc_table_addr);
+	iowrite32be(((uint32_t) mem),
+		    &cfg->regs->dma[cfg->dma_chan].tx_desc_table_addr);
 
 	return 0;
 }
 
 
 /**
- * @brief init rx descriptor table pointers and attach to "free" list
+ * @brief init rx descriptor table pointers and reset the rx ring
  */
 
 int32_t grspw2_rx_desc_table_init(struct grspw2_core_cfg *cfg,
@@ -882,14 +886,16 @@ int32_t grspw2_rx_desc_table_init(struct grspw2_core_cfg *cfg,
 	if (grspw2_set_rx_desc_table_addr(cfg, mem))
 		return -1; /* errno set in call */
 
-	INIT_LIST_HEAD(&cfg->rx_desc_ring_used);
-	INIT_LIST_HEAD(&cfg->rx_desc_ring_free);
-
 	num_desc = tbl_size / GRSPW2_RX_DESC_SIZE;
 
 	if (num_desc > GRSPW2_RX_DESCRIPTORS)
 		num_desc = GRSPW2_RX_DESCRIPTORS;
 
+	/* the core starts at the first descriptor of the new table */
+	cfg->rx_desc_num  = num_desc;
+	cfg->rx_desc_head = 0;
+	cfg->rx_desc_tail = 0;
+
 	for (i = 0; i < num_desc; i++) {
 
 		idx = i * GRSPW2_RX_DESC_SIZE / sizeof(uint32_t);
@@ -900,9 +906,6 @@ int32_t grspw2_rx_desc_table_init(struct grspw2_core_cfg *cfg,
 
 		/* control flags must be set elsewhere */
 		cfg->rx_desc_ring[i].desc->pkt_ctrl = pkt_size;
-
-		list_add_tail(&cfg->rx_desc_ring[i].node,
-			      &cfg->rx_desc_ring_free);
 	}
 
 	return 0;
@@ -910,7 +913,7 @@ int32_t grspw2_rx_desc_table_init(struct grspw2_core_cfg *cfg,
 
 
 /**
- * @brief init tx descriptor table pointers and attach to "free" list
+ * @brief init tx descriptor table pointers and reset the tx ring
  */
 
 int32_t grspw2_tx_desc_table_init(struct grspw2_core_cfg *cfg,
@@ -936,25 +939,28 @@ int32_t grspw2_tx_desc_table_init(struct grspw2_core_cfg *cfg,
 	if (grspw2_set_tx_desc_table_addr(cfg, mem))
 		return -1; /* errno set in call */
 
-	INIT_LIST_HEAD(&cfg->tx_desc_ring_used);
-	INIT_LIST_HEAD(&cfg->tx_desc_ring_free);
-
 	num_desc = tbl_size / GRSPW2_TX_DESC_SIZE;
 
 	if (num_desc > GRSPW2_TX_DESCRIPTORS)
 		num_desc = GRSPW2_TX_DESCRIPTORS;
 
+	/* the core starts at the first descriptor of the new table */
+	cfg->tx_desc_num  = num_desc;
+	cfg->tx_desc_head = 0;
+	cfg->tx_desc_tail = 0;
+
 	for (i = 0; i < num_desc; i++) {
 
 		idx = i * GRSPW2_TX_DESC_SIZE / sizeof(uint32_t);
 		cfg->tx_desc_ring[i].desc = (struct grspw2_tx_desc *) &mem[idx];
 
 		idx = i * hdr_size;
-		cfg->tx_desc_ring[i].desc->hdr_addr = (uint32_t) &hdr_buf[idx];
+		cfg->tx_desc_ring[i].hdr_buf = (uint32_t) &hdr_buf[idx];
+		cfg->tx_desc_ring[i].desc->hdr_addr = cfg->tx_desc_ring[i].hdr_buf;
 
 		idx = i * data_size;
-		cfg->tx_desc_ring[i].desc->data_addr = (uint32_t)
-								&data_buf[idx];
+		cfg->tx_desc_ring[i].data_buf = (uint32_t) &data_buf[idx];
+		cfg->tx_desc_ring[i].desc->data_addr = cfg->tx_desc_ring[i].data_buf;
 
 		cfg->tx_desc_ring[i].desc->hdr_size  = hdr_size;
 		cfg->tx_desc_ring[i].desc->data_size = data_size;
@@ -963,9 +969,6 @@ int32_t grspw2_tx_desc_table_init(struct grspw2_core_cfg *cfg,
 		 * mark the descriptor as enabled
 		 */
 		cfg->tx_desc_ring[i].desc->pkt_ctrl  = 0;
-
-		list_add_tail(&cfg->tx_desc_ring[i].node,
-			      &cfg->tx_desc_ring_free);
 	}
 
 	return 0;
@@ -980,10 +983,10 @@ static void grspw2_rx_desc_new_avail(struct grspw2_core_cfg *cfg)
 {
 	uint32_t flags;
 
-	flags  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	flags  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	flags |= GRSPW2_DMACONTROL_RD | GRSPW2_DMACONTROL_RE;
 
-	iowrite32be(flags, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 
 
@@ -995,218 +998,249 @@ static void grspw2_tx_desc_new_avail(struct grspw2_core_cfg *cfg)
 {
 	uint32_t flags;
 
-	flags  = ioread32be(&cfg->regs->dma[0].ctrl_status);
+	flags  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
 	flags |= GRSPW2_DMACONTROL_TE;
 
-	iowrite32be(flags, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 
 
 /**
- * @brief	move a rx descriptor to the free ring
+ * @brief	advance a ring index
  */
 
-static void grspw2_rx_desc_move_free(struct grspw2_core_cfg *cfg,
-			      struct grspw2_rx_desc_ring_elem *p_elem)
+static uint32_t grspw2_ring_next(uint32_t idx, uint32_t num)
 {
-	list_move_tail(&p_elem->node, &cfg->rx_desc_ring_free);
+	idx++;
+
+	if (idx == 2 * num)
+		idx = 0;
+
+	return idx;
 }
 
 
 /**
- * @brief	move a tx descriptor to the free ring
+ * @brief	get the descriptor slot of a ring index
  */
 
-static void grspw2_tx_desc_move_free(struct grspw2_core_cfg *cfg,
-			      struct grspw2_tx_desc_ring_elem *p_elem)
+static uint32_t grspw2_ring_slot(uint32_t idx, uint32_t num)
 {
-	list_move_tail(&p_elem->node, &cfg->tx_desc_ring_free);
+	if (idx < num)
+		return idx;
+
+	return idx - num;
 }
 
 
 /**
- * @brief	move all inactive tx descriptors to the free ring
+ * @brief	get the number of descriptors between tail and head of a ring
  */
 
-__attribute__((unused))
-static void grspw2_tx_desc_move_free_all(struct grspw2_core_cfg *cfg)
+static uint32_t grspw2_ring_fill(uint32_t head, uint32_t tail, uint32_t num)
 {
-	struct grspw2_tx_desc_ring_elem *p_elem;
-	struct grspw2_tx_desc_ring_elem *p_tmp;
+	if (head >= tail)
+		return head - tail;
 
-	list_for_each_entry_safe(p_elem, p_tmp,
-				 &cfg->tx_desc_ring_used, node) {
+	return head + 2 * num - tail;
+}
 
-		if (p_elem->desc->pkt_ctrl & GRSPW2_TX_DESC_EN)
-			break;
 
-		grspw2_tx_desc_move_free(cfg, p_elem);
-	}
+/**
+ * @brief	release the oldest rx descriptor to the free part of the ring
+ */
+
+static void grspw2_rx_desc_release(struct grspw2_core_cfg *cfg)
+{
+	barrier();
+	cfg->rx_desc_tail = grspw2_ring_next(cfg->rx_desc_tail,
+					     cfg->rx_desc_num);
 }
 
 
-/*
- * @brief	clear the busy ring of all rx descriptors (and move them
- *		to the free ring)
+/**
+ * @brief	release all tx descriptors the core is done with in the order
+ *		they were handed to the core
  */
 
-__attribute__((unused))
-static void grspw2_rx_desc_clear_all(struct grspw2_core_cfg *cfg)
+static void grspw2_tx_desc_move_free_all(struct grspw2_core_cfg *cfg)
 {
-	struct grspw2_rx_desc_ring_elem *p_elem;
-	struct grspw2_rx_desc_ring_elem *p_tmp;
+	uint32_t tail;
+	struct grspw2_tx_desc *desc;
+
+
+	tail = cfg->tx_desc_tail;
 
-	list_for_each_entry_safe(p_elem, p_tmp,
-				 &cfg->rx_desc_ring_used, node) {
+	while (grspw2_ring_fill(cfg->tx_desc_head, tail, cfg->tx_desc_num)) {
 
-		grspw2_rx_desc_move_free(cfg, p_elem);
+		desc = cfg->tx_desc_ring[grspw2_ring_slot(tail,
+						cfg->tx_desc_num)].desc;
+		barrier();
+
+		if (desc->pkt_ctrl & GRSPW2_TX_DESC_EN)
+			break;
+
+		tail = grspw2_ring_next(tail, cfg->tx_desc_num);
 	}
+
+	barrier();
+	cfg->tx_desc_tail = tail;
 }
 
 
-/**
- * @brief	move a rx descriptor to the busy ring
+#if (__SPW_ROUTING__)
+/*
+ * @brief	deactivate all rx descriptors still owned by the core
+ *
+ * @note	descriptors the core has already completed are kept for
+ *		consumption, the remaining ones are disabled and the producer
+ *		index is moved back to the first of them, which is where the
+ *		core's descriptor selector points to
  */
 
-static void grspw2_rx_desc_move_busy(struct grspw2_core_cfg *cfg,
-			      struct grspw2_rx_desc_ring_elem *p_elem)
+static void grspw2_rx_desc_clear_all(struct grspw2_core_cfg *cfg)
 {
-	list_move_tail(&p_elem->node, &cfg->rx_desc_ring_used);
-}
+	uint32_t idx;
+	uint32_t first;
+	struct grspw2_rx_desc *desc;
 
 
-/**
- * @brief	move a tx descriptor to the busy ring
- */
+	idx = cfg->rx_desc_tail;
 
-static void grspw2_tx_desc_move_busy(struct grspw2_core_cfg *cfg,
-			      struct grspw2_tx_desc_ring_elem *p_elem)
-{
-	list_move_tail(&p_elem->node, &cfg->tx_desc_ring_used);
+	while (grspw2_ring_fill(cfg->rx_desc_head, idx, cfg->rx_desc_num)) {
+		desc = cfg->rx_desc_ring[grspw2_ring_slot(idx,
+						cfg->rx_desc_num)].desc;
+		if (desc->pkt_ctrl & GRSPW2_RX_DESC_EN)
+			break;
 
-}
+		idx = grspw2_ring_next(idx, cfg->rx_desc_num);
+	}
+
+	first = idx;
 
+	while (grspw2_ring_fill(cfg->rx_desc_head, idx, cfg->rx_desc_num)) {
+		desc = cfg->rx_desc_ring[grspw2_ring_slot(idx,
+						cfg->rx_desc_num)].desc;
+		desc->pkt_ctrl &= ~GRSPW2_RX_DESC_EN;
+
+		idx = grspw2_ring_next(idx, cfg->rx_desc_num);
+	}
+
+	barrier();
+	cfg->rx_desc_head = first;
+}
+#endif /* (__SPW_ROUTING__) */
 
 
 /**
- * @brief	retrieve a free rx descriptor
+ * @brief	retrieve the next free rx descriptor
  */
 
 static struct grspw2_rx_desc_ring_elem
 	*grspw2_rx_desc_get_next_free(struct grspw2_core_cfg *cfg)
 {
-	struct grspw2_rx_desc_ring_elem *p_elem;
+	uint32_t head = cfg->rx_desc_head;
 
-	if (likely(list_filled(&cfg->rx_desc_ring_free))) {
-		p_elem = list_entry((&cfg->rx_desc_ring_free)->next,
-				    struct grspw2_rx_desc_ring_elem, node);
-		return p_elem;
-	} else {
+
+	if (unlikely(grspw2_ring_fill(head, cfg->rx_desc_tail,
+				      cfg->rx_desc_num) == cfg->rx_desc_num))
 		return NULL;
-	}
+
+	return &cfg->rx_desc_ring[grspw2_ring_slot(head, cfg->rx_desc_num)];
 }
 
 /**
- * @brief	retrieve a busy rx descriptor
+ * @brief	retrieve the oldest busy rx descriptor
  */
 
 static struct grspw2_rx_desc_ring_elem
 	*grspw2_rx_desc_get_next_used(struct grspw2_core_cfg *cfg)
 {
-	struct grspw2_rx_desc_ring_elem *p_elem;
+	uint32_t tail = cfg->rx_desc_tail;
 
-	if (likely(list_filled(&cfg->rx_desc_ring_used))) {
-		p_elem = list_entry((&cfg->rx_desc_ring_used)->next,
-				    struct grspw2_rx_desc_ring_elem, node);
-		return p_elem;
-	} else {
+
+	if (unlikely(!grspw2_ring_fill(cfg->rx_desc_head, tail,
+				       cfg->rx_desc_num)))
 		return NULL;
-	}
+
+	barrier();
+
+	return &cfg->rx_desc_ring[grspw2_ring_slot(tail, cfg->rx_desc_num)];
 }
 
 
 /**
- * @brief	retrieve a free tx descriptor
+ * @brief	retrieve the next free tx descriptor
  */
 
 static struct grspw2_tx_desc_ring_elem
 		*grspw2_tx_desc_get_next_free(struct grspw2_core_cfg *cfg)
 {
-	struct grspw2_tx_desc_ring_elem *p_elem;
+	uint32_t head = cfg->tx_desc_head;
 
-	if (likely(list_filled(&cfg->tx_desc_ring_free))) {
-		p_elem = list_entry((&cfg->tx_desc_ring_free)->next,
-				    struct grspw2_tx_desc_ring_elem, node);
-		return p_elem;
-	} else {
+
+	if (unlikely(grspw2_ring_fill(head, cfg->tx_desc_tail,
+				      cfg->tx_desc_num) == cfg->tx_desc_num))
 		return NULL;
-	}
+
+	return &cfg->tx_desc_ring[grspw2_ring_slot(head, cfg->tx_desc_num)];
 }
 
 
 /**
- * @brief	set tx descriptor active
+ * @brief	set rx descriptor active and hand it to the core
  * @note	per-packet interrupt are enabled by default, enable rx irq
  *		in dma control register to have them actually fire
+ * @note	the last descriptor of the table is marked to wrap, so the
+ *		core follows the ring for tables shorter than the maximum
  */
 
-static void grspw2_rx_desc_set_active(struct grspw2_rx_desc_ring_elem *p_elem)
+static void grspw2_rx_desc_set_active(struct grspw2_core_cfg *cfg,
+				      struct grspw2_rx_desc_ring_elem *p_elem)
 {
-	p_elem->desc->pkt_ctrl |= GRSPW2_RX_DESC_IE | GRSPW2_RX_DESC_EN;
-}
+	uint32_t flags = GRSPW2_RX_DESC_IE | GRSPW2_RX_DESC_EN;
 
 
-/**
- * @brief	set tx descriptor active
- */
+	if (p_elem == &cfg->rx_desc_ring[cfg->rx_desc_num - 1])
+		flags |= GRSPW2_RX_DESC_WR;
 
-static void grspw2_tx_desc_set_active(struct grspw2_tx_desc_ring_elem *p_elem)
-{
-	p_elem->desc->pkt_ctrl |= GRSPW2_TX_DESC_IE | GRSPW2_TX_DESC_EN;
-}
+	/* complete the descriptor before the core may see it */
+	barrier();
+	p_elem->desc->pkt_ctrl |= flags;
 
-/**
- * @brief	check if there are rx descriptors in the free ring
- *
- * @return	1 if available, 0 if ring is empty
- */
-
-static int32_t grspw2_rx_desc_avail(struct grspw2_core_cfg *cfg)
-{
-	if (likely(list_filled(&cfg->rx_desc_ring_free)))
-		return 1;
-	else
-		return 0;
+	barrier();
+	cfg->rx_desc_head = grspw2_ring_next(cfg->rx_desc_head,
+					     cfg->rx_desc_num);
 }
 
 
-#if (__unused__)
 /**
- * @brief	check if there are tx descriptors in the free ring
+ * @brief	set tx descriptor active and hand it to the core
  *
- * @return	1 if available, 0 if ring is empty
+ * @param pkt_ctrl the control field of the descriptor, the wrap bit is
+ *	  added as needed
  */
 
-static int32_t grspw2_tx_desc_avail(struct grspw2_core_cfg *cfg)
+static void grspw2_tx_desc_set_active(struct grspw2_core_cfg *cfg,
+				      struct grspw2_tx_desc_ring_elem *p_elem,
+				      uint32_t pkt_ctrl)
 {
-	if (likely(list_filled(&cfg->tx_desc_ring_free)))
-		return 1;
-	else
-		return 0;
+	if (p_elem == &cfg->tx_desc_ring[cfg->tx_desc_num - 1])
+		pkt_ctrl |= GRSPW2_TX_DESC_WR;
+
+	/* complete the descriptor before the core may see it */
+	barrier();
+	p_elem->desc->pkt_ctrl = pkt_ctrl;
+
+	barrier();
+	cfg->tx_desc_head = grspw2_ring_next(cfg->tx_desc_head,
+					     cfg->tx_desc_num);
 }
-#endif
 
 
 /**
  * @brief	try to activate a free descriptor
  * @return	0 on success, -1 if no descriptor is available
- *
- * @note There is no check for NULL on grspw2_rx_desc_get_next_free(), because
- *       it would be redundant, since a positive return on
- *       grspw2_rx_desc_avail() guarantees the availability of a descriptor
- *       element. (Unless someone maliciously fiddles with our lists
- *       externally). We could of course check anyway, but this function should
- *       be snappy, if we can avoid something clearly useless, we should.
  */
 
 static int32_t grspw2_rx_desc_add(struct grspw2_core_cfg *cfg)
@@ -1214,17 +1248,12 @@ static int32_t grspw2_rx_desc_add(struct grspw2_core_cfg *cfg)
 	struct grspw2_rx_desc_ring_elem *p_elem;
 
 
-	if (!grspw2_rx_desc_avail(cfg))
-		return -1;
-	/* 
-	   The case p_elem == NULL is taken care for by the above check. 
-	   Also see the note in the function description.
-	*/
 	p_elem = grspw2_rx_desc_get_next_free(cfg);
 
-	grspw2_rx_desc_set_active(p_elem);
+	if (!p_elem)
+		return -1;
 
-	grspw2_rx_desc_move_busy(cfg, p_elem);
+	grspw2_rx_desc_set_active(cfg, p_elem);
 
 	grspw2_rx_desc_new_avail(cfg);
 
@@ -1264,11 +1293,17 @@ static int32_t grspw2_rx_desc_add_custom(struct grspw2_core_cfg *cfg,
 		return -1;
 	}
 
+	if (p_elem == &cfg->rx_desc_ring[cfg->rx_desc_num - 1])
+		pkt_ctrl |= GRSPW2_RX_DESC_WR;
+
 	/* ALWAYS set packet address first! */
 	p_elem->desc->pkt_addr = pkt_addr;
+	barrier();
 	p_elem->desc->pkt_ctrl = pkt_ctrl;
 
-	list_move_tail(&p_elem->node, &cfg->rx_desc_ring_used);
+	barrier();
+	cfg->rx_desc_head = grspw2_ring_next(cfg->rx_desc_head,
+					     cfg->rx_desc_num);
 
 	grspw2_rx_desc_new_avail(cfg);
 
@@ -1278,14 +1313,13 @@ static int32_t grspw2_rx_desc_add_custom(struct grspw2_core_cfg *cfg,
 
 
 /**
- * @brief	release and try to reactivate a descriptor
+ * @brief	release the oldest descriptor and try to reactivate a descriptor
  * @return	0 on success, -1 if no descriptor is available
  */
 
-static int32_t grspw2_rx_desc_readd(struct grspw2_core_cfg *cfg,
-			     struct grspw2_rx_desc_ring_elem *p_elem)
+static int32_t grspw2_rx_desc_readd(struct grspw2_core_cfg *cfg)
 {
-	grspw2_rx_desc_move_free(cfg, p_elem);
+	grspw2_rx_desc_release(cfg);
 
 	return grspw2_rx_desc_add(cfg);
 }
@@ -1307,6 +1341,8 @@ static int32_t grspw2_tx_desc_add_pkt(struct grspw2_core_cfg *cfg,
 			       const void *data_buf,
 			       uint32_t data_size)
 {
+	uint32_t pkt_ctrl;
+
 	struct grspw2_tx_desc_ring_elem *p_elem;
 
 
@@ -1332,25 +1368,32 @@ static int32_t grspw2_tx_desc_add_pkt(struct grspw2_core_cfg *cfg,
 		return -1;
 	}
 
+	/* the descriptor may have been used for a zero-copy transfer before */
+	p_elem->desc->hdr_addr  = p_elem->hdr_buf;
+	p_elem->desc->data_addr = p_elem->data_buf;
+
 	if (hdr_buf != NULL)
 		memcpy((void *) p_elem->desc->hdr_addr,  hdr_buf,  hdr_size);
 
 	if (data_buf != NULL)
 		memcpy((void *) p_elem->desc->data_addr, data_buf, data_size);
 
-	p_elem->desc->hdr_size  = hdr_size;
 	p_elem->desc->data_size = data_size;
 
+	/* the control word is written in one go, so no flags of a previous
+	 * packet are left over
+	 */
+	pkt_ctrl  = hdr_size & GRSPW2_TX_DESC_HDR_SIZE_MASK;
+	pkt_ctrl |= ((uint32_t) non_crc_bytes << GRSPW2_TX_DESC_NON_CRC_BYTES_BIT)
+		    & GRSPW2_TX_DESC_NON_CRC_BYTES_MASK;
+	pkt_ctrl |= GRSPW2_TX_DESC_IE | GRSPW2_TX_DESC_EN;
+
 	if (hdr_size)
-		p_elem->desc->append_header_crc = 1;
+		pkt_ctrl |= GRSPW2_TX_DESC_HC;
 	if (data_size)
-		p_elem->desc->append_data_crc = 1;
-	if (non_crc_bytes)
-		p_elem->desc->non_crc_bytes = non_crc_bytes & 0xF;
-
-	grspw2_tx_desc_set_active(p_elem);
+		pkt_ctrl |= GRSPW2_TX_DESC_DC;
 
-	grspw2_tx_desc_move_busy(cfg, p_elem);
+	grspw2_tx_desc_set_active(cfg, p_elem, pkt_ctrl);
 
 	grspw2_tx_desc_new_avail(cfg);
 
@@ -1359,7 +1402,6 @@ static int32_t grspw2_tx_desc_add_pkt(struct grspw2_core_cfg *cfg,
 }
 
 
-#if (__unused__)
 /**
  * @brief set up a TX descriptor with a custom header/data and control field.
  *
@@ -1391,15 +1433,75 @@ static int32_t grspw2_tx_desc_add_custom(struct grspw2_core_cfg *cfg,
 	p_elem->desc->data_size = data_size;
 	p_elem->desc->data_addr = data_addr;
 
-	p_elem->desc->pkt_ctrl = pkt_ctrl;
-
-	list_move_tail(&p_elem->node, &cfg->tx_desc_ring_used);
+	grspw2_tx_desc_set_active(cfg, p_elem, pkt_ctrl);
 
 	grspw2_tx_desc_new_avail(cfg);
 
 	return 0;
 }
-#endif
+
+
+/**
+ * @brief	try to activate a free descriptor, copy the header from the
+ *		supplied buffer and reference the data buffer directly
+ *
+ * @return	0 on success, -1 on failure
+ *
+ * @note	the data buffer must not be modified until the descriptor
+ *		was processed by the core, see grspw2_tx_pkt_pending()
+ * @note	USE WITH CARE: does not perform any size checks on the buffers
+ */
+
+static int32_t grspw2_tx_desc_add_pkt_ref(struct grspw2_core_cfg *cfg,
+					  const void *hdr_buf,
+					  uint32_t hdr_size,
+					  uint8_t non_crc_bytes,
+					  const void *data_buf,
+					  uint32_t data_size)
+{
+	uint32_t pkt_ctrl;
+
+	struct grspw2_tx_desc_ring_elem *p_elem;
+
+
+	if (hdr_size && !hdr_buf) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (data_size && !data_buf) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	grspw2_tx_desc_move_free_all(cfg);
+
+	/* this is the one grspw2_tx_desc_add_custom() will use */
+	p_elem = grspw2_tx_desc_get_next_free(cfg);
+
+	if (unlikely(!p_elem)) {
+		errno = E_SPW_NO_TX_DESC_AVAIL;
+		return -1;
+	}
+
+	/* headers are small and usually temporary, so we copy them anyway */
+	if (hdr_buf != NULL)
+		memcpy((void *) p_elem->hdr_buf, hdr_buf, hdr_size);
+
+	pkt_ctrl  = hdr_size & GRSPW2_TX_DESC_HDR_SIZE_MASK;
+	pkt_ctrl |= ((uint32_t) non_crc_bytes << GRSPW2_TX_DESC_NON_CRC_BYTES_BIT)
+		    & GRSPW2_TX_DESC_NON_CRC_BYTES_MASK;
+	pkt_ctrl |= GRSPW2_TX_DESC_IE | GRSPW2_TX_DESC_EN;
+
+	if (hdr_size)
+		pkt_ctrl |= GRSPW2_TX_DESC_HC;
+	if (data_size)
+		pkt_ctrl |= GRSPW2_TX_DESC_DC;
+
+	return grspw2_tx_desc_add_custom(cfg, pkt_ctrl,
+					 hdr_size,  p_elem->hdr_buf,
+					 data_size, (uint32_t) data_buf);
+}
 
 /**
  *  @brief configure maximum transmission unit
@@ -1407,7 +1509,30 @@ static int32_t grspw2_tx_desc_add_custom(struct grspw2_core_cfg *cfg,
 
 static void grspw2_set_mtu(struct grspw2_core_cfg *cfg, uint32_t mtu)
 {
-	iowrite32be(mtu, &cfg->regs->dma[0].rx_max_pkt_len);
+	iowrite32be(mtu, &cfg->regs->dma[cfg->dma_chan].rx_max_pkt_len);
+}
+
+
+/**
+ * @brief set the separate node address of a DMA channel
+ *
+ * @note packets addressed to the channel are received by the channel instead
+ *	 of the channel matching the default node address; the address must
+ *	 match exactly
+ */
+
+static void grspw2_set_dma_addr(struct grspw2_core_cfg *cfg, uint8_t addr)
+{
+	uint32_t flags;
+
+
+	iowrite32be(addr & GRSPW2_DMA_CHANNEL_ADDR_REG_MASK,
+		    &cfg->regs->dma[cfg->dma_chan].addr);
+
+	flags  = ioread32be(&cfg->regs->dma[cfg->dma_chan].ctrl_status);
+	flags |= GRSPW2_DMACONTROL_EN;
+
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 
 
@@ -1423,7 +1548,7 @@ static void grspw2_configure_dma(struct grspw2_core_cfg *cfg)
 		| GRSPW2_DMACONTROL_PR | GRSPW2_DMACONTROL_TA
 		| GRSPW2_DMACONTROL_RA | GRSPW2_DMACONTROL_NS;
 
-	iowrite32be(flags, &cfg->regs->dma[0].ctrl_status);
+	iowrite32be(flags, &cfg->regs->dma[cfg->dma_chan].ctrl_status);
 }
 
 
@@ -1477,11 +1602,10 @@ int32_t grspw2_route(void *userdata)
 	struct grspw2_core_cfg *cfg;
 
 	struct grspw2_rx_desc_ring_elem *p_elem;
-	struct grspw2_rx_desc_ring_elem *p_tmp;
 
 	cfg = (struct grspw2_core_cfg *) userdata;
 
-	list_for_each_entry_safe(p_elem, p_tmp, &cfg->rx_desc_ring_used, node) {
+	while ((p_elem = grspw2_rx_desc_get_next_used(cfg))) {
 
 		if (p_elem->desc->pkt_ctrl & GRSPW2_RX_DESC_EN)
 			break;
@@ -1497,7 +1621,7 @@ int32_t grspw2_route(void *userdata)
 		if (unlikely(ret))
 			break;
 
-		grspw2_rx_desc_readd(cfg, p_elem);
+		grspw2_rx_desc_readd(cfg);
 	}
 
 	grspw2_tx_desc_move_free_all(cfg->route[0]);
@@ -1578,15 +1702,25 @@ int32_t grspw2_disable_routing(struct grspw2_core_cfg *cfg)
 
 uint32_t grspw2_get_num_pkts_avail(struct grspw2_core_cfg *cfg)
 {
-	uint32_t i = 0;
+	uint32_t i;
+	uint32_t idx;
+	uint32_t fill;
 
-	struct grspw2_rx_desc_ring_elem *p_elem;
-	struct grspw2_rx_desc_ring_elem *p_tmp;
+	struct grspw2_rx_desc *desc;
 
-	list_for_each_entry_safe(p_elem, p_tmp, &cfg->rx_desc_ring_used, node) {
-		if (p_elem->desc->pkt_ctrl & GRSPW2_RX_DESC_EN)
+
+	idx  = cfg->rx_desc_tail;
+	fill = grspw2_ring_fill(cfg->rx_desc_head, idx, cfg->rx_desc_num);
+
+	barrier();
+
+	for (i = 0; i < fill; i++) {
+		desc = cfg->rx_desc_ring[grspw2_ring_slot(idx,
+						cfg->rx_desc_num)].desc;
+		if (desc->pkt_ctrl & GRSPW2_RX_DESC_EN)
 			break;
-		i++;
+
+		idx = grspw2_ring_next(idx, cfg->rx_desc_num);
 	}
 
 	return i;
@@ -1594,21 +1728,54 @@ uint32_t grspw2_get_num_pkts_avail(struct grspw2_core_cfg *cfg)
 
 
 /**
- * @brief get number of available free tx descriptors
+ * @brief check whether a tx buffer is still referenced by an active descriptor
+ *
+ * @param data the data buffer passed to grspw2_add_pkt_zero_copy()
+ *
+ * @returns 1 if the buffer is still in use by the core, 0 otherwise
  */
 
-uint32_t grspw2_get_num_free_tx_desc_avail(struct grspw2_core_cfg *cfg)
+uint32_t grspw2_tx_pkt_pending(struct grspw2_core_cfg *cfg, const void *data)
 {
-	uint32_t i = 0;
+	uint32_t idx;
 
-	struct grspw2_tx_desc_ring_elem *p_elem;
-	struct grspw2_tx_desc_ring_elem *p_tmp;
+	struct grspw2_tx_desc *desc;
+
+
+	grspw2_tx_desc_move_free_all(cfg);
 
-	list_for_each_entry_safe(p_elem, p_tmp, &cfg->tx_desc_ring_free, node) {
-		i++;
+	idx = cfg->tx_desc_tail;
+
+	while (grspw2_ring_fill(cfg->tx_desc_head, idx, cfg->tx_desc_num)) {
+
+		desc = cfg->tx_desc_ring[grspw2_ring_slot(idx,
+						cfg->tx_desc_num)].desc;
+
+		idx = grspw2_ring_next(idx, cfg->tx_desc_num);
+
+		if (!(desc->pkt_ctrl & GRSPW2_TX_DESC_EN))
+			continue;
+
+		if (desc->data_addr == (uint32_t) data)
+			return 1;
 	}
 
-	return i;
+	return 0;
+}
+
+
+/**
+ * @brief get number of available free tx descriptors
+ */
+
+uint32_t grspw2_get_num_free_tx_desc_avail(struct grspw2_core_cfg *cfg)
+{
+	/* collect the descriptors the core is done with */
+	grspw2_tx_desc_move_free_all(cfg);
+
+	return cfg->tx_desc_num - grspw2_ring_fill(cfg->tx_desc_head,
+						   cfg->tx_desc_tail,
+						   cfg->tx_desc_num);
 }
 
 
@@ -1673,11 +1840,46 @@ uint32_t grspw2_get_pkt(struct grspw2_core_cfg *cfg, uint8_t *pkt)
 	       (void *) (p_elem->desc->pkt_addr + cfg->strip_hdr_bytes),
 	       pkt_size);
 
-	grspw2_rx_desc_readd(cfg, p_elem);
+	grspw2_rx_desc_readd(cfg);
 
 	return pkt_size;
 }
 
+/**
+ * @brief get a reference to the next packet in the rx descriptor buffer
+ *
+ * @param pkt a pointer to the packet reference to set
+ *	  if NULL, the size of the pending packet is returned
+ *
+ * @returns the size of the packet, 0 if none is available
+ *
+ * @note the packet is not removed from the descriptor ring, call
+ *	 grspw2_drop_pkt() to release the descriptor once you're done with
+ *	 the buffer
+ */
+
+uint32_t grspw2_peek_pkt(struct grspw2_core_cfg *cfg, uint8_t **pkt)
+{
+	struct grspw2_rx_desc_ring_elem *p_elem;
+
+
+	p_elem = grspw2_rx_desc_get_next_used(cfg);
+
+	if (!p_elem)
+		return 0;
+
+	/* still active */
+	if (p_elem->desc->pkt_ctrl & GRSPW2_RX_DESC_EN)
+		return 0;
+
+	if (pkt)
+		(*pkt) = (uint8_t *) (p_elem->desc->pkt_addr
+				      + cfg->strip_hdr_bytes);
+
+	return p_elem->desc->pkt_size - cfg->strip_hdr_bytes;
+}
+
+
 /**
  * @brief drop a packet
  * @return 1 if packet was dropped, 0 otherwise
@@ -1699,13 +1901,117 @@ uint32_t grspw2_drop_pkt(struct grspw2_core_cfg *cfg)
 
 	cfg->rx_bytes += p_elem->desc->pkt_size;
 
-	grspw2_rx_desc_readd(cfg, p_elem);
+	grspw2_rx_desc_readd(cfg);
 
 	return 1;
 }
 
 
 
+/**
+ * @brief get references to all packets ready in the rx descriptor ring
+ *
+ * @param pkts an array to store up to n packet references in
+ * @param sizes an array to store up to n packet sizes in
+ * @param n the number of array elements
+ *
+ * @returns the number of packets referenced, 0 if none is available
+ *
+ * @note the packets are not removed from the descriptor ring, call
+ *	 grspw2_release_pkts() with the number of packets you are done with
+ *	 to release their descriptors in one go
+ */
+
+uint32_t grspw2_get_pkts(struct grspw2_core_cfg *cfg,
+			 uint8_t **pkts, uint32_t *sizes, uint32_t n)
+{
+	uint32_t i;
+	uint32_t idx;
+	uint32_t fill;
+
+	struct grspw2_rx_desc *desc;
+
+
+	idx  = cfg->rx_desc_tail;
+	fill = grspw2_ring_fill(cfg->rx_desc_head, idx, cfg->rx_desc_num);
+
+	if (n > fill)
+		n = fill;
+
+	barrier();
+
+	for (i = 0; i < n; i++) {
+		desc = cfg->rx_desc_ring[grspw2_ring_slot(idx,
+						cfg->rx_desc_num)].desc;
+
+		/* still active */
+		if (desc->pkt_ctrl & GRSPW2_RX_DESC_EN)
+			break;
+
+		pkts[i]  = (uint8_t *) (desc->pkt_addr + cfg->strip_hdr_bytes);
+		sizes[i] = desc->pkt_size - cfg->strip_hdr_bytes;
+
+		idx = grspw2_ring_next(idx, cfg->rx_desc_num);
+	}
+
+	return i;
+}
+
+
+/**
+ * @brief release packets referenced by grspw2_get_pkts()
+ *
+ * @param n the number of packets to release
+ *
+ * @returns the number of packets released
+ *
+ * @note the descriptors are reactivated in a batch, the core is only
+ *	 notified once
+ */
+
+uint32_t grspw2_release_pkts(struct grspw2_core_cfg *cfg, uint32_t n)
+{
+	uint32_t i;
+	uint32_t j;
+
+	struct grspw2_rx_desc_ring_elem *p_elem;
+
+
+	for (i = 0; i < n; i++) {
+
+		p_elem = grspw2_rx_desc_get_next_used(cfg);
+
+		if (!p_elem)
+			break;
+
+		if (p_elem->desc->pkt_ctrl & GRSPW2_RX_DESC_EN)
+			break;
+
+		cfg->rx_bytes += p_elem->desc->pkt_size;
+
+		grspw2_rx_desc_release(cfg);
+	}
+
+	if (!i)
+		return 0;
+
+	/* reactivate as many descriptors as were released */
+	for (j = 0; j < i; j++) {
+
+		p_elem = grspw2_rx_desc_get_next_free(cfg);
+
+		if (!p_elem)
+			break;
+
+		grspw2_rx_desc_set_active(cfg, p_elem);
+	}
+
+	grspw2_rx_desc_new_avail(cfg);
+
+	return i;
+}
+
+
 /**
  * @brief add a packet
  */
@@ -1731,6 +2037,34 @@ int32_t grspw2_add_pkt(struct grspw2_core_cfg *cfg,
 }
 
 
+/**
+ * @brief add a packet without copying the data payload
+ *
+ * @note the data buffer is referenced by the descriptor and must remain
+ *	 unchanged until the core has sent it, see grspw2_tx_pkt_pending()
+ */
+
+int32_t grspw2_add_pkt_zero_copy(struct grspw2_core_cfg *cfg,
+				 const void *hdr,  uint32_t hdr_size,
+				 const uint8_t non_crc_bytes,
+				 const void *data, uint32_t data_size)
+{
+	int32_t ret;
+
+	ret = grspw2_tx_desc_add_pkt_ref(cfg, hdr, hdr_size, non_crc_bytes,
+					 data, data_size);
+
+	if (unlikely(ret)) {
+		grspw2_handle_error(LOW);
+		return -1;
+	}
+
+	cfg->tx_bytes += hdr_size + data_size;
+
+	return 0;
+}
+
+
 /**
   * @brief start core operation
  */
@@ -1744,6 +2078,85 @@ void grspw2_core_start(struct grspw2_core_cfg *cfg)
 }
 
 
+/**
+ * @brief start operation of an additional DMA channel
+ *
+ * @note the link is started by grspw2_core_start() of the core configuration
+ */
+
+void grspw2_dma_chan_start(struct grspw2_core_cfg *cfg)
+{
+	grswp2_rx_desc_add_all(cfg);
+}
+
+
+/**
+ * @brief (re)initialise an additional DMA channel of a grspw2 core
+ *
+ * @param cfg the configuration of the channel
+ * @param core the configuration of the core, see grspw2_core_init()
+ * @param channel the DMA channel (1 to the number of implemented channels - 1)
+ * @param addr the separate node address of the channel
+ * @param mtu the maximum size of the packets received on the channel
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note every channel has its own descriptor tables, initialise them with
+ *	 grspw2_rx_desc_table_init() and grspw2_tx_desc_table_init() and use
+ *	 the channel configuration with all packet functions; packets addressed
+ *	 to addr are received on the channel, all others on channel 0
+ * @note the channels are serviced round-robin by the core, so small packets
+ *	 on one channel are not stuck behind large transfers on another
+ * @note packets are only distributed by address if promiscuous mode is off
+ */
+
+int32_t grspw2_dma_chan_init(struct grspw2_core_cfg *cfg,
+			     struct grspw2_core_cfg *core,
+			     uint32_t channel, uint8_t addr, uint32_t mtu)
+{
+	uint32_t nch;
+
+
+	if (!cfg || !core) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	nch = GRSPW2_CTRL_GET_NCH(ioread32be(&core->regs->ctrl));
+
+	if (!channel || channel >= nch) {
+		errno = E_SPW_DMA_CHANNEL_INVALID;
+		return -1;
+	}
+
+	cfg->regs     = core->regs;
+	cfg->dma_chan = channel;
+	cfg->core_irq = core->core_irq;
+	cfg->ahb_irq  = core->ahb_irq;
+
+	cfg->strip_hdr_bytes = core->strip_hdr_bytes;
+
+	grspw2_dma_stop(cfg->regs, channel);
+	grspw2_dma_reset(cfg->regs, channel);
+
+	irl1_deregister_callback(cfg->ahb_irq, grspw2_dma_error, cfg);
+
+	grspw2_set_mtu(cfg, mtu);
+	grspw2_configure_dma(cfg);
+	grspw2_set_dma_addr(cfg, addr);
+
+	grspw2_set_ahb_irq(cfg);
+
+	irl1_register_callback(cfg->ahb_irq, PRIORITY_NOW,
+			       grspw2_dma_error, cfg);
+
+	cfg->rx_bytes = 0;
+	cfg->tx_bytes = 0;
+
+	return 0;
+}
+
+
 /**
  * @brief (re)initialise a grswp2 core
  */
@@ -1770,6 +2183,7 @@ int32_t grspw2_core_init(struct grspw2_core_cfg *cfg, uint32_t core_addr,
 	irq_dispatch_enable();
 
 	cfg->regs = (struct grspw2_regs *) core_addr;
+	cfg->dma_chan = 0;
 	cfg->core_irq = core_irq;
 	cfg->ahb_irq  = ahb_irq;
 
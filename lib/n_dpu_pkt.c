@@ -18,12 +18,104 @@
 
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "../include/dlog.h"
 #include "../include/n_dpu_pkt.h"
 #include "../include/cmp_support.h"
 
 
+/* a word of two 16 bit samples; may alias the uint16_t sample buffers */
+typedef uint32_t __attribute__((may_alias)) sample_pair_t;
+
+/* an unaligned 32 bit field of a packed N-DPU entry */
+struct u32_field {
+	uint32_t v;
+} __attribute__((packed));
+
+
+/**
+ * @brief round down consecutive 32 bit fields of every entry of a buffer
+ *
+ * @param buf		the buffer
+ * @param stride	the size of an entry in bytes
+ * @param offset	the offset of the first field in an entry
+ * @param n_fields	the number of consecutive 32 bit fields to round
+ * @param samples	the number of entries
+ * @param round		number of bits to round (> 0)
+ */
+
+static void round_fwd_fields(void *buf, size_t stride, size_t offset,
+			     unsigned int n_fields, size_t samples,
+			     unsigned int round)
+{
+	size_t i;
+	unsigned int j;
+
+	uint8_t *p = (uint8_t *) buf + offset;
+	struct u32_field *f;
+
+
+	for (i = 0; i < samples; i++, p += stride) {
+		f = (struct u32_field *) p;
+		for (j = 0; j < n_fields; j++)
+			f[j].v >>= round;	/* same as round_fwd() */
+	}
+}
+
+
+/**
+ * @brief round back consecutive 32 bit fields of every entry of a buffer
+ *
+ * @param buf		the buffer
+ * @param stride	the size of an entry in bytes
+ * @param offset	the offset of the first field in an entry
+ * @param n_fields	the number of consecutive 32 bit fields to round
+ * @param samples	the number of entries
+ * @param round		number of bits to round (> 0)
+ *
+ * @returns 0 on success, -1 if a field is too large to be rounded back; the
+ *	    buffer is not modified then
+ *
+ * @note all fields are checked in a first pass with a single test over the
+ *	 OR of all of them, so the buffer is only modified if all fit
+ */
+
+static int round_inv_fields(void *buf, size_t stride, size_t offset,
+			    unsigned int n_fields, size_t samples,
+			    unsigned int round)
+{
+	size_t i;
+	unsigned int j;
+	uint32_t acc = 0;
+
+	uint8_t *p = (uint8_t *) buf + offset;
+	struct u32_field *f;
+
+
+	for (i = 0; i < samples; i++, p += stride) {
+		f = (struct u32_field *) p;
+		for (j = 0; j < n_fields; j++)
+			acc |= f[j].v;
+	}
+
+	/* check if data are too big, i.e. would overflow */
+	if (acc & (~0UL << (32 - round)))
+		return -1;
+
+	p = (uint8_t *) buf + offset;
+
+	for (i = 0; i < samples; i++, p += stride) {
+		f = (struct u32_field *) p;
+		for (j = 0; j < n_fields; j++)
+			f[j].v <<= round;	/* same as round_inv() */
+	}
+
+	return 0;
+}
+
+
 /**
  * @brief rounding down the least significant digits of a uint16_t data buffer
  *
@@ -40,7 +132,13 @@
 int lossy_rounding_16(uint16_t *data_buf, unsigned int samples, unsigned int
 		      round)
 {
-	size_t i;
+	size_t i = 0;
+	size_t j;
+	size_t n_pairs;
+
+	uint32_t mask;
+	sample_pair_t *w;
+
 
 	if (!samples)
 		return 0;
@@ -53,8 +151,26 @@ int lossy_rounding_16(uint16_t *data_buf, unsigned int samples, unsigned int
 	if (round == 0)
 		return 0;
 
-	for (i = 0; i < samples; i++)
-		data_buf[i] = round_down(data_buf[i], round);  /* this is the lossy step */
+	if (round >= 16)
+		return -1;
+
+	/* process two samples per word; the mask removes the bits shifted
+	 * over from the neighbouring sample */
+	mask = (0xFFFFUL >> round) * 0x10001UL;
+
+	if ((uintptr_t) data_buf & 0x2)
+		data_buf[i++] >>= round;
+
+	w = (sample_pair_t *) &data_buf[i];
+	n_pairs = (samples - i) / 2;
+
+	for (j = 0; j < n_pairs; j++)
+		w[j] = (w[j] >> round) & mask;  /* this is the lossy step */
+
+	i += n_pairs * 2;
+
+	if (i < samples)
+		data_buf[i] >>= round;
 
 	return 0;
 }
@@ -67,13 +183,22 @@ int lossy_rounding_16(uint16_t *data_buf, unsigned int samples, unsigned int
  * @param samples_used	the size of the data and model buffer in 16 bit units
  * @param round_used	used number of bits to round; if zero no rounding takes place
  *
- * @returns 0 on success, error otherwise
+ * @returns 0 on success, error otherwise; on error, the buffer is unchanged
  */
 
 int de_lossy_rounding_16(uint16_t *data_buf, uint32_t samples_used, uint32_t
 			 round_used)
 {
-	size_t i;
+	size_t head;
+	size_t tail;
+	size_t j;
+	size_t n_pairs;
+
+	uint32_t acc = 0;
+	uint32_t mask;
+	uint32_t ovf;
+	sample_pair_t *w;
+
 
 	if (!samples_used)
 		return 0;
@@ -85,15 +210,44 @@ int de_lossy_rounding_16(uint16_t *data_buf, uint32_t samples_used, uint32_t
 	if (round_used == 0)
 		return 0;
 
-	for (i = 0; i < samples_used; i++) {
-		/* check if data are not to big for a overflow */
-		uint16_t mask = (uint16_t)(~0 << (16-round_used));
-		if (data_buf[i] & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		data_buf[i] = round_back(data_buf[i], round_used);
+	if (round_used >= 16)
+		return -1;
+
+	/* the bits that are shifted out of a sample must be zero */
+	ovf  = (~(0xFFFFUL >> round_used) & 0xFFFFUL) * 0x10001UL;
+	mask = ((0xFFFFUL << round_used) & 0xFFFFUL) * 0x10001UL;
+
+	/* an unaligned head sample is handled on its own */
+	head = (uintptr_t) data_buf & 0x2 ? 1 : 0;
+
+	w = (sample_pair_t *) &data_buf[head];
+	n_pairs = (samples_used - head) / 2;
+	tail = head + n_pairs * 2;
+
+	/* check all samples before the buffer is modified */
+	if (head)
+		acc |= data_buf[0];
+
+	for (j = 0; j < n_pairs; j++)
+		acc |= w[j];
+
+	if (tail < samples_used)
+		acc |= data_buf[tail];
+
+	if (acc & ovf) {
+		dlog0("Error: data are too large to be rounded back.\n");
+		return -1;
 	}
+
+	if (head)
+		data_buf[0] = (uint16_t) (data_buf[0] << round_used);
+
+	for (j = 0; j < n_pairs; j++)
+		w[j] = (w[j] << round_used) & mask;
+
+	if (tail < samples_used)
+		data_buf[tail] = (uint16_t) (data_buf[tail] << round_used);
+
 	return 0;
 }
 
@@ -116,6 +270,7 @@ int lossy_rounding_32(uint32_t *data_buf, unsigned int samples, unsigned int
 {
 	size_t i;
 
+
 	if (!samples)
 		return 0;
 
@@ -127,8 +282,11 @@ int lossy_rounding_32(uint32_t *data_buf, unsigned int samples, unsigned int
 	if (round == 0)
 		return 0;
 
+	if (round >= 32)
+		return -1;
+
 	for (i = 0; i < samples; i++)
-		data_buf[i] = round_down(data_buf[i], round);  /* this is the lossy step */
+		data_buf[i] >>= round;  /* this is the lossy step */
 
 	return 0;
 }
@@ -138,6 +296,8 @@ int de_lossy_rounding_32(uint32_t *data_buf, uint32_t samples_used, uint32_t
 			 round_used)
 {
 	size_t i;
+	uint32_t acc = 0;
+
 
 	if (!samples_used)
 		return 0;
@@ -149,19 +309,249 @@ int de_lossy_rounding_32(uint32_t *data_buf, uint32_t samples_used, uint32_t
 	if (round_used == 0)
 		return 0;
 
-	for (i = 0; i < samples_used; i++) {
-		/* check if data are not to big for a overflow */
-		uint32_t mask = (uint32_t)(~0 << (32-round_used));
-		if (data_buf[i] & mask) {
-			printf("learn how to print debug messages!");
+	if (round_used >= 32)
+		return -1;
+
+	for (i = 0; i < samples_used; i++)
+		acc |= data_buf[i];
+
+	/* check if data are too big, i.e. would overflow */
+	if (acc & (~0UL << (32 - round_used))) {
+		dlog0("Error: data are too large to be rounded back.\n");
+		return -1;
+	}
+
+	for (i = 0; i < samples_used; i++)
+		data_buf[i] <<= round_used;
+
+	return 0;
+}
+
+/**
+ * @brief get the layout of an N-DPU entry type from its size
+ *
+ * @param entry_size	the size of the entry type, e.g. sizeof(struct S_FX_NCOB)
+ * @param n_fields	set to the number of 32 bit fields of the entry
+ *
+ * @note S_ entries start with a byte of exposure flags followed by the 32 bit
+ *	 fields, F_ entries only consist of 32 bit fields
+ *
+ * @returns 1 if the entry has exposure flags, 0 if not, -1 on error
+ */
+
+int n_dpu_get_layout(size_t entry_size, unsigned int *n_fields)
+{
+	unsigned int flags = entry_size & 0x3;
+
+
+	if (!n_fields)
+		return -1;
+
+	if (flags > 1)
+		return -1;
+
+	*n_fields = (unsigned int) (entry_size / sizeof(uint32_t));
+
+	if (!*n_fields || *n_fields > N_DPU_FIELDS_MAX)
+		return -1;
+
+	return (int) flags;
+}
+
+
+/**
+ * @brief split a buffer of N-DPU entries into one stream per field
+ *
+ * @param data_buf	a buffer of N-DPU entries of any S_ or F_ type
+ * @param samples	the number of entries in the buffer
+ * @param entry_size	the size of one entry, e.g. sizeof(struct S_FX_NCOB)
+ * @param s		the streams to write to; a stream of samples bytes for
+ *			the exposure flags (S_ types only) and one stream of
+ *			samples 32 bit words for every field of the entry
+ *
+ * @note the field streams are accessed aligned, so they can be compressed
+ *	 separately, each with compression parameters of its own
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int n_dpu_split(const void *data_buf, unsigned int samples, size_t entry_size,
+		struct n_dpu_streams *s)
+{
+	int flags;
+	unsigned int i;
+	unsigned int j;
+	unsigned int n_fields;
+
+	const uint8_t *p;
+	const struct u32_field *f;
+
+
+	if (!samples)
+		return 0;
+
+	if (!data_buf || !s)
+		return -1;
+
+	flags = n_dpu_get_layout(entry_size, &n_fields);
+	if (flags < 0)
+		return -1;
+
+	if (flags) {
+		if (!s->exposure_flags)
+			return -1;
+
+		p = (const uint8_t *) data_buf;
+		for (i = 0; i < samples; i++, p += entry_size)
+			s->exposure_flags[i] = p[0];
+	}
+
+	/* one field at a time, so every output stream is written sequentially */
+	for (j = 0; j < n_fields; j++) {
+		uint32_t *dst = s->field[j];
+
+		if (!dst)
+			return -1;
+
+		p = (const uint8_t *) data_buf + flags + j * sizeof(uint32_t);
+		for (i = 0; i < samples; i++, p += entry_size) {
+			f = (const struct u32_field *) p;
+			dst[i] = f->v;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief join the field streams of N-DPU entries into an entry buffer; this is
+ *	  the inverse of n_dpu_split()
+ *
+ * @param data_buf	a buffer of N-DPU entries of any S_ or F_ type
+ * @param samples	the number of entries in the buffer
+ * @param entry_size	the size of one entry, e.g. sizeof(struct S_FX_NCOB)
+ * @param s		the streams to read from
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int n_dpu_join(void *data_buf, unsigned int samples, size_t entry_size,
+	       const struct n_dpu_streams *s)
+{
+	int flags;
+	unsigned int i;
+	unsigned int j;
+	unsigned int n_fields;
+
+	uint8_t *p;
+	struct u32_field *f;
+
+
+	if (!samples)
+		return 0;
+
+	if (!data_buf || !s)
+		return -1;
+
+	flags = n_dpu_get_layout(entry_size, &n_fields);
+	if (flags < 0)
+		return -1;
+
+	if (flags) {
+		if (!s->exposure_flags)
 			return -1;
+
+		p = (uint8_t *) data_buf;
+		for (i = 0; i < samples; i++, p += entry_size)
+			p[0] = s->exposure_flags[i];
+	}
+
+	for (j = 0; j < n_fields; j++) {
+		const uint32_t *src = s->field[j];
+
+		if (!src)
+			return -1;
+
+		p = (uint8_t *) data_buf + flags + j * sizeof(uint32_t);
+		for (i = 0; i < samples; i++, p += entry_size) {
+			f = (struct u32_field *) p;
+			f->v = src[i];
 		}
-		data_buf[i] = round_back(data_buf[i], round_used);
 	}
+
+	return 0;
+}
+
+/**
+ * @brief update a whole model buffer of N-DPU entries in-place
+ *
+ * @param model_buf	the model buffer to update; S_ or F_ type entries
+ * @param data_buf	the data buffer of the same entry type
+ * @param samples	the number of entries in the buffers
+ * @param entry_size	the size of one entry, e.g. sizeof(struct S_FX_NCOB)
+ * @param model_value	model weighting parameter
+ *
+ * @note the result is identical to calling the cal_up_model_* function of the
+ *	 entry type for every entry
+ *
+ * @returns 0 on success, error otherwise
+ */
+
+int n_dpu_cal_up_model(void *model_buf, const void *data_buf,
+		       unsigned int samples, size_t entry_size,
+		       unsigned int model_value)
+{
+	int flags;
+	unsigned int i;
+	unsigned int j;
+	unsigned int n_fields;
+
+	uint64_t wd;
+	uint8_t *m;
+	const uint8_t *d;
+	struct u32_field *mf;
+	const struct u32_field *df;
+
+
+	if (!samples)
+		return 0;
+
+	if (!model_buf || !data_buf)
+		return -1;
+
+	if (model_value > MAX_MODEL_VALUE)
+		return -1;
+
+	flags = n_dpu_get_layout(entry_size, &n_fields);
+	if (flags < 0)
+		return -1;
+
+	wd = MAX_MODEL_VALUE - model_value;
+
+	m = (uint8_t *) model_buf;
+	d = (const uint8_t *) data_buf;
+
+	for (i = 0; i < samples; i++, m += entry_size, d += entry_size) {
+
+		if (flags)
+			m[0] = (uint8_t) ((m[0] * model_value + d[0] * wd) /
+					  MAX_MODEL_VALUE);
+
+		mf = (struct u32_field *) (m + flags);
+		df = (const struct u32_field *) (d + flags);
+
+		for (j = 0; j < n_fields; j++)
+			mf[j].v = (uint32_t) (((uint64_t) mf[j].v * model_value +
+					       df[j].v * wd) / MAX_MODEL_VALUE);
+	}
+
 	return 0;
 }
 
 
+
+
 struct S_FX sub_S_FX(struct S_FX a, struct S_FX b)
 {
 	struct S_FX result;
@@ -201,8 +591,6 @@ struct S_FX add_S_FX(struct S_FX a, struct S_FX b)
 int lossy_rounding_S_FX(struct S_FX *data_buf, unsigned int samples, unsigned
 			int round)
 {
-	size_t i;
-
 	if (!samples)
 		return 0;
 
@@ -214,8 +602,12 @@ int lossy_rounding_S_FX(struct S_FX *data_buf, unsigned int samples, unsigned
 	if (round == 0)
 		return 0;
 
-	for (i = 0; i < samples; i++)
-		data_buf[i].FX = round_down(data_buf[i].FX, round);
+	if (round >= 32)
+		return -1;
+
+	/* all fields but the exposure flags are rounded */
+	round_fwd_fields(data_buf, sizeof(struct S_FX),
+			 offsetof(struct S_FX, FX), 1, samples, round);
 
 	return 0;
 }
@@ -224,8 +616,6 @@ int lossy_rounding_S_FX(struct S_FX *data_buf, unsigned int samples, unsigned
 int de_lossy_rounding_S_FX(struct S_FX *data_buf, unsigned int samples_used,
 			   unsigned int round_used)
 {
-	size_t i;
-
 	if (!samples_used)
 		return 0;
 
@@ -235,18 +625,16 @@ int de_lossy_rounding_S_FX(struct S_FX *data_buf, unsigned int samples_used,
 	if (round_used == 0) /* round 0 means loss less compression, no further processing is necessary */
 		return 0;
 
-	for (i = 0; i < samples_used; i++) {
-		uint32_t mask = (~0U << (32-round_used));
-
-		if (data_buf[i].FX & mask) {
-#if DEBUG
-			printf("learn how to print debug messages!");
-#endif
-			return -1;
-		}
+	if (round_used >= 32)
+		return -1;
 
-		data_buf[i].FX = round_back(data_buf[i].FX, round_used);
+	if (round_inv_fields(data_buf, sizeof(struct S_FX),
+			     offsetof(struct S_FX, FX), 1,
+			     samples_used, round_used)) {
+		dlog0("Error: data are too large to be rounded back.\n");
+		return -1;
 	}
+
 	return 0;
 }
 
@@ -306,8 +694,6 @@ struct S_FX_EFX add_S_FX_EFX(struct S_FX_EFX a, struct S_FX_EFX b)
 int lossy_rounding_S_FX_EFX(struct S_FX_EFX *data, unsigned int samples,
 			    unsigned int round)
 {
-	size_t i;
-
 	if (!samples)
 		return 0;
 
@@ -319,11 +705,13 @@ int lossy_rounding_S_FX_EFX(struct S_FX_EFX *data, unsigned int samples,
 	if (round == 0)
 		return 0;
 
-	for (i = 0; i < samples; i++)
-	{
-		data[i].FX = round_down(data[i].FX, round);
-		data[i].EFX = round_down(data[i].EFX, round);
-	}
+	if (round >= 32)
+		return -1;
+
+	/* all fields but the exposure flags are rounded */
+	round_fwd_fields(data, sizeof(struct S_FX_EFX),
+			 offsetof(struct S_FX_EFX, FX), 2, samples, round);
+
 	return 0;
 }
 
@@ -331,8 +719,6 @@ int lossy_rounding_S_FX_EFX(struct S_FX_EFX *data, unsigned int samples,
 int de_lossy_rounding_S_FX_EFX(struct S_FX_EFX *data_buf, unsigned int
 			       samples_used, unsigned int round_used)
 {
-	size_t i;
-
 	if (!samples_used)
 		return 0;
 
@@ -342,21 +728,16 @@ int de_lossy_rounding_S_FX_EFX(struct S_FX_EFX *data_buf, unsigned int
 	if (round_used == 0) /* round 0 means loss less compression, no further processing is necessary */
 		return 0;
 
-	for (i = 0; i < samples_used; i++) {
-		uint32_t mask = (~0U << (32-round_used));
-
-		if (data_buf[i].FX & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].EFX & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
+	if (round_used >= 32)
+		return -1;
 
-		data_buf[i].FX = round_back(data_buf[i].FX, round_used);
-		data_buf[i].EFX = round_back(data_buf[i].EFX, round_used);
+	if (round_inv_fields(data_buf, sizeof(struct S_FX_EFX),
+			     offsetof(struct S_FX_EFX, FX), 2,
+			     samples_used, round_used)) {
+		dlog0("Error: data are too large to be rounded back.\n");
+		return -1;
 	}
+
 	return 0;
 }
 
@@ -370,7 +751,7 @@ struct S_FX_EFX cal_up_model_S_FX_EFX(struct S_FX_EFX data_buf, struct S_FX_EFX
 		(uint8_t)cal_up_model(data_buf.EXPOSURE_FLAGS,
 				      model_buf.EXPOSURE_FLAGS, model_value);
 	result.FX = cal_up_model(data_buf.FX, model_buf.FX, model_value);
-	result.EFX = cal_up_model(data_buf.EFX, model_buf.FX, model_value);
+	result.EFX = cal_up_model(data_buf.EFX, model_buf.EFX, model_value);
 
 	return result;
 }
@@ -419,8 +800,6 @@ struct S_FX_NCOB add_S_FX_NCOB(struct S_FX_NCOB a, struct S_FX_NCOB b)
 int lossy_rounding_S_FX_NCOB(struct S_FX_NCOB *data_buf, unsigned int samples,
 			     unsigned int round)
 {
-	size_t i;
-
 	if (!samples)
 		return 0;
 
@@ -432,12 +811,13 @@ int lossy_rounding_S_FX_NCOB(struct S_FX_NCOB *data_buf, unsigned int samples,
 	if (round == 0)
 		return 0;
 
-	for (i = 0; i < samples; i++)
-	{
-		data_buf[i].FX = round_down(data_buf[i].FX, round);
-		data_buf[i].NCOB_X = round_down(data_buf[i].NCOB_X, round);
-		data_buf[i].NCOB_Y = round_down(data_buf[i].NCOB_Y, round);
-	}
+	if (round >= 32)
+		return -1;
+
+	/* all fields but the exposure flags are rounded */
+	round_fwd_fields(data_buf, sizeof(struct S_FX_NCOB),
+			 offsetof(struct S_FX_NCOB, FX), 3, samples, round);
+
 	return 0;
 }
 
@@ -445,8 +825,6 @@ int lossy_rounding_S_FX_NCOB(struct S_FX_NCOB *data_buf, unsigned int samples,
 int de_lossy_rounding_S_FX_NCOB(struct S_FX_NCOB *data_buf, unsigned int
 				samples_used, unsigned int round_used)
 {
-	size_t i;
-
 	if (!samples_used)
 		return 0;
 
@@ -456,26 +834,16 @@ int de_lossy_rounding_S_FX_NCOB(struct S_FX_NCOB *data_buf, unsigned int
 	if (round_used == 0) /* round 0 means loss less compression, no further processing is necessary */
 		return 0;
 
-	for (i = 0; i < samples_used; i++) {
-		uint32_t mask = (~0U << (32-round_used));
-
-		if (data_buf[i].FX & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].NCOB_X & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].NCOB_Y & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
+	if (round_used >= 32)
+		return -1;
 
-		data_buf[i].FX = round_back(data_buf[i].FX, round_used);
-		data_buf[i].NCOB_X = round_back(data_buf[i].NCOB_X, round_used);
-		data_buf[i].NCOB_Y = round_back(data_buf[i].NCOB_Y, round_used);
+	if (round_inv_fields(data_buf, sizeof(struct S_FX_NCOB),
+			     offsetof(struct S_FX_NCOB, FX), 3,
+			     samples_used, round_used)) {
+		dlog0("Error: data are too large to be rounded back.\n");
+		return -1;
 	}
+
 	return 0;
 }
 
@@ -549,26 +917,24 @@ struct S_FX_EFX_NCOB_ECOB add_S_FX_EFX_NCOB_ECOB(struct S_FX_EFX_NCOB_ECOB a,
 int lossy_rounding_S_FX_EFX_NCOB_ECOB(struct S_FX_EFX_NCOB_ECOB *data_buf,
 				      unsigned int samples, unsigned int round)
 {
-	size_t i;
-
 	if (!samples)
 		return 0;
 
 	if (!data_buf)
 		return -1;
 
-	if (round == 0) /* round 0 means loss less compression, no further processing is necessary */
+	/* round 0 means loss less compression, no further processing is
+	 * necessary */
+	if (round == 0)
 		return 0;
 
-	for (i = 0; i < samples; i++)
-	{
-		data_buf[i].FX = round_down(data_buf[i].FX, round);
-		data_buf[i].NCOB_X = round_down(data_buf[i].NCOB_X, round);
-		data_buf[i].NCOB_Y = round_down(data_buf[i].NCOB_Y, round);
-		data_buf[i].EFX = round_down(data_buf[i].EFX, round);
-		data_buf[i].ECOB_X = round_down(data_buf[i].ECOB_X, round);
-		data_buf[i].ECOB_Y = round_down(data_buf[i].ECOB_Y, round);
-	}
+	if (round >= 32)
+		return -1;
+
+	/* all fields but the exposure flags are rounded */
+	round_fwd_fields(data_buf, sizeof(struct S_FX_EFX_NCOB_ECOB),
+			 offsetof(struct S_FX_EFX_NCOB_ECOB, FX), 6, samples, round);
+
 	return 0;
 }
 
@@ -577,8 +943,6 @@ int de_lossy_rounding_S_FX_EFX_NCOB_ECOB(struct S_FX_EFX_NCOB_ECOB *data_buf,
 					 unsigned int samples_used,
 					 unsigned int round_used)
 {
-	size_t i;
-
 	if (!samples_used)
 		return 0;
 
@@ -588,42 +952,16 @@ int de_lossy_rounding_S_FX_EFX_NCOB_ECOB(struct S_FX_EFX_NCOB_ECOB *data_buf,
 	if (round_used == 0) /* round 0 means loss less compression, no further processing is necessary */
 		return 0;
 
-	for (i = 0; i < samples_used; i++)
-	{
-		uint32_t mask = (~0U << (32-round_used));
-
-		if (data_buf[i].FX & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].NCOB_X & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].NCOB_Y & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].EFX & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].ECOB_X & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
-		if (data_buf[i].ECOB_Y & mask) {
-			printf("learn how to print debug messages!");
-			return -1;
-		}
+	if (round_used >= 32)
+		return -1;
 
-		data_buf[i].FX = round_back(data_buf[i].FX, round_used);
-		data_buf[i].NCOB_X = round_back(data_buf[i].NCOB_X, round_used);
-		data_buf[i].NCOB_Y = round_back(data_buf[i].NCOB_Y, round_used);
-		data_buf[i].EFX = round_back(data_buf[i].EFX, round_used);
-		data_buf[i].ECOB_X = round_back(data_buf[i].ECOB_X, round_used);
-		data_buf[i].ECOB_Y = round_back(data_buf[i].ECOB_Y, round_used);
+	if (round_inv_fields(data_buf, sizeof(struct S_FX_EFX_NCOB_ECOB),
+			     offsetof(struct S_FX_EFX_NCOB_ECOB, FX), 6,
+			     samples_used, round_used)) {
+		dlog0("Error: data are too large to be rounded back.\n");
+		return -1;
 	}
+
 	return 0;
 }
 
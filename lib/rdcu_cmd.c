@@ -207,6 +207,135 @@ int rdcu_write_cmd_register(uint16_t trans_id, uint8_t *cmd, uint32_t addr)
 
 
 
+/**
+ * @brief generate a read command for a block of consecutive registers
+ *
+ * @param trans_id a transaction identifier
+ *
+ * @param cmd the command buffer; if NULL, the function returns the needed size
+ *
+ * @param addr the address of the first register
+ * @param size the number of bytes to read (4 per register)
+ *
+ * @returns the size of the command data buffer or 0 on error
+ *
+ * @note this will configure a multi-address read command
+ */
+
+int rdcu_read_cmd_register_block(uint16_t trans_id, uint8_t *cmd,
+				 uint32_t addr, uint32_t size)
+{
+	return rdcu_gen_cmd(trans_id, cmd, RMAP_READ_ADDR_INC, addr, size);
+}
+
+
+/**
+ * @brief generate a write command for a block of consecutive registers
+ *
+ * @param trans_id a transaction identifier
+ *
+ * @param cmd the command buffer; if NULL, the function returns the needed size
+ *
+ * @param addr the address of the first register
+ * @param size the number of bytes to write (4 per register)
+ *
+ * @returns the size of the command data buffer or 0 on error
+ *
+ * @note this will configure a multi-address write command with reply enabled;
+ *	 unlike single register writes, the data is not verified before
+ *	 writing, as that is limited to 4 bytes
+ */
+
+int rdcu_write_cmd_register_block(uint16_t trans_id, uint8_t *cmd,
+				  uint32_t addr, uint32_t size)
+{
+	return rdcu_gen_cmd(trans_id, cmd, RMAP_WRITE_ADDR_INC_REPLY,
+			    addr, size);
+}
+
+
+
+/**
+ * @brief generate a verified write command for a single register at an
+ *	  arbitrary address
+ *
+ * @param trans_id a transaction identifier
+ *
+ * @param cmd the command buffer; if NULL, the function returns the needed size
+ *
+ * @param addr the register address
+ * @param size the number of bytes to write (must be 4)
+ *
+ * @returns the size of the command data buffer or 0 on error
+ *
+ * @note this is rdcu_write_cmd_register() in the signature of a data transfer
+ *	 generation function, so it can be used with rdcu_sync_block()
+ */
+
+int rdcu_write_cmd_register_at(uint16_t trans_id, uint8_t *cmd,
+			       uint32_t addr, uint32_t size)
+{
+	if (size != 4)
+		return 0;
+
+	return rdcu_write_cmd_register_internal(trans_id, cmd, addr);
+}
+
+
+/**
+ * @brief generate a write command without reply
+ *
+ * @param trans_id a transaction identifier
+ *
+ * @param cmd the command buffer; if NULL, the function returns the needed size
+ *
+ * @param addr the address to write to
+ * @param size the number of bytes to write
+ *
+ * @returns the size of the command data buffer or 0 on error
+ *
+ * @note single register writes (4 bytes) are verified before writing, larger
+ *	 transfers are not, as verification is limited to 4 bytes
+ */
+
+int rdcu_write_cmd_register_noreply(uint16_t trans_id, uint8_t *cmd,
+				    uint32_t addr, uint32_t size)
+{
+	if (size == 4)
+		return rdcu_gen_cmd(trans_id, cmd, RMAP_WRITE_ADDR_INC_VERIFY,
+				    addr, size);
+
+	return rdcu_gen_cmd(trans_id, cmd, RMAP_WRITE_ADDR_INC, addr, size);
+}
+
+
+/**
+ * @brief generate a read-modify-write command for a 32 bit word
+ *
+ * @param trans_id a transaction identifier
+ *
+ * @param cmd the command buffer; if NULL, the function returns the needed size
+ *
+ * @param addr the address of the word
+ * @param size the size of the payload, i.e. data and mask (must be 8)
+ *
+ * @returns the size of the command data buffer or 0 on error
+ *
+ * @note the target performs word = (word & ~mask) | (data & mask) and
+ *	 returns the previous contents of the word
+ */
+
+int rdcu_rmw_cmd_data(uint16_t trans_id, uint8_t *cmd,
+		      uint32_t addr, uint32_t size)
+{
+	if (size != 8)
+		return 0;
+
+	return rdcu_gen_cmd(trans_id, cmd, RMAP_READ_MODIFY_WRITE_ADDR_INC,
+			    addr, size);
+}
+
+
 /**
  * @brief create a command to read the RDCU FPGA version register
  *
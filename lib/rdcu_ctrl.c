@@ -57,11 +57,13 @@
  */
 
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <byteorder.h>
+#include <dlog.h>
 #include <rmap.h>
 #include <rdcu_cmd.h>
 #include <rdcu_ctrl.h>
@@ -71,6 +73,385 @@
 static struct rdcu_mirror *rdcu;
 
 
+/**
+ * We track the state of the SRAM mirror in pages of SRAM_PAGE_SIZE bytes.
+ *
+ * A page is "dirty" if it was modified locally and not yet written to the
+ * RDCU, it is "valid" if its contents are known to match the remote SRAM,
+ * i.e. the page was last transferred in either direction. A page only turns
+ * valid once its transfer completed; a page written to the RDCU is no longer
+ * dirty while the transfer is in flight, but turns dirty again if it fails.
+ * Writes to the mirror
+ * only mark a valid page dirty if they actually change its contents, so
+ * re-uploading a mostly unchanged buffer with rdcu_sync_dirty_to_sram() will
+ * only transfer the pages that differ.
+ *
+ * Note that the page is the smallest unit of transfer for
+ * rdcu_sync_dirty_to_sram(), so the whole page is written to the RDCU, even
+ * if only a part of it was modified. Do not place buffers the RDCU writes to
+ * in the same page as buffers that are uploaded, unless you read them back
+ * before, or use rdcu_sync_dirty_range_to_sram() or rdcu_sync_mirror_to_sram()
+ * with an explicit range instead.
+ */
+
+#define SRAM_PAGE_SHIFT	8
+#define SRAM_PAGE_SIZE	(1UL << SRAM_PAGE_SHIFT)
+#define SRAM_PAGES	(RDCU_SRAM_SIZE >> SRAM_PAGE_SHIFT)
+
+
+/**
+ * The SRAM mirror is either a single image of RDCU_SRAM_SIZE bytes (see
+ * rdcu_ctrl_init()) or sparse (see rdcu_ctrl_init_sparse()). A sparse mirror
+ * is made of blocks of SRAM_BLOCK_SIZE bytes, which are either registered by
+ * the user with rdcu_sram_add_window() or allocated on their first use.
+ * Blocks never used read as zero, so the memory footprint is limited to what
+ * a configuration actually touches.
+ */
+
+#define SRAM_BLOCK_SHIFT	16
+#define SRAM_BLOCK_SIZE		(1UL << SRAM_BLOCK_SHIFT)
+#define SRAM_BLOCKS		(RDCU_SRAM_SIZE >> SRAM_BLOCK_SHIFT)
+
+
+/**
+ * A range of the mirror that is transferred to or from the SRAM is tracked
+ * until all of its transactions completed, only then the state of its pages
+ * is updated. Every range in flight holds at least one transaction, so there
+ * are never more of them than entries in the RMAP transaction log.
+ */
+
+#define SRAM_XFERS	64
+
+struct sram_xfer {
+	struct rdcu_ctrl_ctx *ctx;	/* the context of the pages */
+	uint32_t addr;
+	uint32_t size;
+	uint32_t chunks;		/* transactions in flight */
+	uint8_t  busy;
+	uint8_t  submitting;		/* more chunks are to follow */
+	uint8_t  read;
+	uint8_t  failed;
+};
+
+
+/**
+ * The mirror and the state of its SRAM pages are kept per RDCU in a context,
+ * so several RDCUs can be served (see rdcu_ctrl_select_ctx()). "rdcu",
+ * "sram_dirty" and "sram_valid" always refer to those of the selected
+ * context, which is a built-in default one unless another is selected.
+ */
+
+struct rdcu_ctrl_ctx {
+	struct rdcu_mirror *mirror;
+	uint32_t sram_dirty[SRAM_PAGES / 32];
+	uint32_t sram_valid[SRAM_PAGES / 32];
+
+	/* the blocks of a sparse mirror and which of them belong to the user */
+	uint8_t *sram_block[SRAM_BLOCKS];
+	uint32_t sram_block_user[SRAM_BLOCKS / 32];
+
+	/* the ranges of the mirror in transfer */
+	struct sram_xfer xfer[SRAM_XFERS];
+};
+
+static struct rdcu_ctrl_ctx ctrl_ctx_default;
+static struct rdcu_ctrl_ctx *ctrl_ctx = &ctrl_ctx_default;
+
+static uint32_t *sram_dirty = ctrl_ctx_default.sram_dirty;
+static uint32_t *sram_valid = ctrl_ctx_default.sram_valid;
+
+
+/**
+ * @brief set a page bit in a mirror page map
+ */
+
+static void sram_page_set(uint32_t *map, uint32_t page)
+{
+	map[page >> 5] |= (1UL << (page & 0x1F));
+}
+
+
+/**
+ * @brief clear a page bit in a mirror page map
+ */
+
+static void sram_page_clear(uint32_t *map, uint32_t page)
+{
+	map[page >> 5] &= ~(1UL << (page & 0x1F));
+}
+
+
+/**
+ * @brief test a page bit in a mirror page map
+ */
+
+static int sram_page_test(const uint32_t *map, uint32_t page)
+{
+	return (map[page >> 5] >> (page & 0x1F)) & 0x1;
+}
+
+
+/**
+ * @brief get a mirror location for reading
+ *
+ * @param addr an address within the RDCU SRAM
+ *
+ * @returns a pointer to the mirror of the address, which stays contiguous up
+ *	    to the end of its SRAM block, or NULL if the block of a sparse
+ *	    mirror is unused and hence reads as zero
+ */
+
+static uint8_t *rdcu_sram_peek(uint32_t addr)
+{
+	uint8_t *blk;
+
+
+	if (rdcu->sram)
+		return &rdcu->sram[addr];
+
+	blk = ctrl_ctx->sram_block[addr >> SRAM_BLOCK_SHIFT];
+	if (!blk)
+		return NULL;
+
+	return &blk[addr & (SRAM_BLOCK_SIZE - 1)];
+}
+
+
+/**
+ * @brief get a mirror location for writing, allocating its block if needed
+ *
+ * @param addr an address within the RDCU SRAM
+ *
+ * @returns a pointer to the mirror of the address, which stays contiguous up
+ *	    to the end of its SRAM block, or NULL on error
+ */
+
+static uint8_t *rdcu_sram_map(uint32_t addr)
+{
+	uint32_t blk;
+
+
+	if (rdcu->sram)
+		return &rdcu->sram[addr];
+
+	blk = addr >> SRAM_BLOCK_SHIFT;
+
+	if (!ctrl_ctx->sram_block[blk]) {
+		ctrl_ctx->sram_block[blk] = (uint8_t *) calloc(1,
+							SRAM_BLOCK_SIZE);
+		if (!ctrl_ctx->sram_block[blk]) {
+			printf("Error allocating memory for an SRAM block\n");
+			return NULL;
+		}
+	}
+
+	return &ctrl_ctx->sram_block[blk][addr & (SRAM_BLOCK_SIZE - 1)];
+}
+
+
+/**
+ * @brief get the number of contiguous mirror bytes starting at an address
+ *
+ * @param addr an address within the RDCU SRAM
+ */
+
+static uint32_t rdcu_sram_contig(uint32_t addr)
+{
+	if (rdcu->sram)
+		return RDCU_SRAM_SIZE - addr;
+
+	return SRAM_BLOCK_SIZE - (addr & (SRAM_BLOCK_SIZE - 1));
+}
+
+
+/**
+ * @brief release all blocks of a sparse mirror allocated by the library
+ *
+ * @param c the control context
+ */
+
+static void rdcu_sram_release_blocks(struct rdcu_ctrl_ctx *c)
+{
+	uint32_t i;
+
+
+	for (i = 0; i < SRAM_BLOCKS; i++) {
+		if (!sram_page_test(c->sram_block_user, i))
+			free(c->sram_block[i]);
+		c->sram_block[i] = NULL;
+	}
+
+	memset(c->sram_block_user, 0, sizeof(c->sram_block_user));
+}
+
+
+/**
+ * @brief set or clear the bits of all pages fully covered by a range in a
+ *	  mirror page map
+ *
+ * @param map the page map
+ * @param addr an address within the RDCU SRAM
+ * @param size the size of the range in bytes
+ * @param set 0: clear the bits, otherwise set them
+ *
+ * @note partially covered pages keep their state
+ */
+
+static void sram_range_mark(uint32_t *map, uint32_t addr, uint32_t size,
+			    int set)
+{
+	uint32_t page;
+	uint32_t last;
+
+
+	page = (addr + SRAM_PAGE_SIZE - 1) >> SRAM_PAGE_SHIFT;
+	last = (addr + size) >> SRAM_PAGE_SHIFT;
+
+	for (; page < last; page++) {
+		if (set)
+			sram_page_set(map, page);
+		else
+			sram_page_clear(map, page);
+	}
+}
+
+
+/**
+ * @brief copy data into the SRAM mirror and mark the modified pages dirty
+ *
+ * @param addr an address within the RDCU SRAM
+ * @param buf the buffer to read from
+ * @param size the number of bytes to copy
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static int rdcu_sram_update(uint32_t addr, const uint8_t *buf, uint32_t size)
+{
+	uint32_t n;
+	uint32_t page;
+
+	uint8_t *sram;
+
+
+	while (size) {
+
+		page = addr >> SRAM_PAGE_SHIFT;
+
+		/* bytes to the end of the page */
+		n = SRAM_PAGE_SIZE - (addr & (SRAM_PAGE_SIZE - 1));
+		if (n > size)
+			n = size;
+
+		sram = rdcu_sram_map(addr);
+		if (!sram)
+			return -1;
+
+		if (!sram_page_test(sram_valid, page) ||
+		    memcmp(sram, buf, n)) {
+			memcpy(sram, buf, n);
+			sram_page_set(sram_dirty, page);
+		}
+
+		addr += n;
+		buf  += n;
+		size -= n;
+	}
+
+	return 0;
+}
+
+
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+/**
+ * @brief convert data to big endian while copying them into the SRAM mirror
+ *	  and mark the modified pages dirty
+ *
+ * @param addr an address within the RDCU SRAM
+ * @param buf the buffer to read from
+ * @param size the number of bytes to copy
+ * @param width the size of a value in bytes (2 or 4)
+ *
+ * @note pages not yet valid are converted in bulk, otherwise every value is
+ *	 converted, compared and stored in a single pass
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static int rdcu_sram_update_swab(uint32_t addr, const uint8_t *buf,
+				  uint32_t size, uint32_t width)
+{
+	uint32_t i;
+	uint32_t n;
+	uint32_t page;
+	uint32_t diff;
+
+	uint16_t v16;
+	uint32_t v32;
+
+	uint8_t  *sram;
+	uint16_t *sram16;
+	uint32_t *sram32;
+
+
+	while (size) {
+
+		page = addr >> SRAM_PAGE_SHIFT;
+
+		/* bytes to the end of the page */
+		n = SRAM_PAGE_SIZE - (addr & (SRAM_PAGE_SIZE - 1));
+		if (n > size)
+			n = size;
+
+		sram = rdcu_sram_map(addr);
+		if (!sram)
+			return -1;
+
+		if (!sram_page_test(sram_valid, page)) {
+
+			if (width == sizeof(uint16_t))
+				cpu_to_be16_copy(sram, buf, n / 2);
+			else
+				cpu_to_be32_copy(sram, buf, n / 4);
+
+			sram_page_set(sram_dirty, page);
+
+		} else {
+
+			diff = 0;
+
+			if (width == sizeof(uint16_t)) {
+				sram16 = (uint16_t *) sram;
+				for (i = 0; i < n / 2; i++) {
+					memcpy(&v16, &buf[i * 2], sizeof(v16));
+					v16 = cpu_to_be16(v16);
+					diff |= (uint32_t) (sram16[i] ^ v16);
+					sram16[i] = v16;
+				}
+			} else {
+				sram32 = (uint32_t *) sram;
+				for (i = 0; i < n / 4; i++) {
+					memcpy(&v32, &buf[i * 4], sizeof(v32));
+					v32 = cpu_to_be32(v32);
+					diff |= sram32[i] ^ v32;
+					sram32[i] = v32;
+				}
+			}
+
+			if (diff)
+				sram_page_set(sram_dirty, page);
+		}
+
+		addr += n;
+		buf  += n;
+		size -= n;
+	}
+
+	return 0;
+}
+#endif /* __BYTE_ORDER__ */
+
+
 /**
  * @brief get the 4 FPGA minor/major version digits
  * @see RDCU-FRS-FN-0522
@@ -1505,6 +1886,12 @@ uint8_t rdcu_edac_get_scrub_info(void)
 
 int rdcu_read_sram(void *buf, uint32_t addr, uint32_t size)
 {
+	uint32_t n;
+	uint32_t done;
+
+	const uint8_t *sram;
+
+
 	if (addr > RDCU_SRAM_END)
 		return -1;
 
@@ -1514,8 +1901,21 @@ int rdcu_read_sram(void *buf, uint32_t addr, uint32_t size)
 	if (addr + size > RDCU_SRAM_END)
 		return -1;
 
-	if (buf)
-		memcpy(buf, &rdcu->sram[addr], size);
+	if (!buf)
+		return (int)size;
+
+	for (done = 0; done < size; done += n) {
+
+		n = rdcu_sram_contig(addr + done);
+		if (n > size - done)
+			n = size - done;
+
+		sram = rdcu_sram_peek(addr + done);
+		if (sram)
+			memcpy((uint8_t *) buf + done, sram, n);
+		else
+			memset((uint8_t *) buf + done, 0, n);
+	}
 
 	return (int)size; /* lol */
 }
@@ -1546,8 +1946,8 @@ int rdcu_write_sram(void *buf, uint32_t addr, uint32_t size)
 	if (addr + size > RDCU_SRAM_END)
 		return -1;
 
-	if (buf)
-		memcpy(&rdcu->sram[addr], buf, size);
+	if (rdcu_sram_update(addr, (const uint8_t *) buf, size))
+		return -1;
 
 	return (int)size; /* lol */
 }
@@ -1603,15 +2003,10 @@ int rdcu_write_sram_16(uint16_t *buf, uint32_t addr, uint32_t size)
 #if !(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
 	return rdcu_write_sram(buf, addr, size);
 #else
-	{
-		uint32_t i;
-
-		for (i = 0; i < size/sizeof(uint16_t); i++) {
-			uint16_t *sram_buf = (uint16_t *)&rdcu->sram[addr];
+	if (rdcu_sram_update_swab(addr, (const uint8_t *) buf, size,
+				  sizeof(uint16_t)))
+		return -1;
 
-			sram_buf[i] = cpu_to_be16(buf[i]);
-		}
-	}
 	return (int)size; /* lol */
 #endif /* __BYTE_ORDER__ */
 }
@@ -1649,93 +2044,254 @@ int rdcu_write_sram_32(uint32_t *buf, uint32_t addr, uint32_t size)
 #if !(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
 	return rdcu_write_sram(buf, addr, size);
 #else
-	{
-		uint32_t i;
-
-		for (i = 0; i < size/sizeof(uint32_t); i++) {
-			uint32_t *sram_buf = (uint32_t *)&rdcu->sram[addr];
+	if (rdcu_sram_update_swab(addr, (const uint8_t *) buf, size,
+				  sizeof(uint32_t)))
+		return -1;
 
-			sram_buf[i] = cpu_to_be32(buf[i]);
-		}
-	}
 	return (int)size; /* lol */
 #endif /* __BYTE_ORDER__ */
 }
 
-
 /**
- * @brief sync the FPGA version (read only)
+ * @brief gather strided fields into a contiguous big-endian region of the
+ *	  local SRAM mirror, e.g. one field of an array of packed records.
+ *	  This function is endian-safe.
  *
- * @returns 0 on success, otherwise error
+ * @param buf	 the address of the first field to read from
+ * @param stride the distance between two fields in bytes
+ * @param width	 the size of a field in bytes (1, 2 or 4)
+ * @param addr	 an address within the RDCU SRAM, aligned to the field width
+ * @param n	 the number of fields to write
+ *
+ * @note the fields in buf need not be aligned
+ *
+ * @returns the number of bytes written, < 0 on error
  */
 
-int rdcu_sync_fpga_version(void)
+int rdcu_write_sram_strided(const void *buf, uint32_t stride, uint32_t width,
+			    uint32_t addr, uint32_t n)
 {
-	return rdcu_sync(rdcu_read_cmd_fpga_version, &rdcu->fpga_version, 0);
-}
+	uint32_t i;
+	uint32_t page;
+	uint32_t size;
 
+	uint16_t v16;
+	uint32_t v32;
 
-/**
- * @brief sync the RDCU status register (read only)
- *
- * @returns 0 on success, otherwise error
- */
+	uint8_t *sram;
+	const uint8_t *src = (const uint8_t *) buf;
 
-int rdcu_sync_rdcu_status(void)
-{
-	return rdcu_sync(rdcu_read_cmd_rdcu_status, &rdcu->rdcu_status, 0);
-}
 
+	if (!buf)
+		return 0;
 
-/**
- * @brief sync the LVDS core status register (read only)
- *
- * @returns 0 on success, otherwise error
- */
+	if (width != 1 && width != 2 && width != 4)
+		return -1;
 
-int rdcu_sync_lvds_core_status(void)
-{
-	return rdcu_sync(rdcu_read_cmd_lvds_core_status,
-			 &rdcu->lvds_core_status, 0);
-}
+	if (addr & (width - 1))
+		return -1;
 
+	if (n > RDCU_SRAM_SIZE / width)
+		return -1;
 
-/**
- * @brief sync the SpW link status register (read only)
- *
- * @returns 0 on success, otherwise error
- */
+	size = n * width;
 
-int rdcu_sync_spw_link_status(void)
-{
-	return rdcu_sync(rdcu_read_cmd_spw_link_status,
-			 &rdcu->spw_link_status, 0);
-}
+	if (addr > RDCU_SRAM_END)
+		return -1;
 
+	if (addr + size > RDCU_SRAM_END)
+		return -1;
 
-/**
- * @brief sync the SpW Error Counter register (read only)
- *
- * @returns 0 on success, otherwise error
- */
 
-int rdcu_sync_spw_err_cntrs(void)
-{
-	return rdcu_sync(rdcu_read_cmd_spw_err_cntrs,
-			 &rdcu->spw_err_cntrs, 0);
+	for (i = 0; i < n; i++, src += stride, addr += width) {
+
+		page = addr >> SRAM_PAGE_SHIFT;
+
+		sram = rdcu_sram_map(addr);
+		if (!sram)
+			return -1;
+
+		switch (width) {
+		case 1:
+			if (sram[0] == src[0] &&
+			    sram_page_test(sram_valid, page))
+				continue;
+			sram[0] = src[0];
+			break;
+		case 2:
+			memcpy(&v16, src, sizeof(v16));
+			v16 = cpu_to_be16(v16);
+			if (*(uint16_t *) sram == v16 &&
+			    sram_page_test(sram_valid, page))
+				continue;
+			*(uint16_t *) sram = v16;
+			break;
+		default:
+			memcpy(&v32, src, sizeof(v32));
+			v32 = cpu_to_be32(v32);
+			if (*(uint32_t *) sram == v32 &&
+			    sram_page_test(sram_valid, page))
+				continue;
+			*(uint32_t *) sram = v32;
+			break;
+		}
+
+		sram_page_set(sram_dirty, page);
+	}
+
+	return (int)size;
 }
 
 
 /**
- * @brief sync the RMAP Last Error register (read only)
+ * @brief scatter a contiguous big-endian region of the local SRAM mirror into
+ *	  strided fields, the inverse of rdcu_write_sram_strided().
+ *	  This function is endian-safe.
  *
- * @returns 0 on success, otherwise error
+ * @param buf	 the address of the first field to write to
+ * @param stride the distance between two fields in bytes
+ * @param width	 the size of a field in bytes (1, 2 or 4)
+ * @param addr	 an address within the RDCU SRAM, aligned to the field width
+ * @param n	 the number of fields to read
+ *
+ * @returns the number of bytes read, < 0 on error
  */
 
-int rdcu_sync_rmap_last_err(void)
+int rdcu_read_sram_strided(void *buf, uint32_t stride, uint32_t width,
+			   uint32_t addr, uint32_t n)
 {
-	return rdcu_sync(rdcu_read_cmd_rmap_last_err,
-			 &rdcu->rmap_last_err, 0);
+	uint32_t i;
+	uint32_t size;
+
+	uint16_t v16;
+	uint32_t v32;
+
+	const uint8_t *sram;
+	uint8_t *dst = (uint8_t *) buf;
+
+	static const uint32_t zero;
+
+
+	if (!buf)
+		return 0;
+
+	if (width != 1 && width != 2 && width != 4)
+		return -1;
+
+	if (addr & (width - 1))
+		return -1;
+
+	if (n > RDCU_SRAM_SIZE / width)
+		return -1;
+
+	size = n * width;
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (addr + size > RDCU_SRAM_END)
+		return -1;
+
+
+	for (i = 0; i < n; i++, dst += stride, addr += width) {
+
+		sram = rdcu_sram_peek(addr);
+		if (!sram)
+			sram = (const uint8_t *) &zero;
+
+		switch (width) {
+		case 1:
+			dst[0] = sram[0];
+			break;
+		case 2:
+			v16 = be16_to_cpu(*(const uint16_t *) sram);
+			memcpy(dst, &v16, sizeof(v16));
+			break;
+		default:
+			v32 = be32_to_cpu(*(const uint32_t *) sram);
+			memcpy(dst, &v32, sizeof(v32));
+			break;
+		}
+	}
+
+	return (int)size;
+}
+
+
+
+/**
+ * @brief sync the FPGA version (read only)
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_fpga_version(void)
+{
+	return rdcu_sync(rdcu_read_cmd_fpga_version, &rdcu->fpga_version, 0);
+}
+
+
+/**
+ * @brief sync the RDCU status register (read only)
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_rdcu_status(void)
+{
+	return rdcu_sync(rdcu_read_cmd_rdcu_status, &rdcu->rdcu_status, 0);
+}
+
+
+/**
+ * @brief sync the LVDS core status register (read only)
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_lvds_core_status(void)
+{
+	return rdcu_sync(rdcu_read_cmd_lvds_core_status,
+			 &rdcu->lvds_core_status, 0);
+}
+
+
+/**
+ * @brief sync the SpW link status register (read only)
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_spw_link_status(void)
+{
+	return rdcu_sync(rdcu_read_cmd_spw_link_status,
+			 &rdcu->spw_link_status, 0);
+}
+
+
+/**
+ * @brief sync the SpW Error Counter register (read only)
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_spw_err_cntrs(void)
+{
+	return rdcu_sync(rdcu_read_cmd_spw_err_cntrs,
+			 &rdcu->spw_err_cntrs, 0);
+}
+
+
+/**
+ * @brief sync the RMAP Last Error register (read only)
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_rmap_last_err(void)
+{
+	return rdcu_sync(rdcu_read_cmd_rmap_last_err,
+			 &rdcu->rmap_last_err, 0);
 }
 
 
@@ -2172,189 +2728,1393 @@ int rdcu_sync_sram_edac_status(void)
 
 
 /**
- * @brief sync a range of 32 bit words of the local mirror to the remote SRAM
+ * The consecutive registers in the RDCU address map that can be synced with a
+ * single RMAP transaction. The corresponding mirror fields are laid out in the
+ * same order, so the mirror serves as the data buffer of the transfer.
+ */
+
+static const struct {
+	uint32_t addr;		/* first register */
+	uint32_t n;		/* number of registers */
+	size_t   offset;	/* offset of the first field in the mirror */
+	int      read;		/* direction */
+} rdcu_reg_blocks[] = {
+	{FPGA_VERSION, 13, offsetof(struct rdcu_mirror, fpga_version), 1},
+	{RDCU_RESET,    5, offsetof(struct rdcu_mirror, rdcu_reset), 0},
+	{COMPR_PARAM_1, 10, offsetof(struct rdcu_mirror, compressor_param1), 0},
+	{USED_COMPR_PARAM_1, 9, offsetof(struct rdcu_mirror, used_param1), 1},
+};
+
+
+/**
+ * @brief sync a block of consecutive registers with a single transaction
  *
- * @param addr and address within the remote SRAM
- * @param size the number of bytes to sync
- * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ * @param addr the address of the first register
+ * @param n the number of registers to sync
  *
- * @note due to restrictions, the number of bytes and mtu must be a multiple
- *	 of 4; the address must be aligned to 32-bits as well
+ * @note the direction of the sync is that of the registers, i.e. read-only
+ *	 registers are read to the mirror, write-only registers are written
+ *	 from the mirror
+ * @note the block must not cross a spare address or switch between read-only
+ *	 and write-only registers
  *
  * @returns 0 on success, otherwise error
  */
 
-int rdcu_sync_mirror_to_sram(uint32_t addr, uint32_t size, uint32_t mtu)
+int rdcu_sync_register_block(uint32_t addr, uint32_t n)
 {
-	int ret;
+	size_t i;
 
-	uint32_t sent = 0;
-	uint32_t tx_bytes;
+	uint32_t idx;
+	uint8_t *mirror;
 
 
-	if (mtu & 0x3)
+	if (!n)
 		return -1;
 
 	if (addr & 0x3)
 		return -1;
 
-	if (size & 0x3)
-		return -1;
+	for (i = 0; i < sizeof(rdcu_reg_blocks) / sizeof(rdcu_reg_blocks[0]); i++) {
 
-	if (addr > RDCU_SRAM_END)
-		return -1;
+		if (addr < rdcu_reg_blocks[i].addr)
+			continue;
 
-	if (size > RDCU_SRAM_SIZE)
-		return -1;
+		idx = (addr - rdcu_reg_blocks[i].addr) / 4;
 
-	if ((addr + size) > (RDCU_SRAM_END + 1))
-		return -1;
+		if (idx + n > rdcu_reg_blocks[i].n)
+			continue;
+
+		mirror = (uint8_t *) rdcu + rdcu_reg_blocks[i].offset + idx * 4;
+
+		if (rdcu_reg_blocks[i].read)
+			return rdcu_sync_block(rdcu_read_cmd_register_block,
+					       addr, mirror, n * 4, 1);
+		else
+			return rdcu_sync_block(rdcu_write_cmd_register_block,
+					       addr, mirror, n * 4, 0);
+	}
+
+	return -1;
+}
 
 
-	tx_bytes = size;
+/**
+ * @brief sync all Data Compressor configuration registers (write only)
+ *
+ * @note this is the batched equivalent of rdcu_sync_compressor_param1()
+ *	 through rdcu_sync_compr_data_buf_len()
+ *
+ * @returns 0 on success, otherwise error
+ */
 
-	while (tx_bytes >= mtu) {
+int rdcu_sync_compr_cfg_regs(void)
+{
+	return rdcu_sync_register_block(COMPR_PARAM_1, 10);
+}
 
-		ret = rdcu_sync_data(rdcu_write_cmd_data, addr + sent,
-				     &rdcu->sram[addr + sent], mtu, 0);
-		if (ret > 0)
-			continue;
 
-		if (ret < 0)
-			return -1;
+/**
+ * @brief sync all Data Compressor information registers (read only)
+ *
+ * @note this is the batched equivalent of rdcu_sync_used_param1() through
+ *	 rdcu_sync_samples_used()
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_compr_info_regs(void)
+{
+	return rdcu_sync_register_block(USED_COMPR_PARAM_1, 9);
+}
 
 
-		sent     += mtu;
-		tx_bytes -= mtu;
-	}
+/**
+ * @brief get the mirror field of a writable register
+ *
+ * @param addr the address of the register
+ *
+ * @returns a pointer to the mirror field or NULL if the address is not that of
+ *	    a writable register
+ */
+
+static uint32_t *rdcu_reg_mirror_wr(uint32_t addr)
+{
+	size_t i;
+
+	uint32_t idx;
+
+
+	if (addr & 0x3)
+		return NULL;
+
+	/* not part of a register block */
+	if (addr == COMPR_CTRL)
+		return &rdcu->compr_ctrl;
+
+	if (addr == SRAM_EDAC_CTRL)
+		return &rdcu->sram_edac_ctrl;
+
+	for (i = 0; i < sizeof(rdcu_reg_blocks) / sizeof(rdcu_reg_blocks[0]); i++) {
 
-	while (tx_bytes) {
-		ret = rdcu_sync_data(rdcu_write_cmd_data, addr + sent,
-				     &rdcu->sram[addr + sent], tx_bytes, 0);
-		if (ret > 0)
+		if (rdcu_reg_blocks[i].read)
 			continue;
 
-		if (ret < 0)
-			return -1;
+		if (addr < rdcu_reg_blocks[i].addr)
+			continue;
 
-		tx_bytes = 0;
-	}
+		idx = (addr - rdcu_reg_blocks[i].addr) / 4;
 
+		if (idx >= rdcu_reg_blocks[i].n)
+			continue;
 
-	return 0;
+		return (uint32_t *) ((uint8_t *) rdcu +
+				     rdcu_reg_blocks[i].offset + idx * 4);
+	}
+
+	return NULL;
 }
 
 
 /**
- * @brief sync a range of 32 bit words of the remote SRAM to the local mirror
+ * @brief update bits of a writable register and sync it in one transaction
  *
- * @param addr an address within the remote SRAM
- * @param size the number of bytes to sync
- * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ * @param addr the address of the register
+ * @param val the bits to set
+ * @param mask the bits to modify
  *
- * @note due to restrictions, the number of bytes and mtu must be a multiple
- *	 of 4; the address must be aligned to 32-bits as well
+ * @note the mirror is updated as reg = (reg & ~mask) | (val & mask), then
+ *	 written with a single verified write; the RDCU control, Data
+ *	 Compressor and EDAC registers are write-only, so unlike SRAM (see
+ *	 rdcu_rmw_sram_32()), they cannot be modified with a RMAP RMW command
+ *	 and the mirror is the authoritative copy of their contents
  *
- * @returns 0 on success, otherwise error
+ * @returns 0 on success, < 0: error, > 0: retry
  */
 
-int rdcu_sync_sram_to_mirror(uint32_t addr, uint32_t size, uint32_t mtu)
+int rdcu_update_register(uint32_t addr, uint32_t val, uint32_t mask)
 {
-	int ret;
-
-	uint32_t recv = 0;
-	uint32_t rx_bytes;
+	uint32_t *reg;
 
 
-	if (mtu & 0x3)
+	reg = rdcu_reg_mirror_wr(addr);
+	if (!reg)
 		return -1;
 
-	if (addr & 0x3)
-		return -1;
+	(*reg) = ((*reg) & ~mask) | (val & mask);
 
-	if (size & 0x3)
-		return -1;
+	return rdcu_sync_block(rdcu_write_cmd_register_at, addr, reg, 4, 0);
+}
 
-	if (addr > RDCU_SRAM_END)
-		return -1;
 
-	if (size > RDCU_SRAM_SIZE)
-		return -1;
+/**
+ * @brief update bits of a writable register and write it without reply
+ *
+ * @param addr the address of the register
+ * @param val the bits to set
+ * @param mask the bits to modify
+ *
+ * @note this works like rdcu_update_register(), but the write is not entered
+ *	 in the transaction log and its success can not be determined, use
+ *	 only for fire-and-forget updates, e.g. a reset request
+ *
+ * @returns 0 on success, < 0: error, > 0: retry
+ */
 
-	if ((addr + size) > (RDCU_SRAM_END + 1))
+int rdcu_poke_register(uint32_t addr, uint32_t val, uint32_t mask)
+{
+	uint32_t *reg;
+
+
+	reg = rdcu_reg_mirror_wr(addr);
+	if (!reg)
 		return -1;
 
+	(*reg) = ((*reg) & ~mask) | (val & mask);
 
-	rx_bytes = size;
+	return rdcu_sync_noreply(rdcu_write_cmd_register_noreply, addr, reg, 4);
+}
 
-	while (rx_bytes >= mtu) {
 
-		ret = rdcu_sync_data(rdcu_read_cmd_data, addr + recv,
-				     &rdcu->sram[addr + recv], mtu, 1);
+/**
+ * @brief start the data compressor
+ * @see RDCU-FRS-FN-0732
+ *
+ * @note this sets the start bit and clears the compressor interrupt bit of
+ *	 the Compressor Control register in one verified write, the other
+ *	 bits, e.g. the RDCU interrupt enable, are written as set in the
+ *	 mirror; the start bit is cleared in the mirror afterwards, so the
+ *	 next rdcu_sync_compr_ctrl() does not restart the compression
+ *
+ * @returns 0 on success, < 0: error, > 0: retry
+ */
 
-#if 1
-		while (rdcu_rmap_sync_status() > 3)
-			;
-#endif
+int rdcu_start_data_compr(void)
+{
+	int ret;
 
-		if (ret > 0)
-			continue;
 
-		if (ret < 0)
-			return -1;
+	ret = rdcu_update_register(COMPR_CTRL, 0x1UL, 0x3UL);
 
-		recv     += mtu;
-		rx_bytes -= mtu;
-	}
+	rdcu_clear_data_compr_start();
 
-	while (rx_bytes) {
-		ret = rdcu_sync_data(rdcu_read_cmd_data, addr + recv,
-				     &rdcu->sram[addr + recv], rx_bytes, 1);
-		if (ret > 0)
-			continue;
+	return ret;
+}
 
-		if (ret < 0)
-			return -1;
 
-		rx_bytes = 0;
-	}
+/**
+ * @brief interrupt the data compressor
+ * @see RDCU-FRS-FN-0732
+ *
+ * @note like rdcu_start_data_compr(), but sets the compressor interrupt bit
+ *	 and clears the start bit
+ *
+ * @returns 0 on success, < 0: error, > 0: retry
+ */
 
+int rdcu_interrupt_data_compr(void)
+{
+	int ret;
 
-	return 0;
+
+	ret = rdcu_update_register(COMPR_CTRL, 0x2UL, 0x3UL);
+
+	rdcu_clear_data_compr_interrupt();
+
+	return ret;
 }
 
 
+/**
+ * @brief reset the RMAP and SpaceWire error counters of the RDCU
+ * @see RDCU-FRS-FN-0662
+ *
+ * @note the counter reset bits auto-clear in the FPGA, so the request is
+ *	 written without reply (see rdcu_poke_register()); the internal bus
+ *	 and board reset bits are cleared in the same write, the reset bits are
+ *	 cleared in the mirror afterwards
+ *
+ * @returns 0 on success, < 0: error, > 0: retry
+ */
+
+int rdcu_reset_error_cntrs(void)
+{
+	int ret;
 
 
+	ret = rdcu_poke_register(RDCU_RESET, (0x1UL << 9) | (0x1UL << 8),
+				 (0x1UL << 12) | (0x1UL << 9) |
+				 (0x1UL << 8) | (0x1UL << 1));
 
+	rdcu_clear_rdcu_rmap_error_cntr_reset();
+	rdcu_clear_rdcu_spw_error_cntr_reset();
 
+	return ret;
+}
 
 
 /**
- * @brief initialise the rdcu control library
+ * A sliding window transfer polls for replies while the window is full. If no
+ * transaction completes within SRAM_WINDOW_STALL_MAX consecutive polls, the
+ * transfer is given up, as a reply that is never going to arrive would
+ * otherwise block it forever. With a reply timeout (see
+ * rdcu_rmap_set_timeout()), such transactions are dropped by the link before.
+ */
+
+#define SRAM_WINDOW_STALL_MAX	1000000
+
+
+/**
+ * @brief check whether a full transfer window still makes progress
  *
- * @returns 0 on success, otherwise error
+ * @param stall the number of consecutive polls without progress
+ * @param pending the number of pending transactions at the last poll
+ *
+ * @returns 0 if the transfer may be retried, otherwise error
  */
 
-int rdcu_ctrl_init(void)
+static int rdcu_sync_window_stalled(uint32_t *stall, int *pending)
 {
-	rdcu = (struct rdcu_mirror *) calloc(1, sizeof(struct rdcu_mirror));
-	if (!rdcu) {
-		printf("Error allocating memory for the RDCU mirror\n");
-		return -1;
-	}
+	int n;
 
-#if (__sparc__)
-	rdcu->sram =  (uint8_t *) 0x60000000;
-#else /* assume PC */
-	rdcu->sram = (uint8_t *) malloc(RDCU_SRAM_SIZE);
+
+	n = rdcu_rmap_sync_status();
+
+	if (n < (*pending))
+		(*stall) = 0;
+
+	(*pending) = n;
+
+	if (++(*stall) < SRAM_WINDOW_STALL_MAX)
+		return 0;
+
+	dlog1("Error: transfer window stalled with %lu transactions "
+	      "pending\n", n);
+
+	return -1;
+}
+
+
+/**
+ * @brief wait until all pending transactions completed
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note if no transaction completes within SRAM_WINDOW_STALL_MAX consecutive
+ *	 polls, all pending transactions are dropped (see
+ *	 rdcu_rmap_reset_log()), so none of them refers to a buffer of the
+ *	 caller once this returns
+ */
+
+int rdcu_sync_wait(void)
+{
+	int pending = 0;
+	uint32_t stall = 0;
+
+
+	while (rdcu_rmap_sync_status()) {
+		if (rdcu_sync_window_stalled(&stall, &pending)) {
+			rdcu_rmap_reset_log();
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief update the pages of a range of the mirror once its transfer completed
+ *
+ * @param x the transfer of the range
+ *
+ * @note a read marks the pages valid and clean if it succeeded, and not valid
+ *	 otherwise; a write marks its pages valid if it succeeded and dirty
+ *	 otherwise, they were marked clean when the transfer started
+ */
+
+static void sram_xfer_done(struct sram_xfer *x)
+{
+	struct rdcu_ctrl_ctx *c = x->ctx;
+
+
+	if (x->read) {
+		if (!x->failed)
+			sram_range_mark(c->sram_dirty, x->addr, x->size, 0);
+		sram_range_mark(c->sram_valid, x->addr, x->size, !x->failed);
+	} else {
+		if (x->failed)
+			sram_range_mark(c->sram_dirty, x->addr, x->size, 1);
+		else
+			sram_range_mark(c->sram_valid, x->addr, x->size, 1);
+	}
+
+	x->busy = 0;
+}
+
+
+/**
+ * @brief an SRAM transfer transaction completed
+ *
+ * @param trans_id the transaction identifier (unused)
+ * @param status 0 on success, otherwise the transaction was dropped
+ * @param userdata the transfer the transaction belongs to
+ */
+
+static void sram_xfer_cb(__attribute__((unused)) uint16_t trans_id,
+			 int status, void *userdata)
+{
+	struct sram_xfer *x = (struct sram_xfer *) userdata;
+
+
+	if (status)
+		x->failed = 1;
+
+	x->chunks--;
+
+	if (!x->chunks && !x->submitting)
+		sram_xfer_done(x);
+}
+
+
+/**
+ * @brief start tracking the transfer of a range of the mirror
+ *
+ * @param addr an address within the RDCU SRAM
+ * @param size the size of the range in bytes
+ * @param read 0: mirror to SRAM, otherwise SRAM to mirror
+ *
+ * @returns the transfer or NULL on error
+ *
+ * @note if all transfers are in use, replies are processed until one
+ *	 completes
+ */
+
+static struct sram_xfer *sram_xfer_start(uint32_t addr, uint32_t size,
+					 int read)
+{
+	int i;
+	int pending = 0;
+	uint32_t stall = 0;
+
+	struct sram_xfer *x;
+
+
+	while (1) {
+		for (i = 0; i < SRAM_XFERS; i++) {
+			if (!ctrl_ctx->xfer[i].busy)
+				break;
+		}
+
+		if (i < SRAM_XFERS)
+			break;
+
+		if (rdcu_sync_window_stalled(&stall, &pending))
+			return NULL;
+	}
+
+	x = &ctrl_ctx->xfer[i];
+
+	x->ctx        = ctrl_ctx;
+	x->addr       = addr;
+	x->size       = size;
+	x->chunks     = 0;
+	x->busy       = 1;
+	x->submitting = 1;
+	x->read       = (uint8_t) (read != 0);
+	x->failed     = 0;
+
+	/* the contents of the RDCU are unknown until the write completed */
+	if (!read) {
+		sram_range_mark(sram_dirty, addr, size, 0);
+		sram_range_mark(sram_valid, addr, size, 0);
+	}
+
+	return x;
+}
+
+
+/**
+ * @brief transfer a range of the SRAM mirror in a sliding window
+ *
+ * @param fn a RDCU data transfer generation function
+ * @param addr an address within the remote SRAM
+ * @param size the number of bytes to transfer
+ * @param mtu the maximum transport unit per RMAP packet
+ * @param read 0: mirror to SRAM, otherwise SRAM to mirror
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note chunks are submitted as long as the transfer window allows; when it
+ *	 is full, rdcu_sync_data() processes the pending replies until a slot
+ *	 frees up, so the link always has up to the configured window depth of
+ *	 transactions in flight (see rdcu_rmap_set_window())
+ * @note the transfer fails if the window stalls, see SRAM_WINDOW_STALL_MAX
+ * @note the state of the pages is updated once all transactions completed,
+ *	 see sram_xfer_done()
+ */
+
+static int rdcu_sync_sram_window(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+					   uint32_t addr, uint32_t data_len),
+				 uint32_t addr, uint32_t size, uint32_t mtu,
+				 int read)
+{
+	int ret = 0;
+
+	uint32_t n;
+	uint32_t done = 0;
+	uint32_t stall = 0;
+	int pending = 0;
+
+	uint8_t *sram;
+
+	struct sram_xfer *x;
+
+
+	if (!mtu)
+		return -1;
+
+	x = sram_xfer_start(addr, size, read);
+	if (!x)
+		return -1;
+
+	while (done < size) {
+
+		n = size - done;
+		if (n > mtu)
+			n = mtu;
+
+		/* a transfer must not leave a block of a sparse mirror */
+		if (n > rdcu_sram_contig(addr + done))
+			n = rdcu_sram_contig(addr + done);
+
+		sram = rdcu_sram_map(addr + done);
+		if (!sram) {
+			ret = -1;
+			break;
+		}
+
+		/* earlier chunks may complete while this one is submitted */
+		x->chunks++;
+
+		ret = rdcu_sync_data_async(fn, addr + done, sram, n, read,
+					   sram_xfer_cb, x);
+		if (ret)
+			x->chunks--;
+
+		if (ret > 0) {
+			/* window full, retry */
+			ret = rdcu_sync_window_stalled(&stall, &pending);
+			if (ret)
+				break;
+			continue;
+		}
+
+		if (ret < 0)
+			break;
+
+		stall = 0;
+		done += n;
+	}
+
+	if (ret)
+		x->failed = 1;
+
+	x->submitting = 0;
+
+	if (!x->chunks)
+		sram_xfer_done(x);
+
+	return ret;
+}
+
+
+/**
+ * @brief sync a range of 32 bit words of the local mirror to the remote SRAM
+ *
+ * @param addr and address within the remote SRAM
+ * @param size the number of bytes to sync
+ * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ *
+ * @note due to restrictions, the number of bytes and mtu must be a multiple
+ *	 of 4; the address must be aligned to 32-bits as well
+ * @note the pages turn valid once the transfer completed (see
+ *	 rdcu_rmap_sync_status()), or dirty again if it failed
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_mirror_to_sram(uint32_t addr, uint32_t size, uint32_t mtu)
+{
+	if (mtu & 0x3)
+		return -1;
+
+	if (addr & 0x3)
+		return -1;
+
+	if (size & 0x3)
+		return -1;
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (size > RDCU_SRAM_SIZE)
+		return -1;
+
+	if ((addr + size) > (RDCU_SRAM_END + 1))
+		return -1;
+
+
+	return rdcu_sync_sram_window(rdcu_write_cmd_data, addr, size, mtu, 0);
+}
+
+
+/**
+ * @brief sync a range of 32 bit words of the remote SRAM to the local mirror
+ *
+ * @param addr an address within the remote SRAM
+ * @param size the number of bytes to sync
+ * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ *
+ * @note due to restrictions, the number of bytes and mtu must be a multiple
+ *	 of 4; the address must be aligned to 32-bits as well
+ * @note the pages turn valid once the transfer completed (see
+ *	 rdcu_rmap_sync_status()), or not valid if it failed
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_sram_to_mirror(uint32_t addr, uint32_t size, uint32_t mtu)
+{
+	if (mtu & 0x3)
+		return -1;
+
+	if (addr & 0x3)
+		return -1;
+
+	if (size & 0x3)
+		return -1;
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (size > RDCU_SRAM_SIZE)
+		return -1;
+
+	if ((addr + size) > (RDCU_SRAM_END + 1))
+		return -1;
+
+
+	return rdcu_sync_sram_window(rdcu_read_cmd_data, addr, size, mtu, 1);
+}
+
+
+/**
+ * @brief sync all modified pages of the local mirror to the remote SRAM
+ *
+ * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ *
+ * @note adjacent dirty pages are coalesced and sent in as few RMAP packets
+ *	 of up to mtu bytes as possible
+ * @note the mtu must be a multiple of 4
+ * @note the pages are clean while in transfer, they turn valid once their
+ *	 transfer completed, or dirty again if it failed
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_dirty_to_sram(uint32_t mtu)
+{
+	uint32_t page = 0;
+	uint32_t last;
+
+
+	if (mtu & 0x3)
+		return -1;
+
+	while (page < SRAM_PAGES) {
+
+		/* skip clean blocks of pages quickly */
+		if (!sram_dirty[page >> 5]) {
+			page = (page | 0x1F) + 1;
+			continue;
+		}
+
+		if (!sram_page_test(sram_dirty, page)) {
+			page++;
+			continue;
+		}
+
+		/* find the end of the dirty extent */
+		last = page + 1;
+		while (last < SRAM_PAGES && sram_page_test(sram_dirty, last))
+			last++;
+
+		if (rdcu_sync_sram_window(rdcu_write_cmd_data,
+					  page << SRAM_PAGE_SHIFT,
+					  (last - page) << SRAM_PAGE_SHIFT,
+					  mtu, 0))
+			return -1;
+
+		page = last;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief sync the modified pages of a range of the local mirror to the remote
+ *	  SRAM
+ *
+ * @param addr an address within the remote SRAM; must be 4 byte aligned
+ * @param size the size of the range in bytes
+ * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ *
+ * @note unlike rdcu_sync_dirty_to_sram(), nothing outside of the range is
+ *	 written, so the range may share its first and last page with buffers
+ *	 the RDCU writes to; such partially covered pages stay dirty
+ * @note the size is rounded up to a multiple of 4, the mtu must be a multiple
+ *	 of 4
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sync_dirty_range_to_sram(uint32_t addr, uint32_t size, uint32_t mtu)
+{
+	uint32_t page;
+	uint32_t last;
+	uint32_t end;
+	uint32_t start;
+	uint32_t stop;
+
+
+	if (mtu & 0x3)
+		return -1;
+
+	if (addr & 0x3)
+		return -1;
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (size > RDCU_SRAM_SIZE)
+		return -1;
+
+	size = (size + 3) & ~0x3UL;
+
+	if ((addr + size) > (RDCU_SRAM_END + 1))
+		return -1;
+
+	if (!size)
+		return 0;
+
+	end  = addr + size;
+	page = addr >> SRAM_PAGE_SHIFT;
+
+	while ((page << SRAM_PAGE_SHIFT) < end) {
+
+		if (!sram_page_test(sram_dirty, page)) {
+			page++;
+			continue;
+		}
+
+		/* find the end of the dirty extent within the range */
+		last = page + 1;
+		while ((last << SRAM_PAGE_SHIFT) < end &&
+		       sram_page_test(sram_dirty, last))
+			last++;
+
+		start = page << SRAM_PAGE_SHIFT;
+		if (start < addr)
+			start = addr;
+
+		stop = last << SRAM_PAGE_SHIFT;
+		if (stop > end)
+			stop = end;
+
+		if (rdcu_sync_sram_window(rdcu_write_cmd_data, start,
+					  stop - start, mtu, 0))
+			return -1;
+
+		page = last;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief copy cpu order values into the SRAM mirror and mark the modified
+ *	  pages dirty
+ *
+ * @param addr an address within the RDCU SRAM
+ * @param buf the buffer to read from
+ * @param size the number of bytes to copy
+ * @param width the size of a value in bytes (1, 2 or 4)
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static int rdcu_sram_update_width(uint32_t addr, const uint8_t *buf,
+				  uint32_t size, uint32_t width)
+{
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	if (width > 1)
+		return rdcu_sram_update_swab(addr, buf, size, width);
+#else
+	(void) width;
+#endif /* __BYTE_ORDER__ */
+
+	return rdcu_sram_update(addr, buf, size);
+}
+
+
+/**
+ * @brief update the state of the SRAM mirror for a range that is written to
+ *	  the remote SRAM without going through the mirror
+ *
+ * @param addr an address within the RDCU SRAM
+ * @param buf the buffer that is written
+ * @param size the size of the range in bytes
+ * @param width the size of a value in bytes (1, 2 or 4)
+ *
+ * @note pages fully covered by the range are marked clean, but not valid,
+ *	 as the mirror does not hold their contents; pages partially covered
+ *	 are marked not valid, unless they are dirty, in which case the
+ *	 mirror is updated with the data of the range, so that the page can
+ *	 still be synced as a whole with rdcu_sync_dirty_to_sram()
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static int rdcu_sram_supersede(uint32_t addr, const uint8_t *buf,
+			       uint32_t size, uint32_t width)
+{
+	uint32_t n;
+	uint32_t page;
+
+
+	while (size) {
+
+		page = addr >> SRAM_PAGE_SHIFT;
+
+		/* bytes to the end of the page */
+		n = SRAM_PAGE_SIZE - (addr & (SRAM_PAGE_SIZE - 1));
+		if (n > size)
+			n = size;
+
+		if (n == SRAM_PAGE_SIZE) {
+			sram_page_clear(sram_dirty, page);
+			sram_page_clear(sram_valid, page);
+		} else if (sram_page_test(sram_dirty, page)) {
+			if (rdcu_sram_update_width(addr, buf, n, width))
+				return -1;
+		} else {
+			sram_page_clear(sram_valid, page);
+		}
+
+		addr += n;
+		buf  += n;
+		size -= n;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief transfer a range of a user buffer in a sliding window
+ *
+ * @param fn a RDCU data transfer generation function
+ * @param addr an address within the remote SRAM
+ * @param buf the user buffer
+ * @param size the number of bytes to transfer
+ * @param mtu the maximum transport unit per RMAP packet
+ * @param read 0: buffer to SRAM, otherwise SRAM to buffer
+ * @param width the size of a value in the buffer in bytes (1, 2 or 4)
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note see rdcu_sync_sram_window()
+ * @note on error, the chunks already submitted are waited for (see
+ *	 rdcu_sync_wait()), so no transaction refers to the buffer anymore
+ */
+
+static int rdcu_sync_user_window(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+					   uint32_t addr, uint32_t data_len),
+				 uint32_t addr, uint8_t *buf, uint32_t size,
+				 uint32_t mtu, int read, uint32_t width)
+{
+	int ret;
+
+	uint32_t n;
+	uint32_t done = 0;
+	uint32_t stall = 0;
+	int pending = 0;
+
+
+	if (!mtu)
+		return -1;
+
+	while (done < size) {
+
+		n = size - done;
+		if (n > mtu)
+			n = mtu;
+
+		ret = rdcu_sync_data_swab(fn, addr + done, buf + done, n, read,
+					  width);
+		if (ret > 0) {
+			/* window full, retry */
+			ret = rdcu_sync_window_stalled(&stall, &pending);
+			if (ret)
+				break;
+			continue;
+		}
+
+		if (ret < 0)
+			break;
+
+		stall = 0;
+		done += n;
+	}
+
+	if (ret) {
+		rdcu_sync_wait();
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief write a buffer of cpu order values directly to the remote SRAM
+ *
+ * @param buf the buffer to read from; must be aligned to width
+ * @param addr an address within the remote SRAM
+ * @param size the number of bytes to write
+ * @param width the size of a value in the buffer in bytes (1, 2 or 4)
+ * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ *
+ * @note the data are converted to big endian while the RMAP packets are
+ *	 built, they are not copied to the local SRAM mirror
+ * @note this returns while transactions still refer to the buffer; it must
+ *	 stay valid and must not be modified until rdcu_rmap_sync_status()
+ *	 reports no pending transactions, e.g. wait with rdcu_sync_wait()
+ * @note the address and mtu must be aligned to 32-bits, the size must be a
+ *	 multiple of the width; a trailing partial 32 bit word is placed in
+ *	 the SRAM mirror and is transferred with the next
+ *	 rdcu_sync_dirty_to_sram()
+ * @note pending changes of the mirror in pages shared with the range are
+ *	 updated, so a subsequent rdcu_sync_dirty_to_sram() does not
+ *	 overwrite the data
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_write_user_to_sram(const void *buf, uint32_t addr, uint32_t size,
+			    uint32_t width, uint32_t mtu)
+{
+	uint32_t n;
+
+
+	if (!buf)
+		return -1;
+
+	if (width != 1 && width != sizeof(uint16_t) && width != sizeof(uint32_t))
+		return -1;
+
+	if (mtu & 0x3)
+		return -1;
+
+	if (addr & 0x3)
+		return -1;
+
+	if (size & (width - 1))
+		return -1;
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (size > RDCU_SRAM_SIZE)
+		return -1;
+
+	if ((addr + size) > (RDCU_SRAM_END + 1))
+		return -1;
+
+
+	n = size & ~0x3U;
+
+	/* the tail goes first, so its page is dirty before we supersede it */
+	if (n < size) {
+		if (rdcu_sram_update_width(addr + n, (const uint8_t *) buf + n,
+					   size - n, width))
+			return -1;
+	}
+
+	if (rdcu_sram_supersede(addr, (const uint8_t *) buf, n, width))
+		return -1;
+
+	return rdcu_sync_user_window(rdcu_write_cmd_data, addr,
+				     (uint8_t *) buf, n, mtu, 0, width);
+}
+
+
+/**
+ * @brief read a range of the remote SRAM directly into a buffer of cpu order
+ *	  values
+ *
+ * @param buf the buffer to read to; must be aligned to width
+ * @param addr an address within the remote SRAM
+ * @param size the number of bytes to read
+ * @param width the size of a value in the buffer in bytes (1, 2 or 4)
+ * @param mtu the maximum transport unit per RMAP packet; choose wisely
+ *
+ * @note the replies are converted from big endian while they are copied to
+ *	 the buffer, the local SRAM mirror is not modified
+ * @note this returns while transactions still refer to the buffer; it must
+ *	 stay valid and must not be used until rdcu_rmap_sync_status() reports
+ *	 no pending transactions, e.g. wait with rdcu_sync_wait()
+ * @note due to restrictions, the number of bytes and mtu must be a multiple
+ *	 of 4; the address must be aligned to 32-bits as well
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_read_sram_to_user(void *buf, uint32_t addr, uint32_t size,
+			   uint32_t width, uint32_t mtu)
+{
+	if (!buf)
+		return -1;
+
+	if (mtu & 0x3)
+		return -1;
+
+	if (addr & 0x3)
+		return -1;
+
+	if (size & 0x3)
+		return -1;
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (size > RDCU_SRAM_SIZE)
+		return -1;
+
+	if ((addr + size) > (RDCU_SRAM_END + 1))
+		return -1;
+
+
+	return rdcu_sync_user_window(rdcu_read_cmd_data, addr, (uint8_t *) buf,
+				     size, mtu, 1, width);
+}
+
+
+/**
+ * @brief mark a range of the local SRAM mirror as not matching the remote
+ *
+ * @param addr an address within the RDCU SRAM
+ * @param size the size of the range in bytes
+ *
+ * @note call this for buffers the RDCU writes to, e.g. the compressed data
+ *	 and updated model buffers of a compression, so that subsequent
+ *	 writes will not be skipped because their data matches the stale
+ *	 contents of the mirror
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_sram_invalidate(uint32_t addr, uint32_t size)
+{
+	uint32_t page;
+	uint32_t last;
+
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (size > RDCU_SRAM_SIZE)
+		return -1;
+
+	if ((addr + size) > (RDCU_SRAM_END + 1))
+		return -1;
+
+	if (!size)
+		return 0;
+
+	page = addr >> SRAM_PAGE_SHIFT;
+	last = (addr + size - 1) >> SRAM_PAGE_SHIFT;
+
+	for (; page <= last; page++)
+		sram_page_clear(sram_valid, page);
+
+	return 0;
+}
+
+
+/**
+ * @brief modify bits of a 32 bit word in the remote SRAM in one transaction
+ *
+ * @param addr the address of the word within the RDCU SRAM
+ * @param val the bits to set
+ * @param mask the bits to modify
+ *
+ * @note the RDCU performs word = (word & ~mask) | (val & mask) with a RMAP
+ *	 read-modify-write command; on completion, the word in the local
+ *	 mirror is set to the new remote contents, superseding any pending
+ *	 local change of that word
+ *
+ * @returns 0 on success, < 0: error, > 0: retry
+ */
+
+int rdcu_rmw_sram_32(uint32_t addr, uint32_t val, uint32_t mask)
+{
+	uint8_t *sram;
+
+
+	if (addr & 0x3)
+		return -1;
+
+	if (addr > RDCU_SRAM_END - 3)
+		return -1;
+
+	sram = rdcu_sram_map(addr);
+	if (!sram)
+		return -1;
+
+	return rdcu_sync_rmw(rdcu_rmw_cmd_data, addr,
+			     (uint32_t *) sram, val, mask, 0);
+}
+
+
+
+
+
+
+
+
+/**
+ * @brief allocate a new RDCU control context
+ *
+ * @returns a pointer to the context or NULL on error
+ *
+ * @note the context must be selected with rdcu_ctrl_select_ctx() and
+ *	 initialised with rdcu_ctrl_init() just like the default one
+ */
+
+struct rdcu_ctrl_ctx *rdcu_ctrl_ctx_alloc(void)
+{
+	struct rdcu_ctrl_ctx *c;
+
+
+	c = (struct rdcu_ctrl_ctx *) calloc(1, sizeof(struct rdcu_ctrl_ctx));
+	if (!c)
+		printf("Error allocating memory for the RDCU control context\n");
+
+	return c;
+}
+
+
+/**
+ * @brief release the register and SRAM mirror of a control context
+ *
+ * @param c the control context
+ *
+ * @note the SRAM image of the default context in the boards SDRAM is not
+ *	 released, as it is not allocated
+ */
+
+static void rdcu_ctrl_free_mirror(struct rdcu_ctrl_ctx *c)
+{
+	if (c->mirror) {
+#if (__sparc__)
+		if (c != &ctrl_ctx_default)
+			free(c->mirror->sram);
+#else /* assume PC */
+		free(c->mirror->sram);
+#endif
+		free(c->mirror);
+		c->mirror = NULL;
+	}
+
+	if (ctrl_ctx == c)
+		rdcu = NULL;
+
+	rdcu_sram_release_blocks(c);
+}
+
+
+/**
+ * @brief free an RDCU control context and its mirror
+ *
+ * @param c the context to free
+ *
+ * @note if the context is currently selected, the default context is selected
+ *	 instead; the default context itself is never freed
+ * @note the context must not be freed while transfers of its mirror are in
+ *	 flight
+ */
+
+void rdcu_ctrl_ctx_free(struct rdcu_ctrl_ctx *c)
+{
+	if (!c)
+		return;
+
+	if (c == &ctrl_ctx_default)
+		return;
+
+	if (ctrl_ctx == c)
+		rdcu_ctrl_select_ctx(NULL);
+
+	rdcu_ctrl_free_mirror(c);
+
+	free(c);
+}
+
+
+/**
+ * @brief select the RDCU control context all subsequent calls operate on
+ *
+ * @param c the context to select; NULL selects the default context
+ *
+ * @note never select a context from interrupt context, see
+ *	 rdcu_rmap_select_ctx()
+ */
+
+void rdcu_ctrl_select_ctx(struct rdcu_ctrl_ctx *c)
+{
+	if (!c)
+		c = &ctrl_ctx_default;
+
+	ctrl_ctx   = c;
+	rdcu       = c->mirror;
+	sram_dirty = c->sram_dirty;
+	sram_valid = c->sram_valid;
+}
+
+
+/**
+ * @brief get the currently selected RDCU control context
+ *
+ * @returns the selected context
+ */
+
+struct rdcu_ctrl_ctx *rdcu_ctrl_get_ctx(void)
+{
+	return ctrl_ctx;
+}
+
+
+/**
+ * @brief allocate the register mirror of the selected control context
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the mirror of a previous initialisation is released
+ */
+
+static int rdcu_ctrl_alloc_mirror(void)
+{
+	rdcu_ctrl_free_mirror(ctrl_ctx);
+
+	rdcu = (struct rdcu_mirror *) calloc(1, sizeof(struct rdcu_mirror));
+	if (!rdcu) {
+		printf("Error allocating memory for the RDCU mirror\n");
+		return -1;
+	}
+
+	/* we know nothing about the remote SRAM contents yet */
+	memset(ctrl_ctx->sram_dirty, 0, sizeof(ctrl_ctx->sram_dirty));
+	memset(ctrl_ctx->sram_valid, 0, sizeof(ctrl_ctx->sram_valid));
+
+	return 0;
+}
+
+
+/**
+ * @brief initialise the rdcu control library
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note this initialises the selected control context with a full image of
+ *	 the RDCU SRAM, see rdcu_ctrl_init_sparse() for an alternative
+ * @note the context may be initialised again, its previous mirror is
+ *	 released then; no transfers of the mirror may be in flight
+ */
+
+int rdcu_ctrl_init(void)
+{
+	if (rdcu_ctrl_alloc_mirror())
+		return -1;
+
+#if (__sparc__)
+	/* the default RDCU is mirrored to the boards SDRAM */
+	if (ctrl_ctx == &ctrl_ctx_default)
+		rdcu->sram = (uint8_t *) 0x60000000;
+	else
+		rdcu->sram = (uint8_t *) malloc(RDCU_SRAM_SIZE);
+#else /* assume PC */
+	rdcu->sram = (uint8_t *) malloc(RDCU_SRAM_SIZE);
+#endif
 	if (!rdcu->sram) {
 		printf("Error allocating memory for the RDCU SRAM mirror\n");
+		free(rdcu);
+		rdcu = NULL;
 		return -1;
 	}
-#endif
+
+	ctrl_ctx->mirror = rdcu;
 
 	memset(rdcu->sram, 0, RDCU_SRAM_SIZE);  /* clear sram buffer */
 
 	return 0;
 }
+
+
+/**
+ * @brief initialise the rdcu control library with a sparse SRAM mirror
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note this initialises the selected control context without an image of
+ *	 the RDCU SRAM; blocks of SRAM_BLOCK_SIZE bytes are allocated when they
+ *	 are first written to or transferred, or may be provided by the user
+ *	 with rdcu_sram_add_window(), unused blocks read as zero
+ */
+
+int rdcu_ctrl_init_sparse(void)
+{
+	if (rdcu_ctrl_alloc_mirror())
+		return -1;
+
+	ctrl_ctx->mirror = rdcu;
+
+	return 0;
+}
+
+
+/**
+ * @brief use a user buffer as the mirror of an SRAM range
+ *
+ * @param addr an address within the RDCU SRAM, aligned to the SRAM block size
+ * @param size the size of the range, a multiple of the SRAM block size
+ * @param buf the buffer to use, aligned to 32 bits
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the mirror must have been initialised with rdcu_ctrl_init_sparse();
+ *	 the contents of blocks already in use are copied to the buffer, all
+ *	 others are taken as they are, the range is marked as not matching
+ *	 the remote (see rdcu_sram_invalidate())
+ * @note the buffer must remain valid until the control context is
+ *	 reinitialised or freed
+ */
+
+int rdcu_sram_add_window(uint32_t addr, uint32_t size, void *buf)
+{
+	uint32_t i;
+	uint32_t blk;
+
+	uint8_t *dst = (uint8_t *) buf;
+
+
+	if (!rdcu || rdcu->sram)
+		return -1;
+
+	if (!buf)
+		return -1;
+
+	if ((addr | size) & (SRAM_BLOCK_SIZE - 1))
+		return -1;
+
+	if (addr > RDCU_SRAM_END)
+		return -1;
+
+	if (size > RDCU_SRAM_SIZE)
+		return -1;
+
+	if ((addr + size) > (RDCU_SRAM_END + 1))
+		return -1;
+
+
+	for (i = 0; i < size; i += SRAM_BLOCK_SIZE) {
+
+		blk = (addr + i) >> SRAM_BLOCK_SHIFT;
+
+		if (ctrl_ctx->sram_block[blk]) {
+			memcpy(&dst[i], ctrl_ctx->sram_block[blk],
+			       SRAM_BLOCK_SIZE);
+
+			if (!sram_page_test(ctrl_ctx->sram_block_user, blk))
+				free(ctrl_ctx->sram_block[blk]);
+		}
+
+		ctrl_ctx->sram_block[blk] = &dst[i];
+		sram_page_set(ctrl_ctx->sram_block_user, blk);
+	}
+
+	return rdcu_sram_invalidate(addr, size);
+}
@@ -0,0 +1,839 @@
+/**
+ * @file   rdcu_emu.c
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief a loopback RMAP RDCU target emulator
+ * @see FPGA Requirement Specification PLATO-IWF-PL-RS-005 Issue 0.7
+ *
+ *
+ * This is an in-process replacement for the SpW link and the RDCU, so the
+ * rdcu_rmap/rdcu_ctrl libraries may be used (and profiled) on a PC without any
+ * hardware attached. It decodes RMAP commands and serves them from an
+ * emulated register file and SRAM; the replies are queued and returned by the
+ * rx function. To use it, configure the emulator backend:
+ *
+ *	rdcu_emu_init(RDCU_ADDR_START, RDCU_DEST_KEY);
+ *	rdcu_rmap_init(mtu, rdcu_emu_tx, rdcu_emu_rx);
+ *	rdcu_rmap_set_tx_avail(rdcu_emu_tx_avail);
+ *
+ * By default, replies are available immediately. A link with finite bandwidth
+ * and a turnaround latency may be emulated with rdcu_emu_set_link(); the
+ * ICU->RDCU and the RDCU->ICU directions are modelled separately, as SpW is
+ * full duplex, i.e. a reply becomes available once the command was
+ * transferred, the latency elapsed and the reply was transferred after all
+ * preceding replies.
+ *
+ * If enabled with rdcu_emu_set_compressor(), a start of the data compressor
+ * runs the ICU software compressor on the emulated SRAM and completes
+ * instantly with the compressor information registers set accordingly.
+ *
+ * NOTE: commands take effect the moment they are submitted, only the replies
+ *	 are delayed; the reply path is not prepended to the replies, they start
+ *	 with the initiator logical address like packets received from a
+ *	 GRSPW2 would
+ *
+ * NOTE: the emulated SRAM is allocated from the heap, so this is meant for host
+ *	 builds
+ *
+ * XXX: no locking, single-thread-use only!
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <byteorder.h>
+#include <rmap.h>
+#include <rdcu_cmd.h>
+#include <rdcu_emu.h>
+
+#include "../include/cmp_support.h"
+#include "../include/cmp_icu.h"
+
+
+/* the emulated register banks and the SRAM, all as a big-endian image */
+#define EMU_CTRL_REG_SIZE	(COMPR_CTRL - FPGA_VERSION + 4)
+#define EMU_CMP_REG_SIZE	(USED_NUMBER_OF_SAMPLES - COMPR_PARAM_1 + 4)
+#define EMU_EDAC_REG_SIZE	(SRAM_EDAC_STATUS - SRAM_EDAC_CTRL + 4)
+
+static uint8_t ctrl_regs[EMU_CTRL_REG_SIZE];
+static uint8_t cmp_regs[EMU_CMP_REG_SIZE];
+static uint8_t edac_regs[EMU_EDAC_REG_SIZE];
+static uint8_t *sram;
+
+static struct {
+	uint32_t base;
+	uint32_t size;
+	uint8_t **mem;
+} emu_bank[] = {
+	{RDCU_SRAM_START, RDCU_SRAM_SIZE,	&sram},
+	{FPGA_VERSION,	  EMU_CTRL_REG_SIZE,	NULL},
+	{COMPR_PARAM_1,	  EMU_CMP_REG_SIZE,	NULL},
+	{SRAM_EDAC_CTRL,  EMU_EDAC_REG_SIZE,	NULL},
+};
+
+static uint8_t *emu_bank_mem[] = {NULL, ctrl_regs, cmp_regs, edac_regs};
+
+#define EMU_BANKS	(sizeof(emu_bank) / sizeof(emu_bank[0]))
+
+
+/* the reply queue */
+static struct {
+	uint8_t  *pkt[RDCU_EMU_QUEUE_SIZE];
+	uint32_t  len[RDCU_EMU_QUEUE_SIZE];
+	uint32_t  t_ready[RDCU_EMU_QUEUE_SIZE];
+
+	int head;
+	int tail;
+	int cnt;
+} queue;
+
+
+/* link emulation parameters and state */
+static struct {
+	uint32_t (*time)(void);
+	uint32_t ticks_per_sec;
+	uint32_t latency;
+	uint32_t bytes_per_sec;
+
+	uint32_t tx_free;	/* ICU->RDCU direction is idle after this */
+	uint32_t rx_free;	/* RDCU->ICU direction is idle after this */
+} link;
+
+
+static uint8_t emu_key;
+static int emu_compressor;
+
+
+/**
+ * @brief get a pointer to an address range of the emulated target
+ *
+ * @param addr the start address
+ * @param len the length of the range in bytes
+ *
+ * @returns a pointer to the memory or NULL if the range is not mapped
+ */
+
+static uint8_t *emu_get_mem(uint32_t addr, uint32_t len)
+{
+	size_t i;
+
+
+	for (i = 0; i < EMU_BANKS; i++) {
+
+		if (addr < emu_bank[i].base)
+			continue;
+
+		if (addr - emu_bank[i].base > emu_bank[i].size)
+			continue;
+
+		if (len > emu_bank[i].size - (addr - emu_bank[i].base))
+			continue;
+
+		if (emu_bank[i].mem)
+			return *emu_bank[i].mem + (addr - emu_bank[i].base);
+
+		return emu_bank_mem[i] + (addr - emu_bank[i].base);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * @brief get an emulated register value
+ */
+
+static uint32_t emu_reg_get(uint32_t addr)
+{
+	uint32_t v;
+	uint8_t *p = emu_get_mem(addr, sizeof(uint32_t));
+
+
+	if (!p)
+		return 0;
+
+	memcpy(&v, p, sizeof(v));
+
+	return be32_to_cpu(v);
+}
+
+
+/**
+ * @brief set an emulated register value
+ */
+
+static void emu_reg_set(uint32_t addr, uint32_t val)
+{
+	uint8_t *p = emu_get_mem(addr, sizeof(uint32_t));
+
+
+	if (!p)
+		return;
+
+	val = cpu_to_be32(val);
+	memcpy(p, &val, sizeof(val));
+}
+
+
+/**
+ * @brief get the current logical address of the emulated RDCU
+ */
+
+static uint8_t emu_get_addr(void)
+{
+	return (uint8_t) (emu_reg_get(CORE_CTRL) >> 24);
+}
+
+
+/**
+ * @brief convert the transfer of a number of bytes into link time
+ */
+
+static uint32_t emu_link_ticks(uint32_t bytes)
+{
+	if (!link.bytes_per_sec)
+		return 0;
+
+	return (uint32_t) (((uint64_t) bytes * link.ticks_per_sec) /
+			   link.bytes_per_sec);
+}
+
+
+/**
+ * @brief get the later of two points in (wrapping) time
+ */
+
+static uint32_t emu_time_max(uint32_t a, uint32_t b)
+{
+	if ((int32_t) (a - b) > 0)
+		return a;
+
+	return b;
+}
+
+
+/**
+ * @brief run the software compressor on the emulated SRAM
+ *
+ * @note this uses the compressor configuration and sets the compressor
+ *	 information registers like the RDCU would
+ */
+
+static void emu_compress(void)
+{
+	uint32_t i;
+	uint32_t p1, p2, ap1, ap2;
+	uint16_t cmp_err = 0;
+	uint16_t *data  = NULL;
+	uint16_t *model = NULL;
+	uint8_t *out    = NULL;
+	uint8_t *sram_data;
+	uint8_t *sram_model = NULL;
+	uint8_t *sram_up_model = NULL;
+	uint8_t *sram_out;
+
+	struct cmp_cfg cfg;
+	struct cmp_info info;
+	struct cmp_info ap_info;
+
+
+	memset(&cfg, 0, sizeof(struct cmp_cfg));
+	memset(&info, 0, sizeof(struct cmp_info));
+
+	p1  = emu_reg_get(COMPR_PARAM_1);
+	p2  = emu_reg_get(COMPR_PARAM_2);
+	ap1 = emu_reg_get(ADAPTIVE_PARAM_1);
+	ap2 = emu_reg_get(ADAPTIVE_PARAM_2);
+
+	cfg.cmp_mode       = p1 & 0xFFUL;
+	cfg.model_value    = (p1 >> 8) & 0x1FUL;
+	cfg.round          = (p1 >> 16) & 0x3UL;
+	cfg.golomb_par     = p2 & 0x3FUL;
+	cfg.spill          = (p2 >> 8) & 0x3FFFUL;
+	cfg.samples        = emu_reg_get(NUM_SAMPLES) & 0x00FFFFFFUL;
+	cfg.buffer_length  = emu_reg_get(COMPR_DATA_BUF_LEN) & 0x00FFFFFFUL;
+
+	cfg.rdcu_data_adr      = emu_reg_get(DATA_START_ADDR) & 0x00FFFFFFUL;
+	cfg.rdcu_model_adr     = emu_reg_get(MODEL_START_ADDR) & 0x00FFFFFFUL;
+	cfg.rdcu_new_model_adr = emu_reg_get(UPDATED_MODEL_START_ADDR) &
+				 0x00FFFFFFUL;
+	cfg.rdcu_buffer_adr    = emu_reg_get(COMPR_DATA_BUF_START_ADDR) &
+				 0x00FFFFFFUL;
+
+	sram_data = emu_get_mem(cfg.rdcu_data_adr,
+				cfg.samples * sizeof(uint16_t));
+	sram_out  = emu_get_mem(cfg.rdcu_buffer_adr,
+				cfg.buffer_length * sizeof(uint16_t));
+
+	if (model_mode_is_used(cfg.cmp_mode)) {
+		sram_model    = emu_get_mem(cfg.rdcu_model_adr,
+					    cfg.samples * sizeof(uint16_t));
+		sram_up_model = emu_get_mem(cfg.rdcu_new_model_adr,
+					    cfg.samples * sizeof(uint16_t));
+
+		if (!sram_model || !sram_up_model)
+			sram_data = NULL;
+	}
+
+	if (!sram_data || !sram_out) {
+		cmp_err |= 1U << 9;	/* invalid address error */
+		goto exit;
+	}
+
+	data  = (uint16_t *) malloc(cfg.samples * sizeof(uint16_t) + 1);
+	model = (uint16_t *) malloc(cfg.samples * sizeof(uint16_t) + 1);
+	out   = (uint8_t *)  malloc(cfg.buffer_length * sizeof(uint16_t) + 4);
+
+	if (!data || !model || !out) {
+		printf("Error: emulator out of memory\n");
+		cmp_err |= 1U << SLAVE_BUSY_ERR_BIT;
+		goto exit;
+	}
+
+	/* the SRAM holds big-endian samples */
+	for (i = 0; i < cfg.samples; i++) {
+		data[i] = (uint16_t) ((sram_data[2 * i] << 8) |
+				      sram_data[2 * i + 1]);
+		if (sram_model)
+			model[i] = (uint16_t) ((sram_model[2 * i] << 8) |
+					       sram_model[2 * i + 1]);
+	}
+
+	cfg.input_buf         = data;
+	cfg.model_buf         = model;
+	cfg.icu_new_model_buf = model;
+	cfg.icu_output_buf    = out;
+
+	/* the adaptive sizes first, the model is updated in-place below */
+	cfg.icu_output_buf = NULL;
+	cfg.golomb_par     = ap1 & 0x3FUL;
+	cfg.spill          = (ap1 >> 8) & 0x3FFFUL;
+	cfg.icu_new_model_buf = NULL;
+	if (!icu_compress_data(&cfg, &ap_info))
+		emu_reg_set(COMPR_DATA_ADAPTIVE_1_SIZE, ap_info.cmp_size);
+	else
+		emu_reg_set(COMPR_DATA_ADAPTIVE_1_SIZE, 0);
+
+	cfg.golomb_par = ap2 & 0x3FUL;
+	cfg.spill      = (ap2 >> 8) & 0x3FFFUL;
+	if (!icu_compress_data(&cfg, &ap_info))
+		emu_reg_set(COMPR_DATA_ADAPTIVE_2_SIZE, ap_info.cmp_size);
+	else
+		emu_reg_set(COMPR_DATA_ADAPTIVE_2_SIZE, 0);
+
+	cfg.golomb_par        = p2 & 0x3FUL;
+	cfg.spill             = (p2 >> 8) & 0x3FFFUL;
+	cfg.icu_output_buf    = out;
+	cfg.icu_new_model_buf = model;
+
+	icu_compress_data(&cfg, &info);
+	cmp_err |= info.cmp_err;
+
+	if (!cmp_err) {
+		memcpy(sram_out, out, (info.cmp_size + 7) >> 3);
+
+		for (i = 0; sram_up_model && i < cfg.samples; i++) {
+			sram_up_model[2 * i]     = (uint8_t) (model[i] >> 8);
+			sram_up_model[2 * i + 1] = (uint8_t)  model[i];
+		}
+	}
+
+exit:
+	free(data);
+	free(model);
+	free(out);
+
+	emu_reg_set(USED_COMPR_PARAM_1, p1 & 0x31FFFUL);
+	emu_reg_set(USED_COMPR_PARAM_2, p2 & 0x3FFF3FUL);
+	emu_reg_set(COMPR_DATA_START_ADDR, cfg.rdcu_buffer_adr);
+	emu_reg_set(COMPR_DATA_SIZE, info.cmp_size);
+	emu_reg_set(COMPR_ERROR, cmp_err);
+	emu_reg_set(USED_UPDATED_MODEL_START_ADDR, cfg.rdcu_new_model_adr);
+	emu_reg_set(USED_NUMBER_OF_SAMPLES, cfg.samples);
+
+	/* ready, data valid if there was no error */
+	if (cmp_err)
+		emu_reg_set(COMPR_STATUS, 0x1UL << 4);
+	else
+		emu_reg_set(COMPR_STATUS, (0x1UL << 5) | (0x1UL << 4));
+}
+
+
+/**
+ * @brief emulate the side effects of a register write
+ *
+ * @param addr the start address of the write
+ * @param len the number of bytes written
+ */
+
+static void emu_reg_written(uint32_t addr, uint32_t len)
+{
+	uint32_t ctrl;
+	uint32_t status;
+
+
+	/* the current logical address is reported by the LVDS core status */
+	if (addr <= CORE_CTRL && addr + len > CORE_CTRL) {
+		status = emu_reg_get(LVDS_CORE_STATUS) & 0x00FFFFFFUL;
+		status |= emu_reg_get(CORE_CTRL) & 0xFF000000UL;
+		emu_reg_set(LVDS_CORE_STATUS, status);
+	}
+
+	if (!(addr <= COMPR_CTRL && addr + len > COMPR_CTRL))
+		return;
+
+	ctrl   = emu_reg_get(COMPR_CTRL);
+	status = emu_reg_get(COMPR_STATUS);
+
+	/* interrupt enable */
+	status &= ~(0x1UL << 8);
+	status |= ctrl & (0x1UL << 8);
+
+	if (ctrl & (0x1UL << 1)) {
+		/* interrupted, ready, data invalid */
+		status &= ~((0x1UL << 5) | 0x1UL);
+		status |= (0x1UL << 4) | (0x1UL << 1);
+	} else if (ctrl & 0x1UL) {
+
+		if (emu_compressor) {
+			emu_reg_set(COMPR_STATUS, status);
+			emu_compress();
+			status = emu_reg_get(COMPR_STATUS) | (ctrl & (0x1UL << 8));
+		} else {
+			/* nothing to do, ready but invalid */
+			status &= ~((0x1UL << 5) | (0x1UL << 1) | 0x1UL);
+			status |= 0x1UL << 4;
+		}
+	}
+
+	emu_reg_set(COMPR_STATUS, status);
+}
+
+
+/**
+ * @brief queue a reply packet
+ *
+ * @param cmd the command to reply to
+ * @param status the RMAP reply status
+ * @param data the reply data (may be NULL)
+ * @param data_len the length of the reply data
+ * @param cmd_size the size of the command packet as transmitted
+ *
+ * @returns 0 on success, -1 on error
+ */
+
+static int emu_queue_reply(const struct rmap_pkt *cmd, uint8_t status,
+			   const uint8_t *data, uint32_t data_len,
+			   uint32_t cmd_size)
+{
+	int n;
+	uint8_t *buf;
+	uint32_t len;
+	uint32_t now;
+
+	struct rmap_pkt rep;
+
+
+	if (queue.cnt >= RDCU_EMU_QUEUE_SIZE)
+		return -1;
+
+	memset(&rep, 0, sizeof(struct rmap_pkt));
+
+	rep.dst         = cmd->src;
+	rep.proto_id    = cmd->proto_id;
+	rep.instruction = cmd->instruction;
+	rep.ri.cmd_resp = 0;
+	rep.status      = status;
+	rep.src         = emu_get_addr();
+	rep.tr_id       = cmd->tr_id;
+
+	if (status)
+		data_len = 0;
+
+	/* only reads and rmw return data */
+	if (!(cmd->ri.cmd & RMAP_CMD_BIT_WRITE))
+		rep.data_len = data_len;
+	else
+		data_len = 0;
+
+	n = rmap_build_hdr(&rep, NULL);
+	if (n < 0)
+		return -1;
+
+	len = n + 1;			/* header CRC */
+	if (data_len)
+		len += data_len + 1;	/* data CRC */
+
+	buf = (uint8_t *) malloc(len);
+	if (!buf)
+		return -1;
+
+	rmap_build_hdr(&rep, buf);
+	buf[n] = rmap_crc8(buf, n);
+
+	if (data_len) {
+		memcpy(&buf[n + 1], data, data_len);
+		buf[len - 1] = rmap_crc8(data, data_len);
+	}
+
+	queue.t_ready[queue.tail] = 0;
+
+	if (link.time) {
+		now = link.time();
+
+		link.tx_free = emu_time_max(now, link.tx_free) +
+			       emu_link_ticks(cmd_size);
+		link.rx_free = emu_time_max(link.tx_free + link.latency,
+					    link.rx_free) +
+			       emu_link_ticks(len);
+
+		queue.t_ready[queue.tail] = link.rx_free;
+	}
+
+	queue.pkt[queue.tail] = buf;
+	queue.len[queue.tail] = len;
+	queue.tail = (queue.tail + 1) % RDCU_EMU_QUEUE_SIZE;
+	queue.cnt++;
+
+	return 0;
+}
+
+
+/**
+ * @brief execute an RMAP command on the emulated target
+ *
+ * @param cmd the decoded command
+ * @param cmd_size the size of the command packet as transmitted
+ *
+ * @returns 0 on success, -1 if the reply could not be queued
+ */
+
+static int emu_exec(struct rmap_pkt *cmd, uint32_t cmd_size)
+{
+	uint32_t i;
+	uint32_t n;
+	uint8_t *mem;
+	uint8_t *rmw = NULL;
+	uint8_t status = RMAP_STATUS_SUCCESS;
+	int ret = 0;
+
+
+	/* not for us, a real target would discard it */
+	if (cmd->dst != emu_get_addr())
+		return 0;
+
+	/* commands with a length that does not fit the address increment
+	 * are served from the same address, it's all 32 bit registers anyways
+	 */
+	n = cmd->data_len;
+	if (cmd->ri.cmd == RMAP_READ_MODIFY_WRITE_ADDR_INC)
+		n /= 2;
+
+	if (!(cmd->ri.cmd & RMAP_CMD_BIT_INC) && n > sizeof(uint32_t))
+		n = sizeof(uint32_t);
+
+	mem = emu_get_mem(cmd->addr, n);
+
+	if (cmd->key != emu_key)
+		status = RMAP_STATUS_INVALID_KEY;
+	else if (!mem)
+		status = RMAP_STATUS_CMD_NOT_IMPL_OR_AUTH;
+	else if (cmd->addr & 0x3)
+		status = RMAP_STATUS_GENERAL_ERROR;
+	else if (cmd->data_len && (cmd->ri.cmd & RMAP_CMD_BIT_WRITE) &&
+		 rmap_crc8(cmd->data, cmd->data_len) != cmd->data_crc)
+		status = RMAP_STATUS_INVALID_DATA_CRC;
+	else if (cmd->ri.cmd == RMAP_READ_MODIFY_WRITE_ADDR_INC &&
+		 (cmd->data_len & 0x1))
+		status = RMAP_STATUS_RMW_DATA_LEN_ERROR;
+
+
+	if (status == RMAP_STATUS_SUCCESS) {
+
+		if (cmd->ri.cmd == RMAP_READ_MODIFY_WRITE_ADDR_INC) {
+
+			/* reply with the old data, then apply data & mask */
+			rmw = (uint8_t *) malloc(n + 1);
+			if (!rmw)
+				return -1;
+
+			memcpy(rmw, mem, n);
+
+			for (i = 0; i < n; i++)
+				mem[i] = (uint8_t) ((mem[i] & ~cmd->data[n + i]) |
+						    (cmd->data[i] & cmd->data[n + i]));
+
+			emu_reg_written(cmd->addr, n);
+
+		} else if (cmd->ri.cmd & RMAP_CMD_BIT_WRITE) {
+
+			if (cmd->ri.cmd & RMAP_CMD_BIT_INC)
+				memcpy(mem, cmd->data, cmd->data_len);
+			else if (cmd->data_len >= n)
+				memcpy(mem, &cmd->data[cmd->data_len - n], n);
+
+			emu_reg_written(cmd->addr, n);
+		}
+	}
+
+	if (!(cmd->ri.cmd & RMAP_CMD_BIT_REPLY) &&
+	    (cmd->ri.cmd & RMAP_CMD_BIT_WRITE))
+		goto exit;
+
+	if (rmw)
+		ret = emu_queue_reply(cmd, status, rmw, n, cmd_size);
+	else
+		ret = emu_queue_reply(cmd, status, mem, n, cmd_size);
+
+	if (ret)
+		printf("Error: emulator reply queue overflow\n");
+
+exit:
+	free(rmw);
+
+	return ret;
+}
+
+
+/**
+ * @brief transmit an RMAP command to the emulated RDCU
+ *
+ * @param hdr the command header, including the target path
+ * @param hdr_size the size of the header
+ * @param non_crc_bytes the number of leading target path bytes
+ * @param data the payload (may be NULL)
+ * @param data_size the size of the payload
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note this has the same call interface as the tx function expected by
+ *	 rdcu_rmap_init(), the header and data CRCs are added like the GRSPW2
+ *	 would
+ */
+
+int32_t rdcu_emu_tx(const void *hdr,  uint32_t hdr_size,
+		    const uint8_t non_crc_bytes,
+		    const void *data, uint32_t data_size)
+{
+	int ret;
+	uint8_t *buf;
+	uint32_t len;
+
+	struct rmap_pkt cmd;
+
+
+	if (!hdr)
+		return -1;
+
+	if (hdr_size <= non_crc_bytes)
+		return -1;
+
+	if (!sram)
+		return -1;
+
+	/* the target sees neither the path nor our transmit buffer layout */
+	hdr       = (const uint8_t *) hdr + non_crc_bytes;
+	hdr_size -= non_crc_bytes;
+
+	if (!data)
+		data_size = 0;
+
+	len = hdr_size + 1 + data_size + (data_size ? 1 : 0);
+
+	buf = (uint8_t *) malloc(len);
+	if (!buf)
+		return -1;
+
+	memcpy(buf, hdr, hdr_size);
+	buf[hdr_size] = rmap_crc8(buf, hdr_size);
+
+	if (data_size) {
+		memcpy(&buf[hdr_size + 1], data, data_size);
+		buf[len - 1] = rmap_crc8(data, data_size);
+	}
+
+	ret = rmap_pkt_view_from_buffer(&cmd, buf, len);
+	if (!ret && !cmd.ri.cmd_resp)
+		ret = -1;	/* we only take commands */
+
+	if (!ret)
+		ret = emu_exec(&cmd, len + non_crc_bytes);
+
+	free(buf);
+
+	return ret;
+}
+
+
+/**
+ * @brief receive a reply from the emulated RDCU
+ *
+ * @param pkt the buffer to copy the next reply to; if NULL, only the size of
+ *	  the next reply is returned
+ *
+ * @returns the size of the reply or 0 if none is available yet
+ *
+ * @note this has the same call interface as the rx function expected by
+ *	 rdcu_rmap_init()
+ */
+
+uint32_t rdcu_emu_rx(uint8_t *pkt)
+{
+	uint32_t len;
+
+
+	if (!queue.cnt)
+		return 0;
+
+	if (link.time)
+		if ((int32_t) (link.time() - queue.t_ready[queue.head]) < 0)
+			return 0;
+
+	len = queue.len[queue.head];
+
+	if (!pkt)
+		return len;
+
+	memcpy(pkt, queue.pkt[queue.head], len);
+
+	free(queue.pkt[queue.head]);
+	queue.pkt[queue.head] = NULL;
+
+	queue.head = (queue.head + 1) % RDCU_EMU_QUEUE_SIZE;
+	queue.cnt--;
+
+	return len;
+}
+
+
+/**
+ * @brief get the number of commands the emulator can accept right now
+ *
+ * @note this may be used with rdcu_rmap_set_tx_avail()
+ */
+
+uint32_t rdcu_emu_tx_avail(void)
+{
+	return (uint32_t) (RDCU_EMU_QUEUE_SIZE - queue.cnt);
+}
+
+
+/**
+ * @brief configure the emulated link timing
+ *
+ * @param time a function returning the current time (may be NULL to make
+ *	       replies available immediately)
+ * @param ticks_per_sec the resolution of the time source
+ * @param latency the turnaround time of the target in time source ticks
+ * @param bytes_per_sec the link bandwidth per direction (0 for infinite)
+ */
+
+void rdcu_emu_set_link(uint32_t (*time)(void), uint32_t ticks_per_sec,
+		       uint32_t latency, uint32_t bytes_per_sec)
+{
+	link.time          = time;
+	link.ticks_per_sec = ticks_per_sec;
+	link.latency       = latency;
+	link.bytes_per_sec = bytes_per_sec;
+
+	if (time) {
+		link.tx_free = time();
+		link.rx_free = link.tx_free;
+	}
+}
+
+
+/**
+ * @brief enable or disable the software compressor on compression starts
+ *
+ * @param enable 0 to disable, otherwise enable
+ *
+ * @note if disabled, a compression start completes instantly with invalid data
+ */
+
+void rdcu_emu_set_compressor(int enable)
+{
+	emu_compressor = enable;
+}
+
+
+/**
+ * @brief drop all pending replies, e.g. to emulate a link reset
+ */
+
+void rdcu_emu_flush(void)
+{
+	int i;
+
+
+	for (i = 0; i < RDCU_EMU_QUEUE_SIZE; i++) {
+		free(queue.pkt[i]);
+		queue.pkt[i] = NULL;
+	}
+
+	queue.head = 0;
+	queue.tail = 0;
+	queue.cnt  = 0;
+}
+
+
+/**
+ * @brief initialise the RDCU emulator
+ *
+ * @param addr the initial logical address of the emulated RDCU
+ * @param key the destination key of the emulated RDCU
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_emu_init(uint8_t addr, uint8_t key)
+{
+	if (!sram) {
+		sram = (uint8_t *) malloc(RDCU_SRAM_SIZE);
+		if (!sram) {
+			printf("Error allocating emulated SRAM\n");
+			return -1;
+		}
+	}
+
+	memset(sram, 0, RDCU_SRAM_SIZE);
+	memset(ctrl_regs, 0, sizeof(ctrl_regs));
+	memset(cmp_regs, 0, sizeof(cmp_regs));
+	memset(edac_regs, 0, sizeof(edac_regs));
+
+	rdcu_emu_flush();
+
+	emu_key = key;
+
+	emu_reg_set(FPGA_VERSION, RDCU_EMU_FPGA_VERSION);
+	emu_reg_set(CORE_CTRL, (uint32_t) addr << 24);
+	emu_reg_set(LVDS_CORE_STATUS, (uint32_t) addr << 24);
+	emu_reg_set(COMPR_STATUS, 0x1UL << 4);	/* ready */
+
+	return 0;
+}
+
+
+/**
+ * @brief release the resources of the RDCU emulator
+ */
+
+void rdcu_emu_exit(void)
+{
+	rdcu_emu_flush();
+
+	free(sram);
+	sram = NULL;
+}
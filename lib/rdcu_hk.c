@@ -0,0 +1,292 @@
+/**
+ * @file   rdcu_hk.c
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief RDCU housekeeping snapshots
+ *
+ * All housekeeping registers of the RDCU, from the FPGA version to the ADC
+ * status, are consecutive in the address map, so a snapshot is taken with a
+ * single incrementing read rather than one transaction per register. The
+ * reply is received into a buffer of its own, converted and only then
+ * published, so a snapshot is always complete and consistent, even if the
+ * transaction is dropped.
+ *
+ * Snapshots are requested with rdcu_hk_request(), or periodically by
+ * rdcu_hk_tick() after rdcu_hk_start(). The request is queued like any other
+ * transaction, it does not wait for the link to become idle, so housekeeping
+ * can be collected while compressions are in progress. At most one snapshot
+ * is in flight at a time.
+ *
+ * The time stamps are taken from the time source of the link, see
+ * rdcu_rmap_set_time_source().
+ *
+ * There is a single set of snapshots: periodic snapshots are taken of the RDCU
+ * selected in rdcu_hk_start(), while rdcu_hk_request() serves the selected
+ * one. With several RDCUs, all snapshots go to the same last snapshot and
+ * callback, so request them in turn; the callback runs with the link of its
+ * snapshot selected, see rdcu_rmap_get_ctx().
+ */
+
+
+#include <stdint.h>
+
+#include <byteorder.h>
+#include <dlog.h>
+#include <rdcu_cmd.h>
+#include <rdcu_rmap.h>
+#include <rdcu_hk.h>
+
+
+/* the index of a register in the reply */
+#define HK_IDX(reg)	(((reg) - RDCU_HK_START) / sizeof(uint32_t))
+
+
+static struct {
+	struct rdcu_rmap_ctx *rmap;	/* the link of the periodic snapshots */
+
+	uint32_t period;		/* ticks per snapshot, 0: stopped */
+	uint32_t ticks;
+
+	int pending;
+	uint32_t t_req;
+	uint32_t buf[RDCU_HK_SIZE / sizeof(uint32_t)];
+
+	int valid;
+	struct rdcu_hk last;
+
+	void (*cb)(const struct rdcu_hk *hk, void *userdata);
+	void *userdata;
+
+	struct rdcu_hk_stats st;
+} hk;
+
+
+/**
+ * @brief the housekeeping read completed, publish the snapshot
+ */
+
+static void hk_done(__attribute__((unused)) uint16_t trans_id,
+		    int status,
+		    __attribute__((unused)) void *userdata)
+{
+	hk.pending = 0;
+
+	if (status) {
+		hk.st.failed++;
+		dlog0("hk: housekeeping read failed\n");
+		return;
+	}
+
+	hk.last.seq    = hk.st.done++;
+	hk.last.t_req  = hk.t_req;
+	hk.last.t_done = rdcu_rmap_get_time();
+
+	hk.last.fpga_version    = be32_to_cpu(hk.buf[HK_IDX(FPGA_VERSION)]);
+	hk.last.rdcu_status     = be32_to_cpu(hk.buf[HK_IDX(RDCU_STATUS)]);
+	hk.last.spw_link_status = be32_to_cpu(hk.buf[HK_IDX(SPW_LINK_STATUS)]);
+	hk.last.spw_err_cntrs   = be32_to_cpu(hk.buf[HK_IDX(SPW_ERR_CNTRS)]);
+	hk.last.rmap_last_err   = be32_to_cpu(hk.buf[HK_IDX(RMAP_LAST_ERR)]);
+
+	hk.last.lvds_core_status =
+		be32_to_cpu(hk.buf[HK_IDX(LVDS_CORE_STATUS)]);
+	hk.last.rmap_no_reply_err_cntrs =
+		be32_to_cpu(hk.buf[HK_IDX(RMAP_NO_REPLY_ERR_CNTRS)]);
+	hk.last.rmap_pckt_err_cntrs =
+		be32_to_cpu(hk.buf[HK_IDX(RMAP_PCKT_ERR_CNTRS)]);
+
+	hk.last.adc_values_1 = be32_to_cpu(hk.buf[HK_IDX(ADC_VALUES_1)]);
+	hk.last.adc_values_2 = be32_to_cpu(hk.buf[HK_IDX(ADC_VALUES_2)]);
+	hk.last.adc_values_3 = be32_to_cpu(hk.buf[HK_IDX(ADC_VALUES_3)]);
+	hk.last.adc_values_4 = be32_to_cpu(hk.buf[HK_IDX(ADC_VALUES_4)]);
+	hk.last.adc_status   = be32_to_cpu(hk.buf[HK_IDX(ADC_STATUS)]);
+
+	hk.valid = 1;
+
+	if (hk.cb)
+		hk.cb(&hk.last, hk.userdata);
+}
+
+
+/**
+ * @brief request a housekeeping snapshot
+ *
+ * @returns 0 on success, < 0: error, > 0: retry
+ *
+ * @note the snapshot is taken on the currently selected link context; use
+ *	 rdcu_hk_get() or a callback (see rdcu_hk_set_callback()) to retrieve it
+ *	 once the transaction completed
+ */
+
+int rdcu_hk_request(void)
+{
+	int ret;
+
+
+	/* a previous snapshot is still in flight */
+	if (hk.pending)
+		return 1;
+
+	/* the reply may be processed while submitting */
+	hk.pending = 1;
+	hk.t_req   = rdcu_rmap_get_time();
+
+	ret = rdcu_sync_data_async(rdcu_read_cmd_register_block, RDCU_HK_START,
+				   hk.buf, RDCU_HK_SIZE, 1, hk_done, NULL);
+	if (ret)
+		hk.pending = 0;
+
+	return ret;
+}
+
+
+/**
+ * @brief get the last housekeeping snapshot
+ *
+ * @param snapshot the structure to fill
+ *
+ * @returns 0 on success, -1 if no snapshot was taken yet
+ */
+
+int rdcu_hk_get(struct rdcu_hk *snapshot)
+{
+	if (!snapshot)
+		return -1;
+
+	if (!hk.valid)
+		return -1;
+
+	(*snapshot) = hk.last;
+
+	return 0;
+}
+
+
+/**
+ * @brief set a function to call with each new housekeeping snapshot
+ *
+ * @param cb the callback (may be NULL)
+ * @param userdata a pointer to arbitrary user data; passed to cb
+ *
+ * @note the callback is executed from the context the RMAP replies are
+ *	 processed in, the snapshot is only valid for the duration of the call
+ */
+
+void rdcu_hk_set_callback(void (*cb)(const struct rdcu_hk *hk,
+				     void *userdata),
+			  void *userdata)
+{
+	hk.cb       = cb;
+	hk.userdata = userdata;
+}
+
+
+/**
+ * @brief take housekeeping snapshots periodically
+ *
+ * @param period the number of calls to rdcu_hk_tick() per snapshot
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the snapshots are taken on the currently selected link context
+ * @note configure a reply timeout (see rdcu_rmap_set_timeout()), otherwise a
+ *	 lost reply holds up all further snapshots until rdcu_rmap_reset_log()
+ *	 drops it
+ */
+
+int rdcu_hk_start(uint32_t period)
+{
+	if (!period)
+		return -1;
+
+	hk.rmap   = rdcu_rmap_get_ctx();
+	hk.ticks  = 0;
+	hk.period = period;
+
+	return 0;
+}
+
+
+/**
+ * @brief stop taking periodic housekeeping snapshots
+ */
+
+void rdcu_hk_stop(void)
+{
+	hk.period = 0;
+}
+
+
+/**
+ * @brief advance the periodic housekeeping snapshots
+ *
+ * @note call this at a fixed rate from the context the other rdcu_rmap
+ *	 functions are used in; a snapshot that cannot be requested in its
+ *	 period is skipped rather than delayed, so the rate is kept
+ */
+
+void rdcu_hk_tick(void)
+{
+	struct rdcu_rmap_ctx *prev;
+
+
+	if (!hk.period)
+		return;
+
+	if (++hk.ticks < hk.period)
+		return;
+
+	hk.ticks = 0;
+
+	prev = rdcu_rmap_get_ctx();
+	rdcu_rmap_select_ctx(hk.rmap);
+
+	if (rdcu_hk_request())
+		hk.st.skipped++;
+
+	rdcu_rmap_select_ctx(prev);
+}
+
+
+/**
+ * @brief advance the periodic housekeeping snapshots from a timer interrupt
+ *	  callback
+ *
+ * @param userdata unused
+ *
+ * @returns always 0
+ *
+ * @note as this issues RMAP transactions, register it with PRIORITY_LATER
+ *	 and call irq_queue_execute() from the same context the other rdcu_rmap
+ *	 functions are used in
+ */
+
+int32_t rdcu_hk_irq(__attribute__((unused)) void *userdata)
+{
+	rdcu_hk_tick();
+
+	return 0;
+}
+
+
+/**
+ * @brief get the bookkeeping of the housekeeping snapshots
+ *
+ * @param stats the structure to fill
+ */
+
+void rdcu_hk_get_stats(struct rdcu_hk_stats *stats)
+{
+	if (stats)
+		(*stats) = hk.st;
+}
@@ -31,10 +31,16 @@
  *
  * This is probably the nicest solution when it comes to call overhead, but it
  * requires 8 MiB of memory for the SRAM mirror and the some for the registers.
+ * If only a few buffers in the SRAM are used, rdcu_ctrl_init_sparse() limits
+ * the mirror to the blocks actually touched.
  *
  * Note that for simplicity , we assume that there is a working heap allocator
  * available, please adapt all malloc/free calls to your needs, or ask us
- * to do that for you.
+ * to do that for you. If compiled with RMAP_STATIC_ALLOC=1, no heap is used
+ * on the transfer path: the rmap packets come from the pools in rmap.c and
+ * copied reply packets are received into a static buffer, which limits the
+ * mtu to RMAP_POOL_DATA_SIZE. Only the optional context allocation functions
+ * still use the heap.
  *
  * NOTE: in order to run this on the GR712RC eval board, we set the SRAM mirror
  *	 image to the boards SDRAM in rdcu_ctrl_init() and just malloc() it for
@@ -51,54 +57,66 @@
  *	 your particular SpW interface or just redirect RX/TX to files
  *	 or via a network connection.
  *
- * NOTE: We don't have to serve more than one RDCU at any given time, so we
- *	 track addresses and paths internally in a single instance. This also
- *	 makes the interface less cluttered. Besides, I'm lazy.
+ * NOTE: Addresses, paths and the transaction log are tracked internally in
+ *	 a link context, so the interface is not cluttered with a handle. If
+ *	 more than one RDCU is to be served, allocate a context per RDCU with
+ *	 rdcu_rmap_ctx_alloc() and switch between them with
+ *	 rdcu_rmap_select_ctx().
  *
  *
- * @warn when operational, we expect to have exclusive control of the SpW link
+ * NOTE: Errors in the reply path (invalid replies, error status codes,
+ *	 timeouts and dropped transactions) are counted in the link statistics
+ *	 and reported via event_report() with class RMAP and one of the
+ *	 E_RMAP_* codes from errors.h, so the user has to provide that
+ *	 function. Other diagnostics on the transfer path are recorded in the
+ *	 deferred log (see dlog.h) and printed when it is drained.
  *
- * TODO: RMAP command response evaluation
+ * @warn when operational, we expect to have exclusive control of the SpW link
  */
 
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <byteorder.h>
+#include <errors.h>
+#include <event_report.h>
+#include <dlog.h>
 #include <rmap.h>
+#include <sysctl.h>
+#include <rdcu_cmd.h>
 #include <rdcu_rmap.h>
 
 
 
-static uint8_t rdcu_addr;
-static uint8_t icu_addr;
-
-static uint8_t *dpath;	/* destination path (to the RDCU) */
-static uint8_t *rpath;	/* return path (to the ICU) */
-static uint8_t dpath_len;
-static uint8_t rpath_len;
-
-static uint8_t dst_key;	/* destination command key */
-
-
-
-
- /* generic calls, functions must be provided to init() */
-static int32_t (*rmap_tx)(const void *hdr,  uint32_t hdr_size,
-			  const uint8_t non_crc_bytes,
-			  const void *data, uint32_t data_size);
-static uint32_t (*rmap_rx)(uint8_t *pkt);
-
-static size_t data_mtu;	/* maximum data transfer size per unit */
-
-
-
+/* the largest command header we may generate (without header CRC) */
+#define RDCU_CMD_HDR_MAX_SIZE	(RMAP_HDR_MIN_SIZE_WRITE_CMD + \
+				 RMAP_MAX_PATH_LEN + RMAP_MAX_REPLY_PATH_LEN)
 
+/* offsets of the variable fields from the end of a command header */
+#define RDCU_CMD_HDR_SRC_OFF	11
+#define RDCU_CMD_HDR_TR_ID_OFF	10
+#define RDCU_CMD_HDR_ADDR_OFF	 7
+#define RDCU_CMD_HDR_LEN_OFF	 3
 
+/* the number of distinct command types we cache headers for */
+#define RDCU_HDR_CACHE_SIZE	6
 
+/**
+ * Pre-built command headers. Everything but the transaction id, the address
+ * and the data length is fixed once the addresses, paths and key are
+ * configured, so we build a header only once per command type and patch
+ * those fields per transfer. The cache is flushed whenever one of the
+ * parameters changes.
+ */
 
+struct rdcu_hdr_cache {
+	uint8_t hdr[RDCU_CMD_HDR_MAX_SIZE];
+	uint8_t cmd_type;
+	int size;
+};
 
 
 
@@ -107,11 +125,13 @@ static size_t data_mtu;	/* maximum data transfer size per unit */
  * packets the GRSPW2 SpW descriptor table can hold at any one time without
  * blocking the link.
  *
- * Every time a new transfer is to be submitted, we grab the first free
- * slot we encounter in the "in_use" array and use the index as the transaction
- * identifier of the RMAP packet. (Yes, this is potentially slow, as we may have
- * to iterate over the whole array every time if we're very busy with
- * transmissions, so there is room for improvement.)
+ * Every time a new transfer is to be submitted, we take the next transaction
+ * identifier from the "free_id" ring and use it as the index into the
+ * per-slot arrays. Released identifiers are put back at the tail of the ring,
+ * so both operations are in constant time no matter how busy we are. As a
+ * side effect, a released identifier is reused only after all other free ones
+ * were handed out, which makes it less likely that a late reply is matched
+ * to the wrong transaction.
  *
  * Every time a slot is retrieved, the "pending" counter is incremented to
  * have a fast indicator of the synchronisation status, i.e. if "pending"
@@ -124,442 +144,1983 @@ static size_t data_mtu;	/* maximum data transfer size per unit */
  * data if we issue an RMAP_read command. This may be omitted for write
  * commands.
  *
- * Every time a response packet is received, the data (if any) is written to the
- * local address, using the length specified by RMAP packet, so be careful where
- * you place your buffers or registers. On success, the "in_use" slot is cleared
- * and the pending counter is improved.
+ * Once the command header was generated, the RMAP command type, the expected
+ * number of reply data bytes and the submission time (if a time source was
+ * configured via rdcu_rmap_set_time_source()) are recorded in the slot as
+ * well, so the reply processing does not need to look anywhere else.
+ *
+ * Every time a response packet is received, its command and data length are
+ * checked against those recorded in the slot, so a reply never writes more
+ * (or less) than was requested to the local address. The data (if any) are
+ * then written to the local address. On success, the "in_use" slot is cleared
+ * and the pending counter is improved. If a completion callback was registered
+ * with the transaction, it is called after the slot was released, so it may
+ * submit new transactions right away.
+ *
+ * The transaction identifier sent with a command is the slot index in the
+ * lower bits and a per-slot sequence number above, which is advanced on every
+ * (re)transmission, so a late reply to an earlier use of a slot is rejected
+ * rather than taken for the reply to the current one.
+ *
+ * If a reply is invalid (CRC or length error) or, with a timeout configured
+ * via rdcu_rmap_set_timeout(), does not arrive in time, the transaction is
+ * retransmitted from the same slot up to the configured number of retries
+ * before it is dropped. Only the affected transaction is sent again, so a
+ * single error does not stall or restart a windowed multi-packet transfer.
+ * For this, the command generator, remote address and length are recorded
+ * in the slot; read-modify-write transactions are never retransmitted.
+ *
+ * Replies are processed whenever a command is submitted or the user calls
+ * rdcu_rmap_sync_status(). Alternatively, rdcu_rmap_rx_irq() may be registered
+ * as a deferred (PRIORITY_LATER) callback of the interface's receive
+ * interrupt via irq_dispatch, in which case the replies are processed every
+ * time irq_queue_execute() is called.
  *
  * XXX: careful, no locking is used on any of the log data, so this is
  * single-thread-use only!
  *
  */
 #define TRANS_LOG_SIZE 64	/* GRSPW2 TX descriptor limit */
-static struct {
+#define TRANS_ID_SEQ_SHIFT 6	/* log2(TRANS_LOG_SIZE) */
+#define RDCU_RX_BURST  16	/* max. replies fetched per burst receive call */
+struct rdcu_trans_log {
 
 	uint8_t  in_use[TRANS_LOG_SIZE];
 	void    *local_addr[TRANS_LOG_SIZE];
 
+	uint8_t  cmd_type[TRANS_LOG_SIZE];	/* RMAP command type */
+	uint32_t reply_len[TRANS_LOG_SIZE];	/* expected reply data bytes */
+	uint32_t t_submit[TRANS_LOG_SIZE];	/* time of submission */
+	uint8_t  swap[TRANS_LOG_SIZE];		/* width of reply values */
+	uint16_t seq[TRANS_LOG_SIZE];		/* upper transaction id bits */
+
+	/* what is needed to retransmit a transaction */
+	int (*gen[TRANS_LOG_SIZE])(uint16_t trans_id, uint8_t *cmd,
+				   uint32_t addr, uint32_t data_len);
+	int (*gen_reg[TRANS_LOG_SIZE])(uint16_t trans_id, uint8_t *cmd);
+	uint32_t remote_addr[TRANS_LOG_SIZE];
+	uint32_t data_len[TRANS_LOG_SIZE];	/* length argument of gen */
+	uint8_t  retries[TRANS_LOG_SIZE];	/* retransmissions so far */
+
+	/* the value and mask of a read-modify-write transaction */
+	uint32_t rmw_val[TRANS_LOG_SIZE];
+	uint32_t rmw_mask[TRANS_LOG_SIZE];
+
+	/* optional completion notification */
+	void (*cb[TRANS_LOG_SIZE])(uint16_t trans_id, int status, void *userdata);
+	void    *cb_data[TRANS_LOG_SIZE];
+
+	uint16_t free_id[TRANS_LOG_SIZE];	/* ring of unused ids */
+	int free_head;
+	int free_tail;
+
 	int pending;
-} trans_log;
+};
 
 
 /**
- * @brief grab a slot in the transaction log
+ * The link statistics are exported via sysctl as driver object "rmap", see
+ * rdcu_rmap_init(). Writing to an attribute resets the respective counter.
  *
- * @param local_addr the local memory address
+ * The transaction round-trip latency is measured from the submission of a
+ * command to the completion of its reply, in units of the time source set
+ * with rdcu_rmap_set_time_source(). The histogram bins are logarithmic,
+ * bin 0 holds latencies of 0, bin n those of [2^(n-1), 2^n) and the last bin
+ * everything above.
  *
- * @returns -1 on no slots, >= 0 for the transaction id
+ * Replies with an error status are counted per class of the status code, see
+ * rmap_status_class(), in st_transfer, st_cmd, st_auth and st_target.
+ *
+ * The statistics are kept per link context; sysctl shows those of the default
+ * context, the counters of the selected context are also available via
+ * rdcu_rmap_get_stat().
  */
 
-static int trans_log_grab_slot(void *local_addr)
-{
-	int i;
-	int slot = -1;
+#define RMAP_LAT_BINS	16
+
+struct rmap_stats {
+	uint32_t submitted;	/* commands handed to the interface */
+	uint32_t completed;	/* transactions completed successfully */
+	uint32_t dropped;	/* transactions dropped due to invalid replies */
+	uint32_t stall_window;	/* retries: transfer window full */
+	uint32_t stall_slots;	/* retries/errors: transaction log full */
+	uint32_t stall_tx;	/* retries: no free transmit buffer */
+	uint32_t crc_err;	/* replies with a data CRC mismatch */
+	uint32_t hdr_crc_err;	/* replies with a header CRC mismatch */
+	uint32_t len_err;	/* replies not matching length or command */
+	uint32_t rx_unknown;	/* replies not matching a pending transaction */
+	uint32_t timeouts;	/* transactions without a reply in time */
+	uint32_t retransmits;	/* transactions sent again */
+	uint32_t status_err[RMAP_ERR_CLASSES];	/* replies with error status */
+	uint32_t rx_pkts;	/* reply packets received */
+	uint32_t rx_bytes;	/* reply packet bytes received */
+	uint32_t tx_bytes;	/* command and payload bytes submitted */
+	uint32_t lat_max;	/* maximum round-trip latency */
+	uint32_t lat_hist[RMAP_LAT_BINS];
+};
 
-	for (i = 0; i < TRANS_LOG_SIZE; i++) {
 
-		if (trans_log.in_use[i])
-			continue;
+/**
+ * All of the above is kept per RDCU link in a context, so several RDCUs can be
+ * served, each with its own addresses, paths, key, interface functions and
+ * transaction log. All rdcu_rmap functions operate on the currently selected
+ * context (see rdcu_rmap_select_ctx()), which is a built-in default one
+ * unless another is selected, so single-RDCU users need not care.
+ *
+ * As transactions are asynchronous, multiple RDCUs are driven concurrently
+ * by selecting a context, submitting commands, and moving on to the next one,
+ * then polling the contexts in turn for completion.
+ */
 
-		/* got one */
-		slot = i;
-		trans_log.in_use[slot] = 1;
-		trans_log.local_addr[slot] = local_addr;
-		trans_log.pending++;
-		break;
-	}
+struct rdcu_rmap_ctx {
+	uint8_t rdcu_addr;
+	uint8_t icu_addr;
+	uint8_t icu_addr_bulk;	/* reply address of SRAM transfers */
 
-	return slot;
-}
+	uint8_t *dpath;		/* destination path (to the RDCU) */
+	uint8_t *rpath;		/* return path (to the ICU) */
+	uint8_t dpath_len;
+	uint8_t rpath_len;
 
+	uint8_t dst_key;	/* destination command key */
 
-/**
- * @brief release a slot in the transaction log
- *
- * @param slot the id of the slot
- *
- */
+	struct rdcu_hdr_cache hdr_cache[RDCU_HDR_CACHE_SIZE];
+	int hdr_cache_used;
 
-static void trans_log_release_slot(int slot)
-{
+	/* generic calls, functions must be provided to init() */
+	int32_t (*rmap_tx)(const void *hdr,  uint32_t hdr_size,
+			   const uint8_t non_crc_bytes,
+			   const void *data, uint32_t data_size);
+	uint32_t (*rmap_rx)(uint8_t *pkt);
 
-	if (slot < 0)
-		return;
+	/* optional zero-copy transmit call, see rdcu_rmap_set_tx_zero_copy() */
+	int32_t (*rmap_tx_zero_copy)(const void *hdr,  uint32_t hdr_size,
+				     const uint8_t non_crc_bytes,
+				     const void *data, uint32_t data_size);
 
-	if (slot >= TRANS_LOG_SIZE)
-		return;
+	/* optional zero-copy receive calls, see rdcu_rmap_set_rx_zero_copy() */
+	uint32_t (*rmap_rx_peek)(uint8_t **pkt);
+	uint32_t (*rmap_rx_release)(void);
 
-	if (!trans_log.in_use[slot])
-		return;
+	/* optional burst receive calls, see rdcu_rmap_set_rx_burst() */
+	uint32_t (*rmap_rx_burst)(uint8_t **pkts, uint32_t *sizes, uint32_t n);
+	uint32_t (*rmap_rx_burst_release)(uint32_t n);
 
-	trans_log.in_use[slot] = 0;
-	trans_log.pending--;
-}
+	size_t data_mtu;	/* maximum data transfer size per unit */
 
+	struct rdcu_trans_log trans_log;
 
-/**
- * @brief get the local address for a slot
- *
- * @param slot the id of the slot
- *
- * @returns the address or NULL if not found/slot not in use
- */
+	/* optional time source for the submission time stamps */
+	uint32_t (*trans_log_time)(void);
 
-static void *trans_log_get_addr(int slot)
-{
-	if (slot < 0)
-		return NULL;
+	/* maximum number of data transfers in flight, see
+	 * rdcu_rmap_set_window()
+	 */
+	int trans_window;
 
-	if (slot >= TRANS_LOG_SIZE)
-		return NULL;
+	/* optional query for free transmit buffers, see
+	 * rdcu_rmap_set_tx_avail()
+	 */
+	uint32_t (*rmap_tx_avail)(void);
+
+	/* reply timeout and retransmission limit, see rdcu_rmap_set_timeout() */
+	uint32_t trans_timeout;
+	uint8_t trans_retries;
+
+	/* replies are being processed, see rdcu_process_rx() */
+	int rx_busy;
+
+	struct rmap_stats stats;
+};
+
+static struct rdcu_rmap_ctx rmap_ctx_default = {
+	.trans_window = TRANS_LOG_SIZE,
+};
+
+static struct rdcu_rmap_ctx *ctx = &rmap_ctx_default;
 
-	if (!trans_log.in_use[slot])
-		return NULL;
 
-	return trans_log.local_addr[slot];
-}
 
 /**
- * @brief n rmap command transaction
+ * @brief add a round-trip latency sample to the histogram
  *
- * @returns number of packets processed or < 0 on error
+ * @param lat the latency in time source units
  */
 
-static int rdcu_process_rx(void)
+static void rmap_stats_add_latency(uint32_t lat)
 {
-	int n;
-	int cnt = 0;
+	unsigned int bin = 0;
 
-	uint32_t *local_addr;
 
-	uint8_t *spw_pckt;
+	if (lat > ctx->stats.lat_max)
+		ctx->stats.lat_max = lat;
 
-	struct rmap_pkt *rp;
+	while (lat && bin < (RMAP_LAT_BINS - 1)) {
+		lat >>= 1;
+		bin++;
+	}
 
+	ctx->stats.lat_hist[bin]++;
+}
 
-	if (!rmap_rx)
-		return -1;
 
-	/* process all pending responses */
-	while ((n = rmap_rx(NULL))) {
-		/* we received something, allocate enough space for the packet */
-		spw_pckt = (uint8_t *) malloc(n);
-		if (!spw_pckt) {
-			printf("malloc() for packet failed!\n");
-			return -1;
-		}
+#if (__sparc__)
+#define UINT32_T_FORMAT		"%lu"
+#else
+#define UINT32_T_FORMAT		"%u"
+#endif
+
+/* the position of a counter within struct rmap_stats */
+#define RMAP_STATS_OFF(x)	offsetof(struct rmap_stats, x)
+
+static const struct {
+	const char *name;
+	size_t off;
+} rmap_stats_cnt[] = {
+	{"submitted",	 RMAP_STATS_OFF(submitted)},
+	{"completed",	 RMAP_STATS_OFF(completed)},
+	{"dropped",	 RMAP_STATS_OFF(dropped)},
+	{"stall_window", RMAP_STATS_OFF(stall_window)},
+	{"stall_slots",	 RMAP_STATS_OFF(stall_slots)},
+	{"stall_tx",	 RMAP_STATS_OFF(stall_tx)},
+	{"crc_err",	 RMAP_STATS_OFF(crc_err)},
+	{"hdr_crc_err",	 RMAP_STATS_OFF(hdr_crc_err)},
+	{"len_err",	 RMAP_STATS_OFF(len_err)},
+	{"rx_unknown",	 RMAP_STATS_OFF(rx_unknown)},
+	{"timeouts",	 RMAP_STATS_OFF(timeouts)},
+	{"retransmits",	 RMAP_STATS_OFF(retransmits)},
+	{"st_transfer",	 RMAP_STATS_OFF(status_err) +
+			 RMAP_ERR_TRANSFER * sizeof(uint32_t)},
+	{"st_cmd",	 RMAP_STATS_OFF(status_err) +
+			 RMAP_ERR_CMD * sizeof(uint32_t)},
+	{"st_auth",	 RMAP_STATS_OFF(status_err) +
+			 RMAP_ERR_AUTH * sizeof(uint32_t)},
+	{"st_target",	 RMAP_STATS_OFF(status_err) +
+			 RMAP_ERR_TARGET * sizeof(uint32_t)},
+	{"rx_pkts",	 RMAP_STATS_OFF(rx_pkts)},
+	{"rx_bytes",	 RMAP_STATS_OFF(rx_bytes)},
+	{"tx_bytes",	 RMAP_STATS_OFF(tx_bytes)},
+	{"lat_max",	 RMAP_STATS_OFF(lat_max)},
+};
+
+#define RMAP_STATS_CNT	(sizeof(rmap_stats_cnt) / sizeof(rmap_stats_cnt[0]))
 
-		/* read the packet */
-		n = rmap_rx(spw_pckt);
 
-		if (!n) {
-			printf("Unknown error in rmap_rx()\n");
-			free(spw_pckt);
-			return -1;
-		}
+/**
+ * @brief get a counter of a set of link statistics
+ *
+ * @param st the statistics
+ * @param i the index of the counter in rmap_stats_cnt
+ *
+ * @returns a pointer to the counter
+ */
 
-		cnt++;
+static uint32_t *rmap_stats_get_cnt(struct rmap_stats *st, size_t i)
+{
+	return (uint32_t *) ((uint8_t *) st + rmap_stats_cnt[i].off);
+}
 
-		if (0)
-			rmap_parse_pkt(spw_pckt);
 
-		/* convert format */
-		rp = rmap_pkt_from_buffer(spw_pckt, n);
-		free(spw_pckt);
+__extension__
+static ssize_t rmap_stats_show(__attribute__((unused)) struct sysobj *sobj,
+			       struct sobj_attribute *sattr, char *buf)
+{
+	size_t i;
+	ssize_t n = 0;
 
-		if (!rp) {
-			printf("Error converting to RMAP packet\n");
-			continue;
-		}
+	struct rmap_stats *st = &rmap_ctx_default.stats;
 
-		local_addr = trans_log_get_addr(rp->tr_id);
 
-		if (!local_addr) {
-			printf("warning: response packet received not in "
-			       "transaction log\n");
-			rmap_erase_packet(rp);
-			continue;
-		}
+	if (!strcmp(sattr->name, "lat_hist")) {
+		for (i = 0; i < RMAP_LAT_BINS; i++)
+			n += sprintf(buf + n, UINT32_T_FORMAT " ",
+				     st->lat_hist[i]);
+		return n;
+	}
 
+	for (i = 0; i < RMAP_STATS_CNT; i++)
+		if (!strcmp(sattr->name, rmap_stats_cnt[i].name))
+			return sprintf(buf, UINT32_T_FORMAT,
+				       *rmap_stats_get_cnt(st, i));
 
-		if (rp->data_len & 0x3) {
-			printf("Error: response packet data size is not a "
-			       "multiple of 4, transaction dropped\n");
+	return 0;
+}
 
-			trans_log_release_slot(rp->tr_id);
-			rmap_erase_packet(rp);
-			return -1;
-		}
+__extension__
+static ssize_t rmap_stats_store(__attribute__((unused)) struct sysobj *sobj,
+				struct sobj_attribute *sattr,
+				__attribute__((unused)) const char *buf,
+				__attribute__((unused)) size_t len)
+{
+	size_t i;
 
+	struct rmap_stats *st = &rmap_ctx_default.stats;
 
-		if (rp->data_len) {
 
-			uint8_t crc8;
+	if (!strcmp(sattr->name, "lat_hist")) {
+		memset(st->lat_hist, 0, sizeof(st->lat_hist));
+		return 0;
+	}
 
-			/* convert endianess if needed */
-#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-			{
-				unsigned int i;
-				uint32_t *p = (uint32_t *) rp->data;
+	for (i = 0; i < RMAP_STATS_CNT; i++)
+		if (!strcmp(sattr->name, rmap_stats_cnt[i].name))
+			*rmap_stats_get_cnt(st, i) = 0;
+
+	return 0;
+}
+
+#define RMAP_STATS_ATTR(x) \
+	__extension__ \
+	static struct sobj_attribute x##_attr = __ATTR(x, rmap_stats_show, \
+						       rmap_stats_store)
+
+RMAP_STATS_ATTR(submitted);
+RMAP_STATS_ATTR(completed);
+RMAP_STATS_ATTR(dropped);
+RMAP_STATS_ATTR(stall_window);
+RMAP_STATS_ATTR(stall_slots);
+RMAP_STATS_ATTR(stall_tx);
+RMAP_STATS_ATTR(crc_err);
+RMAP_STATS_ATTR(hdr_crc_err);
+RMAP_STATS_ATTR(len_err);
+RMAP_STATS_ATTR(rx_unknown);
+RMAP_STATS_ATTR(timeouts);
+RMAP_STATS_ATTR(retransmits);
+RMAP_STATS_ATTR(st_transfer);
+RMAP_STATS_ATTR(st_cmd);
+RMAP_STATS_ATTR(st_auth);
+RMAP_STATS_ATTR(st_target);
+RMAP_STATS_ATTR(rx_pkts);
+RMAP_STATS_ATTR(rx_bytes);
+RMAP_STATS_ATTR(tx_bytes);
+RMAP_STATS_ATTR(lat_max);
+RMAP_STATS_ATTR(lat_hist);
+
+__extension__
+static struct sobj_attribute *rmap_attributes[] = {&submitted_attr,
+						   &completed_attr,
+						   &dropped_attr,
+						   &stall_window_attr,
+						   &stall_slots_attr,
+						   &stall_tx_attr,
+						   &crc_err_attr,
+						   &hdr_crc_err_attr,
+						   &len_err_attr,
+						   &rx_unknown_attr,
+						   &timeouts_attr,
+						   &retransmits_attr,
+						   &st_transfer_attr,
+						   &st_cmd_attr,
+						   &st_auth_attr,
+						   &st_target_attr,
+						   &rx_pkts_attr,
+						   &rx_bytes_attr,
+						   &tx_bytes_attr,
+						   &lat_max_attr,
+						   &lat_hist_attr,
+						   NULL};
+
+static struct sysobj rmap_sobj;
 
-				for (i = 0; i < (rp->data_len / 4); i++)
-					be32_to_cpus(&p[i]);
-			}
-#endif /* __BYTE_ORDER__ */
 
 
-			crc8 = rmap_crc8(rp->data, rp->data_len);
+/**
+ * @brief grab a slot in the transaction log
+ *
+ * @param local_addr the local memory address
+ *
+ * @returns -1 on no slots, >= 0 for the transaction id
+ */
+
+static int trans_log_grab_slot(void *local_addr)
+{
+	int slot;
 
-			if (crc8 != rp->data_crc) {
 
-				printf("Error: data CRC8 mismatch, data invalid or "
-				       "packet truncated. Transaction dropped\n");
+	if (ctx->trans_log.pending >= TRANS_LOG_SIZE)
+		return -1;
 
-				trans_log_release_slot(rp->tr_id);
-				rmap_erase_packet(rp);
-				return -1;
-			}
+	slot = ctx->trans_log.free_id[ctx->trans_log.free_head];
+	ctx->trans_log.free_head = (ctx->trans_log.free_head + 1) %
+				   TRANS_LOG_SIZE;
+
+	ctx->trans_log.in_use[slot]     = 1;
+	ctx->trans_log.local_addr[slot] = local_addr;
+	ctx->trans_log.cmd_type[slot]   = 0;
+	ctx->trans_log.reply_len[slot]  = 0;
+	ctx->trans_log.t_submit[slot]   = 0;
+	ctx->trans_log.swap[slot]       = sizeof(uint32_t);
+	ctx->trans_log.gen[slot]        = NULL;
+	ctx->trans_log.gen_reg[slot]    = NULL;
+	ctx->trans_log.retries[slot]    = 0;
+	ctx->trans_log.cb[slot]         = NULL;
+	ctx->trans_log.cb_data[slot]    = NULL;
+	ctx->trans_log.seq[slot]++;
+	ctx->trans_log.pending++;
 
-			memcpy(local_addr, rp->data, rp->data_len);
-		}
+	return slot;
+}
 
 
-		trans_log_release_slot(rp->tr_id);
-		rmap_erase_packet(rp);
-	}
+/**
+ * @brief get the transaction identifier of a slot
+ *
+ * @param slot the id of the slot
+ *
+ * @returns the transaction identifier to send with the command
+ */
 
-	return cnt;
+static uint16_t trans_log_id(int slot)
+{
+	return (uint16_t) ((ctx->trans_log.seq[slot] << TRANS_ID_SEQ_SHIFT) |
+			   slot);
 }
 
 
 /**
- * @brief submit an rmap command transaction
+ * @brief look up the slot of a transaction identifier
  *
- * @param cmd the rmap command
- * @param cmd_size the size of the rmap command
- * @param data the payload (may be NULL)
- * @param data_size the size of the payload
+ * @param trans_id the transaction identifier of a reply
  *
- * @returns 0 on success, otherwise error
+ * @returns the id of the slot, -1 if no such transaction is pending
  */
 
-int rdcu_submit_tx(const uint8_t *cmd,  int cmd_size,
-		   const uint8_t *data, int data_size)
+static int trans_log_find(uint16_t trans_id)
 {
-	/* try to process pending responses */
-	rdcu_process_rx();
+	int slot = trans_id & (TRANS_LOG_SIZE - 1);
 
-	if (!rmap_tx)
-		return -1;
 
-	if (0)
-		printf("Transmitting RMAP command\n");
+	if (!ctx->trans_log.in_use[slot])
+		return -1;
 
-	if (rmap_tx(cmd, cmd_size, dpath_len, data, data_size)) {
-		printf("rmap_tx() returned error!\n");
+	if (trans_log_id(slot) != trans_id)
 		return -1;
-	}
 
-	return 0;
+	return slot;
 }
 
 
 /**
- * @brief generate an rmap command packet
- *
- * @param trans_id a transaction identifier
- *
- * @param cmd the command buffer; if NULL, the function returns the needed size
- *
- * @param rmap_cmd_type the rmap command type of the packet
- *
- * @param addr the address to read from or write to
- *
- * @param size the number of bytes to read or write
+ * @brief record how to generate the command of a slot again
  *
- * @returns the size of the command data buffer or 0 on error
+ * @param slot the id of the slot
+ * @param fn the data transfer generation function
+ * @param addr the remote address
+ * @param data_len the data length passed to fn
  */
 
-int rdcu_gen_cmd(uint16_t trans_id, uint8_t *cmd,
-		 uint8_t rmap_cmd_type,
-		 uint32_t addr, uint32_t size)
+static void trans_log_set_gen(int slot,
+			      int (*fn)(uint16_t trans_id, uint8_t *cmd,
+					uint32_t addr, uint32_t data_len),
+			      uint32_t addr, uint32_t data_len)
 {
-	int n;
+	ctx->trans_log.gen[slot]         = fn;
+	ctx->trans_log.remote_addr[slot] = addr;
+	ctx->trans_log.data_len[slot]    = data_len;
+}
 
-	struct rmap_pkt *pkt;
 
-	pkt = rmap_create_packet();
-	if (!pkt) {
-		printf("Error creating packet\n");
-		return 0;
-	}
+/**
+ * @brief record the command properties of a slot in the transaction log
+ *
+ * @param slot the id of the slot
+ * @param cmd the generated rmap command header
+ * @param cmd_size the size of the command header
+ *
+ * @note the header is expected to be in the format created by rdcu_gen_cmd(),
+ *	 i.e. ending with the 24 bit data length field
+ */
 
-	rmap_set_dst(pkt, rdcu_addr);
-	rmap_set_src(pkt, icu_addr);
-	rmap_set_dest_path(pkt, dpath, dpath_len);
-	rmap_set_reply_path(pkt, rpath, rpath_len);
-	rmap_set_key(pkt, dst_key);
-	rmap_set_cmd(pkt, rmap_cmd_type);
-	rmap_set_tr_id(pkt, trans_id);
-	rmap_set_data_addr(pkt, addr);
-	rmap_set_data_len(pkt, size);
+static void trans_log_set_info(int slot, const uint8_t *cmd, int cmd_size)
+{
+	uint32_t len;
+	struct rmap_instruction *ri;
 
-	/* determine header size */
-	n = rmap_build_hdr(pkt, NULL);
 
-	if (!cmd) {
-		rmap_erase_packet(pkt);
-		return n;
-	}
+	if (slot < 0)
+		return;
 
-	memset(cmd, 0, n);  /* clear command buffer */
+	if (slot >= TRANS_LOG_SIZE)
+		return;
 
-	n = rmap_build_hdr(pkt, cmd);
+	if (cmd_size < ctx->dpath_len + RMAP_HDR_MIN_SIZE_READ_CMD)
+		return;
 
-	rmap_erase_packet(pkt);
+	ri = (struct rmap_instruction *)
+	     &cmd[ctx->dpath_len + RMAP_INSTRUCTION];
 
-	return n;
-}
+	len = ((uint32_t) cmd[cmd_size - 3] << 16) |
+	      ((uint32_t) cmd[cmd_size - 2] <<  8) |
+	       (uint32_t) cmd[cmd_size - 1];
 
+	ctx->trans_log.cmd_type[slot] = ri->cmd;
 
+	/* only reads return data (RMW is a read as far as we're concerned,
+	 * its command payload is the data followed by the mask)
+	 */
+	if (ri->cmd & RMAP_CMD_BIT_WRITE)
+		ctx->trans_log.reply_len[slot] = 0;
+	else if (ri->cmd == RMAP_READ_MODIFY_WRITE_ADDR_INC)
+		ctx->trans_log.reply_len[slot] = len / 2;
+	else
+		ctx->trans_log.reply_len[slot] = len;
 
+	if (ctx->trans_log_time)
+		ctx->trans_log.t_submit[slot] = ctx->trans_log_time();
+}
 
 
 /**
- * @brief submit a sync command
- *
- * @param fn the RDCU command generation function
- * @param addr the local address of the corresponding remote address
- * @param data_len the length of the data payload (0 for read commands)
+ * @brief release a slot in the transaction log
  *
- * @note data_len must be a multiple of 4
- * @note all data is treated (and byte swapped) as 32 bit words
+ * @param slot the id of the slot
  *
- * @return 0 on success, otherwise error
  */
 
-
-int rdcu_sync(int (*fn)(uint16_t trans_id, uint8_t *cmd),
-	      void *addr, int data_len)
+static void trans_log_release_slot(int slot)
 {
-	int n;
-	int slot;
 
-	uint8_t *rmap_cmd;
+	if (slot < 0)
+		return;
 
+	if (slot >= TRANS_LOG_SIZE)
+		return;
 
-	if (data_len & 0x3)
-		return -1;
+	if (!ctx->trans_log.in_use[slot])
+		return;
 
-	slot = trans_log_grab_slot(addr);
-	if (slot < 0)
-		return -1;
+	ctx->trans_log.in_use[slot] = 0;
+	ctx->trans_log.pending--;
 
+	ctx->trans_log.free_id[ctx->trans_log.free_tail] = (uint16_t) slot;
+	ctx->trans_log.free_tail = (ctx->trans_log.free_tail + 1) %
+				   TRANS_LOG_SIZE;
+}
 
-	/* determine size of command */
-	n = fn(slot, NULL);
 
-	rmap_cmd = (uint8_t *) malloc(n);
-	if (!rmap_cmd) {
-		printf("Error allocating rmap cmd");
-		return -1;
-	}
+/**
+ * @brief complete a transaction and notify the submitter
+ *
+ * @param slot the id of the slot
+ * @param status 0 on success, -1 if the transaction was dropped
+ */
 
-	/* now fill actual command */
-	n = fn(slot, rmap_cmd);
-	if (!n) {
-		printf("Error creating command packet\n");
-		free(rmap_cmd);
-		return -1;
-	}
+static void trans_log_complete(int slot, int status)
+{
+	void *userdata;
+	struct rdcu_rmap_ctx *c;
+	void (*cb)(uint16_t trans_id, int status, void *userdata);
 
-	/* convert endianess if needed */
-#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-	if (data_len)
-	{
-		int i;
+
+	if (slot < 0)
+		return;
+
+	if (slot >= TRANS_LOG_SIZE)
+		return;
+
+	if (!ctx->trans_log.in_use[slot])
+		return;
+
+	c        = ctx;
+	cb       = ctx->trans_log.cb[slot];
+	userdata = ctx->trans_log.cb_data[slot];
+
+	if (status)
+		ctx->stats.dropped++;
+	else
+		ctx->stats.completed++;
+
+	if (ctx->trans_log_time)
+		rmap_stats_add_latency(ctx->trans_log_time() -
+				       ctx->trans_log.t_submit[slot]);
+
+	trans_log_release_slot(slot);
+
+	if (!cb)
+		return;
+
+	cb(trans_log_id(slot), status, userdata);
+
+	/* the replies of this context may still be in processing */
+	ctx = c;
+}
+
+
+/**
+ * @brief get the local address for a slot
+ *
+ * @param slot the id of the slot
+ *
+ * @returns the address or NULL if not found/slot not in use
+ */
+
+static void *trans_log_get_addr(int slot)
+{
+	if (slot < 0)
+		return NULL;
+
+	if (slot >= TRANS_LOG_SIZE)
+		return NULL;
+
+	if (!ctx->trans_log.in_use[slot])
+		return NULL;
+
+	return ctx->trans_log.local_addr[slot];
+}
+
+/**
+ * @brief copy a reply payload to its local destination
+ *
+ * @param dst the local address
+ * @param src the payload in the packet buffer (big endian 32 bit words)
+ * @param len the number of bytes to copy (a multiple of 4)
+ * @param swap 0: copy as-is (SRAM byte image), 2: 16 bit values, otherwise
+ *	       32 bit words
+ *
+ * @note the source buffer may be unaligned, the destination must be aligned
+ *	 to the size of the values
+ * @note the payload must have been verified, the destination is overwritten
+ */
+
+static void rdcu_copy_reply_data(uint32_t *dst, const uint8_t *src,
+				 uint32_t len, int swap)
+{
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	if (swap == sizeof(uint16_t)) {
+		be16_to_cpu_copy(dst, src, len / sizeof(uint16_t));
+		return;
+	}
+
+	if (swap) {
+		be32_to_cpu_copy(dst, src, len / sizeof(uint32_t));
+		return;
+	}
+#else
+	(void) swap;
+#endif /* __BYTE_ORDER__ */
+
+	memcpy(dst, src, len);
+}
+
+
+/**
+ * @brief apply the modification of a read-modify-write transaction to the
+ *	  local copy of the word
+ *
+ * @param slot the id of the slot
+ * @param local the local word, holding the value read by the target
+ *
+ * @note the (mirror) word is updated to what the target wrote, i.e.
+ *	 (old & ~mask) | (value & mask)
+ */
+
+static void rdcu_apply_rmw(int slot, uint32_t *local)
+{
+	uint32_t w;
+
+
+	w = (*local);
+
+	if (!ctx->trans_log.swap[slot])
+		w = be32_to_cpu(w);	/* big-endian SRAM image */
+
+	w = (w & ~ctx->trans_log.rmw_mask[slot]) |
+	    (ctx->trans_log.rmw_val[slot] & ctx->trans_log.rmw_mask[slot]);
+
+	if (!ctx->trans_log.swap[slot])
+		w = cpu_to_be32(w);
+
+	(*local) = w;
+}
+
+
+/**
+ * @brief retransmit a transaction
+ *
+ * @param slot the id of the slot
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the command is generated with the next transaction identifier of the
+ *	 slot and the payload of a write is taken from the local address again
+ */
+
+static int trans_log_resubmit(int slot)
+{
+	int n;
+	uint32_t len = 0;
+	uint8_t *data;
+
+	uint8_t rmap_cmd[RDCU_CMD_HDR_MAX_SIZE];
+
+	struct rdcu_trans_log *log = &ctx->trans_log;
+
+
+	/* if we fail, the next attempt is after another timeout */
+	if (ctx->trans_log_time)
+		log->t_submit[slot] = ctx->trans_log_time();
+
+	log->seq[slot]++;
+
+	if (log->gen_reg[slot]) {
+		n = log->gen_reg[slot](trans_log_id(slot), NULL);
+		if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE)
+			return -1;
+		n = log->gen_reg[slot](trans_log_id(slot), rmap_cmd);
+	} else {
+		n = log->gen[slot](trans_log_id(slot), NULL,
+				   log->remote_addr[slot], log->data_len[slot]);
+		if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE)
+			return -1;
+		n = log->gen[slot](trans_log_id(slot), rmap_cmd,
+				   log->remote_addr[slot], log->data_len[slot]);
+	}
+
+	if (!n)
+		return -1;
+
+	data = (uint8_t *) log->local_addr[slot];
+
+	if (log->cmd_type[slot] & RMAP_CMD_BIT_WRITE)
+		len = log->data_len[slot];
+
+	/* convert endianess if needed */
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	if (len && log->swap[slot]) {
+		uint32_t *tmp_buf = alloca(len);
+
+		if (log->swap[slot] == sizeof(uint16_t))
+			cpu_to_be16_copy(tmp_buf, data, len / 2);
+		else
+			cpu_to_be32_copy(tmp_buf, data, len / 4);
+
+		data = (uint8_t *) tmp_buf;
+	}
+#endif /* __BYTE_ORDER__ */
+
+	return rdcu_submit_tx(rmap_cmd, n, data, len);
+}
+
+
+/**
+ * @brief retransmit a failed transaction or drop it if it is out of retries
+ *
+ * @param slot the id of the slot
+ */
+
+static void trans_log_fail(int slot)
+{
+	struct rdcu_trans_log *log = &ctx->trans_log;
+
+
+	if (!log->gen[slot] && !log->gen_reg[slot]) {
+		trans_log_complete(slot, -1);
+		return;
+	}
+
+	if (log->retries[slot] >= ctx->trans_retries) {
+		event_report(RMAP, MEDIUM, E_RMAP_TRANS_DROPPED);
+		trans_log_complete(slot, -1);
+		return;
+	}
+
+	log->retries[slot]++;
+
+	if (!trans_log_resubmit(slot)) {
+		ctx->stats.retransmits++;
+		return;
+	}
+
+	/* the interface did not take it, try again on the next timeout */
+	if (ctx->trans_timeout && ctx->trans_log_time)
+		return;
+
+	event_report(RMAP, MEDIUM, E_RMAP_TRANS_DROPPED);
+	trans_log_complete(slot, -1);
+}
+
+
+/**
+ * @brief retransmit or drop all transactions that are overdue
+ *
+ * @note a transaction is overdue if no reply arrived within the timeout set
+ *	 by rdcu_rmap_set_timeout() after it was submitted
+ */
+
+static void trans_log_check_timeouts(void)
+{
+	int i;
+	uint32_t now;
+
+
+	if (!ctx->trans_timeout || !ctx->trans_log_time)
+		return;
+
+	if (!ctx->trans_log.pending)
+		return;
+
+	now = ctx->trans_log_time();
+
+	for (i = 0; i < TRANS_LOG_SIZE; i++) {
+
+		if (!ctx->trans_log.in_use[i])
+			continue;
+
+		/* signed, slots may be (re)submitted while we scan */
+		if ((int32_t) (now - ctx->trans_log.t_submit[i]) <
+		    (int32_t) ctx->trans_timeout)
+			continue;
+
+		ctx->stats.timeouts++;
+		event_report(RMAP, LOW, E_RMAP_REPLY_TIMEOUT);
+
+		trans_log_fail(i);
+	}
+}
+
+
+/**
+ * @brief handle a reply with an error status
+ *
+ * @param slot the id of the slot
+ * @param status the status code of the reply
+ *
+ * @note only a command damaged in transfer may succeed when sent again, any
+ *	 other error would just repeat, so the transaction is dropped right
+ *	 away and its submitter learns about it with this very reply
+ */
+
+static void rdcu_reply_status_error(int slot, uint8_t status)
+{
+	enum rmap_err_class c = rmap_status_class(status);
+
+
+	ctx->stats.status_err[c]++;
+
+	if (status > 0xF)
+		status = RMAP_STATUS_RESERVED;
+
+	if (c == RMAP_ERR_TRANSFER) {
+		event_report(RMAP, LOW, E_RMAP_STATUS(status));
+		trans_log_fail(slot);
+		return;
+	}
+
+	event_report(RMAP, MEDIUM, E_RMAP_STATUS(status));
+	trans_log_complete(slot, -1);
+}
+
+
+/**
+ * @brief process a single rmap reply packet
+ *
+ * @param buf the packet buffer
+ * @param len the size of the packet buffer
+ *
+ * @note the packet is decoded in place, the only copy done is of the reply
+ *	 data into the local address registered in the transaction log
+ * @note a transaction with an invalid reply is retransmitted or dropped, see
+ *	 trans_log_fail() and rdcu_reply_status_error(); a reply with a header
+ *	 CRC mismatch is discarded, as its transaction cannot be identified
+ */
+
+static void rdcu_process_reply(uint8_t *buf, uint32_t len)
+{
+	int slot;
+	uint32_t *local_addr;
+
+	struct rmap_pkt rp;
+
+
+	if (0)
+		rmap_parse_pkt(buf);
+
+	if (rmap_pkt_view_from_buffer(&rp, buf, len)) {
+		ctx->stats.rx_unknown++;
+		event_report(RMAP, LOW, E_RMAP_REPLY_INVALID);
+		return;
+	}
+
+	/* with a damaged header, not even the transaction id can be trusted,
+	 * so the reply is discarded and the transaction is left to time out
+	 */
+	if (rmap_crc8(buf, (size_t) rmap_build_hdr(&rp, NULL)) != rp.hdr_crc) {
+		ctx->stats.hdr_crc_err++;
+		event_report(RMAP, LOW, E_RMAP_REPLY_HDR_CRC);
+		return;
+	}
+
+	slot = trans_log_find(rp.tr_id);
+
+	local_addr = trans_log_get_addr(slot);
+
+	if (!local_addr) {
+		ctx->stats.rx_unknown++;
+		event_report(RMAP, LOW, E_RMAP_REPLY_UNKNOWN);
+		return;
+	}
+
+	if (rp.status) {
+		rdcu_reply_status_error(slot, rp.status);
+		return;
+	}
+
+	/* the reply must be that of the logged command and carry exactly the
+	 * data that were requested, anything else would not fit the local
+	 * buffer or leave it without data
+	 */
+	if (rp.ri.cmd_resp ||
+	    rp.ri.cmd != ctx->trans_log.cmd_type[slot] ||
+	    rp.data_len != ctx->trans_log.reply_len[slot]) {
+		ctx->stats.len_err++;
+		event_report(RMAP, LOW, E_RMAP_REPLY_DATA_LEN);
+
+		trans_log_fail(slot);
+		return;
+	}
+
+	/* the CRC is over the data as transmitted; verify it before the copy,
+	 * so the local data stay untouched if the transaction is dropped
+	 */
+	if (rp.data_len) {
+
+		if (rmap_crc8(rp.data, rp.data_len) != rp.data_crc) {
+
+			ctx->stats.crc_err++;
+			event_report(RMAP, LOW, E_RMAP_REPLY_DATA_CRC);
+
+			trans_log_fail(slot);
+			return;
+		}
+
+		rdcu_copy_reply_data(local_addr, rp.data, rp.data_len,
+				     ctx->trans_log.swap[slot]);
+
+		if (ctx->trans_log.cmd_type[slot] ==
+		    RMAP_READ_MODIFY_WRITE_ADDR_INC)
+			rdcu_apply_rmw(slot, local_addr);
+	}
+
+	trans_log_complete(slot, 0);
+}
+
+
+#if (RMAP_STATIC_ALLOC)
+/* a read reply: header, data and data crc */
+#define RDCU_RX_PKT_MAX (RMAP_DATA_START + RMAP_POOL_DATA_SIZE + 1)
+
+/* replies are processed one at a time, so a single buffer will do */
+static uint8_t rdcu_rx_pkt_buf[RDCU_RX_PKT_MAX];
+
+static uint8_t *rdcu_rx_buf_alloc(int n)
+{
+	if (n > RDCU_RX_PKT_MAX)
+		return NULL;
+
+	return rdcu_rx_pkt_buf;
+}
+
+static void rdcu_rx_buf_free(__attribute__((unused)) uint8_t *buf)
+{
+}
+#else
+static uint8_t *rdcu_rx_buf_alloc(int n)
+{
+	return (uint8_t *) malloc(n);
+}
+
+static void rdcu_rx_buf_free(uint8_t *buf)
+{
+	free(buf);
+}
+#endif /* RMAP_STATIC_ALLOC */
+
+
+/**
+ * @brief process pending rmap replies in batches of up to RDCU_RX_BURST
+ *
+ * @returns number of packets processed or < 0 on error
+ */
+
+static int rdcu_process_rx_burst(void)
+{
+	int cnt = 0;
+
+	uint32_t i;
+	uint32_t n;
+
+	uint8_t *pkts[RDCU_RX_BURST];
+	uint32_t sizes[RDCU_RX_BURST];
+
+
+	while ((n = ctx->rmap_rx_burst(pkts, sizes, RDCU_RX_BURST))) {
+
+		for (i = 0; i < n; i++) {
+
+			cnt++;
+			ctx->stats.rx_pkts++;
+			ctx->stats.rx_bytes += sizes[i];
+
+			/* an invalid reply only affects its own transaction */
+			rdcu_process_reply(pkts[i], sizes[i]);
+		}
+
+		/* the buffers may be reused now */
+		ctx->rmap_rx_burst_release(n);
+
+		/* the batch was not full, the ring is drained */
+		if (n < RDCU_RX_BURST)
+			break;
+	}
+
+	return cnt;
+}
+
+
+/**
+ * @brief n rmap command transaction
+ *
+ * @returns number of packets processed or < 0 on error
+ */
+
+static int rdcu_process_rx_pkts(void)
+{
+	int n;
+	int cnt = 0;
+
+	uint8_t *spw_pckt;
+
+
+	/* burst variant: work directly on a batch of receive buffers */
+	if (ctx->rmap_rx_burst && ctx->rmap_rx_burst_release)
+		return rdcu_process_rx_burst();
+
+	/* zero-copy variant: work directly on the receive buffer */
+	if (ctx->rmap_rx_peek && ctx->rmap_rx_release) {
+
+		while ((n = ctx->rmap_rx_peek(&spw_pckt))) {
+
+			cnt++;
+			ctx->stats.rx_pkts++;
+			ctx->stats.rx_bytes += n;
+
+			rdcu_process_reply(spw_pckt, n);
+
+			/* the buffer may be reused now */
+			ctx->rmap_rx_release();
+		}
+
+		return cnt;
+	}
+
+
+	if (!ctx->rmap_rx)
+		return -1;
+
+	/* process all pending responses */
+	while ((n = ctx->rmap_rx(NULL))) {
+		/* we received something, allocate enough space for the packet */
+		spw_pckt = rdcu_rx_buf_alloc(n);
+		if (!spw_pckt) {
+			dlog1("allocation of %lu bytes for packet failed!\n", n);
+			return -1;
+		}
+
+		/* read the packet */
+		n = ctx->rmap_rx(spw_pckt);
+
+		if (!n) {
+			dlog0("Unknown error in rmap_rx()\n");
+			rdcu_rx_buf_free(spw_pckt);
+			return -1;
+		}
+
+		cnt++;
+		ctx->stats.rx_pkts++;
+		ctx->stats.rx_bytes += n;
+
+		rdcu_process_reply(spw_pckt, n);
+		rdcu_rx_buf_free(spw_pckt);
+	}
+
+	return cnt;
+}
+
+
+/**
+ * @brief process all pending rmap replies
+ *
+ * @returns number of packets processed or < 0 on error
+ *
+ * @note completion callbacks may submit new transactions, which in turn try
+ *	 to process pending replies; we must not recurse into the receive
+ *	 loop of a context while a packet is being processed, so those calls
+ *	 do nothing; the replies of other contexts may still be processed
+ * @note overdue transactions are retransmitted or dropped afterwards
+ */
+
+static int rdcu_process_rx(void)
+{
+	int ret;
+
+	struct rdcu_rmap_ctx *c = ctx;
+
+
+	if (c->rx_busy)
+		return 0;
+
+	c->rx_busy = 1;
+	ret = rdcu_process_rx_pkts();
+	trans_log_check_timeouts();
+	c->rx_busy = 0;
+
+	return ret;
+}
+
+
+/**
+ * @brief submit an rmap command transaction
+ *
+ * @param cmd the rmap command
+ * @param cmd_size the size of the rmap command
+ * @param data the payload (may be NULL)
+ * @param data_size the size of the payload
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+int rdcu_submit_tx(const uint8_t *cmd,  int cmd_size,
+		   const uint8_t *data, int data_size)
+{
+	/* try to process pending responses */
+	rdcu_process_rx();
+
+	if (!ctx->rmap_tx)
+		return -1;
+
+	if (0)
+		printf("Transmitting RMAP command\n");
+
+	if (ctx->rmap_tx(cmd, cmd_size, ctx->dpath_len, data, data_size)) {
+		dlog0("rmap_tx() returned error!\n");
+		return -1;
+	}
+
+	ctx->stats.submitted++;
+	ctx->stats.tx_bytes += cmd_size + data_size;
+
+	return 0;
+}
+
+
+/**
+ * @brief submit an rmap command transaction without copying the payload
+ *
+ * @param cmd the rmap command
+ * @param cmd_size the size of the rmap command
+ * @param data the payload
+ * @param data_size the size of the payload
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the payload is referenced until it was transmitted; since we only
+ *	 issue write commands with reply, the data buffer may be modified
+ *	 again once the transaction is no longer pending
+ */
+
+static int rdcu_submit_tx_zero_copy(const uint8_t *cmd,  int cmd_size,
+				    const uint8_t *data, int data_size)
+{
+	/* try to process pending responses */
+	rdcu_process_rx();
+
+	if (!ctx->rmap_tx_zero_copy)
+		return -1;
+
+	if (ctx->rmap_tx_zero_copy(cmd, cmd_size, ctx->dpath_len,
+				   data, data_size)) {
+		dlog0("rmap_tx_zero_copy() returned error!\n");
+		return -1;
+	}
+
+	ctx->stats.submitted++;
+	ctx->stats.tx_bytes += cmd_size + data_size;
+
+	return 0;
+}
+
+
+/**
+ * @brief submit the command of a logged transaction
+ *
+ * @param slot the id of the slot of the transaction
+ * @param cmd the rmap command
+ * @param cmd_size the size of the rmap command
+ * @param data the payload (may be NULL)
+ * @param data_size the size of the payload
+ * @param zero_copy if set, the payload is not copied by the interface
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note if the interface did not take the command, the slot is released
+ *	 without calling its callback, the submitter is told by the return
+ *	 value instead
+ */
+
+static int trans_log_submit_tx(int slot, const uint8_t *cmd, int cmd_size,
+			       const uint8_t *data, int data_size,
+			       int zero_copy)
+{
+	int ret;
+
+
+	if (zero_copy)
+		ret = rdcu_submit_tx_zero_copy(cmd, cmd_size, data, data_size);
+	else
+		ret = rdcu_submit_tx(cmd, cmd_size, data, data_size);
+
+	if (ret)
+		trans_log_release_slot(slot);
+
+	return ret;
+}
+
+
+/**
+ * @brief select the reply address of a transfer by its class
+ *
+ * @param addr the remote address of the transfer
+ *
+ * @returns the logical address of the ICU the reply is to be sent to
+ *
+ * @note replies to SRAM transfers may be large, so they can be sent to a
+ *	 separate address (see rdcu_set_bulk_source_logical_address()), which
+ *	 the interface may receive on a different DMA channel than the replies
+ *	 to register accesses
+ */
+
+static uint8_t rdcu_reply_addr(uint32_t addr)
+{
+	if (addr <= RDCU_SRAM_END)
+		return ctx->icu_addr_bulk;
+
+	return ctx->icu_addr;
+}
+
+
+/**
+ * @brief build an rmap command header from scratch
+ *
+ * @param trans_id a transaction identifier
+ *
+ * @param cmd the command buffer; if NULL, the function returns the needed size
+ *
+ * @param rmap_cmd_type the rmap command type of the packet
+ *
+ * @param addr the address to read from or write to
+ *
+ * @param size the number of bytes to read or write
+ *
+ * @returns the size of the command data buffer or 0 on error
+ */
+
+static int rdcu_build_cmd(uint16_t trans_id, uint8_t *cmd,
+			  uint8_t rmap_cmd_type,
+			  uint32_t addr, uint32_t size)
+{
+	int n;
+
+	struct rmap_pkt *pkt;
+
+	pkt = rmap_create_packet();
+	if (!pkt) {
+		dlog0("Error creating packet\n");
+		return 0;
+	}
+
+	rmap_set_dst(pkt, ctx->rdcu_addr);
+	rmap_set_src(pkt, rdcu_reply_addr(addr));
+	rmap_set_dest_path(pkt, ctx->dpath, ctx->dpath_len);
+	rmap_set_reply_path(pkt, ctx->rpath, ctx->rpath_len);
+	rmap_set_key(pkt, ctx->dst_key);
+	rmap_set_cmd(pkt, rmap_cmd_type);
+	rmap_set_tr_id(pkt, trans_id);
+	rmap_set_data_addr(pkt, addr);
+	rmap_set_data_len(pkt, size);
+
+	/* determine header size */
+	n = rmap_build_hdr(pkt, NULL);
+
+	if (!cmd) {
+		rmap_erase_packet(pkt);
+		return n;
+	}
+
+	memset(cmd, 0, n);  /* clear command buffer */
+
+	n = rmap_build_hdr(pkt, cmd);
+
+	rmap_erase_packet(pkt);
+
+	return n;
+}
+
+
+/**
+ * @brief drop all cached command headers
+ */
+
+static void rdcu_hdr_cache_flush(void)
+{
+	ctx->hdr_cache_used = 0;
+}
+
+
+/**
+ * @brief look up (or create) the cached header for a command type
+ *
+ * @param rmap_cmd_type the rmap command type
+ *
+ * @returns the index of the cache entry, -1 if the cache is full or the
+ *	    header could not be built
+ */
+
+static int rdcu_hdr_cache_get(uint8_t rmap_cmd_type)
+{
+	int i;
+	int n;
+
+
+	for (i = 0; i < ctx->hdr_cache_used; i++) {
+		if (ctx->hdr_cache[i].cmd_type == rmap_cmd_type)
+			return i;
+	}
+
+	if (ctx->hdr_cache_used >= RDCU_HDR_CACHE_SIZE)
+		return -1;
+
+	n = rdcu_build_cmd(0, NULL, rmap_cmd_type, 0, 0);
+	if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE)
+		return -1;
+
+	n = rdcu_build_cmd(0, ctx->hdr_cache[i].hdr, rmap_cmd_type, 0, 0);
+	if (n < RMAP_HDR_MIN_SIZE_WRITE_CMD)
+		return -1;
+
+	ctx->hdr_cache[i].cmd_type = rmap_cmd_type;
+	ctx->hdr_cache[i].size     = n;
+
+	ctx->hdr_cache_used++;
+
+	return i;
+}
+
+
+/**
+ * @brief generate an rmap command packet
+ *
+ * @param trans_id a transaction identifier
+ *
+ * @param cmd the command buffer; if NULL, the function returns the needed size
+ *
+ * @param rmap_cmd_type the rmap command type of the packet
+ *
+ * @param addr the address to read from or write to
+ *
+ * @param size the number of bytes to read or write
+ *
+ * @returns the size of the command data buffer or 0 on error
+ *
+ * @note the header is copied from a template and only the reply address,
+ *	 transaction id, address and data length are filled in; the header CRC is not part
+ *	 of the command buffer, it is added by the interface or rdcu_package()
+ * @note the path arrays are taken as references, if their contents are
+ *	 changed, rdcu_set_destination_path() or rdcu_set_return_path() must be
+ *	 called again so the templates are rebuilt
+ */
+
+int rdcu_gen_cmd(uint16_t trans_id, uint8_t *cmd,
+		 uint8_t rmap_cmd_type,
+		 uint32_t addr, uint32_t size)
+{
+	int i;
+	int n;
+
+	uint8_t *p;
+
+
+	if (size > RMAP_MAX_DATA_LEN)
+		return 0;
+
+	i = rdcu_hdr_cache_get(rmap_cmd_type);
+	if (i < 0)
+		return rdcu_build_cmd(trans_id, cmd, rmap_cmd_type, addr, size);
+
+	n = ctx->hdr_cache[i].size;
+
+	if (!cmd)
+		return n;
+
+	memcpy(cmd, ctx->hdr_cache[i].hdr, n);
+
+	cmd[n - RDCU_CMD_HDR_SRC_OFF] = rdcu_reply_addr(addr);
+
+	p = &cmd[n - RDCU_CMD_HDR_TR_ID_OFF];
+	p[0] = (uint8_t) (trans_id >> 8);
+	p[1] = (uint8_t)  trans_id;
+
+	p = &cmd[n - RDCU_CMD_HDR_ADDR_OFF];
+	p[0] = (uint8_t) (addr >> 24);
+	p[1] = (uint8_t) (addr >> 16);
+	p[2] = (uint8_t) (addr >>  8);
+	p[3] = (uint8_t)  addr;
+
+	p = &cmd[n - RDCU_CMD_HDR_LEN_OFF];
+	p[0] = (uint8_t) (size >> 16);
+	p[1] = (uint8_t) (size >>  8);
+	p[2] = (uint8_t)  size;
+
+	return n;
+}
+
+
+
+
+
+/**
+ * @brief submit a sync command
+ *
+ * @param fn the RDCU command generation function
+ * @param addr the local address of the corresponding remote address
+ * @param data_len the length of the data payload (0 for read commands)
+ *
+ * @note data_len must be a multiple of 4
+ * @note all data is treated (and byte swapped) as 32 bit words
+ *
+ * @return 0 on success, otherwise error
+ */
+
+
+int rdcu_sync(int (*fn)(uint16_t trans_id, uint8_t *cmd),
+	      void *addr, int data_len)
+{
+	return rdcu_sync_async(fn, addr, data_len, NULL, NULL);
+}
+
+
+/**
+ * @brief submit a sync command with a completion callback
+ *
+ * @param fn the RDCU command generation function
+ * @param addr the local address of the corresponding remote address
+ * @param data_len the length of the data payload (0 for read commands)
+ * @param cb a function to call when the transaction completed (may be NULL)
+ * @param userdata a pointer to arbitrary user data; passed to cb
+ *
+ * @note data_len must be a multiple of 4
+ * @note all data is treated (and byte swapped) as 32 bit words
+ * @note cb receives the transaction id and a status of 0 on success or -1 if
+ *	 the reply was invalid and the transaction was dropped
+ * @note cb is called with the link context of the transaction selected; it
+ *	 may select another one, but the selection is restored on its return
+ *
+ * @return 0 on success, otherwise error
+ */
+
+int rdcu_sync_async(int (*fn)(uint16_t trans_id, uint8_t *cmd),
+		    void *addr, int data_len,
+		    void (*cb)(uint16_t trans_id, int status, void *userdata),
+		    void *userdata)
+{
+	int n;
+	int slot;
+
+	uint8_t rmap_cmd[RDCU_CMD_HDR_MAX_SIZE];
+
+
+	if (data_len & 0x3)
+		return -1;
+
+	slot = trans_log_grab_slot(addr);
+	if (slot < 0) {
+		ctx->stats.stall_slots++;
+		return -1;
+	}
+
+
+	/* determine size of command */
+	n = fn(trans_log_id(slot), NULL);
+	if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE) {
+		dlog0("Error: invalid rmap cmd size\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	/* now fill actual command */
+	n = fn(trans_log_id(slot), rmap_cmd);
+	if (!n) {
+		dlog0("Error creating command packet\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	trans_log_set_info(slot, rmap_cmd, n);
+
+	ctx->trans_log.gen_reg[slot]  = fn;
+	ctx->trans_log.data_len[slot] = (uint32_t) data_len;
+
+	ctx->trans_log.cb[slot]      = cb;
+	ctx->trans_log.cb_data[slot] = userdata;
+
+	/* convert endianess if needed */
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	if (data_len)
+	{
 		uint32_t *tmp_buf = alloca(data_len);
-		uint32_t *p = (uint32_t *) addr;
 
-		for (i = 0; i < (data_len / 4); i++)
-			tmp_buf[i] = cpu_to_be32(p[i]);
+		cpu_to_be32_copy(tmp_buf, addr, data_len / 4);
 
 		addr = tmp_buf;
 	}
 #endif /* __BYTE_ORDER__ */
 
-	n = rdcu_submit_tx(rmap_cmd, n, addr, data_len);
-	free(rmap_cmd);
+	return trans_log_submit_tx(slot, rmap_cmd, n, addr, data_len, 0);
+}
+
+
+
+/**
+ * @brief submit a register block sync command
+ *
+ * @param fn a RDCU register block command generation function
+ * @param addr the remote address of the first register
+ * @param data the local address of the first register
+ * @param data_len the size of the register block in bytes
+ * @param read 0: write, otherwise read
+ *
+ * @note data_len must be a multiple of 4
+ * @note all data is treated (and byte swapped) as 32 bit words, i.e. this
+ *	 works like rdcu_sync() for multiple consecutive registers
+ *
+ * @return 0 on success, otherwise error
+ */
+
+int rdcu_sync_block(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+			      uint32_t addr, uint32_t data_len),
+		    uint32_t addr, void *data, uint32_t data_len, int read)
+{
+	int n;
+	int slot;
+
+	uint8_t rmap_cmd[RDCU_CMD_HDR_MAX_SIZE];
+
+
+	if (data_len & 0x3)
+		return -1;
+
+	slot = trans_log_grab_slot(data);
+	if (slot < 0) {
+		ctx->stats.stall_slots++;
+		return -1;
+	}
+
+
+	/* determine size of command */
+	n = fn(trans_log_id(slot), NULL, addr, data_len);
+	if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE) {
+		dlog0("Error: invalid rmap cmd size\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	/* now fill actual command */
+	n = fn(trans_log_id(slot), rmap_cmd, addr, data_len);
+	if (!n) {
+		dlog0("Error creating command packet\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	trans_log_set_info(slot, rmap_cmd, n);
+	trans_log_set_gen(slot, fn, addr, data_len);
+
+	if (read)
+		return trans_log_submit_tx(slot, rmap_cmd, n, NULL, 0, 0);
+
+	/* convert endianess if needed */
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	{
+		uint32_t *tmp_buf = alloca(data_len);
+
+		cpu_to_be32_copy(tmp_buf, data, data_len / 4);
+
+		data = tmp_buf;
+	}
+#endif /* __BYTE_ORDER__ */
+
+	return trans_log_submit_tx(slot, rmap_cmd, n, data, data_len, 0);
+}
+
+
+
+/**
+ * @brief submit a read-modify-write command for a single 32 bit word
+ *
+ * @param fn a RDCU read-modify-write command generation function
+ * @param addr the remote address of the word
+ * @param local the local copy of the word
+ * @param val the bits to write
+ * @param mask the bits to modify
+ * @param swap 0: the local copy is big endian (SRAM image), otherwise a
+ *	       32 bit word in cpu order (register)
+ *
+ * @note the target performs (word & ~mask) | (val & mask) and returns the
+ *	 previous contents, from which the local copy is updated on completion
+ *
+ * @return 0 on success, < 0: error, > 0: retry
+ */
+
+int rdcu_sync_rmw(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+			    uint32_t addr, uint32_t data_len),
+		  uint32_t addr, uint32_t *local, uint32_t val, uint32_t mask,
+		  int swap)
+{
+	int n;
+	int slot;
+
+	uint32_t payload[2];
+	uint8_t rmap_cmd[RDCU_CMD_HDR_MAX_SIZE];
+
+
+	if (!local)
+		return -1;
+
+	if (addr & 0x3)
+		return -1;
+
+	rdcu_process_rx();
+
+	if (ctx->trans_log.pending >= ctx->trans_window) {
+		ctx->stats.stall_window++;
+		return 1;
+	}
+
+	slot = trans_log_grab_slot(local);
+	if (slot < 0) {
+		ctx->stats.stall_slots++;
+		return 1;
+	}
+
+	n = fn(trans_log_id(slot), NULL, addr, sizeof(payload));
+	if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE) {
+		dlog0("Error: invalid rmap cmd size\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	n = fn(trans_log_id(slot), rmap_cmd, addr, sizeof(payload));
+	if (!n) {
+		dlog0("Error creating command packet\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	trans_log_set_info(slot, rmap_cmd, n);
+
+	ctx->trans_log.swap[slot]     = (uint8_t) (swap ? sizeof(uint32_t) : 0);
+	ctx->trans_log.rmw_val[slot]  = val;
+	ctx->trans_log.rmw_mask[slot] = mask;
+
+	/* the data, followed by the mask */
+	payload[0] = cpu_to_be32(val);
+	payload[1] = cpu_to_be32(mask);
+
+	return trans_log_submit_tx(slot, rmap_cmd, n, (uint8_t *) payload,
+				   sizeof(payload), 0);
+}
+
+
+/**
+ * @brief submit a write command that does not expect a reply
+ *
+ * @param fn a RDCU write command generation function that produces commands
+ *	     without the reply bit set
+ * @param addr the remote address
+ * @param data the local data address
+ * @param data_len the length of the data payload
+ *
+ * @note the data is treated (and byte swapped) as 32 bit words
+ * @note the command is not entered in the transaction log, so it neither
+ *	 takes up a slot nor counts towards the transfer window; the success
+ *	 of the write can only be determined by reading back the target
+ *
+ * @return 0 on success, < 0: error, > 0: retry
+ */
+
+int rdcu_sync_noreply(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+				uint32_t addr, uint32_t data_len),
+		      uint32_t addr, void *data, uint32_t data_len)
+{
+	int n;
+
+	uint8_t rmap_cmd[RDCU_CMD_HDR_MAX_SIZE];
+
+
+	if (!data)
+		return -1;
+
+	if (data_len & 0x3)
+		return -1;
+
+	rdcu_process_rx();
+
+	if (ctx->rmap_tx_avail) {
+		if (!ctx->rmap_tx_avail()) {
+			ctx->stats.stall_tx++;
+			return 1;
+		}
+	}
+
+	/* the transaction id is never returned to us */
+	n = fn(0, NULL, addr, data_len);
+	if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE) {
+		dlog0("Error: invalid rmap cmd size\n");
+		return -1;
+	}
+
+	n = fn(0, rmap_cmd, addr, data_len);
+	if (!n) {
+		dlog0("Error creating command packet\n");
+		return -1;
+	}
+
+	if (rmap_cmd[ctx->dpath_len + RMAP_INSTRUCTION] &
+	    (RMAP_CMD_BIT_REPLY << 2)) {
+		dlog0("Error: command requests a reply\n");
+		return -1;
+	}
+
+	/* convert endianess if needed */
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	{
+		uint32_t *tmp_buf = alloca(data_len);
+
+		cpu_to_be32_copy(tmp_buf, data, data_len / 4);
+
+		data = tmp_buf;
+	}
+#endif /* __BYTE_ORDER__ */
+
+	return rdcu_submit_tx(rmap_cmd, n, data, data_len);
+}
+
+
+/**
+ * @brief submit a data sync command
+ *
+ * @param fn a RDCU data transfer generation function
+ * @param addr the remote address
+ * @param data the local data address
+ * @param data_len the length of the data payload
+ * @param read 0: write, otherwise read
+ *
+ * @return 0 on success, < 0: error, > 0: retry
+ *
+ * @note a retry is signalled if the number of pending transactions reached
+ *	 the transfer window depth or if the interface reports that it cannot
+ *	 accept another packet; pending replies are processed on every call
+ *
+ * @note this one is a little redundant, but otherwise we'd have a lot of
+ *	 unused parameters on most of the control functions
+ *
+ * XXX need a paramter for read...meh...must think of something else
+ */
+
+
+int rdcu_sync_data(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+			     uint32_t addr, uint32_t data_len),
+		   uint32_t addr, void *data, uint32_t data_len, int read)
+{
+	return rdcu_sync_data_async(fn, addr, data, data_len, read, NULL, NULL);
+}
+
+
+/**
+ * @brief submit a data sync command
+ *
+ * @param fn a RDCU data transfer generation function
+ * @param addr the remote address
+ * @param data the local data address
+ * @param data_len the length of the data payload
+ * @param read 0: write, otherwise read
+ * @param width the size of the values in bytes; 2 and 4 are converted
+ *	        between cpu and big endian order, anything else is
+ *	        transferred as-is
+ * @param cb a function to call when the transaction completed (may be NULL)
+ * @param userdata a pointer to arbitrary user data; passed to cb
+ *
+ * @return 0 on success, < 0: error, > 0: retry
+ */
+
+static int rdcu_sync_data_submit(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+					   uint32_t addr, uint32_t data_len),
+				 uint32_t addr, void *data, uint32_t data_len,
+				 int read, uint32_t width,
+				 void (*cb)(uint16_t trans_id, int status,
+					    void *userdata),
+				 void *userdata)
+{
+	int n;
+	int slot;
+
+	uint8_t rmap_cmd[RDCU_CMD_HDR_MAX_SIZE];
+
+
+
+	if (width != sizeof(uint16_t) && width != sizeof(uint32_t))
+		width = 0;
+
+	if (width && (data_len & 0x3))
+		return -1;
+
+	rdcu_process_rx();
+
+	/* keep within the transfer window */
+	if (ctx->trans_log.pending >= ctx->trans_window) {
+		ctx->stats.stall_window++;
+		return 1;
+	}
+
+	/* the interface could not take another packet right now */
+	if (ctx->rmap_tx_avail) {
+		if (!ctx->rmap_tx_avail()) {
+			ctx->stats.stall_tx++;
+			return 1;
+		}
+	}
+
+	slot = trans_log_grab_slot(data);
+	if (slot < 0) {
+		if (0)
+		dlog0("Error: all slots busy!\n");
+		ctx->stats.stall_slots++;
+		return 1;
+	}
+
+
+	/* determine size of command */
+	n = fn(trans_log_id(slot), NULL, addr, data_len);
+	if (n <= 0 || n > RDCU_CMD_HDR_MAX_SIZE) {
+		dlog0("Error: invalid rmap cmd size\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	/* now fill actual command */
+	n = fn(trans_log_id(slot), rmap_cmd, addr, data_len);
+	if (!n) {
+		dlog0("Error creating command packet\n");
+		trans_log_release_slot(slot);
+		return -1;
+	}
+
+	trans_log_set_info(slot, rmap_cmd, n);
+	trans_log_set_gen(slot, fn, addr, data_len);
+
+	ctx->trans_log.cb[slot]      = cb;
+	ctx->trans_log.cb_data[slot] = userdata;
+
+	/* replies are converted while they are copied to the local address */
+	ctx->trans_log.swap[slot]    = (uint8_t) width;
+
+	if (read)
+		return trans_log_submit_tx(slot, rmap_cmd, n, NULL, 0, 0);
+
+	/* convert endianess if needed; the interface copies the payload */
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	if (width) {
+		uint32_t *tmp_buf = alloca(data_len);
+
+		if (width == sizeof(uint16_t))
+			cpu_to_be16_copy(tmp_buf, data, data_len / 2);
+		else
+			cpu_to_be32_copy(tmp_buf, data, data_len / 4);
+
+		return trans_log_submit_tx(slot, rmap_cmd, n,
+					   (uint8_t *) tmp_buf, data_len, 0);
+	}
+#endif /* __BYTE_ORDER__ */
+
+	return trans_log_submit_tx(slot, rmap_cmd, n, data, data_len,
+				   ctx->rmap_tx_zero_copy != NULL);
+}
+
+
+/**
+ * @brief submit a data sync command with a completion callback
+ *
+ * @param fn a RDCU data transfer generation function
+ * @param addr the remote address
+ * @param data the local data address
+ * @param data_len the length of the data payload
+ * @param read 0: write, otherwise read
+ * @param cb a function to call when the transaction completed (may be NULL)
+ * @param userdata a pointer to arbitrary user data; passed to cb
+ *
+ * @return 0 on success, < 0: error, > 0: retry
+ *
+ * @note see rdcu_sync_data() and rdcu_sync_async()
+ */
 
-	return n;
+int rdcu_sync_data_async(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+				   uint32_t addr, uint32_t data_len),
+			 uint32_t addr, void *data, uint32_t data_len, int read,
+			 void (*cb)(uint16_t trans_id, int status,
+				    void *userdata),
+			 void *userdata)
+{
+	/* data are transferred unconverted in both directions */
+	return rdcu_sync_data_submit(fn, addr, data, data_len, read, 0,
+				     cb, userdata);
 }
 
 
-
 /**
- * @brief submit a data sync command
+ * @brief submit a data sync command for a buffer of cpu order values
  *
  * @param fn a RDCU data transfer generation function
  * @param addr the remote address
- * @param data the local data address
- * @param data_len the length of the data payload
+ * @param data the local data address; must be aligned to width
+ * @param data_len the length of the data payload (a multiple of 4)
  * @param read 0: write, otherwise read
+ * @param width the size of the values in bytes (1, 2 or 4)
  *
  * @return 0 on success, < 0: error, > 0: retry
  *
- * @note this one is a little redundant, but otherwise we'd have a lot of
- *	 unused parameters on most of the control functions
- *
- * XXX need a paramter for read...meh...must think of something else
+ * @note the data are converted to and from the big endian order of the RDCU
+ *	 on the fly: replies are stored directly at the local address, which
+ *	 is registered in the transaction log, and on little endian machines,
+ *	 a converted copy of the payload is sent; otherwise, the payload is
+ *	 sent from the local address, so it must not be modified before the
+ *	 transaction completed if a zero-copy interface is configured
  */
 
-
-int rdcu_sync_data(int (*fn)(uint16_t trans_id, uint8_t *cmd,
-			     uint32_t addr, uint32_t data_len),
-		   uint32_t addr, void *data, uint32_t data_len, int read)
+int rdcu_sync_data_swab(int (*fn)(uint16_t trans_id, uint8_t *cmd,
+				  uint32_t addr, uint32_t data_len),
+			uint32_t addr, void *data, uint32_t data_len, int read,
+			uint32_t width)
 {
-	int n;
-	int slot;
-
-	uint8_t *rmap_cmd;
-
-
-
-	rdcu_process_rx();
-
-	slot = trans_log_grab_slot(data);
-	if (slot < 0) {
-		if (0)
-		printf("Error: all slots busy!\n");
-		return 1;
-	}
-
-
-	/* determine size of command */
-	n = fn(slot, NULL, addr, data_len);
-
-	rmap_cmd = (uint8_t *) malloc(n);
-	if (!rmap_cmd) {
-		printf("Error allocating rmap cmd");
+	if (!data)
 		return -1;
-	}
 
-	/* now fill actual command */
-	n = fn(slot, rmap_cmd, addr, data_len);
-	if (!n) {
-		printf("Error creating command packet\n");
-		free(rmap_cmd);
+	if (width != 1 && width != sizeof(uint16_t) && width != sizeof(uint32_t))
 		return -1;
-	}
 
-	if (read)
-		n = rdcu_submit_tx(rmap_cmd, n, NULL, 0);
-	else
-		n = rdcu_submit_tx(rmap_cmd, n, data, data_len);
-
-	free(rmap_cmd);
+	if ((unsigned long) data & (width - 1))
+		return -1;
 
-	return n;
+	return rdcu_sync_data_submit(fn, addr, data, data_len, read, width,
+				     NULL, NULL);
 }
 
 
@@ -658,7 +2219,8 @@ int rdcu_package(uint8_t *blob,
 
 void rdcu_set_destination_logical_address(uint8_t addr)
 {
-	rdcu_addr = addr;
+	ctx->rdcu_addr = addr;
+	rdcu_hdr_cache_flush();
 }
 
 /**
@@ -668,7 +2230,28 @@ void rdcu_set_destination_logical_address(uint8_t addr)
 
 void rdcu_set_source_logical_address(uint8_t addr)
 {
-	icu_addr = addr;
+	ctx->icu_addr      = addr;
+	ctx->icu_addr_bulk = addr;
+	rdcu_hdr_cache_flush();
+}
+
+
+/**
+ * @brief sets the logical address of the ICU for SRAM data transfers
+ * @param addr the address
+ *
+ * @note the replies to SRAM reads and writes are sent to this address, all
+ *	 others to the source logical address; if the interface receives the
+ *	 two addresses on separate DMA channels (see grspw2_dma_chan_init()),
+ *	 replies to register accesses are not held up by bulk transfers
+ * @note this is reset by rdcu_set_source_logical_address(), so call it
+ *	 afterwards
+ */
+
+void rdcu_set_bulk_source_logical_address(uint8_t addr)
+{
+	ctx->icu_addr_bulk = addr;
+	rdcu_hdr_cache_flush();
 }
 
 
@@ -689,14 +2272,16 @@ int rdcu_set_destination_path(uint8_t *path, uint8_t len)
 	if (len > RMAP_MAX_PATH_LEN)
 		return -1;
 
+	rdcu_hdr_cache_flush();
+
 	if (!path || !len) {
-		dpath     = NULL;
-		dpath_len = 0;
+		ctx->dpath     = NULL;
+		ctx->dpath_len = 0;
 		return 0;
 	}
 
-	dpath     = path;
-	dpath_len = len;
+	ctx->dpath     = path;
+	ctx->dpath_len = len;
 
 	return 0;
 }
@@ -723,14 +2308,16 @@ int rdcu_set_return_path(uint8_t *path, uint8_t len)
 	if (len & 0x3)
 		return -1;	/* not a multiple of 4 */
 
+	rdcu_hdr_cache_flush();
+
 	if (!path || !len) {
-		rpath     = NULL;
-		rpath_len = 0;
+		ctx->rpath     = NULL;
+		ctx->rpath_len = 0;
 		return 0;
 	}
 
-	rpath     = path;
-	rpath_len = len;
+	ctx->rpath     = path;
+	ctx->rpath_len = len;
 
 	return 0;
 }
@@ -744,7 +2331,8 @@ int rdcu_set_return_path(uint8_t *path, uint8_t len)
 
 void rdcu_set_destination_key(uint8_t key)
 {
-	dst_key = key;
+	ctx->dst_key = key;
+	rdcu_hdr_cache_flush();
 }
 
 
@@ -756,7 +2344,7 @@ void rdcu_set_destination_key(uint8_t key)
 
 size_t rdcu_get_data_mtu(void)
 {
-	return data_mtu;
+	return ctx->data_mtu;
 }
 
 
@@ -771,18 +2359,302 @@ int rdcu_rmap_sync_status(void)
 	/* try to process pending responses */
 	rdcu_process_rx();
 
-	return trans_log.pending;
+	return ctx->trans_log.pending;
+}
+
+
+/**
+ * @brief process pending RMAP replies from an interrupt callback
+ *
+ * @param userdata the link context of the interface (see
+ *		  rdcu_rmap_ctx_alloc()) or NULL for the selected one
+ *
+ * @returns always 0
+ *
+ * @note this is meant to be registered with irl1_register_callback() or
+ *	 irl2_register_callback() on the receive interrupt of the SpW interface;
+ *	 since the transaction log is not locked, use PRIORITY_LATER and call
+ *	 irq_queue_execute() from the same context the other rdcu_rmap
+ *	 functions are used in
+ */
+
+int32_t rdcu_rmap_rx_irq(void *userdata)
+{
+	struct rdcu_rmap_ctx *prev = ctx;
+
+
+	/* process the replies of the link the interrupt was registered for */
+	if (userdata)
+		ctx = (struct rdcu_rmap_ctx *) userdata;
+
+	rdcu_process_rx();
+
+	ctx = prev;
+
+	return 0;
+}
+
+
+/**
+ * @brief get a link statistics counter of the selected context
+ *
+ * @param name the name of the counter, as exported via sysctl
+ *
+ * @returns the value of the counter, 0 if there is no such counter
+ */
+
+uint32_t rdcu_rmap_get_stat(const char *name)
+{
+	size_t i;
+
+
+	if (!name)
+		return 0;
+
+	for (i = 0; i < RMAP_STATS_CNT; i++)
+		if (!strcmp(name, rmap_stats_cnt[i].name))
+			return *rmap_stats_get_cnt(&ctx->stats, i);
+
+	return 0;
 }
 
 
 /**
  * @brief reset all entries in the RMAP transaction log
+ *
+ * @note all pending transactions are completed as dropped, so their
+ *	 submitters are notified; replies that still arrive for them are
+ *	 discarded
  */
 
 void rdcu_rmap_reset_log(void)
 {
-	memset(trans_log.in_use, 0, sizeof(trans_log.in_use));  /* clear in_use buffer */
-	trans_log.pending = 0;
+	int i;
+	uint8_t in_use[TRANS_LOG_SIZE];
+
+
+	/* a callback may submit new transactions, these are kept */
+	memcpy(in_use, ctx->trans_log.in_use, sizeof(in_use));
+
+	for (i = 0; i < TRANS_LOG_SIZE; i++) {
+		if (in_use[i])
+			trans_log_complete(i, -1);
+	}
+
+	if (ctx->trans_log.pending)
+		return;
+
+	/* clear in_use buffer */
+	memset(ctx->trans_log.in_use, 0, sizeof(ctx->trans_log.in_use));
+
+	/* all ids are free again */
+	for (i = 0; i < TRANS_LOG_SIZE; i++)
+		ctx->trans_log.free_id[i] = (uint16_t) i;
+
+	ctx->trans_log.free_head = 0;
+	ctx->trans_log.free_tail = 0;
+}
+
+
+/**
+ * @brief set the depth of the data transfer window
+ *
+ * @param depth the maximum number of data transfers in flight
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the depth is limited by the size of the transaction log; make sure
+ *	 the interface is able to buffer as many replies as set here, otherwise
+ *	 the link will stall until the replies are retrieved
+ */
+
+int rdcu_rmap_set_window(int depth)
+{
+	if (depth < 1)
+		return -1;
+
+	if (depth > TRANS_LOG_SIZE)
+		return -1;
+
+	ctx->trans_window = depth;
+
+	return 0;
+}
+
+
+/**
+ * @brief get the depth of the data transfer window
+ *
+ * @returns the maximum number of data transfers in flight
+ */
+
+int rdcu_rmap_get_window(void)
+{
+	return ctx->trans_window;
+}
+
+
+/**
+ * @brief get the maximum supported depth of the data transfer window
+ *
+ * @returns the number of entries in the transaction log
+ */
+
+int rdcu_rmap_get_max_window(void)
+{
+	return TRANS_LOG_SIZE;
+}
+
+
+/**
+ * @brief set a function to query the interface for free transmit buffers
+ *
+ * @param fn a function returning the number of packets the interface can
+ *	     accept right now (may be NULL to disable)
+ *
+ * @note if set, data transfers are deferred with a retry instead of failing
+ *	 in the tx function when the interface has no free buffers
+ */
+
+void rdcu_rmap_set_tx_avail(uint32_t (*fn)(void))
+{
+	ctx->rmap_tx_avail = fn;
+}
+
+
+/**
+ * @brief set a time source for the transaction log submission time stamps
+ *
+ * @param fn a function returning the current time in arbitrary units
+ *	     (may be NULL to disable time stamping)
+ *
+ * @note the time stamps are also used for the round-trip latency histogram,
+ *	 so a unit of microseconds is a good choice
+ */
+
+void rdcu_rmap_set_time_source(uint32_t (*fn)(void))
+{
+	ctx->trans_log_time = fn;
+}
+
+
+/**
+ * @brief get the current time of the configured time source
+ *
+ * @returns the current time or 0 if no time source is configured
+ */
+
+uint32_t rdcu_rmap_get_time(void)
+{
+	if (!ctx->trans_log_time)
+		return 0;
+
+	return ctx->trans_log_time();
+}
+
+
+/**
+ * @brief configure the reply timeout and the retransmission of transactions
+ *
+ * @param timeout the time after which a transaction without a reply is
+ *		  retransmitted, in units of the time source (0 to disable)
+ * @param retries the maximum number of retransmissions of a transaction
+ *		  before it is dropped (at most 255)
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note timeouts require a time source, see rdcu_rmap_set_time_source(); the
+ *	 deadline is counted from the (re)submission of a command, so it must
+ *	 cover the time a command may wait behind a full transfer window
+ * @note retries also apply to replies with an invalid length or data CRC,
+ *	 with a timeout of 0, those are retransmitted right away
+ * @note to be retransmitted, the payload of a write must stay unchanged at
+ *	 its local address until the transaction completed
+ * @note a dropped transaction completes with an error status and releases
+ *	 its slot, so a lost reply no longer blocks the transaction log
+ */
+
+int rdcu_rmap_set_timeout(uint32_t timeout, uint32_t retries)
+{
+	if (retries > 0xFF)
+		return -1;
+
+	if (timeout > INT32_MAX)
+		return -1;
+
+	ctx->trans_timeout = timeout;
+	ctx->trans_retries = (uint8_t) retries;
+
+	return 0;
+}
+
+
+/**
+ * @brief configure zero-copy transmission of rmap data write commands
+ *
+ * @param tx function pointer to transmit an rmap command that references
+ *	     rather than copies the data payload (may be NULL to disable)
+ *
+ * @note this is only used for bulk data transfers via rdcu_sync_data(), which
+ *	 send straight from the SRAM mirror; the caller must not touch the
+ *	 written section of the mirror until rdcu_rmap_sync_status()
+ *	 reports the transfer as complete
+ * @note tx has the same call interface and return values as the tx function
+ *	 configured in rdcu_rmap_init()
+ */
+
+void rdcu_rmap_set_tx_zero_copy(int32_t (*tx)(const void *hdr,
+					      uint32_t hdr_size,
+					      const uint8_t non_crc_bytes,
+					      const void *data,
+					      uint32_t data_size))
+{
+	ctx->rmap_tx_zero_copy = tx;
+}
+
+
+/**
+ * @brief configure zero-copy reception of rmap reply packets
+ *
+ * @param peek function pointer to reference the next received packet
+ * @param release function pointer to release the packet buffer
+ *
+ * @note peek is expected to set the packet reference to the start of the
+ *	 next pending packet (without any target path bytes) and return its
+ *	 size, or 0 if there is none; the buffer must stay valid until release
+ *	 is called
+ * @note if either argument is NULL, the rx function configured in
+ *	 rdcu_rmap_init() is used (this is the default)
+ */
+
+void rdcu_rmap_set_rx_zero_copy(uint32_t (*peek)(uint8_t **pkt),
+				uint32_t (*release)(void))
+{
+	ctx->rmap_rx_peek    = peek;
+	ctx->rmap_rx_release = release;
+}
+
+
+/**
+ * @brief configure burst reception of rmap reply packets
+ *
+ * @param get function pointer to reference up to n received packets
+ * @param release function pointer to release the first n packet buffers
+ *
+ * @note get is expected to fill the arrays with the start (without any
+ *	 target path bytes) and size of the pending packets in the order
+ *	 they were received and return their number, or 0 if there are none;
+ *	 the buffers must stay valid until release is called
+ * @note this takes precedence over rdcu_rmap_set_rx_zero_copy(); if either
+ *	 argument is NULL, burst reception is disabled (this is the default)
+ */
+
+void rdcu_rmap_set_rx_burst(uint32_t (*get)(uint8_t **pkts, uint32_t *sizes,
+					    uint32_t n),
+			    uint32_t (*release)(uint32_t n))
+{
+	ctx->rmap_rx_burst         = get;
+	ctx->rmap_rx_burst_release = release;
 }
 
 
@@ -812,10 +2684,117 @@ int rdcu_rmap_init(size_t mtu,
 	if (!rx)
 		return -1;
 
-	rmap_tx = tx;
-	rmap_rx = rx;
+#if (RMAP_STATIC_ALLOC)
+	if (mtu > RMAP_POOL_DATA_SIZE) {
+		printf("mtu exceeds the static rx buffer size of %d bytes\n",
+		       RMAP_POOL_DATA_SIZE);
+		return -1;
+	}
+#endif
+
+	ctx->rmap_tx = tx;
+	ctx->rmap_rx = rx;
+
+	ctx->data_mtu = mtu;
+
+	rdcu_rmap_reset_log();
+	rdcu_hdr_cache_flush();
+
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+
+	/* as sysctl does not provide a _remove() function, make
+	 * sure that we do not re-add the same object to the sysctl tree
+	 */
+	if (rmap_sobj.sattr)
+		return 0;
 
-	data_mtu = mtu;
+	sysobj_init(&rmap_sobj);
+	rmap_sobj.sattr = rmap_attributes;
+	sysobj_add(&rmap_sobj, NULL, driver_set, "rmap");
 
 	return 0;
 }
+
+
+/**
+ * @brief allocate a new RDCU link context
+ *
+ * @returns a pointer to the context or NULL on error
+ *
+ * @note the context must be selected with rdcu_rmap_select_ctx() and
+ *	 initialised with rdcu_rmap_init() just like the default one
+ */
+
+struct rdcu_rmap_ctx *rdcu_rmap_ctx_alloc(void)
+{
+	struct rdcu_rmap_ctx *c;
+
+
+	c = (struct rdcu_rmap_ctx *) calloc(1, sizeof(struct rdcu_rmap_ctx));
+	if (!c) {
+		printf("Error allocating memory for the RDCU link context\n");
+		return NULL;
+	}
+
+	c->trans_window = TRANS_LOG_SIZE;
+
+	return c;
+}
+
+
+/**
+ * @brief free an RDCU link context
+ *
+ * @param c the context to free
+ *
+ * @note if the context is currently selected, the default context is selected
+ *	 instead; the default context itself is never freed
+ */
+
+void rdcu_rmap_ctx_free(struct rdcu_rmap_ctx *c)
+{
+	if (!c)
+		return;
+
+	if (c == &rmap_ctx_default)
+		return;
+
+	if (ctx == c)
+		ctx = &rmap_ctx_default;
+
+	free(c);
+}
+
+
+/**
+ * @brief select the RDCU link context all subsequent calls operate on
+ *
+ * @param c the context to select; NULL selects the default context
+ *
+ * @note pass the context as userdata when registering rdcu_rmap_rx_irq() for
+ *	 the receive interrupt of the corresponding link
+ * @note never select a context from interrupt context (PRIORITY_NOW), the
+ *	 selection would change under the feet of the interrupted code; the
+ *	 deferred callbacks, e.g. rdcu_rmap_rx_irq(), run from
+ *	 irq_queue_execute() and restore the previous selection on return
+ */
+
+void rdcu_rmap_select_ctx(struct rdcu_rmap_ctx *c)
+{
+	if (!c)
+		c = &rmap_ctx_default;
+
+	ctx = c;
+}
+
+
+/**
+ * @brief get the currently selected RDCU link context
+ *
+ * @returns the selected context
+ */
+
+struct rdcu_rmap_ctx *rdcu_rmap_get_ctx(void)
+{
+	return ctx;
+}
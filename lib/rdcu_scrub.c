@@ -0,0 +1,473 @@
+/**
+ * @file   rdcu_scrub.c
+ * @author agent (agent@local),
+ * @date   2026
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief background scrubbing of the RDCU SRAM
+ *
+ * The SRAM is scrubbed in steps: a step reads a block of the SRAM through
+ * the EDAC of the memory controller, which corrects single bit errors, and
+ * writes the corrected data back, before the errors of a word can pile up
+ * to an uncorrectable one. A cursor walks over the whole SRAM, so that every
+ * word is visited once per pass.
+ *
+ * Scrubbing must not get in the way of the compressions, nor may a write
+ * back overwrite anything else that was put into the SRAM meanwhile, so a
+ * step is only started if the link is idle, i.e. no other transaction is
+ * pending, and the compressor is neither busy nor active. Data are only
+ * written back if still no other transaction was issued after the read and
+ * the compressor is still idle, which is read again right before the write.
+ * The status is needed as well as the link state: if replies to SRAM
+ * transfers are received on a separate channel (see
+ * rdcu_set_bulk_source_logical_address()), the reply to a compression start
+ * issued after the read may overtake the read reply. Otherwise, the step is
+ * deferred. Steps are also skipped while the EDAC is bypassed, as there is
+ * nothing to correct then.
+ *
+ * The write back is issued from the completion of the status read, so no
+ * other command can get in between on our side; the commands must reach
+ * the RDCU in the order they were submitted, i.e. on a single transmit
+ * channel.
+ *
+ * Steps are triggered by rdcu_scrub_tick(), which is meant to be called
+ * periodically, e.g. from a timer interrupt via rdcu_scrub_irq(). Without a
+ * budget, one step is done per tick, provided the link is idle. With a
+ * budget, each tick adds that many bytes of transfer volume to a bucket and
+ * steps are done back to back while the bucket holds enough, so scrubbing
+ * takes a bounded share of the link.
+ *
+ * The scrubber operates on the link context that was selected when
+ * rdcu_scrub_init() was called. There is a single scrubber, so only one RDCU
+ * is scrubbed at a time; to move it to another one, call rdcu_scrub_init()
+ * again with the other link context selected.
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include <dlog.h>
+#include <rdcu_cmd.h>
+#include <rdcu_rmap.h>
+#include <rdcu_scrub.h>
+
+
+/* compressor status bits, see RDCU-FRS-FN-0632 */
+#define SCRUB_COMPR_READY	(0x1UL << 4)
+#define SCRUB_COMPR_ACTIVE	 0x1UL
+
+/* SRAM EDAC status bits, see RDCU-FRS-FN-1032 */
+#define SCRUB_EDAC_BYPASS	(0x1UL << 8)
+
+
+enum scrub_state {SCRUB_IDLE, SCRUB_CHECK, SCRUB_READ, SCRUB_VERIFY,
+		  SCRUB_WRITE};
+
+static struct {
+	struct rdcu_rmap_ctx *rmap;	/* the link of the scrubbed RDCU */
+
+	int enabled;
+	enum scrub_state state;
+
+	uint32_t step;			/* the size of a step */
+	uint32_t len;			/* the size of the current step */
+	uint32_t budget;		/* transfer bytes per tick, 0: none */
+	uint32_t tokens;		/* transfer bytes available */
+
+	int n_wait;			/* status reads pending */
+	int n_fail;			/* status reads failed */
+	uint32_t compr_status;
+	uint32_t edac_status;
+
+	struct rdcu_scrub_status st;
+
+	uint32_t buf[RDCU_SCRUB_STEP_MAX / sizeof(uint32_t)];
+} scrub;
+
+
+static void scrub_next(void);
+
+
+/**
+ * @brief get the region of an SRAM address
+ */
+
+static uint32_t scrub_region(uint32_t addr)
+{
+	return (addr - RDCU_SRAM_START) / RDCU_SCRUB_REGION_SIZE;
+}
+
+
+/**
+ * @brief check whether the last compressor status read shows an idle
+ *	  compressor
+ */
+
+static int scrub_compr_idle(void)
+{
+	if (!(scrub.compr_status & SCRUB_COMPR_READY))
+		return 0;
+
+	if (scrub.compr_status & SCRUB_COMPR_ACTIVE)
+		return 0;
+
+	return 1;
+}
+
+
+/**
+ * @brief move the cursor past the current step
+ */
+
+static void scrub_advance(void)
+{
+	scrub.st.cursor += scrub.len;
+
+	if (scrub.st.cursor > RDCU_SRAM_END) {
+		scrub.st.cursor = RDCU_SRAM_START;
+		scrub.st.passes++;
+	}
+}
+
+
+/**
+ * @brief the write back of a step completed
+ */
+
+static void scrub_write_done(__attribute__((unused)) uint16_t trans_id,
+			     int status,
+			     __attribute__((unused)) void *userdata)
+{
+	scrub.state = SCRUB_IDLE;
+
+	if (status) {
+		dlog1("scrub: write back at 0x%06lx failed\n", scrub.st.cursor);
+		return;
+	}
+
+	scrub.st.steps++;
+	scrub_advance();
+
+	/* continue while there is budget left */
+	if (scrub.budget)
+		scrub_next();
+}
+
+
+/**
+ * @brief the compressor status was read again, write the corrected data
+ *	  back if it is still idle
+ */
+
+static void scrub_verify_done(__attribute__((unused)) uint16_t trans_id,
+			      int status,
+			      __attribute__((unused)) void *userdata)
+{
+	scrub.state = SCRUB_IDLE;
+
+	if (status || !scrub.enabled)
+		return;
+
+	/* a compression may have been started after the read */
+	if (!scrub_compr_idle() || rdcu_rmap_sync_status()) {
+		scrub.st.yields++;
+		return;
+	}
+
+	scrub.state = SCRUB_WRITE;
+
+	if (rdcu_sync_data_async(rdcu_write_cmd_data, scrub.st.cursor,
+				 scrub.buf, scrub.len, 0,
+				 scrub_write_done, NULL))
+		scrub.state = SCRUB_IDLE;
+}
+
+
+/**
+ * @brief the read of a step completed, check the compressor again before
+ *	  the corrected data are written back
+ */
+
+static void scrub_read_done(__attribute__((unused)) uint16_t trans_id,
+			    int status,
+			    __attribute__((unused)) void *userdata)
+{
+	uint32_t r;
+
+
+	scrub.state = SCRUB_IDLE;
+
+	if (status) {
+		r = scrub_region(scrub.st.cursor);
+		scrub.st.read_err[r]++;
+		dlog2("scrub: read at 0x%06lx (region %lu) failed\n",
+		      scrub.st.cursor, r);
+		scrub_advance();
+		return;
+	}
+
+	if (!scrub.enabled)
+		return;
+
+	/* the SRAM may have been changed after the read */
+	if (rdcu_rmap_sync_status()) {
+		scrub.st.yields++;
+		return;
+	}
+
+	scrub.state = SCRUB_VERIFY;
+
+	if (rdcu_sync_async(rdcu_read_cmd_compr_status, &scrub.compr_status,
+			    0, scrub_verify_done, NULL))
+		scrub.state = SCRUB_IDLE;
+}
+
+
+/**
+ * @brief the compressor and EDAC status reads of a step completed
+ */
+
+static void scrub_check_done(__attribute__((unused)) uint16_t trans_id,
+			     int status,
+			     __attribute__((unused)) void *userdata)
+{
+	if (status)
+		scrub.n_fail++;
+
+	if (--scrub.n_wait)
+		return;
+
+	scrub.state = SCRUB_IDLE;
+
+	if (scrub.n_fail || !scrub.enabled)
+		return;
+
+	if (!scrub_compr_idle() || rdcu_rmap_sync_status()) {
+		scrub.st.yields++;
+		return;
+	}
+
+	if (scrub.edac_status & SCRUB_EDAC_BYPASS) {
+		scrub.st.bypassed++;
+		return;
+	}
+
+	scrub.len = RDCU_SRAM_END + 1 - scrub.st.cursor;
+	if (scrub.len > scrub.step)
+		scrub.len = scrub.step;
+
+	if (scrub.budget)
+		scrub.tokens -= 2 * scrub.len;
+
+	scrub.state = SCRUB_READ;
+
+	if (rdcu_sync_data_async(rdcu_read_cmd_data, scrub.st.cursor,
+				 scrub.buf, scrub.len, 1,
+				 scrub_read_done, NULL))
+		scrub.state = SCRUB_IDLE;
+}
+
+
+/**
+ * @brief start the next step if the link is idle
+ */
+
+static void scrub_next(void)
+{
+	if (!scrub.enabled)
+		return;
+
+	if (scrub.state != SCRUB_IDLE)
+		return;
+
+	if (scrub.budget && scrub.tokens < 2 * scrub.step)
+		return;
+
+	if (rdcu_rmap_sync_status()) {
+		scrub.st.yields++;
+		return;
+	}
+
+	scrub.state  = SCRUB_CHECK;
+	scrub.n_wait = 2;
+	scrub.n_fail = 0;
+
+	/* replies may be processed while submitting, so the state is set up
+	 * in advance and a failed submission counts as a failed read
+	 */
+	if (rdcu_sync_async(rdcu_read_cmd_compr_status, &scrub.compr_status,
+			    0, scrub_check_done, NULL))
+		scrub_check_done(0, -1, NULL);
+
+	if (rdcu_sync_async(rdcu_read_cmd_sram_edac_status,
+			    &scrub.edac_status, 0, scrub_check_done, NULL))
+		scrub_check_done(0, -1, NULL);
+}
+
+
+/**
+ * @brief set up and enable the SRAM scrubber
+ *
+ * @param step		the number of bytes scrubbed per step; must be a
+ *			multiple of 4 and fit the data mtu of the link and
+ *			RDCU_SCRUB_STEP_MAX
+ * @param budget	the transfer volume in bytes granted per tick, 0 to
+ *			do a single step per tick; a step transfers twice its
+ *			size
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the scrubber works on the currently selected link context; the
+ *	 cursor and counters are reset
+ * @note configure a reply timeout (see rdcu_rmap_set_timeout()), otherwise a
+ *	 lost reply suspends the scrubber until rdcu_rmap_reset_log() drops it
+ */
+
+int rdcu_scrub_init(uint32_t step, uint32_t budget)
+{
+	if (!step || (step & 0x3))
+		return -1;
+
+	if (step > RDCU_SCRUB_STEP_MAX || step > rdcu_get_data_mtu())
+		return -1;
+
+	if (scrub.state != SCRUB_IDLE)
+		return -1;
+
+	memset(&scrub.st, 0, sizeof(scrub.st));
+
+	scrub.rmap   = rdcu_rmap_get_ctx();
+	scrub.step   = step;
+	scrub.budget = budget;
+	scrub.tokens = 0;
+
+	scrub.st.cursor = RDCU_SRAM_START;
+
+	scrub.enabled = 1;
+
+	return 0;
+}
+
+
+/**
+ * @brief disable the SRAM scrubber
+ *
+ * @note a step in progress is completed, except for the write back
+ */
+
+void rdcu_scrub_stop(void)
+{
+	scrub.enabled = 0;
+}
+
+
+/**
+ * @brief advance the SRAM scrubber
+ *
+ * @note call this periodically from the context the other rdcu_rmap
+ *	 functions are used in
+ */
+
+void rdcu_scrub_tick(void)
+{
+	uint32_t max;
+
+	struct rdcu_rmap_ctx *prev;
+
+
+	if (!scrub.enabled)
+		return;
+
+	if (scrub.budget) {
+		/* allow at least one step, but do not save up */
+		max = scrub.budget;
+		if (max < 2 * scrub.step)
+			max = 2 * scrub.step;
+
+		scrub.tokens += scrub.budget;
+		if (scrub.tokens > max)
+			scrub.tokens = max;
+	}
+
+	prev = rdcu_rmap_get_ctx();
+	rdcu_rmap_select_ctx(scrub.rmap);
+
+	scrub_next();
+
+	rdcu_rmap_select_ctx(prev);
+}
+
+
+/**
+ * @brief advance the SRAM scrubber from a timer interrupt callback
+ *
+ * @param userdata unused
+ *
+ * @returns always 0
+ *
+ * @note as this issues RMAP transactions, register it with PRIORITY_LATER
+ *	 and call irq_queue_execute() from the same context the other rdcu_rmap
+ *	 functions are used in
+ */
+
+int32_t rdcu_scrub_irq(__attribute__((unused)) void *userdata)
+{
+	rdcu_scrub_tick();
+
+	return 0;
+}
+
+
+/**
+ * @brief account a multi-bit error to the SRAM regions of a buffer
+ *
+ * @param addr	the SRAM start address of the buffer
+ * @param size	the size of the buffer in bytes
+ *
+ * @note the memory controller flags uncorrectable errors to the compressor
+ *	 only (see MB_ERR_BIT), which does not tell where it found the error;
+ *	 call this with the input buffers of a compression that reported one
+ */
+
+void rdcu_scrub_report_mb_err(uint32_t addr, uint32_t size)
+{
+	uint32_t r;
+	uint32_t last;
+
+
+	if (!size || addr > RDCU_SRAM_END)
+		return;
+
+	last = addr + size - 1;
+	if (last > RDCU_SRAM_END || last < addr)
+		last = RDCU_SRAM_END;
+
+	for (r = scrub_region(addr); r <= scrub_region(last); r++)
+		scrub.st.mb_err[r]++;
+
+	dlog2("scrub: multi-bit error reported in 0x%06lx-0x%06lx\n",
+	      addr, last);
+}
+
+
+/**
+ * @brief get the progress and error counters of the SRAM scrubber
+ *
+ * @param status the structure to fill
+ */
+
+void rdcu_scrub_get_status(struct rdcu_scrub_status *status)
+{
+	if (status)
+		(*status) = scrub.st;
+}
@@ -16,6 +16,11 @@
  * @brief rmap command/reply helper functions
  *
  * @note the extended address byte is always set to 0x0
+ *
+ * @note if compiled with RMAP_STATIC_ALLOC=1, no heap allocations are made;
+ *	 packets, paths and data buffers are taken from the pools sized via
+ *	 RMAP_POOL_PKTS, RMAP_POOL_DATA_BUFS and RMAP_POOL_DATA_SIZE (see rmap.h)
+ *	 in constant time
  */
 
 
@@ -24,9 +29,205 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <dlog.h>
 #include <rmap.h>
 
 
+#if (RMAP_STATIC_ALLOC)
+/* a pool packet carries its own path buffers */
+struct rmap_pool_pkt {
+	struct rmap_pkt pkt;
+	uint8_t path[RMAP_MAX_PATH_LEN];
+	uint8_t rpath[RMAP_MAX_REPLY_PATH_LEN];
+	struct rmap_pool_pkt *next;
+};
+
+union rmap_pool_data {
+	uint8_t buf[RMAP_POOL_DATA_SIZE];
+	union rmap_pool_data *next;
+};
+
+static struct rmap_pool_pkt rmap_pkt_pool[RMAP_POOL_PKTS];
+static union rmap_pool_data rmap_data_pool[RMAP_POOL_DATA_BUFS];
+
+static struct rmap_pool_pkt *rmap_pkt_pool_free;
+static union rmap_pool_data *rmap_data_pool_free;
+static int rmap_pool_ready;
+
+
+/**
+ * @brief link all pool elements into their free lists
+ */
+
+static void rmap_pool_init(void)
+{
+	size_t i;
+
+
+	for (i = 0; i < RMAP_POOL_PKTS - 1; i++)
+		rmap_pkt_pool[i].next = &rmap_pkt_pool[i + 1];
+
+	rmap_pkt_pool[RMAP_POOL_PKTS - 1].next = NULL;
+	rmap_pkt_pool_free = &rmap_pkt_pool[0];
+
+	for (i = 0; i < RMAP_POOL_DATA_BUFS - 1; i++)
+		rmap_data_pool[i].next = &rmap_data_pool[i + 1];
+
+	rmap_data_pool[RMAP_POOL_DATA_BUFS - 1].next = NULL;
+	rmap_data_pool_free = &rmap_data_pool[0];
+
+	rmap_pool_ready = 1;
+}
+
+
+/**
+ * @brief get the pool element of a packet
+ *
+ * @returns the pool element or NULL if the packet was not taken from the pool
+ */
+
+static struct rmap_pool_pkt *rmap_pool_elem(struct rmap_pkt *pkt)
+{
+	struct rmap_pool_pkt *e = (struct rmap_pool_pkt *) pkt;
+
+
+	if (e < &rmap_pkt_pool[0] || e >= &rmap_pkt_pool[RMAP_POOL_PKTS])
+		return NULL;
+
+	return e;
+}
+
+
+static struct rmap_pkt *rmap_pkt_alloc(void)
+{
+	struct rmap_pool_pkt *e;
+
+
+	if (!rmap_pool_ready)
+		rmap_pool_init();
+
+	e = rmap_pkt_pool_free;
+	if (!e)
+		return NULL;
+
+	rmap_pkt_pool_free = e->next;
+
+	memset(&e->pkt, 0, sizeof(struct rmap_pkt));
+
+	return &e->pkt;
+}
+
+
+static void rmap_pkt_release(struct rmap_pkt *pkt)
+{
+	struct rmap_pool_pkt *e = rmap_pool_elem(pkt);
+
+
+	if (!e)
+		return;
+
+	e->next = rmap_pkt_pool_free;
+	rmap_pkt_pool_free = e;
+}
+
+
+static uint8_t *rmap_path_alloc(struct rmap_pkt *pkt, int reply)
+{
+	struct rmap_pool_pkt *e = rmap_pool_elem(pkt);
+
+
+	if (!e)
+		return NULL;
+
+	if (reply)
+		return e->rpath;
+
+	return e->path;
+}
+
+
+static void rmap_path_release(__attribute__((unused)) uint8_t *path)
+{
+	/* part of the packet */
+}
+
+
+static uint8_t *rmap_data_alloc(uint32_t size)
+{
+	union rmap_pool_data *d;
+
+
+	if (size > RMAP_POOL_DATA_SIZE)
+		return NULL;
+
+	if (!rmap_pool_ready)
+		rmap_pool_init();
+
+	d = rmap_data_pool_free;
+	if (!d)
+		return NULL;
+
+	rmap_data_pool_free = d->next;
+
+	return d->buf;
+}
+
+
+static void rmap_data_release(uint8_t *buf)
+{
+	union rmap_pool_data *d = (union rmap_pool_data *) buf;
+
+
+	/* references assigned by the user are not ours to release */
+	if (d < &rmap_data_pool[0] || d >= &rmap_data_pool[RMAP_POOL_DATA_BUFS])
+		return;
+
+	d->next = rmap_data_pool_free;
+	rmap_data_pool_free = d;
+}
+
+#else
+
+static struct rmap_pkt *rmap_pkt_alloc(void)
+{
+	return (struct rmap_pkt *) calloc(1, sizeof(struct rmap_pkt));
+}
+
+
+static void rmap_pkt_release(struct rmap_pkt *pkt)
+{
+	free(pkt);
+}
+
+
+static uint8_t *rmap_path_alloc(struct rmap_pkt *pkt, int reply)
+{
+	if (reply)
+		return (uint8_t *) malloc(pkt->rpath_len);
+
+	return (uint8_t *) malloc(pkt->path_len);
+}
+
+
+static void rmap_path_release(uint8_t *path)
+{
+	free(path);
+}
+
+
+static uint8_t *rmap_data_alloc(uint32_t size)
+{
+	return (uint8_t *) malloc(size);
+}
+
+
+static void rmap_data_release(uint8_t *buf)
+{
+	free(buf);
+}
+#endif /* RMAP_STATIC_ALLOC */
+
+
 
 
 
@@ -100,23 +301,13 @@ static int rmap_get_min_hdr_size(struct rmap_pkt *pkt)
 	}
 }
 
-/**
- * @brief calculate the CRC8 of a given buffer
- *
- * @param buf the buffer containing the data
- * @param len the length of the buffer
- *
- * @returns the CRC8
+/* crc8 lookup tables for slice-by-4 processing: crc8_lt[0] is the table from
+ * ECSS‐E‐ST‐50‐52C A.3, crc8_lt[k] advances the CRC by another k zero bytes,
+ * i.e. crc8_lt[k][x] == crc8_lt[0][crc8_lt[k - 1][x]]
  */
 
-uint8_t rmap_crc8(const uint8_t *buf, const size_t len)
-{
-	size_t i;
-
-	uint8_t crc8 = 0;
-
-	/* crc8 lookup table from ECSS‐E‐ST‐50‐52C A.3 */
-	const uint8_t crc8_lt[256] = {
+static const uint8_t crc8_lt[4][256] = {
+	{
 		0x00, 0x91, 0xe3, 0x72, 0x07, 0x96, 0xe4, 0x75,
 		0x0e, 0x9f, 0xed, 0x7c, 0x09, 0x98, 0xea, 0x7b,
 		0x1c, 0x8d, 0xff, 0x6e, 0x1b, 0x8a, 0xf8, 0x69,
@@ -149,21 +340,190 @@ uint8_t rmap_crc8(const uint8_t *buf, const size_t len)
 		0xa6, 0x37, 0x45, 0xd4, 0xa1, 0x30, 0x42, 0xd3,
 		0xb4, 0x25, 0x57, 0xc6, 0xb3, 0x22, 0x50, 0xc1,
 		0xba, 0x2b, 0x59, 0xc8, 0xbd, 0x2c, 0x5e, 0xcf,
-	};
+	},
+	{
+		0x00, 0x6d, 0xda, 0xb7, 0x75, 0x18, 0xaf, 0xc2,
+		0xea, 0x87, 0x30, 0x5d, 0x9f, 0xf2, 0x45, 0x28,
+		0x15, 0x78, 0xcf, 0xa2, 0x60, 0x0d, 0xba, 0xd7,
+		0xff, 0x92, 0x25, 0x48, 0x8a, 0xe7, 0x50, 0x3d,
+		0x2a, 0x47, 0xf0, 0x9d, 0x5f, 0x32, 0x85, 0xe8,
+		0xc0, 0xad, 0x1a, 0x77, 0xb5, 0xd8, 0x6f, 0x02,
+		0x3f, 0x52, 0xe5, 0x88, 0x4a, 0x27, 0x90, 0xfd,
+		0xd5, 0xb8, 0x0f, 0x62, 0xa0, 0xcd, 0x7a, 0x17,
+		0x54, 0x39, 0x8e, 0xe3, 0x21, 0x4c, 0xfb, 0x96,
+		0xbe, 0xd3, 0x64, 0x09, 0xcb, 0xa6, 0x11, 0x7c,
+		0x41, 0x2c, 0x9b, 0xf6, 0x34, 0x59, 0xee, 0x83,
+		0xab, 0xc6, 0x71, 0x1c, 0xde, 0xb3, 0x04, 0x69,
+		0x7e, 0x13, 0xa4, 0xc9, 0x0b, 0x66, 0xd1, 0xbc,
+		0x94, 0xf9, 0x4e, 0x23, 0xe1, 0x8c, 0x3b, 0x56,
+		0x6b, 0x06, 0xb1, 0xdc, 0x1e, 0x73, 0xc4, 0xa9,
+		0x81, 0xec, 0x5b, 0x36, 0xf4, 0x99, 0x2e, 0x43,
+		0xa8, 0xc5, 0x72, 0x1f, 0xdd, 0xb0, 0x07, 0x6a,
+		0x42, 0x2f, 0x98, 0xf5, 0x37, 0x5a, 0xed, 0x80,
+		0xbd, 0xd0, 0x67, 0x0a, 0xc8, 0xa5, 0x12, 0x7f,
+		0x57, 0x3a, 0x8d, 0xe0, 0x22, 0x4f, 0xf8, 0x95,
+		0x82, 0xef, 0x58, 0x35, 0xf7, 0x9a, 0x2d, 0x40,
+		0x68, 0x05, 0xb2, 0xdf, 0x1d, 0x70, 0xc7, 0xaa,
+		0x97, 0xfa, 0x4d, 0x20, 0xe2, 0x8f, 0x38, 0x55,
+		0x7d, 0x10, 0xa7, 0xca, 0x08, 0x65, 0xd2, 0xbf,
+		0xfc, 0x91, 0x26, 0x4b, 0x89, 0xe4, 0x53, 0x3e,
+		0x16, 0x7b, 0xcc, 0xa1, 0x63, 0x0e, 0xb9, 0xd4,
+		0xe9, 0x84, 0x33, 0x5e, 0x9c, 0xf1, 0x46, 0x2b,
+		0x03, 0x6e, 0xd9, 0xb4, 0x76, 0x1b, 0xac, 0xc1,
+		0xd6, 0xbb, 0x0c, 0x61, 0xa3, 0xce, 0x79, 0x14,
+		0x3c, 0x51, 0xe6, 0x8b, 0x49, 0x24, 0x93, 0xfe,
+		0xc3, 0xae, 0x19, 0x74, 0xb6, 0xdb, 0x6c, 0x01,
+		0x29, 0x44, 0xf3, 0x9e, 0x5c, 0x31, 0x86, 0xeb,
+	},
+	{
+		0x00, 0xd0, 0x61, 0xb1, 0xc2, 0x12, 0xa3, 0x73,
+		0x45, 0x95, 0x24, 0xf4, 0x87, 0x57, 0xe6, 0x36,
+		0x8a, 0x5a, 0xeb, 0x3b, 0x48, 0x98, 0x29, 0xf9,
+		0xcf, 0x1f, 0xae, 0x7e, 0x0d, 0xdd, 0x6c, 0xbc,
+		0xd5, 0x05, 0xb4, 0x64, 0x17, 0xc7, 0x76, 0xa6,
+		0x90, 0x40, 0xf1, 0x21, 0x52, 0x82, 0x33, 0xe3,
+		0x5f, 0x8f, 0x3e, 0xee, 0x9d, 0x4d, 0xfc, 0x2c,
+		0x1a, 0xca, 0x7b, 0xab, 0xd8, 0x08, 0xb9, 0x69,
+		0x6b, 0xbb, 0x0a, 0xda, 0xa9, 0x79, 0xc8, 0x18,
+		0x2e, 0xfe, 0x4f, 0x9f, 0xec, 0x3c, 0x8d, 0x5d,
+		0xe1, 0x31, 0x80, 0x50, 0x23, 0xf3, 0x42, 0x92,
+		0xa4, 0x74, 0xc5, 0x15, 0x66, 0xb6, 0x07, 0xd7,
+		0xbe, 0x6e, 0xdf, 0x0f, 0x7c, 0xac, 0x1d, 0xcd,
+		0xfb, 0x2b, 0x9a, 0x4a, 0x39, 0xe9, 0x58, 0x88,
+		0x34, 0xe4, 0x55, 0x85, 0xf6, 0x26, 0x97, 0x47,
+		0x71, 0xa1, 0x10, 0xc0, 0xb3, 0x63, 0xd2, 0x02,
+		0xd6, 0x06, 0xb7, 0x67, 0x14, 0xc4, 0x75, 0xa5,
+		0x93, 0x43, 0xf2, 0x22, 0x51, 0x81, 0x30, 0xe0,
+		0x5c, 0x8c, 0x3d, 0xed, 0x9e, 0x4e, 0xff, 0x2f,
+		0x19, 0xc9, 0x78, 0xa8, 0xdb, 0x0b, 0xba, 0x6a,
+		0x03, 0xd3, 0x62, 0xb2, 0xc1, 0x11, 0xa0, 0x70,
+		0x46, 0x96, 0x27, 0xf7, 0x84, 0x54, 0xe5, 0x35,
+		0x89, 0x59, 0xe8, 0x38, 0x4b, 0x9b, 0x2a, 0xfa,
+		0xcc, 0x1c, 0xad, 0x7d, 0x0e, 0xde, 0x6f, 0xbf,
+		0xbd, 0x6d, 0xdc, 0x0c, 0x7f, 0xaf, 0x1e, 0xce,
+		0xf8, 0x28, 0x99, 0x49, 0x3a, 0xea, 0x5b, 0x8b,
+		0x37, 0xe7, 0x56, 0x86, 0xf5, 0x25, 0x94, 0x44,
+		0x72, 0xa2, 0x13, 0xc3, 0xb0, 0x60, 0xd1, 0x01,
+		0x68, 0xb8, 0x09, 0xd9, 0xaa, 0x7a, 0xcb, 0x1b,
+		0x2d, 0xfd, 0x4c, 0x9c, 0xef, 0x3f, 0x8e, 0x5e,
+		0xe2, 0x32, 0x83, 0x53, 0x20, 0xf0, 0x41, 0x91,
+		0xa7, 0x77, 0xc6, 0x16, 0x65, 0xb5, 0x04, 0xd4,
+	},
+	{
+		0x00, 0x8c, 0xd9, 0x55, 0x73, 0xff, 0xaa, 0x26,
+		0xe6, 0x6a, 0x3f, 0xb3, 0x95, 0x19, 0x4c, 0xc0,
+		0x0d, 0x81, 0xd4, 0x58, 0x7e, 0xf2, 0xa7, 0x2b,
+		0xeb, 0x67, 0x32, 0xbe, 0x98, 0x14, 0x41, 0xcd,
+		0x1a, 0x96, 0xc3, 0x4f, 0x69, 0xe5, 0xb0, 0x3c,
+		0xfc, 0x70, 0x25, 0xa9, 0x8f, 0x03, 0x56, 0xda,
+		0x17, 0x9b, 0xce, 0x42, 0x64, 0xe8, 0xbd, 0x31,
+		0xf1, 0x7d, 0x28, 0xa4, 0x82, 0x0e, 0x5b, 0xd7,
+		0x34, 0xb8, 0xed, 0x61, 0x47, 0xcb, 0x9e, 0x12,
+		0xd2, 0x5e, 0x0b, 0x87, 0xa1, 0x2d, 0x78, 0xf4,
+		0x39, 0xb5, 0xe0, 0x6c, 0x4a, 0xc6, 0x93, 0x1f,
+		0xdf, 0x53, 0x06, 0x8a, 0xac, 0x20, 0x75, 0xf9,
+		0x2e, 0xa2, 0xf7, 0x7b, 0x5d, 0xd1, 0x84, 0x08,
+		0xc8, 0x44, 0x11, 0x9d, 0xbb, 0x37, 0x62, 0xee,
+		0x23, 0xaf, 0xfa, 0x76, 0x50, 0xdc, 0x89, 0x05,
+		0xc5, 0x49, 0x1c, 0x90, 0xb6, 0x3a, 0x6f, 0xe3,
+		0x68, 0xe4, 0xb1, 0x3d, 0x1b, 0x97, 0xc2, 0x4e,
+		0x8e, 0x02, 0x57, 0xdb, 0xfd, 0x71, 0x24, 0xa8,
+		0x65, 0xe9, 0xbc, 0x30, 0x16, 0x9a, 0xcf, 0x43,
+		0x83, 0x0f, 0x5a, 0xd6, 0xf0, 0x7c, 0x29, 0xa5,
+		0x72, 0xfe, 0xab, 0x27, 0x01, 0x8d, 0xd8, 0x54,
+		0x94, 0x18, 0x4d, 0xc1, 0xe7, 0x6b, 0x3e, 0xb2,
+		0x7f, 0xf3, 0xa6, 0x2a, 0x0c, 0x80, 0xd5, 0x59,
+		0x99, 0x15, 0x40, 0xcc, 0xea, 0x66, 0x33, 0xbf,
+		0x5c, 0xd0, 0x85, 0x09, 0x2f, 0xa3, 0xf6, 0x7a,
+		0xba, 0x36, 0x63, 0xef, 0xc9, 0x45, 0x10, 0x9c,
+		0x51, 0xdd, 0x88, 0x04, 0x22, 0xae, 0xfb, 0x77,
+		0xb7, 0x3b, 0x6e, 0xe2, 0xc4, 0x48, 0x1d, 0x91,
+		0x46, 0xca, 0x9f, 0x13, 0x35, 0xb9, 0xec, 0x60,
+		0xa0, 0x2c, 0x79, 0xf5, 0xd3, 0x5f, 0x0a, 0x86,
+		0x4b, 0xc7, 0x92, 0x1e, 0x38, 0xb4, 0xe1, 0x6d,
+		0xad, 0x21, 0x74, 0xf8, 0xde, 0x52, 0x07, 0x8b,
+	},
+};
+
+
+/**
+ * @brief start an incremental CRC8 calculation
+ *
+ * @returns the initial CRC8 value
+ */
 
+uint8_t rmap_crc8_init(void)
+{
+	return 0;
+}
 
 
+/**
+ * @brief update a CRC8 with the contents of a buffer
+ *
+ * @param crc8 the current CRC8 value, see rmap_crc8_init()
+ * @param buf the buffer containing the data
+ * @param len the length of the buffer
+ *
+ * @returns the updated CRC8
+ *
+ * @note this processes 4 bytes per iteration; as the CRC is only 8 bits wide,
+ *	 the lookups of a round are independent of each other
+ */
+
+uint8_t rmap_crc8_update(uint8_t crc8, const uint8_t *buf, size_t len)
+{
 	if (!buf)
-		return 0;
+		return crc8;
 
+	while (len >= 4) {
+		crc8 = crc8_lt[3][crc8 ^ buf[0]] ^ crc8_lt[2][buf[1]] ^
+		       crc8_lt[1][buf[2]]        ^ crc8_lt[0][buf[3]];
+		buf += 4;
+		len -= 4;
+	}
 
-	for (i = 0; i < len; i++)
-		crc8 = crc8_lt[crc8 ^ buf[i]];
+	while (len--)
+		crc8 = crc8_lt[0][crc8 ^ *buf++];
+
+	return crc8;
+}
+
+
+/**
+ * @brief finish an incremental CRC8 calculation
+ *
+ * @param crc8 the current CRC8 value
+ *
+ * @returns the final CRC8
+ *
+ * @note the RMAP CRC has no final xor, this exists for symmetry
+ */
 
+uint8_t rmap_crc8_final(uint8_t crc8)
+{
 	return crc8;
 }
 
 
+/**
+ * @brief calculate the CRC8 of a given buffer
+ *
+ * @param buf the buffer containing the data
+ * @param len the length of the buffer
+ *
+ * @returns the CRC8
+ */
+
+uint8_t rmap_crc8(const uint8_t *buf, const size_t len)
+{
+	if (!buf)
+		return 0;
+
+	return rmap_crc8_final(rmap_crc8_update(rmap_crc8_init(), buf, len));
+}
+
+
 /**
  * @brief create an RMAP packet and set defaults
  *
@@ -178,7 +538,7 @@ struct rmap_pkt *rmap_create_packet(void)
 	struct rmap_pkt *pkt;
 
 
-	pkt = (struct rmap_pkt *) calloc(1, sizeof(struct rmap_pkt));
+	pkt = rmap_pkt_alloc();
 	if (pkt)
 		pkt->proto_id = RMAP_PROTOCOL_ID;
 
@@ -196,7 +556,7 @@ struct rmap_pkt *rmap_create_packet(void)
 
 void rmap_destroy_packet(struct rmap_pkt *pkt)
 {
-	free(pkt);
+	rmap_pkt_release(pkt);
 }
 
 
@@ -207,15 +567,16 @@ void rmap_destroy_packet(struct rmap_pkt *pkt)
  *
  * @note this will attempt to deallocate any pointer references assigned by the
  * 	 user
+ * @note with RMAP_STATIC_ALLOC, only buffers taken from the pools are released
  * @warning use with care
  */
 
 void rmap_erase_packet(struct rmap_pkt *pkt)
 {
-	free(pkt->path);
-	free(pkt->rpath);
-	free(pkt->data);
-	free(pkt);
+	rmap_path_release(pkt->path);
+	rmap_path_release(pkt->rpath);
+	rmap_data_release(pkt->data);
+	rmap_pkt_release(pkt);
 }
 
 /**
@@ -288,7 +649,7 @@ int rmap_set_reply_path(struct rmap_pkt *pkt, const uint8_t *rpath, uint8_t len)
 
 	pkt->rpath_len = len;
 
-	pkt->rpath = (uint8_t *) malloc(pkt->rpath_len);
+	pkt->rpath = rmap_path_alloc(pkt, 1);
 	if (!pkt->rpath)
 		return -1;
 
@@ -326,7 +687,7 @@ int rmap_set_dest_path(struct rmap_pkt *pkt, const uint8_t *path, uint8_t len)
 
 	pkt->path_len = len;
 
-	pkt->path = (uint8_t *) malloc(pkt->path_len);
+	pkt->path = rmap_path_alloc(pkt, 0);
 	if (!pkt->path)
 		return -1;
 
@@ -485,44 +846,44 @@ int rmap_build_hdr(struct rmap_pkt *pkt, uint8_t *hdr)
 
 
 /**
- * @brief create an rmap packet from a buffer
+ * @brief decode an rmap packet in place
  *
+ * @param pkt a struct rmap_pkt to fill
  * @param buf the buffer, with the target path stripped away, i.e.
  *	  starting with <logical address>, <protocol id>, ...
  * @param len the data length of the buffer (in bytes)
  *
- * @returns an rmap packet, containing the decoded buffer including any data,
- *	    NULL on error
+ * @returns 0 on success, -1 on error
+ *
+ * @note no memory is allocated, the reply path and data references of the
+ *	 packet point into the buffer, so it must be kept around for as long as
+ *	 the packet is used; do NOT call rmap_erase_packet() on the result
  */
 
-struct rmap_pkt *rmap_pkt_from_buffer(uint8_t *buf, uint32_t len)
+int rmap_pkt_view_from_buffer(struct rmap_pkt *pkt, uint8_t *buf, uint32_t len)
 {
 	size_t n = 0;
-	size_t i;
 	int min_hdr_size;
 
-	struct rmap_pkt *pkt = NULL;
 
+	if (!pkt)
+		return -1;
 
 	if (!buf)
-		goto error;
+		return -1;
 
 	if (len < RMAP_HDR_MIN_SIZE_WRITE_REP) {
-		printf("buffer len is smaller than the smallest RMAP packet\n");
-		goto error;
+		dlog0("buffer len is smaller than the smallest RMAP packet\n");
+		return -1;
 	}
 
 	if (buf[RMAP_PROTOCOL_ID] != RMAP_PROTOCOL_ID) {
-		printf("Not an RMAP packet, got %x but expected %x\n",
-		       buf[RMAP_PROTOCOL_ID], RMAP_PROTOCOL_ID);
-		goto error;
+		dlog2("Not an RMAP packet, got %lx but expected %lx\n",
+		      buf[RMAP_PROTOCOL_ID], RMAP_PROTOCOL_ID);
+		return -1;
 	}
 
-	pkt = rmap_create_packet();
-	if (!pkt) {
-		printf("Error creating packet\n");
-		goto error;
-	}
+	memset(pkt, 0, sizeof(struct rmap_pkt));
 
 	pkt->dst         = buf[RMAP_DEST_ADDRESS];
 	pkt->proto_id    = buf[RMAP_PROTOCOL_ID];
@@ -531,27 +892,23 @@ struct rmap_pkt *rmap_pkt_from_buffer(uint8_t *buf, uint32_t len)
 
 	min_hdr_size = rmap_get_min_hdr_size(pkt);
 	if (min_hdr_size < 0)
-		goto error;
+		return -1;
 
-	if (len < (uint32_t)min_hdr_size) {
-		printf("buffer len is smaller than the contained RMAP packet\n");
-		goto error;
+	/* +1 for the header CRC */
+	if (len < (uint32_t)min_hdr_size + 1) {
+		dlog0("buffer len is smaller than the contained RMAP packet\n");
+		return -1;
 	}
 
 
 	if (pkt->ri.cmd_resp) {
 		pkt->rpath_len = pkt->ri.reply_addr_len << 2;
-		if (len < (uint32_t)min_hdr_size + pkt->rpath_len) {
-			printf("buffer is smaller than the contained RMAP packet\n");
-			goto error;
+		if (len < (uint32_t)min_hdr_size + pkt->rpath_len + 1) {
+			dlog0("buffer is smaller than the contained RMAP packet\n");
+			return -1;
 		}
 
-		pkt->rpath = (uint8_t *) malloc(pkt->rpath_len);
-		if (!pkt->rpath)
-			goto error;
-
-		for (i = 0; i < pkt->rpath_len; i++)
-			pkt->rpath[i] = buf[RMAP_REPLY_ADDR_START + i];
+		pkt->rpath = &buf[RMAP_REPLY_ADDR_START];
 
 		n = pkt->rpath_len; /* rpath skip */
 	}
@@ -575,28 +932,83 @@ struct rmap_pkt *rmap_pkt_from_buffer(uint8_t *buf, uint32_t len)
 		pkt->data_len = ((uint32_t) buf[RMAP_DATALEN_BYTE0 + n] << 16) |
 				((uint32_t) buf[RMAP_DATALEN_BYTE1 + n] <<  8) |
 			         (uint32_t) buf[RMAP_DATALEN_BYTE2 + n];
+
+		pkt->hdr_crc  = buf[RMAP_HEADER_CRC + n];
+	} else {
+		/* write replies end after the transaction id */
+		pkt->hdr_crc  = buf[RMAP_TRANS_ID_BYTE1 + 1];
 	}
 
-	pkt->hdr_crc  = buf[RMAP_HEADER_CRC];
+	/* read commands specify a length, but carry no data */
+	if (pkt->ri.cmd_resp && !(pkt->ri.cmd & RMAP_CMD_BIT_WRITE) &&
+	    pkt->ri.cmd != RMAP_READ_MODIFY_WRITE_ADDR_INC)
+		return 0;
 
 	if (pkt->data_len) {
 		if (len < RMAP_DATA_START + n + pkt->data_len + 1) {  /* +1 for data CRC */
-			printf("buffer len is smaller than the contained RMAP packet; buf len: %lu bytes vs RMAP: %lu bytes needed\n",
-				len , RMAP_DATA_START + n + pkt->data_len);
-			goto error;
+			dlog2("buffer len is smaller than the contained RMAP packet; buf len: %lu bytes vs RMAP: %lu bytes needed\n",
+			      len, RMAP_DATA_START + n + pkt->data_len);
+			return -1;
 		}
 		if (len > RMAP_DATA_START + n + pkt->data_len + 1)  /* +1 for data CRC */
-			printf("warning: the buffer is larger than the included RMAP packet\n");
+			dlog0("warning: the buffer is larger than the included RMAP packet\n");
 
-		pkt->data = (uint8_t *) malloc(pkt->data_len);
-		if (!pkt->data)
+		pkt->data = &buf[RMAP_DATA_START + n];
+
+		/* final byte is data crc */
+		pkt->data_crc = buf[RMAP_DATA_START + n + pkt->data_len];
+	}
+
+
+	return 0;
+}
+
+
+/**
+ * @brief create an rmap packet from a buffer
+ *
+ * @param buf the buffer, with the target path stripped away, i.e.
+ *	  starting with <logical address>, <protocol id>, ...
+ * @param len the data length of the buffer (in bytes)
+ *
+ * @returns an rmap packet, containing the decoded buffer including any data,
+ *	    NULL on error
+ */
+
+struct rmap_pkt *rmap_pkt_from_buffer(uint8_t *buf, uint32_t len)
+{
+	struct rmap_pkt view;
+	struct rmap_pkt *pkt = NULL;
+
+
+	if (rmap_pkt_view_from_buffer(&view, buf, len))
+		goto error;
+
+	pkt = rmap_create_packet();
+	if (!pkt) {
+		dlog0("Error creating packet\n");
+		goto error;
+	}
+
+	memcpy(pkt, &view, sizeof(struct rmap_pkt));
+
+	pkt->rpath = NULL;
+	pkt->data  = NULL;
+
+	if (view.rpath_len) {
+		pkt->rpath = rmap_path_alloc(pkt, 1);
+		if (!pkt->rpath)
 			goto error;
 
-		for (i = 0; i < pkt->data_len; i++)
-			pkt->data[i] = buf[RMAP_DATA_START + n + i];
+		memcpy(pkt->rpath, view.rpath, view.rpath_len);
+	}
 
-		/* final byte is data crc */
-		pkt->data_crc = buf[RMAP_DATA_START + n + i];
+	if (view.data_len) {
+		pkt->data = rmap_data_alloc(view.data_len);
+		if (!pkt->data)
+			goto error;
+
+		memcpy(pkt->data, view.data, view.data_len);
 	}
 
 
@@ -604,9 +1016,9 @@ struct rmap_pkt *rmap_pkt_from_buffer(uint8_t *buf, uint32_t len)
 
 error:
 	if (pkt) {
-		free(pkt->data);
-		free(pkt->rpath);
-		free(pkt);
+		rmap_data_release(pkt->data);
+		rmap_path_release(pkt->rpath);
+		rmap_pkt_release(pkt);
 	}
 
 	return NULL;
@@ -614,6 +1026,46 @@ error:
 
 
 
+/**
+ * @brief classify an rmap reply status code
+ *
+ * @param status the status byte of a reply
+ *
+ * @returns the class of the status
+ *
+ * @note this is a table lookup, so it is cheap enough for the reply path
+ */
+
+enum rmap_err_class rmap_status_class(uint8_t status)
+{
+	static const uint8_t status_class[16] = {
+		RMAP_ERR_NONE,		/* success */
+		RMAP_ERR_TARGET,	/* general error */
+		RMAP_ERR_CMD,		/* unused packet type or command code */
+		RMAP_ERR_AUTH,		/* invalid key */
+		RMAP_ERR_TRANSFER,	/* invalid data CRC */
+		RMAP_ERR_TRANSFER,	/* early EOP */
+		RMAP_ERR_TRANSFER,	/* too much data */
+		RMAP_ERR_TRANSFER,	/* EEP */
+		RMAP_ERR_TARGET,	/* reserved */
+		RMAP_ERR_CMD,		/* verify buffer overrun */
+		RMAP_ERR_AUTH,		/* command not implemented or authorised */
+		RMAP_ERR_CMD,		/* RMW data length error */
+		RMAP_ERR_AUTH,		/* invalid target logical address */
+		RMAP_ERR_TARGET,	/* reserved */
+		RMAP_ERR_TARGET,	/* reserved */
+		RMAP_ERR_TARGET,	/* reserved */
+	};
+
+
+	if (status >= sizeof(status_class))
+		return RMAP_ERR_TARGET;
+
+	return (enum rmap_err_class) status_class[status];
+}
+
+
+
 /**** UNFINISHED INFO STUFF BELOW ******/
 
 __extension__